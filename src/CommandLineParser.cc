@@ -27,6 +27,7 @@
 #include "xxhash.hh"
 #include "build-info.hh"
 #include <cassert>
+#include <cstdlib>
 #include <iostream>
 #include <memory>
 
@@ -71,6 +72,9 @@ CommandLineParser::CommandLineParser(Reactor& reactor_)
 	registerOption("-script",     scriptOption,  PHASE_BEFORE_SETTINGS, 1); // correct phase?
 	registerOption("-command",    commandOption, PHASE_BEFORE_SETTINGS, 1); // same phase as -script
 	registerOption("-testconfig", testConfigOption, PHASE_BEFORE_SETTINGS, 1);
+	registerOption("-headless",   headlessOption, PHASE_BEFORE_SETTINGS, 1);
+	registerOption("-run-for",    runForOption,   PHASE_BEFORE_SETTINGS);
+	registerOption("-run-until",  runUntilOption, PHASE_BEFORE_SETTINGS);
 
 	registerOption("-machine",    machineOption, PHASE_LOAD_MACHINE);
 
@@ -182,6 +186,10 @@ void CommandLineParser::parse(int argc, char** argv)
 			break;
 		case PHASE_LOAD_SETTINGS:
 			// after -control and -setting has been parsed
+			if (!isHeadless() && (getRunFor() || !getRunUntil().empty())) {
+				throw FatalError("-run-for and -run-until can only "
+				                 "be used together with -headless");
+			}
 			if (parseStatus != CONTROL) {
 				// if there already is a XML-StdioConnection, we
 				// can't also show plain messages on stdout
@@ -214,6 +222,10 @@ void CommandLineParser::parse(int argc, char** argv)
 				// this forces overwriting a non-setting file.
 				settingsConfig.setSaveFilename(context, filename);
 			}
+			if (isHeadless()) {
+				// before the machine (and the sound driver) is created
+				reactor.setHeadless();
+			}
 			break;
 		case PHASE_DEFAULT_MACHINE: {
 			if (!haveConfig) {
@@ -283,7 +295,7 @@ void CommandLineParser::parse(int argc, char** argv)
 
 bool CommandLineParser::isHiddenStartup() const
 {
-	return parseStatus == one_of(CONTROL, TEST);
+	return (parseStatus == one_of(CONTROL, TEST)) || isHeadless();
 }
 
 CommandLineParser::ParseStatus CommandLineParser::getParseStatus() const
@@ -386,6 +398,58 @@ std::string_view CommandLineParser::CommandOption::optionHelp() const
 }
 
 
+// Headless option
+
+void CommandLineParser::HeadlessOption::parseOption(
+	const string& /*option*/, span<string>& /*cmdLine*/)
+{
+	headless = true;
+}
+
+string_view CommandLineParser::HeadlessOption::optionHelp() const
+{
+	return "Run without video and sound output and without throttling, "
+	       "for batch jobs (see -run-for and -run-until)";
+}
+
+
+// Run-for option
+
+void CommandLineParser::RunForOption::parseOption(
+	const string& option, span<string>& cmdLine)
+{
+	auto arg = getArgument(option, cmdLine);
+	char* end;
+	double d = strtod(arg.c_str(), &end);
+	if (arg.empty() || *end || !(d >= 0.0)) {
+		throw FatalError("Invalid duration for ", option, ": ", arg);
+	}
+	duration = d;
+}
+
+string_view CommandLineParser::RunForOption::optionHelp() const
+{
+	return "Exit after this amount of emulated time (in seconds, only with -headless), "
+	       "together with -run-until: exit with status 1 when the "
+	       "condition wasn't met in time";
+}
+
+
+// Run-until option
+
+void CommandLineParser::RunUntilOption::parseOption(
+	const string& option, span<string>& cmdLine)
+{
+	condition = getArgument(option, cmdLine);
+}
+
+string_view CommandLineParser::RunUntilOption::optionHelp() const
+{
+	return "Exit (with status 0, only with -headless) as soon as the given Tcl expression "
+	       "is true, it's checked (at least) once per emulated frame";
+}
+
+
 // Help option
 
 static string formatSet(const vector<string_view>& inputSet, string::size_type columns)
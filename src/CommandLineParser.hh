@@ -15,6 +15,7 @@
 #include "components.hh"
 #include <memory>
 #include <initializer_list>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -69,6 +70,16 @@ public:
 	  */
 	[[nodiscard]] bool isHiddenStartup() const;
 
+	/** Run without video and sound output, as fast as possible (-headless).
+	  */
+	[[nodiscard]] bool isHeadless() const { return headlessOption.headless; }
+	/** Amount of emulated time (in seconds) to run for (-run-for).
+	  */
+	[[nodiscard]] std::optional<double> getRunFor() const { return runForOption.duration; }
+	/** Tcl condition to stop running (-run-until), empty if not given.
+	  */
+	[[nodiscard]] const std::string& getRunUntil() const { return runUntilOption.condition; }
+
 private:
 	struct OptionData {
 		CLIOption* option;
@@ -137,6 +148,27 @@ private:
 		[[nodiscard]] std::string_view optionHelp() const override;
 	} testConfigOption;
 
+	struct HeadlessOption final : CLIOption {
+		void parseOption(const std::string& option, span<std::string>& cmdLine) override;
+		[[nodiscard]] std::string_view optionHelp() const override;
+
+		bool headless = false;
+	} headlessOption;
+
+	struct RunForOption final : CLIOption {
+		void parseOption(const std::string& option, span<std::string>& cmdLine) override;
+		[[nodiscard]] std::string_view optionHelp() const override;
+
+		std::optional<double> duration;
+	} runForOption;
+
+	struct RunUntilOption final : CLIOption {
+		void parseOption(const std::string& option, span<std::string>& cmdLine) override;
+		[[nodiscard]] std::string_view optionHelp() const override;
+
+		std::string condition;
+	} runUntilOption;
+
 	struct BashOption final : CLIOption {
 		void parseOption(const std::string& option, span<std::string>& cmdLine) override;
 		[[nodiscard]] std::string_view optionHelp() const override;
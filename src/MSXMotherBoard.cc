@@ -224,6 +224,9 @@ MSXMotherBoard::MSXMotherBoard(Reactor& reactor_)
 	machineExtensionInfo = make_unique<MachineExtensionInfo>(*this);
 	deviceInfo = make_unique<DeviceInfo>(*this);
 	debugger = make_unique<Debugger>(*this);
+#ifdef USE_SCHEDULER_STATS
+	scheduler->getStats().registerInfoTopic(getMachineInfoCommand());
+#endif
 
 	msxMixer->mute(); // powered down
 
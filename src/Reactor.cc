@@ -26,6 +26,7 @@
 #include "Mixer.hh"
 #include "AviRecorder.hh"
 #include "GlobalSettings.hh"
+#include "SettingsManager.hh"
 #include "BooleanSetting.hh"
 #include "EnumSetting.hh"
 #include "TclObject.hh"
@@ -48,6 +49,8 @@
 #include "view.hh"
 #include "build-info.hh"
 #include <cassert>
+#include <iomanip>
+#include <iostream>
 #include <memory>
 
 using std::make_shared;
@@ -556,11 +559,90 @@ void Reactor::run(CommandLineParser& parser)
 		}
 	}
 
+	if (parser.isHeadless()) {
+		runHeadless(parser);
+		return;
+	}
+
 	while (doOneIteration()) {
 		// nothing
 	}
 }
 
+void Reactor::setHeadless()
+{
+	assert(!mixer && boards.empty());
+	headless = true;
+
+	// No throttling. (The renderer stays 'none' because of the hidden
+	// startup, the Mixer selects the 'null' sound driver.) This value is
+	// not stored in settings.xml.
+	auto& settingsManager = globalCommandController->getSettingsManager();
+	auto* throttle = settingsManager.findSetting("throttle");
+	assert(throttle);
+	throttle->setDontSaveValue(TclObject("off"));
+	throttle->setValue(TclObject("off"));
+}
+
+void Reactor::runHeadless(const CommandLineParser& parser)
+{
+	assert(headless);
+
+	auto runFor = parser.getRunFor();
+	bool haveCondition = !parser.getRunUntil().empty();
+	TclObject condition(parser.getRunUntil());
+
+	double emulated = 0.0; // in seconds
+	auto startReal = Timer::getTime();
+	auto lastPoll = startReal;
+	while (running) {
+		// Polling host events is only needed to react on e.g. Ctrl-C,
+		// so don't do it for every iteration.
+		if (auto now = Timer::getTime(); (now - lastPoll) > 100000) {
+			inputEventGenerator->poll();
+			lastPoll = now;
+		}
+		eventDistributor->deliverEvents();
+		if (!running) break;
+
+		bool blocked = (blockedCounter > 0) || !activeBoard;
+		if (!blocked) {
+			auto copy = activeBoard;
+			auto before = copy->getCurrentTime();
+			blocked = !copy->execute();
+			emulated += (copy->getCurrentTime() - before).toDouble();
+		}
+
+		if (haveCondition) {
+			bool done = false;
+			try {
+				done = condition.evalBool(getInterpreter());
+			} catch (CommandException& e) {
+				throw FatalError("Error in -run-until condition: ",
+				                 e.getMessage());
+			}
+			if (done) {
+				exitCode = 0;
+				break;
+			}
+		}
+		if (runFor && (emulated >= *runFor)) {
+			// with -run-until this means the condition timed out
+			exitCode = haveCondition ? 1 : 0;
+			break;
+		}
+		if (blocked) {
+			eventDistributor->sleep(20 * 1000);
+		}
+	}
+
+	double real = double(Timer::getTime() - startReal) / 1000000.0;
+	std::cout << std::fixed << std::setprecision(3)
+	          << "Emulated " << emulated << "s in " << real << "s: "
+	          << ((real > 0.0) ? (emulated / real) : 0.0)
+	          << " emulated seconds per second\n";
+}
+
 bool Reactor::doOneIteration()
 {
 	eventDistributor->deliverEvents();
@@ -77,6 +77,12 @@ public:
 
 	void enterMainLoop();
 
+	/** Running with the -headless command line option? */
+	[[nodiscard]] bool isHeadless() const { return headless; }
+	/** Switch to headless mode: no sound output and no throttling. Must
+	  * be called before the first machine is created. */
+	void setHeadless();
+
 	[[nodiscard]] RTScheduler& getRTScheduler() { return *rtScheduler; }
 	[[nodiscard]] EventDistributor& getEventDistributor() { return *eventDistributor; }
 	[[nodiscard]] GlobalCliComm& getGlobalCliComm() { return *globalCliComm; }
@@ -130,6 +136,9 @@ private:
 	// running.
 	[[nodiscard]] bool doOneIteration();
 
+	// Main loop for -headless mode.
+	void runHeadless(const CommandLineParser& parser);
+
 	void unpause();
 	void pause();
 
@@ -195,6 +204,8 @@ private:
 	 */
 	bool running = true;
 
+	bool headless = false;
+
 	bool isInit = false; // has the init() method been run successfully
 
 	friend class MachineCommand;
@@ -12,6 +12,9 @@ Schedulable::Schedulable(Scheduler& scheduler_)
 Schedulable::~Schedulable()
 {
 	removeSyncPoints();
+#ifdef USE_SCHEDULER_STATS
+	scheduler.stats.schedulableDeleted(*this);
+#endif
 }
 
 void Schedulable::schedulerDeleted()
@@ -99,6 +99,13 @@ protected:
 
 private:
 	Scheduler& scheduler;
+
+	// Bookkeeping for the Scheduler: the number of pending sync points
+	// of this Schedulable and (only for the heap backend and only when
+	// there is exactly one pending sync point) its position in the queue.
+	friend class Scheduler;
+	unsigned numSyncPoints = 0;
+	size_t queueIndex = 0;
 };
 REGISTER_BASE_CLASS(Schedulable, "Schedulable");
 
@@ -7,6 +7,9 @@
 #include "stl.hh"
 #include <cassert>
 #include <iterator> // for back_inserter
+#ifdef USE_SCHEDULER_STATS
+#include <chrono>
+#endif
 
 namespace openmsx {
 
@@ -37,10 +40,18 @@ void Scheduler::setSyncPoint(EmuTime::param time, Schedulable& device)
 	assert(time >= scheduleTime);
 
 	// Push sync point into queue.
+	++device.numSyncPoints;
+#ifdef USE_SCHEDULER_STATS
+	stats.syncPointSet(device);
+#endif
+#ifdef USE_SCHEDULER_HEAP
+	queue.insert(SynchronizationPoint(time, &device));
+#else
 	queue.insert(SynchronizationPoint(time, &device),
 	             [](SynchronizationPoint& sp) { sp.setTime(EmuTime::infinity()); },
 	             [](const SynchronizationPoint& x, const SynchronizationPoint& y) {
 	                     return x.getTime() < y.getTime(); });
+#endif
 
 	if (!scheduleInProgress && cpu) {
 		// only when scheduleHelper() is not being executed
@@ -53,33 +64,100 @@ void Scheduler::setSyncPoint(EmuTime::param time, Schedulable& device)
 Scheduler::SyncPoints Scheduler::getSyncPoints(const Schedulable& device) const
 {
 	SyncPoints result;
+	if (device.numSyncPoints == 0) return result;
 	ranges::copy_if(queue, back_inserter(result), EqualSchedulable(device));
+#ifdef USE_SCHEDULER_HEAP
+	// heap order is unspecified, keep the same order as SchedulerQueue
+	ranges::stable_sort(result, [](const auto& x, const auto& y) {
+		return x.getTime() < y.getTime(); });
+#endif
 	return result;
 }
 
 bool Scheduler::removeSyncPoint(Schedulable& device)
 {
 	assert(Thread::isMainThread());
-	return queue.remove(EqualSchedulable(device));
+	if (device.numSyncPoints == 0) return false;
+#ifdef USE_SCHEDULER_STATS
+	stats.syncPointsRemoved(device, 1);
+#endif
+#ifdef USE_SCHEDULER_HEAP
+	if (device.numSyncPoints == 1) {
+		assert(queue[device.queueIndex].getDevice() == &device);
+		queue.removeAt(device.queueIndex);
+		--device.numSyncPoints;
+		return true;
+	}
+#endif
+	bool removed = queue.remove(EqualSchedulable(device));
+	assert(removed);
+	--device.numSyncPoints;
+#ifdef USE_SCHEDULER_HEAP
+	updateQueueIndex(device);
+#endif
+	return removed;
 }
 
 void Scheduler::removeSyncPoints(Schedulable& device)
 {
 	assert(Thread::isMainThread());
+	if (device.numSyncPoints == 0) return;
+#ifdef USE_SCHEDULER_STATS
+	stats.syncPointsRemoved(device, device.numSyncPoints);
+#endif
+#ifdef USE_SCHEDULER_HEAP
+	if (device.numSyncPoints == 1) {
+		queue.removeAt(device.queueIndex);
+		device.numSyncPoints = 0;
+		return;
+	}
+#endif
 	queue.remove_all(EqualSchedulable(device));
+	device.numSyncPoints = 0;
 }
 
 bool Scheduler::pendingSyncPoint(const Schedulable& device,
                                  EmuTime& result) const
 {
 	assert(Thread::isMainThread());
-	if (auto it = ranges::find_if(queue, EqualSchedulable(device));
-	    it != std::end(queue)) {
-		result = it->getTime();
+	if (device.numSyncPoints == 0) return false;
+#ifdef USE_SCHEDULER_HEAP
+	if (device.numSyncPoints == 1) {
+		result = queue[device.queueIndex].getTime();
 		return true;
 	}
-	return false;
+	// the earliest of the (unordered) matches
+	result = EmuTime::infinity();
+	for (const auto& sp : queue) {
+		if ((sp.getDevice() == &device) && (sp.getTime() < result)) {
+			result = sp.getTime();
+		}
+	}
+	return true;
+#else
+	auto it = ranges::find_if(queue, EqualSchedulable(device));
+	assert(it != std::end(queue));
+	result = it->getTime();
+	return true;
+#endif
+}
+
+#ifdef USE_SCHEDULER_HEAP
+void Scheduler::SyncPointTraits::setIndex(SynchronizationPoint& sp, size_t index)
+{
+	sp.getDevice()->queueIndex = index;
+}
+
+// After the number of sync points of a device dropped to one, its
+// 'queueIndex' might point to an already removed sync point.
+void Scheduler::updateQueueIndex(Schedulable& device)
+{
+	if (device.numSyncPoints != 1) return;
+	auto it = ranges::find_if(queue, EqualSchedulable(device));
+	assert(it != std::end(queue));
+	device.queueIndex = it - std::begin(queue);
 }
+#endif
 
 EmuTime::param Scheduler::getCurrentTime() const
 {
@@ -99,8 +177,22 @@ void Scheduler::scheduleHelper(EmuTime::param limit, EmuTime next)
 		auto* device = sp.getDevice();
 
 		queue.remove_front();
-
+		--device->numSyncPoints;
+#ifdef USE_SCHEDULER_HEAP
+		updateQueueIndex(*device);
+#endif
+
+#ifdef USE_SCHEDULER_STATS
+		stats.executing(*device);
+		auto start = std::chrono::steady_clock::now();
+		device->executeUntil(next);
+		auto stop = std::chrono::steady_clock::now();
+		// note: 'device' might have deleted itself
+		stats.executed(device, std::chrono::duration_cast<
+			std::chrono::nanoseconds>(stop - start).count());
+#else
 		device->executeUntil(next);
+#endif
 
 		next = getNext();
 		if (likely(next > limit)) break;
@@ -2,10 +2,30 @@
 #define SCHEDULER_HH
 
 #include "EmuTime.hh"
+#include "SchedulerHeap.hh"
 #include "SchedulerQueue.hh"
 #include "likely.hh"
+#include <cstddef>
 #include <vector>
 
+// Select the data structure that holds the pending sync points. By default
+// this is a sorted array (SchedulerQueue), enable this to use a heap
+// (SchedulerHeap) instead. The heap scales better to many sync points, the
+// sorted array has less overhead for a small number of sync points. Enable
+// it with the 'scheduler_heap' meson option, or by passing
+// -DUSE_SCHEDULER_HEAP to the compiler.
+// #define USE_SCHEDULER_HEAP
+
+// Collect statistics about the sync points of each Schedulable (see
+// SchedulerStats.hh). When not enabled this has no overhead at all. Enable it
+// with the 'scheduler_stats' meson option, or by passing -DUSE_SCHEDULER_STATS
+// to the compiler.
+// #define USE_SCHEDULER_STATS
+
+#ifdef USE_SCHEDULER_STATS
+#include "SchedulerStats.hh"
+#endif
+
 namespace openmsx {
 
 class Schedulable;
@@ -53,6 +73,12 @@ public:
 	 */
 	[[nodiscard]] inline EmuTime::param getNext() const
 	{
+#ifdef USE_SCHEDULER_HEAP
+		if (unlikely(queue.empty())) {
+			static constexpr auto inf = EmuTime::infinity();
+			return inf;
+		}
+#endif
 		return queue.front().getTime();
 	}
 
@@ -68,6 +94,10 @@ public:
 		scheduleTime = limit;
 	}
 
+#ifdef USE_SCHEDULER_STATS
+	[[nodiscard]] SchedulerStats& getStats() { return stats; }
+#endif
+
 	template<typename Archive>
 	void serialize(Archive& ar, unsigned version);
 
@@ -89,8 +119,7 @@ private: // -> intended for Schedulable
 
 	/**
 	 * Removes a syncPoint of a given device.
-	 * If there is more than one match only one will be removed,
-	 * there is no guarantee that the earliest syncPoint is
+	 * If there is more than one match only the earliest one will be
 	 * removed.
 	 * Returns false <=> if there was no match (so nothing removed)
 	 */
@@ -109,10 +138,25 @@ private:
 	void scheduleHelper(EmuTime::param limit, EmuTime next);
 
 private:
+#ifdef USE_SCHEDULER_HEAP
+	struct SyncPointTraits {
+		[[nodiscard]] static bool less(const SynchronizationPoint& x,
+		                               const SynchronizationPoint& y) {
+			return x.getTime() < y.getTime();
+		}
+		static void setIndex(SynchronizationPoint& sp, size_t index);
+	};
+	void updateQueueIndex(Schedulable& device);
+	SchedulerHeap<SynchronizationPoint, SyncPointTraits> queue;
+#else
 	/** Vector used as heap, not a priority queue because that
 	  * doesn't allow removal of non-top element.
 	  */
 	SchedulerQueue<SynchronizationPoint> queue;
+#endif
+#ifdef USE_SCHEDULER_STATS
+	SchedulerStats stats;
+#endif
 	EmuTime scheduleTime = EmuTime::zero();
 	MSXCPU* cpu = nullptr;
 	bool scheduleInProgress = false;
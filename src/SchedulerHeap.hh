@@ -0,0 +1,173 @@
+#ifndef SCHEDULERHEAP_HH
+#define SCHEDULERHEAP_HH
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace openmsx {
+
+// Alternative for SchedulerQueue, implemented as a 4-ary min-heap.
+//
+// Insert and remove (of any element, given its index) are O(log(N)), for
+// the sorted SchedulerQueue these are O(N) in the worst case. On the other
+// hand, iterating over the elements visits them in an unspecified order
+// (front() is still the smallest element).
+//
+// The TRAITS class must provide:
+//   static bool less(const T& x, const T& y);
+//   static void setIndex(T& t, size_t index);
+// 'less' defines the order. Elements that are equivalent according to
+// 'less' are ordered on insertion order (like in SchedulerQueue), so
+// they're removed in the same order as they were inserted.
+// 'setIndex' gets called whenever an element is stored at a (new) position.
+// This allows to keep a handle to an element, so it can later be found or
+// removed without searching, see operator[] and removeAt().
+template<typename T, typename TRAITS> class SchedulerHeap
+{
+public:
+	static constexpr size_t D = 4; // arity of the heap
+
+	[[nodiscard]] size_t size()  const { return values.size(); }
+	[[nodiscard]] bool   empty() const { return values.empty(); }
+
+	// Returns reference to the smallest element.
+	[[nodiscard]]       T& front()       { assert(!empty()); return values.front(); }
+	[[nodiscard]] const T& front() const { assert(!empty()); return values.front(); }
+
+	[[nodiscard]]       T& operator[](size_t i)       { return values[i]; }
+	[[nodiscard]] const T& operator[](size_t i) const { return values[i]; }
+
+	// Iterate over all elements, in unspecified order.
+	[[nodiscard]] auto begin()       { return values.begin(); }
+	[[nodiscard]] auto begin() const { return values.begin(); }
+	[[nodiscard]] auto end()         { return values.end(); }
+	[[nodiscard]] auto end()   const { return values.end(); }
+
+	void insert(const T& t)
+	{
+		values.push_back(t);
+		orders.push_back(counter++);
+		siftUp(values.size() - 1);
+	}
+
+	// Remove the smallest element.
+	void remove_front()
+	{
+		removeAt(0);
+	}
+
+	// Remove the element at the given index.
+	void removeAt(size_t i)
+	{
+		assert(i < size());
+		size_t last = size() - 1;
+		if (i != last) {
+			values[i] = values[last];
+			orders[i] = orders[last];
+		}
+		values.pop_back();
+		orders.pop_back();
+		if (i != last) {
+			if ((i != 0) && isLess(i, parent(i))) {
+				siftUp(i);
+			} else {
+				siftDown(i);
+			}
+		}
+	}
+
+	// Remove the smallest element for which the given predicate returns
+	// true. So when there are multiple matches, the same element gets
+	// removed as in SchedulerQueue (there it's the first match).
+	template<typename PRED> bool remove(PRED p)
+	{
+		size_t n = size();
+		size_t found = n;
+		for (size_t i = 0; i < n; ++i) {
+			if (p(values[i]) && ((found == n) || isLess(i, found))) {
+				found = i;
+			}
+		}
+		if (found == n) return false;
+		removeAt(found);
+		return true;
+	}
+
+	// Remove all elements for which the given predicate returns true.
+	template<typename PRED> void remove_all(PRED p)
+	{
+		size_t dst = 0;
+		for (size_t src = 0; src < size(); ++src) {
+			if (p(values[src])) continue;
+			values[dst] = values[src];
+			orders[dst] = orders[src];
+			++dst;
+		}
+		if (dst == size()) return;
+		values.resize(dst);
+		orders.resize(dst);
+		// restore heap property (bottom-up, O(N))
+		for (size_t i = size(); i-- > 0;) {
+			siftDown(i);
+		}
+	}
+
+private:
+	[[nodiscard]] static size_t parent(size_t i) { return (i - 1) / D; }
+
+	[[nodiscard]] bool isLess(size_t i, size_t j) const
+	{
+		if (TRAITS::less(values[i], values[j])) return true;
+		if (TRAITS::less(values[j], values[i])) return false;
+		return orders[i] < orders[j];
+	}
+
+	void swapElements(size_t i, size_t j)
+	{
+		std::swap(values[i], values[j]);
+		std::swap(orders[i], orders[j]);
+		TRAITS::setIndex(values[i], i);
+		TRAITS::setIndex(values[j], j);
+	}
+
+	void siftUp(size_t i)
+	{
+		TRAITS::setIndex(values[i], i);
+		while (i != 0) {
+			size_t p = parent(i);
+			if (!isLess(i, p)) break;
+			swapElements(i, p);
+			i = p;
+		}
+	}
+
+	void siftDown(size_t i)
+	{
+		TRAITS::setIndex(values[i], i);
+		size_t n = size();
+		while (true) {
+			size_t first = D * i + 1;
+			if (first >= n) break;
+			size_t smallest = first;
+			size_t last = std::min(first + D, n);
+			for (size_t c = first + 1; c < last; ++c) {
+				if (isLess(c, smallest)) smallest = c;
+			}
+			if (!isLess(smallest, i)) break;
+			swapElements(i, smallest);
+			i = smallest;
+		}
+	}
+
+private:
+	std::vector<T> values;
+	std::vector<uint64_t> orders; // insertion order, parallel to 'values'
+	uint64_t counter = 0;
+};
+
+} // namespace openmsx
+
+#endif // SCHEDULERHEAP_HH
@@ -0,0 +1,149 @@
+#include "SchedulerStats.hh"
+#include "Schedulable.hh"
+#include "MSXDevice.hh"
+#include "InfoTopic.hh"
+#include "CommandException.hh"
+#include "TclObject.hh"
+#include "ranges.hh"
+#include <typeinfo>
+#include <vector>
+#ifdef __GNUC__
+#include <cxxabi.h>
+#include <cstdlib>
+#endif
+
+namespace openmsx {
+
+class SchedulerStatsInfo final : public InfoTopic
+{
+public:
+	SchedulerStatsInfo(InfoCommand& machineInfoCommand, SchedulerStats& stats_)
+		: InfoTopic(machineInfoCommand, "scheduler_stats")
+		, stats(stats_)
+	{
+	}
+
+	void execute(span<const TclObject> tokens, TclObject& result) const override
+	{
+		checkNumArgs(tokens, Between{2, 3}, "?reset?");
+		if (tokens.size() == 3) {
+			if (tokens[2] != "reset") {
+				throw CommandException("Invalid argument: ", tokens[2].getString());
+			}
+			stats.reset();
+		} else {
+			stats.report(result);
+		}
+	}
+
+	[[nodiscard]] std::string help(const std::vector<std::string>& /*tokens*/) const override
+	{
+		return "Without arguments, returns per Schedulable the number of "
+		       "executeUntil() calls, the number of sync points it set and "
+		       "removed and the host time (in nanoseconds) spent in "
+		       "executeUntil(). Sorted on the number of executeUntil() "
+		       "calls.\n"
+		       "With argument 'reset', resets all counters.";
+	}
+
+	void tabCompletion(std::vector<std::string>& tokens) const override
+	{
+		static constexpr const char* const args[] = { "reset" };
+		completeString(tokens, args);
+	}
+
+private:
+	SchedulerStats& stats;
+};
+
+
+SchedulerStats::SchedulerStats() = default;
+SchedulerStats::~SchedulerStats() = default;
+
+void SchedulerStats::registerInfoTopic(InfoCommand& machineInfoCommand)
+{
+	infoTopic = std::make_unique<SchedulerStatsInfo>(machineInfoCommand, *this);
+}
+
+void SchedulerStats::executing(const Schedulable& s)
+{
+	auto& entry = live[&s];
+	++entry.counters.executeUntil;
+	// 's' is fully constructed now (it can already set sync points from
+	// within its constructor, then it's not yet possible to get its type)
+	if (entry.id.first.empty()) entry.id = getId(s);
+}
+
+void SchedulerStats::executed(const Schedulable* s, uint64_t nanoseconds)
+{
+	if (auto it = live.find(s); it != live.end()) {
+		it->second.counters.nanoseconds += nanoseconds;
+	}
+}
+
+void SchedulerStats::schedulableDeleted(const Schedulable& s)
+{
+	auto it = live.find(&s);
+	if (it == live.end()) return;
+	// Can't query the type of 's' anymore, so if it wasn't known yet,
+	// it never executed anything.
+	const auto& [id, counters] = it->second;
+	auto& d = deleted[id.first.empty() ? Id{"(unknown)", ""} : id];
+	d.executeUntil      += counters.executeUntil;
+	d.syncPointsSet     += counters.syncPointsSet;
+	d.syncPointsRemoved += counters.syncPointsRemoved;
+	d.nanoseconds       += counters.nanoseconds;
+	live.erase(it);
+}
+
+void SchedulerStats::reset()
+{
+	for (auto& [s, entry] : live) {
+		entry.counters = Counters();
+	}
+	deleted.clear();
+}
+
+SchedulerStats::Id SchedulerStats::getId(const Schedulable& s)
+{
+	const char* mangled = typeid(s).name();
+	std::string type = mangled;
+#ifdef __GNUC__
+	int status = 0;
+	if (char* demangled = abi::__cxa_demangle(mangled, nullptr, nullptr, &status)) {
+		type = demangled;
+		free(demangled);
+	}
+#endif
+	// Some Schedulables are also MSXDevices, for those we also know the
+	// name of the instance.
+	std::string name;
+	if (const auto* device = dynamic_cast<const MSXDevice*>(&s)) {
+		name = device->getName();
+	}
+	return {std::move(type), std::move(name)};
+}
+
+void SchedulerStats::report(TclObject& result)
+{
+	std::vector<std::pair<Id, Counters>> all(deleted.begin(), deleted.end());
+	for (auto& [s, entry] : live) {
+		if (entry.id.first.empty()) entry.id = getId(*s);
+		all.emplace_back(entry.id, entry.counters);
+	}
+	ranges::stable_sort(all, [](const auto& x, const auto& y) {
+		return x.second.executeUntil > y.second.executeUntil; });
+	for (const auto& [id, counters] : all) {
+		if ((counters.executeUntil | counters.syncPointsSet |
+		     counters.syncPointsRemoved) == 0) continue;
+		result.addListElement(makeTclDict(
+			"type", id.first,
+			"name", id.second,
+			"executeUntil", int64_t(counters.executeUntil),
+			"set", int64_t(counters.syncPointsSet),
+			"removed", int64_t(counters.syncPointsRemoved),
+			"nanoseconds", int64_t(counters.nanoseconds)));
+	}
+}
+
+} // namespace openmsx
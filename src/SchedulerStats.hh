@@ -0,0 +1,79 @@
+#ifndef SCHEDULERSTATS_HH
+#define SCHEDULERSTATS_HH
+
+#include "hash_map.hh"
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+
+namespace openmsx {
+
+class InfoCommand;
+class Schedulable;
+class SchedulerStatsInfo;
+class TclObject;
+
+/** Statistics about the sync points of each Schedulable: how often its
+  * executeUntil() method got called, how much (host) time that took, and
+  * how many sync points it set and removed.
+  *
+  * This is only used when the Scheduler is compiled with
+  * USE_SCHEDULER_STATS (see Scheduler.hh). The results can be retrieved via
+  * the 'machine_info scheduler_stats' command.
+  */
+class SchedulerStats
+{
+public:
+	struct Counters {
+		uint64_t executeUntil = 0;
+		uint64_t syncPointsSet = 0;
+		uint64_t syncPointsRemoved = 0;
+		uint64_t nanoseconds = 0; // host time spent in executeUntil()
+	};
+
+	SchedulerStats();
+	~SchedulerStats();
+
+	void registerInfoTopic(InfoCommand& machineInfoCommand);
+
+	void syncPointSet(const Schedulable& s) {
+		++live[&s].counters.syncPointsSet;
+	}
+	void syncPointsRemoved(const Schedulable& s, unsigned num) {
+		if (num) live[&s].counters.syncPointsRemoved += num;
+	}
+	/** Call right before and after executeUntil(). The latter only
+	  * accesses the pointer value (the Schedulable might have deleted
+	  * itself). */
+	void executing(const Schedulable& s);
+	void executed(const Schedulable* s, uint64_t nanoseconds);
+	/** Must be called when a Schedulable gets destroyed (its counters
+	  * are then accumulated under its name). */
+	void schedulableDeleted(const Schedulable& s);
+
+	void reset();
+
+	/** A list with, per Schedulable, a dictionary with its type, name and
+	  * counters. Sorted on the number of executeUntil() calls, most
+	  * frequent first. */
+	void report(TclObject& result);
+
+private:
+	// {type, name} of a Schedulable
+	using Id = std::pair<std::string, std::string>;
+	struct Entry {
+		Id id; // only set once the Schedulable is fully constructed
+		Counters counters;
+	};
+	static Id getId(const Schedulable& s);
+
+	hash_map<const Schedulable*, Entry> live;
+	std::map<Id, Counters> deleted;
+	std::unique_ptr<SchedulerStatsInfo> infoTopic;
+};
+
+} // namespace openmsx
+
+#endif
@@ -5,12 +5,39 @@
 
 namespace openmsx {
 
-bool BreakPointBase::isTrue(GlobalCliComm& cliComm, Interpreter& interp) const
+std::shared_ptr<const CompiledCondition> BreakPointBase::compileCondition(
+	const TclObject& condition)
+{
+	auto str = condition.getString();
+	if (str.empty()) return nullptr;
+	auto result = CompiledCondition::compile(str);
+	if (!result) return nullptr;
+	return std::make_shared<const CompiledCondition>(std::move(*result));
+}
+
+std::optional<bool> BreakPointBase::evaluateCompiled(CompiledCondition::Context& context) const
 {
 	if (condition.getString().empty()) {
 		// unconditional bp
 		return true;
 	}
+	if (!compiled) return {};
+	return compiled->evaluate(context);
+}
+
+bool BreakPointBase::isTrue(GlobalCliComm& cliComm, Interpreter& interp,
+                            CompiledCondition::Context* context) const
+{
+	if (condition.getString().empty()) {
+		// unconditional bp
+		return true;
+	}
+	if (context && compiled) {
+		if (auto result = compiled->evaluate(*context)) {
+			return *result;
+		}
+		// fall back to Tcl, e.g. to get the proper error message
+	}
 	try {
 		return condition.evalBool(interp);
 	} catch (CommandException& e) {
@@ -19,19 +46,38 @@ bool BreakPointBase::isTrue(GlobalCliComm& cliComm, Interpreter& interp) const
 	}
 }
 
-void BreakPointBase::checkAndExecute(GlobalCliComm& cliComm, Interpreter& interp)
+void BreakPointBase::executeCommand(GlobalCliComm& cliComm, Interpreter& interp)
+{
+	try {
+		command.executeCommand(interp, true); // compile command
+	} catch (CommandException& e) {
+		cliComm.printWarning(e.getMessage());
+	}
+}
+
+void BreakPointBase::checkAndExecute(GlobalCliComm& cliComm, Interpreter& interp,
+                                     CompiledCondition::Context* context)
 {
 	if (executing) {
 		// no recursive execution
 		return;
 	}
 	ScopedAssign sa(executing, true);
-	if (isTrue(cliComm, interp)) {
-		try {
-			command.executeCommand(interp, true); // compile command
-		} catch (CommandException& e) {
-			cliComm.printWarning(e.getMessage());
-		}
+	if (isTrue(cliComm, interp, context)) {
+		executeCommand(cliComm, interp);
+	}
+}
+
+void BreakPointBase::checkAndExecute(GlobalCliComm& cliComm, Interpreter& interp,
+                                     std::optional<bool> compiledResult)
+{
+	if (executing) {
+		// no recursive execution
+		return;
+	}
+	ScopedAssign sa(executing, true);
+	if (compiledResult ? *compiledResult : isTrue(cliComm, interp, nullptr)) {
+		executeCommand(cliComm, interp);
 	}
 }
 
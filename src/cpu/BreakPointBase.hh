@@ -1,7 +1,10 @@
 #ifndef BREAKPOINTBASE_HH
 #define BREAKPOINTBASE_HH
 
+#include "CompiledCondition.hh"
 #include "TclObject.hh"
+#include <memory>
+#include <optional>
 #include <string_view>
 
 namespace openmsx {
@@ -20,7 +23,20 @@ public:
 	[[nodiscard]] TclObject getCommandObj()   const { return command; }
 	[[nodiscard]] bool onlyOnce() const { return once; }
 
-	void checkAndExecute(GlobalCliComm& cliComm, Interpreter& interp);
+	/** When a context is given, the condition is (if possible) evaluated
+	  * natively instead of via Tcl, see CompiledCondition. */
+	void checkAndExecute(GlobalCliComm& cliComm, Interpreter& interp,
+	                     CompiledCondition::Context* context = nullptr);
+	/** Same, but the caller already evaluated the condition with
+	  * evaluateCompiled(), that result is used instead of evaluating it a
+	  * second time. When it's std::nullopt the condition is evaluated via
+	  * Tcl. */
+	void checkAndExecute(GlobalCliComm& cliComm, Interpreter& interp,
+	                     std::optional<bool> compiledResult);
+
+	/** Evaluate the condition without going through Tcl. Returns
+	  * std::nullopt when that's not possible. */
+	[[nodiscard]] std::optional<bool> evaluateCompiled(CompiledCondition::Context& context) const;
 
 protected:
 	// Note: we require GlobalCliComm here because breakpoint objects can
@@ -29,16 +45,23 @@ protected:
 	BreakPointBase(TclObject command_, TclObject condition_, bool once_)
 		: command(std::move(command_))
 		, condition(std::move(condition_))
-		, once(once_) {}
+		, once(once_)
+		, compiled(compileCondition(condition)) {}
 
 private:
-	[[nodiscard]] bool isTrue(GlobalCliComm& cliComm, Interpreter& interp) const;
+	[[nodiscard]] static std::shared_ptr<const CompiledCondition> compileCondition(
+		const TclObject& condition);
+	[[nodiscard]] bool isTrue(GlobalCliComm& cliComm, Interpreter& interp,
+	                          CompiledCondition::Context* context) const;
+	void executeCommand(GlobalCliComm& cliComm, Interpreter& interp);
 
 private:
 	TclObject command;
 	TclObject condition;
 	bool once;
 	bool executing = false;
+	// shared between copies of this breakpoint, nullptr if not compiled
+	std::shared_ptr<const CompiledCondition> compiled;
 };
 
 } // namespace openmsx
@@ -39,6 +39,7 @@ protected:
 	}
 	void setTime(EmuTime::param time) { sync(); clock.reset(time); }
 	void setFreq(unsigned freq) { clock.setFreq(freq); }
+	[[nodiscard]] EmuDuration getPeriod() const { return clock.getPeriod(); }
 	void advanceTime(EmuTime::param time);
 	[[nodiscard]] EmuTime calcTime(EmuTime::param time, unsigned ticks) const {
 		return clock.add(time, ticks);
@@ -112,6 +113,12 @@ protected:
 	[[nodiscard]] inline bool limitReached() const {
 		return remaining < 0;
 	}
+	/** The number of ticks that can still be executed before the limit
+	  * is reached. Negative when the limit is disabled (or reached).
+	  */
+	[[nodiscard]] int getRemainingTicks() const {
+		return remaining;
+	}
 
 	template<typename Archive>
 	void serialize(Archive& ar, unsigned version);
@@ -159,6 +159,7 @@
 // instructions too late.
 
 #include "CPUCore.hh"
+#include "CPUProfiler.hh"
 #include "MSXCPUInterface.hh"
 #include "Scheduler.hh"
 #include "MSXMotherBoard.hh"
@@ -173,6 +174,7 @@
 #include "inline.hh"
 #include "unreachable.hh"
 #include "xrange.hh"
+#include <algorithm>
 #include <iostream>
 #include <type_traits>
 #include <cassert>
@@ -838,7 +840,20 @@ template<typename T> inline void CPUCore<T>::irq2()
 }
 
 template<typename T>
-void CPUCore<T>::executeInstructions()
+inline void CPUCore<T>::executeInstructions()
+{
+	if (unlikely(profiler != nullptr)) {
+		executeInstructions2<true>();
+	} else {
+		executeInstructions2<false>();
+	}
+}
+
+// When PROFILE is true, every executed instruction gets recorded in the
+// CPUProfiler. This is done in a separate instantiation, so that the regular
+// CPU loop doesn't pay for it.
+template<typename T> template<bool PROFILE>
+void CPUCore<T>::executeInstructions2()
 {
 	checkNoCurrentFlags();
 #ifdef USE_COMPUTED_GOTO
@@ -885,7 +900,9 @@ void CPUCore<T>::executeInstructions()
 	setPC(getPC() + ii.length); \
 	T::add(ii.cycles); \
 	T::R800Refresh(*this); \
+	if constexpr (PROFILE) profilePost(); \
 	if (likely(!T::limitReached())) { \
+		if constexpr (PROFILE) profilePre(); \
 		incR(1); \
 		unsigned address = getPC(); \
 		const byte* line = readCacheLine[address >> CacheLine::BITS]; \
@@ -905,6 +922,7 @@ void CPUCore<T>::executeInstructions()
 	setPC(getPC() + ii.length); \
 	T::add(ii.cycles); \
 	T::R800Refresh(*this); \
+	if constexpr (PROFILE) profilePost(); \
 	assert(T::limitReached()); \
 	return;
 
@@ -912,6 +930,7 @@ void CPUCore<T>::executeInstructions()
 	setPC(getPC() + ii.length); \
 	T::add(ii.cycles); \
 	/* !! NO T::R800Refresh(*this); !! */ \
+	if constexpr (PROFILE) profilePost(); \
 	assert(T::limitReached()); \
 	return;
 
@@ -924,6 +943,7 @@ void CPUCore<T>::executeInstructions()
 	setPC(getPC() + ii.length); \
 	T::add(ii.cycles); \
 	T::R800Refresh(*this); \
+	if constexpr (PROFILE) profilePost(); \
 	if (likely(!T::limitReached())) { \
 		goto start; \
 	} \
@@ -933,6 +953,7 @@ void CPUCore<T>::executeInstructions()
 	setPC(getPC() + ii.length); \
 	T::add(ii.cycles); \
 	T::R800Refresh(*this); \
+	if constexpr (PROFILE) profilePost(); \
 	assert(T::limitReached()); \
 	return;
 
@@ -940,6 +961,7 @@ void CPUCore<T>::executeInstructions()
 	setPC(getPC() + ii.length); \
 	T::add(ii.cycles); \
 	/* !! NO T::R800Refresh(*this); !! */ \
+	if constexpr (PROFILE) profilePost(); \
 	assert(T::limitReached()); \
 	return;
 
@@ -950,6 +972,7 @@ void CPUCore<T>::executeInstructions()
 #ifndef USE_COMPUTED_GOTO
 start:
 #endif
+	if constexpr (PROFILE) profilePre();
 	unsigned ixy; // for dd_cb/fd_cb
 	byte opcodeMain = RDMEM_OPCODE<0>(T::CC_MAIN);
 	incR(1);
@@ -2444,6 +2467,22 @@ template<typename T> inline void CPUCore<T>::cpuTracePost()
 		cpuTracePost_slow();
 	}
 }
+template<typename T> void CPUCore<T>::profilePre()
+{
+	// slot can change during the instruction, so look it up before
+	profilePC = getPC();
+	int page = profilePC >> 14;
+	profilePs = interface->getPrimarySlot(page);
+	profileSs = interface->getSecondarySlot(page);
+	profileStartTime = T::getTimeFast();
+}
+template<typename T> void CPUCore<T>::profilePost(unsigned count)
+{
+	// (a Tcl callback could have stopped the profiler in the meantime)
+	if (unlikely(profiler == nullptr)) return;
+	unsigned ticks = (T::getTimeFast() - profileStartTime) / T::getPeriod();
+	profiler->record(profilePs, profileSs, word(profilePC), ticks, count);
+}
 template<typename T> void CPUCore<T>::cpuTracePost_slow()
 {
 	byte opBuf[4];
@@ -2471,9 +2510,18 @@ template<typename T> ExecIRQ CPUCore<T>::getExecIRQ() const
 
 template<typename T> void CPUCore<T>::executeSlow(ExecIRQ execIRQ)
 {
+	// Accepting an IRQ or NMI is recorded as an instruction on the address
+	// where it happened (like the RST instruction the Z80 executes
+	// instead of the instruction at that address). The instructions in
+	// HALT mode are recorded on the address after the HALT instruction.
+	bool profiling = unlikely(profiler != nullptr) && (
+		(execIRQ != ExecIRQ::NONE) || getHALT());
+	if (profiling) profilePre();
+
 	if (unlikely(execIRQ == ExecIRQ::NMI)) {
 		nmiEdge = false;
 		nmi(); // NMI occurred
+		if (profiling) profilePost();
 	} else if (unlikely(execIRQ == ExecIRQ::IRQ)) {
 		// normal interrupt
 		if (unlikely(prevWasLDAI())) {
@@ -2508,9 +2556,12 @@ template<typename T> void CPUCore<T>::executeSlow(ExecIRQ execIRQ)
 			default:
 				UNREACHABLE;
 		}
+		if (profiling) profilePost();
 	} else if (unlikely(getHALT())) {
 		// in halt mode
-		incR(T::advanceHalt(T::haltStates(), scheduler.getNext()));
+		unsigned haltStates = T::advanceHalt(T::haltStates(), scheduler.getNext());
+		incR(haltStates);
+		if (profiling) profilePost(haltStates);
 		setSlowInstructions();
 	} else {
 		cpuTracePre();
@@ -3971,12 +4022,89 @@ template<typename T> template<typename COND> II CPUCore<T>::jr(COND cond) {
 		}
 		setPC((getPC() + 2 + ofst) & 0xFFFF); /**/
 		T::setMemPtr(getPC());
+		if (!T::isR800() && !profiler && ((ofst == -6) || (ofst == -3))) {
+			skipIdleLoop();
+		}
 		return {0/*2*/, T::CC_JR_A};
 	} else {
 		return {2, T::CC_JR_B};
 	}
 }
 
+// Detect a busy-wait loop that polls a memory location, e.g.
+//     loop: ld a,(nn) ; or a ; jr z,loop
+//     loop: cp (hl)   ; jr nz,loop
+// and skip ahead over as many iterations as fit before the next sync point.
+// Called right after such a 'jr' jumped back to 'loop' (PC already points
+// to 'loop').
+//
+// This is exact: between two sync points no device code runs and no IRQ
+// can be accepted, and all involved bytes are read via cached memory (so
+// without side effects and not watched by the debugger). So as long as the
+// polled value doesn't change, the outcome of each iteration is fixed.
+// Only whole iterations are skipped, and only those that would have
+// completed before the limit is reached. So the clock, the R register and
+// the other registers end up exactly as if each instruction had been
+// executed.
+//
+// Only for Z80: on R800 the page-break and refresh timing depends on more
+// than just the instruction sequence. And not while profiling: the profiler
+// must see each executed instruction.
+template<typename T> NEVER_INLINE void CPUCore<T>::skipIdleLoop()
+{
+	assert(!T::isR800());
+	auto peek = [&](unsigned address) -> int {
+		address &= 0xFFFF;
+		const byte* line = readCacheLine[address >> CacheLine::BITS];
+		return (uintptr_t(line) > 1) ? line[address] : -1;
+	};
+	auto jrTaken = [](byte jrOpcode, bool zero) {
+		return (jrOpcode == 0x28) ? zero : !zero; // jr z / jr nz
+	};
+
+	unsigned pc = getPC();
+	int op = peek(pc);
+	if (op == 0x3A) {
+		// ld a,(nn) ; or a / and a ; jr z/nz,loop
+		if ((peek(pc + 5) != 0xFA) ||
+		    ((peek(pc + 3) != 0xB7) && (peek(pc + 3) != 0xA7))) return;
+		int jrOp = peek(pc + 4);
+		if ((jrOp != 0x20) && (jrOp != 0x28)) return;
+		int lo = peek(pc + 1);
+		int hi = peek(pc + 2);
+		if ((lo < 0) || (hi < 0)) return;
+		unsigned addr = lo + (hi << 8);
+		int value = peek(addr);
+		if ((value < 0) || !jrTaken(byte(jrOp), value == 0)) return;
+
+		constexpr int ITERATION = T::CC_LD_A_NN + T::CC_CP_R + T::CC_JR_A;
+		int n = T::getRemainingTicks() / ITERATION;
+		if (n <= 0) return;
+		T::add(n * ITERATION);
+		incR(byte(3 * n));
+		setA(byte(value));
+		if (peek(pc + 3) == 0xB7) {
+			or_a();
+		} else {
+			and_a();
+		}
+	} else if (op == 0xBE) {
+		// cp (hl) ; jr z/nz,loop
+		if (peek(pc + 2) != 0xFD) return;
+		int jrOp = peek(pc + 1);
+		if ((jrOp != 0x20) && (jrOp != 0x28)) return;
+		int value = peek(getHL());
+		if ((value < 0) || !jrTaken(byte(jrOp), value == getA())) return;
+
+		constexpr int ITERATION = T::CC_CP_XHL + T::CC_JR_A;
+		int n = T::getRemainingTicks() / ITERATION;
+		if (n <= 0) return;
+		T::add(n * ITERATION);
+		incR(byte(2 * n));
+		CP(byte(value));
+	}
+}
+
 // DJNZ e
 template<typename T> II CPUCore<T>::djnz() {
 	byte b = getB() - 1;
@@ -4093,7 +4221,7 @@ template<typename T> II CPUCore<T>::cpir() { return BLOCK_CP( 1, true ); }
 
 
 // block LD
-template<typename T> inline II CPUCore<T>::BLOCK_LD(int increase, bool repeat) {
+template<typename T> inline void CPUCore<T>::blockLD(int increase) {
 	byte val = RDMEM(getHL(), T::CC_LDI_1);
 	WRMEM(getDE(), val, T::CC_LDI_2);
 	setHL(getHL() + increase);
@@ -4108,7 +4236,11 @@ template<typename T> inline II CPUCore<T>::BLOCK_LD(int increase, bool repeat) {
 		f |= (getA() + val) & X_FLAG;        // bit 3 -> flag 3
 	}
 	setF(f);
+}
+template<typename T> inline II CPUCore<T>::BLOCK_LD(int increase, bool repeat) {
+	blockLD(increase);
 	if (repeat && getBC()) {
+		if (!T::isR800() && !profiler) repeatBlockLD(increase);
 		//setPC(getPC() - 2);
 		T::setMemPtr(getPC() + 1);
 		return {-1/*1*/, T::CC_LDIR};
@@ -4123,7 +4255,7 @@ template<typename T> II CPUCore<T>::ldir() { return BLOCK_LD( 1, true ); }
 
 
 // block IN
-template<typename T> inline II CPUCore<T>::BLOCK_IN(int increase, bool repeat) {
+template<typename T> inline void CPUCore<T>::blockIn(int increase) {
 	// TODO R800 flags
 	if (T::isR800()) T::waitForEvenCycle(T::CC_INI_1);
 	T::setMemPtr(getBC() + increase);
@@ -4137,7 +4269,11 @@ template<typename T> inline II CPUCore<T>::BLOCK_IN(int increase, bool repeat) {
 	       ((k & 0x100) ? (H_FLAG | C_FLAG) : 0) |
 	       table.ZSXY[b] |
 	       (table.ZSPXY[(k & 0x07) ^ b] & P_FLAG));
-	if (repeat && b) {
+}
+template<typename T> inline II CPUCore<T>::BLOCK_IN(int increase, bool repeat) {
+	blockIn(increase);
+	if (repeat && getB()) {
+		if (!T::isR800() && !profiler) repeatBlockIn(increase);
 		//setPC(getPC() - 2);
 		return {-1/*1*/, T::CC_INIR};
 	} else {
@@ -4151,7 +4287,7 @@ template<typename T> II CPUCore<T>::inir() { return BLOCK_IN( 1, true ); }
 
 
 // block OUT
-template<typename T> inline II CPUCore<T>::BLOCK_OUT(int increase, bool repeat) {
+template<typename T> inline void CPUCore<T>::blockOut(int increase) {
 	// TODO R800 flags
 	byte val = RDMEM(getHL(), T::CC_OUTI_1);
 	setHL(getHL() + increase);
@@ -4165,7 +4301,11 @@ template<typename T> inline II CPUCore<T>::BLOCK_OUT(int increase, bool repeat)
 	       ((k & 0x100) ? (H_FLAG | C_FLAG) : 0) |
 	       table.ZSXY[b] |
 	       (table.ZSPXY[(k & 0x07) ^ b] & P_FLAG));
-	if (repeat && b) {
+}
+template<typename T> inline II CPUCore<T>::BLOCK_OUT(int increase, bool repeat) {
+	blockOut(increase);
+	if (repeat && getB()) {
+		if (!T::isR800() && !profiler) repeatBlockOut(increase);
 		//setPC(getPC() - 2);
 		return {-1/*1*/, T::CC_OTIR};
 	} else {
@@ -4178,6 +4318,129 @@ template<typename T> II CPUCore<T>::otdr() { return BLOCK_OUT(-1, true ); }
 template<typename T> II CPUCore<T>::otir() { return BLOCK_OUT( 1, true ); }
 
 
+// Repeated block instructions (LDIR, INIR, OTIR, ...) normally execute one
+// iteration per pass through the main CPU loop: the instruction jumps back
+// to itself, so each iteration refetches and redispatches the opcode, and
+// the limit (sync points, IRQs, ...) is checked in between. The functions
+// below run as many of the following iterations as possible directly,
+// with exactly the same result:
+//  - Only iterations that would start before the limit is reached are
+//    executed (the limit is rechecked after each I/O access, because a
+//    device can move the next sync point or raise an IRQ).
+//  - The opcode bytes must be in cached memory (so refetching them has no
+//    side effects) and must still contain the same instruction (the block
+//    instruction might have overwritten itself).
+//  - The last iteration is left for the normal code path, so the instruction
+//    termination is handled as before.
+//  - Clock and R register are advanced as if each iteration was fetched.
+// This is only done for Z80. On R800 the timing of these instructions also
+// depends on page-breaks. It's also not done while profiling, then each
+// iteration is recorded as a separate instruction.
+
+template<typename T> inline const byte* CPUCore<T>::getCachedReadPtr(unsigned address) const
+{
+	address &= 0xFFFF;
+	const byte* line = readCacheLine[address >> CacheLine::BITS];
+	return (uintptr_t(line) > 1) ? &line[address] : nullptr;
+}
+
+// The block instruction (prefix 'ED' at PC-1, 'edOpcode' at PC) would be
+// refetched from cached memory.
+template<typename T> inline bool CPUCore<T>::refetchesBlockOp(byte edOpcode) const
+{
+	const byte* prefix = getCachedReadPtr(getPC() - 1);
+	const byte* opcode = getCachedReadPtr(getPC());
+	return prefix && opcode && (*prefix == 0xED) && (*opcode == edOpcode);
+}
+
+template<typename T> NEVER_INLINE void CPUCore<T>::repeatBlockLD(int increase)
+{
+	assert(!T::isR800());
+	byte edOpcode = (increase > 0) ? 0xB0 : 0xB8; // LDIR / LDDR
+	auto bytesInLine = [&](unsigned address) {
+		return (increase > 0) ? int(CacheLine::SIZE - (address & CacheLine::LOW))
+		                      : int((address & CacheLine::LOW) + 1);
+	};
+	while ((getBC() > 1) && refetchesBlockOp(edOpcode)) {
+		int n = std::min(T::getRemainingTicks() / int(T::CC_LDIR), int(getBC() - 1));
+		if (n <= 0) return;
+		unsigned src = getHL();
+		unsigned dst = getDE();
+		const byte* srcLine = readCacheLine[src >> CacheLine::BITS];
+		byte* dstLine = writeCacheLine[dst >> CacheLine::BITS];
+		if ((uintptr_t(srcLine) <= 1) || (uintptr_t(dstLine) <= 1)) return;
+		n = std::min({n, bytesInLine(src), bytesInLine(dst)});
+
+		// Copy the first 'n - 1' bytes in bulk, the last one (and the
+		// flags) via blockLD().
+		const byte* s = &srcLine[src];
+		byte* d = &dstLine[dst];
+		auto lowest = [&](const byte* p, int count) {
+			return uintptr_t(p) - ((increase > 0) ? 0 : (count - 1));
+		};
+		auto codeInDst = [&](unsigned address) {
+			auto c = uintptr_t(getCachedReadPtr(address));
+			auto lo = lowest(d, n);
+			return (lo <= c) && (c < lo + n);
+		};
+		if (codeInDst(getPC() - 1) || codeInDst(getPC())) {
+			// overwrites itself, go one iteration at a time
+			n = 1;
+		}
+		int m = n - 1;
+		if (m > 0) {
+			auto srcLo = lowest(s, m);
+			auto dstLo = lowest(d, m);
+			auto* dstPtr = reinterpret_cast<byte*>(dstLo);
+			bool replicate = (increase > 0)
+			               ? ((srcLo < dstLo) && (dstLo < srcLo + m))
+			               : ((dstLo < srcLo) && (srcLo < dstLo + m));
+			if (!replicate) {
+				memmove(dstPtr, reinterpret_cast<const byte*>(srcLo), m);
+			} else if (uintptr_t(d) == uintptr_t(s) + increase) {
+				// typical fill: LDIR with DE = HL + 1
+				memset(dstPtr, *s, m);
+			} else {
+				// repeating pattern
+				for (int i = 0; i < m; ++i) {
+					d[i * increase] = s[i * increase];
+				}
+			}
+			setHL(src + m * increase);
+			setDE(dst + m * increase);
+			setBC(getBC() - m);
+		}
+		T::add(n * T::CC_LDIR);
+		incR(byte(2 * n));
+		blockLD(increase);
+	}
+}
+
+template<typename T> NEVER_INLINE void CPUCore<T>::repeatBlockIn(int increase)
+{
+	assert(!T::isR800());
+	byte edOpcode = (increase > 0) ? 0xB2 : 0xBA; // INIR / INDR
+	while ((getB() > 1) && refetchesBlockOp(edOpcode) &&
+	       (T::getRemainingTicks() >= int(T::CC_INIR))) {
+		T::add(T::CC_INIR);
+		incR(2);
+		blockIn(increase);
+	}
+}
+
+template<typename T> NEVER_INLINE void CPUCore<T>::repeatBlockOut(int increase)
+{
+	assert(!T::isR800());
+	byte edOpcode = (increase > 0) ? 0xB3 : 0xBB; // OTIR / OTDR
+	while ((getB() > 1) && refetchesBlockOp(edOpcode) &&
+	       (T::getRemainingTicks() >= int(T::CC_OTIR))) {
+		T::add(T::CC_OTIR);
+		incR(2);
+		blockOut(increase);
+	}
+}
+
+
 // various
 template<typename T> II CPUCore<T>::nop() { return {1, T::CC_NOP}; }
 template<typename T> II CPUCore<T>::ccf() {
@@ -16,6 +16,7 @@
 namespace openmsx {
 
 class MSXCPUInterface;
+class CPUProfiler;
 class Scheduler;
 class MSXMotherBoard;
 class TclCallback;
@@ -55,6 +56,11 @@ public:
 
 	void setInterface(MSXCPUInterface* interf) { interface = interf; }
 
+	/** Start (non-nullptr) or stop (nullptr) collecting profile data.
+	  * While profiling, the instructions are executed by a variant of
+	  * executeInstructions() that records each of them. */
+	void setProfiler(CPUProfiler* profiler_) { profiler = profiler_; }
+
 	/**
 	 * Reset the CPU.
 	 */
@@ -165,6 +171,12 @@ private:
 	/** In sync with traceSetting.getBoolean(). */
 	bool tracingEnabled;
 
+	/** nullptr when not profiling. */
+	CPUProfiler* profiler = nullptr;
+	EmuTime profileStartTime = EmuTime::zero();
+	unsigned profilePC; // address of the current instruction
+	int profilePs, profileSs; // slot of the current instruction
+
 	/** 'normal' Z80 and Z80 in a turboR behave slightly different */
 	const bool isTurboR;
 
@@ -172,6 +184,8 @@ private:
 	inline void cpuTracePre();
 	inline void cpuTracePost();
 	void cpuTracePost_slow();
+	void profilePre();
+	void profilePost(unsigned count = 1);
 
 	inline byte READ_PORT(unsigned port, unsigned cc);
 	inline void WRITE_PORT(unsigned port, byte value, unsigned cc);
@@ -214,7 +228,8 @@ private:
 	template<bool PRE_PB, bool POST_PB>
 	inline void WR_WORD_rev (unsigned address, unsigned value, unsigned cc);
 
-	void executeInstructions();
+	inline void executeInstructions();
+	template<bool PROFILE> void executeInstructions2();
 	inline void nmi();
 	inline void irq0();
 	inline void irq1();
@@ -419,6 +434,7 @@ private:
 	template<Reg16 REG, int EE> inline II jp_SS();
 	template<typename COND> inline II jp(COND cond);
 	template<typename COND> inline II jr(COND cond);
+	void skipIdleLoop();
 	inline II djnz();
 
 	template<Reg16 REG, int EE> inline II ex_xsp_SS();
@@ -435,19 +451,28 @@ private:
 	inline II cpdr();
 	inline II cpir();
 
+	inline void blockLD(int increase);
 	inline II BLOCK_LD(int increase, bool repeat);
+	void repeatBlockLD(int increase);
 	inline II ldd();
 	inline II ldi();
 	inline II lddr();
 	inline II ldir();
 
+	inline void blockIn(int increase);
 	inline II BLOCK_IN(int increase, bool repeat);
+	void repeatBlockIn(int increase);
 	inline II ind();
 	inline II ini();
 	inline II indr();
 	inline II inir();
 
+	inline void blockOut(int increase);
 	inline II BLOCK_OUT(int increase, bool repeat);
+	void repeatBlockOut(int increase);
+
+	[[nodiscard]] inline const byte* getCachedReadPtr(unsigned address) const;
+	[[nodiscard]] inline bool refetchesBlockOp(byte edOpcode) const;
 	inline II outd();
 	inline II outi();
 	inline II otdr();
@@ -0,0 +1,55 @@
+#include "CPUProfiler.hh"
+#include "File.hh"
+#include "endian.hh"
+#include <cstring>
+#include <vector>
+
+namespace openmsx {
+
+void CPUProfiler::clear()
+{
+	for (auto& table : tables) {
+		table.reset();
+	}
+}
+
+void CPUProfiler::save(const std::string& filename) const
+{
+	struct Header {
+		char magic[8];
+		Endian::L32 version;
+		Endian::L32 numRecords;
+	};
+	struct Record {
+		byte ps;
+		byte ss;
+		Endian::L16 pc;
+		Endian::L32 reserved;
+		Endian::L64 count;
+		Endian::L64 ticks;
+	};
+	static_assert(sizeof(Header) == 16);
+	static_assert(sizeof(Record) == 24);
+
+	std::vector<Record> records;
+	forEach([&](int ps, int ss, word pc, const Counter& counter) {
+		Record& r = records.emplace_back();
+		r.ps = byte(ps);
+		r.ss = byte(ss); // -1 -> 255
+		r.pc = pc;
+		r.reserved = 0;
+		r.count = counter.count;
+		r.ticks = counter.ticks;
+	});
+
+	Header header;
+	memcpy(header.magic, "OMSXPROF", 8);
+	header.version = 1;
+	header.numRecords = uint32_t(records.size());
+
+	File file(filename, File::TRUNCATE);
+	file.write(&header, sizeof(header));
+	file.write(records.data(), records.size() * sizeof(Record));
+}
+
+} // namespace openmsx
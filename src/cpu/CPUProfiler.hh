@@ -0,0 +1,88 @@
+#ifndef CPUPROFILER_HH
+#define CPUPROFILER_HH
+
+#include "openmsx.hh"
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace openmsx {
+
+/** Accumulates, per executed instruction address, how many times an
+  * instruction was executed and how many CPU clock cycles it took.
+  *
+  * The counters are kept per (primary, secondary) slot, so that e.g. code in
+  * different ROMs that's mapped on the same address can be distinguished.
+  * Counting is done by CPUCore (while profiling is active it runs a variant
+  * of its instruction loop that records every instruction), the results can
+  * be retrieved via the 'debug profile' command.
+  */
+class CPUProfiler
+{
+public:
+	struct Counter {
+		uint64_t count = 0; // number of executed instructions
+		uint64_t ticks = 0; // total number of CPU clock cycles
+	};
+
+	/** Record the execution of one (or more) instruction(s).
+	  * @param ps Primary slot (0-3).
+	  * @param ss Secondary slot (0-3), or -1 if 'ps' is not expanded.
+	  * @param pc Start address of the instruction.
+	  * @param ticks Duration of the instruction(s) in CPU clock cycles.
+	  * @param count Number of executed instructions (e.g. while halted).
+	  */
+	void record(int ps, int ss, word pc, unsigned ticks, unsigned count = 1)
+	{
+		auto& table = tables[slotIndex(ps, ss)];
+		if (!table) table = std::make_unique<Counter[]>(0x10000);
+		auto& counter = table[pc];
+		counter.count += count;
+		counter.ticks += ticks;
+	}
+
+	/** Reset all counters. */
+	void clear();
+
+	/** Call the given function for all counters with a non-zero count, as
+	  * op(ps, ss, pc, counter). The calls are ordered on slot and address. */
+	template<typename Op> void forEach(Op op) const
+	{
+		for (int ps = 0; ps < 4; ++ps) {
+			for (int ss = -1; ss < 4; ++ss) {
+				const auto& table = tables[slotIndex(ps, ss)];
+				if (!table) continue;
+				for (unsigned pc = 0; pc < 0x10000; ++pc) {
+					if (table[pc].count) op(ps, ss, word(pc), table[pc]);
+				}
+			}
+		}
+	}
+
+	/** Write all non-zero counters to a binary file.
+	  * The file starts with the 8 characters "OMSXPROF" followed by a
+	  * 32-bit version number (currently 1) and the 32-bit number of
+	  * records. Each record is 24 bytes: primary slot (1 byte), secondary
+	  * slot (1 byte, 255 when not expanded), address (16-bit), 4 reserved
+	  * bytes, instruction count (64-bit) and clock cycles (64-bit). All
+	  * multi-byte values are little endian.
+	  * @throws FileException
+	  */
+	void save(const std::string& filename) const;
+
+private:
+	[[nodiscard]] static int slotIndex(int ps, int ss)
+	{
+		assert((0 <= ps) && (ps < 4));
+		assert((-1 <= ss) && (ss < 4));
+		return 5 * ps + (ss + 1);
+	}
+
+	// allocated on first use
+	std::unique_ptr<Counter[]> tables[4 * 5];
+};
+
+} // namespace openmsx
+
+#endif
@@ -0,0 +1,633 @@
+#include "CompiledCondition.hh"
+#include "CPURegs.hh"
+#include "StringOp.hh"
+#include "unreachable.hh"
+#include <cassert>
+#include <cstdint>
+#include <limits>
+
+namespace openmsx {
+
+enum Reg : int64_t {
+	REG_A, REG_F, REG_B, REG_C, REG_D, REG_E, REG_H, REG_L,
+	REG_A2, REG_F2, REG_B2, REG_C2, REG_D2, REG_E2, REG_H2, REG_L2,
+	REG_IXH, REG_IXL, REG_IYH, REG_IYL, REG_PCH, REG_PCL, REG_SPH, REG_SPL,
+	REG_I, REG_R, REG_IM, REG_IFF,
+	REG_AF, REG_BC, REG_DE, REG_HL, REG_AF2, REG_BC2, REG_DE2, REG_HL2,
+	REG_IX, REG_IY, REG_PC, REG_SP,
+};
+
+// Same names as accepted by the 'reg' proc (see share/scripts/_cpuregs.tcl).
+static constexpr std::pair<std::string_view, Reg> regNames[] = {
+	{"A",   REG_A},   {"F",   REG_F},   {"B",   REG_B},   {"C",   REG_C},
+	{"D",   REG_D},   {"E",   REG_E},   {"H",   REG_H},   {"L",   REG_L},
+	{"A2",  REG_A2},  {"F2",  REG_F2},  {"B2",  REG_B2},  {"C2",  REG_C2},
+	{"D2",  REG_D2},  {"E2",  REG_E2},  {"H2",  REG_H2},  {"L2",  REG_L2},
+	{"IXH", REG_IXH}, {"IXL", REG_IXL}, {"IYH", REG_IYH}, {"IYL", REG_IYL},
+	{"PCH", REG_PCH}, {"PCL", REG_PCL}, {"SPH", REG_SPH}, {"SPL", REG_SPL},
+	{"I",   REG_I},   {"R",   REG_R},   {"IM",  REG_IM},  {"IFF", REG_IFF},
+	{"AF",  REG_AF},  {"BC",  REG_BC},  {"DE",  REG_DE},  {"HL",  REG_HL},
+	{"AF2", REG_AF2}, {"BC2", REG_BC2}, {"DE2", REG_DE2}, {"HL2", REG_HL2},
+	{"IX",  REG_IX},  {"IY",  REG_IY},  {"PC",  REG_PC},  {"SP",  REG_SP},
+};
+
+static int64_t readRegister(const CPURegs& regs, int64_t reg)
+{
+	switch (reg) {
+	case REG_A:   return regs.getA();
+	case REG_F:   return regs.getF();
+	case REG_B:   return regs.getB();
+	case REG_C:   return regs.getC();
+	case REG_D:   return regs.getD();
+	case REG_E:   return regs.getE();
+	case REG_H:   return regs.getH();
+	case REG_L:   return regs.getL();
+	case REG_A2:  return regs.getA2();
+	case REG_F2:  return regs.getF2();
+	case REG_B2:  return regs.getB2();
+	case REG_C2:  return regs.getC2();
+	case REG_D2:  return regs.getD2();
+	case REG_E2:  return regs.getE2();
+	case REG_H2:  return regs.getH2();
+	case REG_L2:  return regs.getL2();
+	case REG_IXH: return regs.getIXh();
+	case REG_IXL: return regs.getIXl();
+	case REG_IYH: return regs.getIYh();
+	case REG_IYL: return regs.getIYl();
+	case REG_PCH: return regs.getPCh();
+	case REG_PCL: return regs.getPCl();
+	case REG_SPH: return regs.getSPh();
+	case REG_SPL: return regs.getSPl();
+	case REG_I:   return regs.getI();
+	case REG_R:   return regs.getR();
+	case REG_IM:  return regs.getIM();
+	case REG_IFF: return 1 *  regs.getIFF1() + // same as 'CPU regs' debuggable
+	                     2 *  regs.getIFF2() +
+	                     4 * (regs.getIFF1() && !regs.prevWasEI());
+	case REG_AF:  return regs.getAF();
+	case REG_BC:  return regs.getBC();
+	case REG_DE:  return regs.getDE();
+	case REG_HL:  return regs.getHL();
+	case REG_AF2: return regs.getAF2();
+	case REG_BC2: return regs.getBC2();
+	case REG_DE2: return regs.getDE2();
+	case REG_HL2: return regs.getHL2();
+	case REG_IX:  return regs.getIX();
+	case REG_IY:  return regs.getIY();
+	case REG_PC:  return regs.getPC();
+	case REG_SP:  return regs.getSP();
+	default: UNREACHABLE; return 0;
+	}
+}
+
+
+// Recursive descent parser for (a subset of) the Tcl expression syntax. The
+// operator precedence is the same as in Tcl.
+class CompiledCondition::Parser
+{
+public:
+	struct Unsupported {};
+
+	explicit Parser(std::string_view expr_) : expr(expr_) {}
+
+	std::vector<Instruction> parse()
+	{
+		parseTernary();
+		skipSpace();
+		if (pos != expr.size()) throw Unsupported();
+		assert(depth == 1);
+		return std::move(code);
+	}
+
+private:
+	// 'pc_in_slot' returns either "0" or "true". That's fine as a boolean,
+	// but e.g. '[pc_in_slot 1] == 1' compares the strings "true" and "1".
+	// So only allow such values where Tcl interprets them as a boolean.
+	enum Kind { INT, BOOL_STRING };
+
+	void skipSpace()
+	{
+		while ((pos < expr.size()) &&
+		       ((expr[pos] == ' ')  || (expr[pos] == '\t') ||
+		        (expr[pos] == '\n') || (expr[pos] == '\r'))) {
+			++pos;
+		}
+	}
+	// Inside a command a newline would start a new command.
+	void skipBlanks()
+	{
+		while ((pos < expr.size()) &&
+		       ((expr[pos] == ' ') || (expr[pos] == '\t'))) {
+			++pos;
+		}
+	}
+	[[nodiscard]] bool match(std::string_view token)
+	{
+		skipSpace();
+		if (expr.substr(pos, token.size()) != token) return false;
+		pos += token.size();
+		return true;
+	}
+	// Match a single character operator that is not the start of a
+	// longer operator, e.g. '&' but not '&&'.
+	[[nodiscard]] bool matchSingle(char c, char notFollowedBy1, char notFollowedBy2 = '\0')
+	{
+		skipSpace();
+		if ((pos >= expr.size()) || (expr[pos] != c)) return false;
+		if (pos + 1 < expr.size()) {
+			char next = expr[pos + 1];
+			if ((next == notFollowedBy1) ||
+			    (notFollowedBy2 && (next == notFollowedBy2))) {
+				return false;
+			}
+		}
+		++pos;
+		return true;
+	}
+	static void requireInt(Kind kind)
+	{
+		if (kind != INT) throw Unsupported();
+	}
+
+	size_t emit(Op op, int64_t arg = 0)
+	{
+		switch (op) {
+		case Op::CONSTANT: case Op::REG: case Op::PC_IN_SLOT:
+			++depth;
+			break;
+		case Op::MUL: case Op::DIV: case Op::MOD: case Op::ADD:
+		case Op::SUB: case Op::SHL: case Op::SHR: case Op::LT:
+		case Op::GT:  case Op::LE:  case Op::GE:  case Op::EQ:
+		case Op::NE:  case Op::AND: case Op::XOR: case Op::OR:
+		case Op::JUMP_IF_FALSE:
+			--depth;
+			break;
+		default:
+			break;
+		}
+		maxDepth = std::max(maxDepth, depth);
+		if (maxDepth > MAX_STACK) throw Unsupported();
+		code.push_back({op, arg});
+		return code.size() - 1;
+	}
+	void patch(size_t instr)
+	{
+		code[instr].arg = int64_t(code.size());
+	}
+
+	Kind parseTernary()
+	{
+		auto kind = parseLogicalOr();
+		if (!match("?")) return kind;
+		auto jumpFalse = emit(Op::JUMP_IF_FALSE);
+		auto kind1 = parseTernary();
+		if (!match(":")) throw Unsupported();
+		auto jumpEnd = emit(Op::JUMP);
+		patch(jumpFalse);
+		--depth; // only one of both branches gets executed
+		auto kind2 = parseTernary();
+		patch(jumpEnd);
+		return ((kind1 == INT) && (kind2 == INT)) ? INT : BOOL_STRING;
+	}
+
+	Kind parseLogicalOr()
+	{
+		auto kind = parseLogicalAnd();
+		while (match("||")) {
+			auto jump = emit(Op::OR_ELSE);
+			--depth; // popped when not short-circuited
+			parseLogicalAnd();
+			emit(Op::TO_BOOL);
+			patch(jump);
+			kind = INT;
+		}
+		return kind;
+	}
+
+	Kind parseLogicalAnd()
+	{
+		auto kind = parseBitOr();
+		while (match("&&")) {
+			auto jump = emit(Op::AND_THEN);
+			--depth; // popped when not short-circuited
+			parseBitOr();
+			emit(Op::TO_BOOL);
+			patch(jump);
+			kind = INT;
+		}
+		return kind;
+	}
+
+	Kind parseBitOr()
+	{
+		auto kind = parseBitXor();
+		while (matchSingle('|', '|')) {
+			requireInt(kind);
+			requireInt(parseBitXor());
+			emit(Op::OR);
+		}
+		return kind;
+	}
+
+	Kind parseBitXor()
+	{
+		auto kind = parseBitAnd();
+		while (match("^")) {
+			requireInt(kind);
+			requireInt(parseBitAnd());
+			emit(Op::XOR);
+		}
+		return kind;
+	}
+
+	Kind parseBitAnd()
+	{
+		auto kind = parseEquality();
+		while (matchSingle('&', '&')) {
+			requireInt(kind);
+			requireInt(parseEquality());
+			emit(Op::AND);
+		}
+		return kind;
+	}
+
+	Kind parseEquality()
+	{
+		auto kind = parseRelational();
+		while (true) {
+			Op op;
+			if      (match("==")) op = Op::EQ;
+			else if (match("!=")) op = Op::NE;
+			else return kind;
+			requireInt(kind);
+			requireInt(parseRelational());
+			emit(op);
+		}
+	}
+
+	Kind parseRelational()
+	{
+		auto kind = parseShift();
+		while (true) {
+			Op op;
+			if      (match("<=")) op = Op::LE;
+			else if (match(">=")) op = Op::GE;
+			else if (matchSingle('<', '<')) op = Op::LT;
+			else if (matchSingle('>', '>')) op = Op::GT;
+			else return kind;
+			requireInt(kind);
+			requireInt(parseShift());
+			emit(op);
+		}
+	}
+
+	Kind parseShift()
+	{
+		auto kind = parseAdditive();
+		while (true) {
+			Op op;
+			if      (match("<<")) op = Op::SHL;
+			else if (match(">>")) op = Op::SHR;
+			else return kind;
+			requireInt(kind);
+			requireInt(parseAdditive());
+			emit(op);
+		}
+	}
+
+	Kind parseAdditive()
+	{
+		auto kind = parseMultiplicative();
+		while (true) {
+			Op op;
+			if      (match("+")) op = Op::ADD;
+			else if (match("-")) op = Op::SUB;
+			else return kind;
+			requireInt(kind);
+			requireInt(parseMultiplicative());
+			emit(op);
+		}
+	}
+
+	Kind parseMultiplicative()
+	{
+		auto kind = parseUnary();
+		while (true) {
+			Op op;
+			if (match("**")) throw Unsupported();
+			if      (match("*")) op = Op::MUL;
+			else if (match("/")) op = Op::DIV;
+			else if (match("%")) op = Op::MOD;
+			else return kind;
+			requireInt(kind);
+			requireInt(parseUnary());
+			emit(op);
+		}
+	}
+
+	Kind parseUnary()
+	{
+		if (matchSingle('-', '\0')) {
+			requireInt(parseUnary());
+			emit(Op::NEG);
+			return INT;
+		} else if (matchSingle('+', '\0')) {
+			requireInt(parseUnary());
+			return INT;
+		} else if (match("~")) {
+			requireInt(parseUnary());
+			emit(Op::INV);
+			return INT;
+		} else if (matchSingle('!', '=')) {
+			parseUnary();
+			emit(Op::NOT);
+			return INT;
+		}
+		return parsePrimary();
+	}
+
+	Kind parsePrimary()
+	{
+		skipSpace();
+		if (pos >= expr.size()) throw Unsupported();
+		char c = expr[pos];
+		if (c == '(') {
+			++pos;
+			auto kind = parseTernary();
+			if (!match(")")) throw Unsupported();
+			return kind;
+		} else if (c == '[') {
+			++pos;
+			return parseCommand();
+		} else if (('0' <= c) && (c <= '9')) {
+			size_t begin = pos;
+			while ((pos < expr.size()) && isWordChar(expr[pos])) ++pos;
+			emit(Op::CONSTANT, parseNumber(expr.substr(begin, pos - begin)));
+			return INT;
+		}
+		// variables, strings, function calls, ...
+		throw Unsupported();
+	}
+
+	// Parses the command after the opening '['.
+	Kind parseCommand()
+	{
+		auto name = parseBareWord();
+		Kind kind = INT;
+		if (name == "reg") {
+			auto regName = parseBareWord();
+			emit(Op::REG, lookupRegister(regName));
+		} else if ((name == "peek") || (name == "peek8") || (name == "peek_u8")) {
+			parseAddress(Op::PEEK);
+		} else if ((name == "peek16") || (name == "peek16_LE") ||
+		           (name == "peek_u16") || (name == "peek_u16LE")) {
+			parseAddress(Op::PEEK16);
+		} else if (name == "debug") {
+			if (parseBareWord() != "read")   throw Unsupported();
+			if (parseBareWord() != "memory") throw Unsupported();
+			parseValueWord();
+			emit(Op::PEEK);
+		} else if (name == "pc_in_slot") {
+			int ps = parseSlot();
+			skipBlanks();
+			int ss = (peekChar() == ']') ? -1 : parseSlot();
+			emit(Op::PC_IN_SLOT, 8 * (ps + 1) + (ss + 1));
+			kind = BOOL_STRING;
+		} else {
+			throw Unsupported();
+		}
+		skipBlanks();
+		if (peekChar() != ']') throw Unsupported();
+		++pos;
+		return kind;
+	}
+
+	void parseAddress(Op op)
+	{
+		parseValueWord();
+		skipBlanks();
+		if (peekChar() != ']') {
+			// optional debuggable name, only the default is supported
+			if (parseBareWord() != "memory") throw Unsupported();
+		}
+		emit(op);
+	}
+
+	// A command argument that is either a number or a nested command.
+	void parseValueWord()
+	{
+		skipBlanks();
+		if (peekChar() == '[') {
+			++pos;
+			requireInt(parseCommand());
+		} else {
+			emit(Op::CONSTANT, parseNumber(parseBareWord()));
+		}
+	}
+
+	int parseSlot()
+	{
+		auto w = parseBareWord();
+		if (w == "X") return -1;
+		if ((w.size() == 1) && ('0' <= w[0]) && (w[0] <= '3')) {
+			return w[0] - '0';
+		}
+		throw Unsupported();
+	}
+
+	std::string_view parseBareWord()
+	{
+		skipBlanks();
+		size_t begin = pos;
+		while ((pos < expr.size()) && isWordChar(expr[pos])) ++pos;
+		if (pos == begin) throw Unsupported();
+		// e.g. "$var", "{..}" or "a[b]" are not supported
+		char next = peekChar();
+		if ((next != ' ') && (next != '\t') && (next != ']')) throw Unsupported();
+		return expr.substr(begin, pos - begin);
+	}
+
+	[[nodiscard]] char peekChar() const
+	{
+		return (pos < expr.size()) ? expr[pos] : '\0';
+	}
+
+	static bool isWordChar(char c)
+	{
+		return (('0' <= c) && (c <= '9')) ||
+		       (('a' <= c) && (c <= 'z')) ||
+		       (('A' <= c) && (c <= 'Z')) ||
+		       (c == '_');
+	}
+
+	static int64_t parseNumber(std::string_view s)
+	{
+		// Tcl interprets a leading zero as octal, StringOp doesn't.
+		if ((s.size() > 1) && (s[0] == '0') && ('0' <= s[1]) && (s[1] <= '9')) {
+			throw Unsupported();
+		}
+		auto n = StringOp::stringTo<uint32_t>(s);
+		if (!n || (*n > uint32_t(std::numeric_limits<int32_t>::max()))) {
+			throw Unsupported();
+		}
+		return *n;
+	}
+
+	static Reg lookupRegister(std::string_view name)
+	{
+		for (const auto& [regName, reg] : regNames) {
+			if (StringOp::casecmp()(name, regName)) return reg;
+		}
+		// Tcl would throw an error, let Tcl produce the message.
+		throw Unsupported();
+	}
+
+private:
+	std::string_view expr;
+	size_t pos = 0;
+	std::vector<Instruction> code;
+	int depth = 0;
+	int maxDepth = 0;
+};
+
+std::optional<CompiledCondition> CompiledCondition::compile(std::string_view expr)
+{
+	try {
+		return CompiledCondition(Parser(expr).parse());
+	} catch (Parser::Unsupported&) {
+		return std::nullopt;
+	}
+}
+
+// All intermediate results are kept in 32-bit range. Tcl would switch to
+// wider (or even arbitrary precision) integers, so on overflow we bail out.
+static bool inRange(int64_t x)
+{
+	return (std::numeric_limits<int32_t>::min() <= x) &&
+	       (x <= std::numeric_limits<int32_t>::max());
+}
+
+std::optional<bool> CompiledCondition::evaluate(Context& context) const
+{
+	int64_t stack[MAX_STACK];
+	int sp = 0;
+	size_t ip = 0;
+	size_t end = code.size();
+	while (ip < end) {
+		const auto& instr = code[ip++];
+		switch (instr.op) {
+		case Op::CONSTANT:
+			stack[sp++] = instr.arg;
+			break;
+		case Op::REG:
+			stack[sp++] = readRegister(context.getRegisters(), instr.arg);
+			break;
+		case Op::PEEK: {
+			auto addr = stack[sp - 1];
+			if ((addr < 0) || (addr > 0xFFFF)) return {};
+			stack[sp - 1] = context.peekMem(word(addr));
+			break;
+		}
+		case Op::PEEK16: {
+			auto addr = stack[sp - 1];
+			if ((addr < 0) || (addr > 0xFFFE)) return {};
+			stack[sp - 1] = context.peekMem(word(addr + 0)) +
+			          256 * context.peekMem(word(addr + 1));
+			break;
+		}
+		case Op::PC_IN_SLOT: {
+			// same as the 'pc_in_slot' proc (see share/scripts/_slot.tcl)
+			int ps = int(instr.arg / 8) - 1;
+			int ss = int(instr.arg % 8) - 1;
+			int page = context.getRegisters().getPC() >> 14;
+			auto [pcPs, pcSs] = context.getSlot(page);
+			stack[sp++] = ((ps == -1) || (ps == pcPs)) &&
+			              ((ss == -1) || (pcSs == -1) || (ss == pcSs));
+			break;
+		}
+		case Op::NEG:
+			stack[sp - 1] = -stack[sp - 1];
+			break;
+		case Op::INV:
+			stack[sp - 1] = ~stack[sp - 1];
+			break;
+		case Op::NOT:
+			stack[sp - 1] = stack[sp - 1] == 0;
+			break;
+		case Op::TO_BOOL:
+			stack[sp - 1] = stack[sp - 1] != 0;
+			break;
+		case Op::AND_THEN:
+			if (stack[sp - 1] == 0) {
+				ip = size_t(instr.arg); // result is 0
+			} else {
+				--sp;
+			}
+			break;
+		case Op::OR_ELSE:
+			if (stack[sp - 1] != 0) {
+				stack[sp - 1] = 1;
+				ip = size_t(instr.arg);
+			} else {
+				--sp;
+			}
+			break;
+		case Op::JUMP_IF_FALSE:
+			if (stack[--sp] == 0) ip = size_t(instr.arg);
+			break;
+		case Op::JUMP:
+			ip = size_t(instr.arg);
+			break;
+		default: {
+			// binary operators
+			int64_t b = stack[--sp];
+			int64_t& a = stack[sp - 1];
+			switch (instr.op) {
+			case Op::MUL: a = a * b; break;
+			case Op::DIV:
+			case Op::MOD: {
+				if (b == 0) return {};
+				// Tcl rounds the quotient towards negative infinity
+				int64_t q = a / b;
+				int64_t r = a % b;
+				if ((r != 0) && ((r < 0) != (b < 0))) {
+					--q;
+					r += b;
+				}
+				a = (instr.op == Op::DIV) ? q : r;
+				break;
+			}
+			case Op::ADD: a = a + b; break;
+			case Op::SUB: a = a - b; break;
+			case Op::SHL:
+				if (b < 0) return {};
+				if (a == 0) break;
+				if (b > 32) return {};
+				a = a * (int64_t(1) << b);
+				break;
+			case Op::SHR:
+				if (b < 0) return {};
+				a = (b >= 63) ? ((a < 0) ? -1 : 0) : (a >> b);
+				break;
+			case Op::LT:  a = a <  b; break;
+			case Op::GT:  a = a >  b; break;
+			case Op::LE:  a = a <= b; break;
+			case Op::GE:  a = a >= b; break;
+			case Op::EQ:  a = a == b; break;
+			case Op::NE:  a = a != b; break;
+			case Op::AND: a = a & b; break;
+			case Op::XOR: a = a ^ b; break;
+			case Op::OR:  a = a | b; break;
+			default: UNREACHABLE;
+			}
+			break;
+		}
+		}
+		// (stack can be empty right after a conditional jump)
+		if ((sp > 0) && !inRange(stack[sp - 1])) return {};
+	}
+	assert(sp == 1);
+	return stack[0] != 0;
+}
+
+} // namespace openmsx
@@ -0,0 +1,81 @@
+#ifndef COMPILEDCONDITION_HH
+#define COMPILEDCONDITION_HH
+
+#include "openmsx.hh"
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace openmsx {
+
+class CPURegs;
+
+/** Native evaluation of (simple) debug conditions.
+ *
+ * Breakpoint and debug conditions are Tcl expressions. Evaluating those via
+ * the Tcl interpreter is relatively expensive, and a debug condition gets
+ * evaluated after every emulated instruction. This class compiles the
+ * subset of Tcl expressions that's typically used in such conditions to a
+ * small bytecode program that can be evaluated without entering Tcl:
+ *  - integer constants (decimal, 0x.., 0b..)
+ *  - [reg <name>]  (same register names as the 'reg' proc)
+ *  - [peek <addr>], [peek16 <addr>] and their aliases,
+ *    [debug read memory <addr>]
+ *  - [pc_in_slot <ps> [<ss>]]
+ *  - the arithmetic, bitwise, comparison, logical and ?: operators
+ * The arguments of the commands can be constants or (nested) commands.
+ * Expressions that use anything else (variables, strings, other commands,
+ * ...) are not compiled, the caller should then use Tcl instead.
+ */
+class CompiledCondition
+{
+public:
+	/** Gives access to the state of the emulated machine. */
+	class Context {
+	public:
+		[[nodiscard]] virtual const CPURegs& getRegisters() = 0;
+		[[nodiscard]] virtual byte peekMem(word address) = 0;
+		/** Returns the selected {primary, secondary} slot in the given
+		  * page. Secondary slot is -1 for non-expanded slots. */
+		[[nodiscard]] virtual std::pair<int, int> getSlot(int page) = 0;
+	protected:
+		~Context() = default;
+	};
+
+	/** Returns std::nullopt when the expression is not in the supported
+	  * subset. */
+	[[nodiscard]] static std::optional<CompiledCondition> compile(std::string_view expr);
+
+	/** Returns std::nullopt when the evaluation failed (e.g. an address
+	  * out of range or an integer overflow). The caller should then fall
+	  * back to Tcl (which will also produce a proper error message).
+	  */
+	[[nodiscard]] std::optional<bool> evaluate(Context& context) const;
+
+private:
+	class Parser;
+
+	enum class Op : uint8_t {
+		CONSTANT, REG, PEEK, PEEK16, PC_IN_SLOT,
+		NEG, INV, NOT, TO_BOOL,
+		MUL, DIV, MOD, ADD, SUB, SHL, SHR,
+		LT, GT, LE, GE, EQ, NE, AND, XOR, OR,
+		AND_THEN, OR_ELSE, JUMP_IF_FALSE, JUMP,
+	};
+	struct Instruction {
+		Op op;
+		int64_t arg; // constant, register, slot or jump target
+	};
+	static constexpr int MAX_STACK = 32;
+
+	explicit CompiledCondition(std::vector<Instruction> code_)
+		: code(std::move(code_)) {}
+
+	std::vector<Instruction> code;
+};
+
+} // namespace openmsx
+
+#endif
@@ -344,6 +344,15 @@ CPURegs& MSXCPU::getRegisters()
 	}
 }
 
+void MSXCPU::setProfiling(bool enabled)
+{
+	profiling = enabled;
+	auto* p = enabled ? &profiler : nullptr;
+	          z80 ->setProfiler(p);
+	if (r800) r800->setProfiler(p);
+	exitCPULoopSync();
+}
+
 void MSXCPU::update(const Setting& setting) noexcept
 {
 	          z80 ->update(setting);
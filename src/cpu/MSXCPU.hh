@@ -6,6 +6,7 @@
 #include "Observer.hh"
 #include "BooleanSetting.hh"
 #include "CacheLine.hh"
+#include "CPUProfiler.hh"
 #include "EmuTime.hh"
 #include "TclCallback.hh"
 #include "serialize_meta.hh"
@@ -144,6 +145,13 @@ public:
 
 	[[nodiscard]] CPURegs& getRegisters();
 
+	/** Start or stop collecting profile data (see CPUProfiler). Stopping
+	  * keeps the data collected so far. */
+	void setProfiling(bool enabled);
+	[[nodiscard]] bool isProfiling() const { return profiling; }
+	[[nodiscard]]       CPUProfiler& getProfiler()       { return profiler; }
+	[[nodiscard]] const CPUProfiler& getProfiler() const { return profiler; }
+
 	template<typename Archive>
 	void serialize(Archive& ar, unsigned version);
 
@@ -210,6 +218,9 @@ private:
 	bool newZ80Active;
 
 	MSXCPUInterface* interface = nullptr; // only used for debug
+
+	CPUProfiler profiler;
+	bool profiling = false;
 };
 SERIALIZE_CLASS_VERSION(MSXCPU, 2);
 
@@ -7,6 +7,7 @@
 #include "RealTime.hh"
 #include "MSXMotherBoard.hh"
 #include "MSXCPU.hh"
+#include "CompiledCondition.hh"
 #include "VDPIODelay.hh"
 #include "CliComm.hh"
 #include "MSXMultiIODevice.hh"
@@ -781,15 +782,18 @@ void MSXCPUInterface::writeSlottedMem(unsigned address, byte value,
 
 void MSXCPUInterface::insertBreakPoint(BreakPoint bp)
 {
+	breakPointAddresses[bp.getAddress()] = true;
 	auto it = ranges::upper_bound(breakPoints, bp, CompareBreakpoints());
 	breakPoints.insert(it, std::move(bp));
 }
 
 void MSXCPUInterface::removeBreakPoint(const BreakPoint& bp)
 {
-	auto [first, last] = ranges::equal_range(breakPoints, bp.getAddress(), CompareBreakpoints());
+	word address = bp.getAddress();
+	auto [first, last] = ranges::equal_range(breakPoints, address, CompareBreakpoints());
 	breakPoints.erase(find_if_unguarded(first, last,
 		[&](const BreakPoint& i) { return &i == &bp; }));
+	updateBreakPointAddress(address);
 }
 void MSXCPUInterface::removeBreakPoint(unsigned id)
 {
@@ -797,15 +801,71 @@ void MSXCPUInterface::removeBreakPoint(unsigned id)
 		[&](const BreakPoint& i) { return i.getId() == id; });
 	    // could be ==end for a breakpoint that removes itself AND has the -once flag set
 	    it != breakPoints.end()) {
+		word address = it->getAddress();
 		breakPoints.erase(it);
+		updateBreakPointAddress(address);
 	}
 }
+void MSXCPUInterface::updateBreakPointAddress(word address)
+{
+	breakPointAddresses[address] =
+		ranges::binary_search(breakPoints, address, CompareBreakpoints());
+}
+
+namespace {
+// Gives compiled breakpoint conditions direct access to the machine state.
+class ConditionContext final : public CompiledCondition::Context
+{
+public:
+	explicit ConditionContext(MSXMotherBoard& motherBoard_)
+		: motherBoard(motherBoard_)
+		, cpuInterface(motherBoard.getCPUInterface()) {}
+
+	[[nodiscard]] const CPURegs& getRegisters() override {
+		return motherBoard.getCPU().getRegisters();
+	}
+	[[nodiscard]] byte peekMem(word address) override {
+		return cpuInterface.peekMem(address, motherBoard.getCurrentTime());
+	}
+	[[nodiscard]] std::pair<int, int> getSlot(int page) override {
+		return {cpuInterface.getPrimarySlot(page),
+		        cpuInterface.getSecondarySlot(page)};
+	}
+
+private:
+	MSXMotherBoard& motherBoard;
+	MSXCPUInterface& cpuInterface;
+};
+} // namespace
 
 void MSXCPUInterface::checkBreakPoints(
 	std::pair<BreakPoints::const_iterator,
 	          BreakPoints::const_iterator> range,
 	MSXMotherBoard& motherBoard)
 {
+	// Typical case: no breakpoints at this address and none of the
+	// conditions is true, they can all be evaluated without Tcl. Then
+	// there's no need to make copies. Each condition is only evaluated
+	// once: the leading ones that are false are not copied, and the
+	// result for the next one is passed on.
+	ConditionContext context(motherBoard);
+	size_t numFalse = 0;
+	bool nextEvaluated = false;
+	std::optional<bool> nextResult; // of conditions[numFalse]
+	if (range.first == range.second) {
+		for (/**/; numFalse < conditions.size(); ++numFalse) {
+			const auto& c = conditions[numFalse];
+			// 'once' conditions must be removed, also when false
+			if (c.onlyOnce()) break;
+			nextResult = c.evaluateCompiled(context);
+			if (!nextResult || *nextResult) {
+				nextEvaluated = true;
+				break;
+			}
+		}
+		if (numFalse == conditions.size()) return;
+	}
+
 	// create copy for the case that breakpoint/condition removes itself
 	//  - keeps object alive by holding a shared_ptr to it
 	//  - avoids iterating over a changing collection
@@ -813,14 +873,19 @@ void MSXCPUInterface::checkBreakPoints(
 	auto& globalCliComm = motherBoard.getReactor().getGlobalCliComm();
 	auto& interp        = motherBoard.getReactor().getInterpreter();
 	for (auto& p : bpCopy) {
-		p.checkAndExecute(globalCliComm, interp);
+		p.checkAndExecute(globalCliComm, interp, &context);
 		if (p.onlyOnce()) {
 			removeBreakPoint(p.getId());
 		}
 	}
-	auto condCopy = conditions;
-	for (auto& c : condCopy) {
-		c.checkAndExecute(globalCliComm, interp);
+	Conditions condCopy(conditions.begin() + numFalse, conditions.end());
+	for (auto i : xrange(condCopy.size())) {
+		auto& c = condCopy[i];
+		if ((i == 0) && nextEvaluated) {
+			c.checkAndExecute(globalCliComm, interp, nextResult);
+		} else {
+			c.checkAndExecute(globalCliComm, interp, &context);
+		}
 		if (c.onlyOnce()) {
 			removeCondition(c.getId());
 		}
@@ -843,21 +908,34 @@ static void registerIOWatch(WatchPoint& watchPoint, MSXDevice** devices)
 
 void MSXCPUInterface::setWatchPoint(const shared_ptr<WatchPoint>& watchPoint)
 {
-	watchPoints.push_back(watchPoint);
-	WatchPoint::Type type = watchPoint->getType();
-	switch (type) {
-	case WatchPoint::READ_IO:
-		registerIOWatch(*watchPoint, IO_In);
-		break;
-	case WatchPoint::WRITE_IO:
-		registerIOWatch(*watchPoint, IO_Out);
-		break;
-	case WatchPoint::READ_MEM:
-	case WatchPoint::WRITE_MEM:
-		updateMemWatch(type);
-		break;
-	default:
-		UNREACHABLE; break;
+	setWatchPoints(span<const shared_ptr<WatchPoint>>(&watchPoint, 1));
+}
+
+void MSXCPUInterface::setWatchPoints(span<const shared_ptr<WatchPoint>> newWatchPoints)
+{
+	unsigned beginAddr = 0x10000;
+	unsigned endAddr = 0;
+	for (const auto& watchPoint : newWatchPoints) {
+		watchPoints.push_back(watchPoint);
+		switch (watchPoint->getType()) {
+		case WatchPoint::READ_IO:
+			registerIOWatch(*watchPoint, IO_In);
+			break;
+		case WatchPoint::WRITE_IO:
+			registerIOWatch(*watchPoint, IO_Out);
+			break;
+		case WatchPoint::READ_MEM:
+		case WatchPoint::WRITE_MEM:
+			insertMemWatch(watchPoint);
+			beginAddr = std::min(beginAddr, watchPoint->getBeginAddress());
+			endAddr   = std::max(endAddr,   watchPoint->getEndAddress());
+			break;
+		default:
+			UNREACHABLE; break;
+		}
+	}
+	if (beginAddr <= endAddr) {
+		updateMemWatch(beginAddr, endAddr);
 	}
 }
 
@@ -899,9 +977,19 @@ void MSXCPUInterface::removeWatchPoint(shared_ptr<WatchPoint> watchPoint)
 			unregisterIOWatch(*watchPoint, IO_Out);
 			break;
 		case WatchPoint::READ_MEM:
-		case WatchPoint::WRITE_MEM:
-			updateMemWatch(type);
+		case WatchPoint::WRITE_MEM: {
+			auto* index = (type == WatchPoint::READ_MEM)
+			            ? readWatchIndex : writeWatchIndex;
+			unsigned beginAddr = watchPoint->getBeginAddress();
+			unsigned endAddr   = watchPoint->getEndAddress();
+			for (auto line : xrange(beginAddr >> CacheLine::BITS,
+			                        (endAddr  >> CacheLine::BITS) + 1)) {
+				auto& v = index[line];
+				v.erase(rfind_unguarded(v, watchPoint));
+			}
+			updateMemWatch(beginAddr, endAddr);
 			break;
+		}
 		default:
 			UNREACHABLE; break;
 		}
@@ -929,26 +1017,44 @@ void MSXCPUInterface::removeCondition(unsigned id)
 	}
 }
 
-void MSXCPUInterface::updateMemWatch(WatchPoint::Type type)
+void MSXCPUInterface::insertMemWatch(const shared_ptr<WatchPoint>& watchPoint)
 {
-	std::bitset<CacheLine::SIZE>* watchSet =
-		(type == WatchPoint::READ_MEM) ? readWatchSet : writeWatchSet;
-	for (auto i : xrange(CacheLine::NUM)) {
-		watchSet[i].reset();
+	auto* index = (watchPoint->getType() == WatchPoint::READ_MEM)
+	            ? readWatchIndex : writeWatchIndex;
+	unsigned beginAddr = watchPoint->getBeginAddress();
+	unsigned endAddr   = watchPoint->getEndAddress();
+	assert(beginAddr <= endAddr);
+	assert(endAddr < 0x10000);
+	for (auto line : xrange(beginAddr >> CacheLine::BITS,
+	                        (endAddr  >> CacheLine::BITS) + 1)) {
+		index[line].push_back(watchPoint);
 	}
-	for (auto& w : watchPoints) {
-		if (w->getType() == type) {
-			unsigned beginAddr = w->getBeginAddress();
-			unsigned endAddr   = w->getEndAddress();
-			assert(beginAddr <= endAddr);
-			assert(endAddr < 0x10000);
-			for (unsigned addr = beginAddr; addr <= endAddr; ++addr) {
-				watchSet[addr >> CacheLine::BITS].set(
-				         addr  & CacheLine::LOW);
+}
+
+// Recalculate the watch sets for all CacheLines that overlap with the given
+// (inclusive) address range.
+void MSXCPUInterface::updateMemWatch(unsigned beginAddr, unsigned endAddr)
+{
+	assert(beginAddr <= endAddr);
+	assert(endAddr < 0x10000);
+	unsigned firstLine = beginAddr >> CacheLine::BITS;
+	unsigned lastLine  = endAddr   >> CacheLine::BITS;
+	auto fillWatchSet = [](std::bitset<CacheLine::SIZE>& watchSet,
+	                       const WatchPoints& lineWatchPoints, unsigned line) {
+		watchSet.reset();
+		unsigned lineBegin = line << CacheLine::BITS;
+		unsigned lineEnd   = lineBegin + CacheLine::SIZE - 1;
+		for (const auto& w : lineWatchPoints) {
+			unsigned b = std::max(w->getBeginAddress(), lineBegin);
+			unsigned e = std::min(w->getEndAddress(),   lineEnd);
+			for (unsigned addr = b; addr <= e; ++addr) {
+				watchSet.set(addr & CacheLine::LOW);
 			}
 		}
-	}
-	for (auto i : xrange(CacheLine::NUM)) {
+	};
+	for (auto i : xrange(firstLine, lastLine + 1)) {
+		fillWatchSet(readWatchSet [i], readWatchIndex [i], i);
+		fillWatchSet(writeWatchSet[i], writeWatchIndex[i], i);
 		if (readWatchSet [i].any()) {
 			disallowReadCache [i] |=  MEMORY_WATCH_BIT;
 		} else {
@@ -960,7 +1066,8 @@ void MSXCPUInterface::updateMemWatch(WatchPoint::Type type)
 			disallowWriteCache[i] &= ~MEMORY_WATCH_BIT;
 		}
 	}
-	msxcpu.invalidateAllSlotsRWCache(0x0000, 0x10000);
+	msxcpu.invalidateAllSlotsRWCache(firstLine << CacheLine::BITS,
+	                                 (lastLine - firstLine + 1) << CacheLine::BITS);
 }
 
 void MSXCPUInterface::executeMemWatch(WatchPoint::Type type,
@@ -978,11 +1085,14 @@ void MSXCPUInterface::executeMemWatch(WatchPoint::Type type,
 		                   TclObject(int(value)));
 	}
 
-	auto wpCopy = watchPoints;
+	// only the watchpoints in this CacheLine can match
+	auto& lineWatchPoints = (type == WatchPoint::READ_MEM)
+	                      ? readWatchIndex [address >> CacheLine::BITS]
+	                      : writeWatchIndex[address >> CacheLine::BITS];
+	auto wpCopy = lineWatchPoints;
 	for (auto& w : wpCopy) {
 		if ((w->getBeginAddress() <= address) &&
-		    (w->getEndAddress()   >= address) &&
-		    (w->getType()         == type)) {
+		    (w->getEndAddress()   >= address)) {
 			w->checkAndExecute(globalCliComm, interp);
 			if (w->onlyOnce()) {
 				removeWatchPoint(w);
@@ -1040,6 +1150,7 @@ void MSXCPUInterface::cleanup()
 	// TODO it would be nicer if breakpoints and conditions were not
 	//      global objects.
 	breakPoints.clear();
+	breakPointAddresses.reset();
 	conditions.clear();
 }
 
@@ -12,7 +12,9 @@
 #include "openmsx.hh"
 #include "likely.hh"
 #include "ranges.hh"
+#include "span.hh"
 #include <bitset>
+#include <cassert>
 #include <vector>
 #include <memory>
 
@@ -246,6 +248,13 @@ public:
 	void unsetExpanded(int ps);
 	void testUnsetExpanded(int ps, std::vector<MSXDevice*> allowed) const;
 	[[nodiscard]] inline bool isExpanded(int ps) const { return expanded[ps] != 0; }
+	/** Currently selected primary slot in the given page. */
+	[[nodiscard]] int getPrimarySlot(int page) const { return primarySlotState[page]; }
+	/** Currently selected secondary slot in the given page, or -1 when the
+	  * selected primary slot is not expanded. */
+	[[nodiscard]] int getSecondarySlot(int page) const {
+		return isExpanded(primarySlotState[page]) ? secondarySlotState[page] : -1;
+	}
 	void changeExpanded(bool newExpanded);
 
 	[[nodiscard]] DummyDevice& getDummyDevice() { return *dummyDevice; }
@@ -255,10 +264,13 @@ public:
 	using BreakPoints = std::vector<BreakPoint>;
 	[[nodiscard]] static const BreakPoints& getBreakPoints() { return breakPoints; }
 
-	void setWatchPoint(const std::shared_ptr<WatchPoint>& watchPoint);
-	void removeWatchPoint(std::shared_ptr<WatchPoint> watchPoint);
 	// note: must be shared_ptr (not unique_ptr), see WatchIO::doReadCallback()
 	using WatchPoints = std::vector<std::shared_ptr<WatchPoint>>;
+	void setWatchPoint(const std::shared_ptr<WatchPoint>& watchPoint);
+	/** Insert many watchpoints at once. Equivalent to repeatedly calling
+	  * setWatchPoint(), but the CPU memory caches are only updated once. */
+	void setWatchPoints(span<const std::shared_ptr<WatchPoint>> newWatchPoints);
+	void removeWatchPoint(std::shared_ptr<WatchPoint> watchPoint);
 	[[nodiscard]] const WatchPoints& getWatchPoints() const { return watchPoints; }
 
 	static void setCondition(DebugCondition cond);
@@ -278,12 +290,19 @@ public:
 	}
 	[[nodiscard]] static bool checkBreakPoints(unsigned pc, MSXMotherBoard& motherBoard)
 	{
-		auto range = ranges::equal_range(breakPoints, pc, CompareBreakpoints());
-		if (conditions.empty() && (range.first == range.second)) {
+		assert(pc < 0x10000);
+		bool anyAtPc = breakPointAddresses[pc];
+		if (likely(!anyAtPc && conditions.empty())) {
 			return false;
 		}
 
 		// slow path non-inlined
+		auto end = breakPoints.cend();
+		std::pair<BreakPoints::const_iterator,
+		          BreakPoints::const_iterator> range(end, end);
+		if (anyAtPc) {
+			range = ranges::equal_range(breakPoints, pc, CompareBreakpoints());
+		}
 		checkBreakPoints(range, motherBoard);
 		return isBreaked();
 	}
@@ -320,10 +339,12 @@ private:
 	                                       BreakPoints::const_iterator> range,
 	                             MSXMotherBoard& motherBoard);
 	static void removeBreakPoint(unsigned id);
+	static void updateBreakPointAddress(word address);
 	static void removeCondition(unsigned id);
 
 	void removeAllWatchPoints();
-	void updateMemWatch(WatchPoint::Type type);
+	void insertMemWatch(const std::shared_ptr<WatchPoint>& watchPoint);
+	void updateMemWatch(unsigned beginAddr, unsigned endAddr);
 	void executeMemWatch(WatchPoint::Type type, unsigned address,
 	                     unsigned value = ~0u);
 
@@ -408,6 +429,11 @@ private:
 	byte disallowWriteCache[CacheLine::NUM];
 	std::bitset<CacheLine::SIZE> readWatchSet [CacheLine::NUM];
 	std::bitset<CacheLine::SIZE> writeWatchSet[CacheLine::NUM];
+	// Memory watchpoints per CacheLine (a watchpoint is present in all
+	// lines it overlaps), in creation order. So a memory access only needs
+	// to look at the watchpoints that can possibly match.
+	WatchPoints readWatchIndex [CacheLine::NUM];
+	WatchPoints writeWatchIndex[CacheLine::NUM];
 
 	struct GlobalRwInfo {
 		MSXDevice* device;
@@ -434,6 +460,9 @@ private:
 
 	//  All CPUs (Z80 and R800) of all MSX machines share this state.
 	static inline BreakPoints breakPoints; // sorted on address
+	// Bit is set for each address that has at least one breakpoint, avoids
+	// a search in 'breakPoints' for every executed instruction.
+	static inline std::bitset<0x10000> breakPointAddresses;
 	WatchPoints watchPoints; // ordered in creation order,  TODO must also be static
 	static inline Conditions conditions; // ordered in creation order
 	static inline bool breaked = false;
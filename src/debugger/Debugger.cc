@@ -10,6 +10,7 @@
 #include "TclArgParser.hh"
 #include "TclObject.hh"
 #include "CommandException.hh"
+#include "FileOperations.hh"
 #include "MemBuffer.hh"
 #include "one_of.hh"
 #include "ranges.hh"
@@ -144,20 +145,28 @@ void Debugger::removeProbeBreakPoint(ProbeBreakPoint& bp)
 		[&](auto& v) { return v.get() == &bp; }));
 }
 
-unsigned Debugger::setWatchPoint(TclObject command, TclObject condition,
-                                 WatchPoint::Type type,
-                                 unsigned beginAddr, unsigned endAddr,
-                                 bool once, unsigned newId /*= -1*/)
+shared_ptr<WatchPoint> Debugger::createWatchPoint(
+	TclObject command, TclObject condition,
+	WatchPoint::Type type, unsigned beginAddr, unsigned endAddr,
+	bool once, unsigned newId /*= -1*/)
 {
-	shared_ptr<WatchPoint> wp;
 	if (type == one_of(WatchPoint::READ_IO, WatchPoint::WRITE_IO)) {
-		wp = make_shared<WatchIO>(
+		return make_shared<WatchIO>(
 			motherBoard, type, beginAddr, endAddr,
 			std::move(command), std::move(condition), once, newId);
 	} else {
-		wp = make_shared<WatchPoint>(
+		return make_shared<WatchPoint>(
 			std::move(command), std::move(condition), type, beginAddr, endAddr, once, newId);
 	}
+}
+
+unsigned Debugger::setWatchPoint(TclObject command, TclObject condition,
+                                 WatchPoint::Type type,
+                                 unsigned beginAddr, unsigned endAddr,
+                                 bool once, unsigned newId /*= -1*/)
+{
+	auto wp = createWatchPoint(std::move(command), std::move(condition),
+	                           type, beginAddr, endAddr, once, newId);
 	motherBoard.getCPUInterface().setWatchPoint(wp);
 	return wp->getId();
 }
@@ -166,12 +175,16 @@ void Debugger::transfer(Debugger& other)
 {
 	// Copy watchpoints to new machine.
 	assert(motherBoard.getCPUInterface().getWatchPoints().empty());
-	for (const auto& wp : other.motherBoard.getCPUInterface().getWatchPoints()) {
-		setWatchPoint(wp->getCommandObj(), wp->getConditionObj(),
-		              wp->getType(),       wp->getBeginAddress(),
-		              wp->getEndAddress(), wp->onlyOnce(),
-		              wp->getId());
-	}
+	auto wps = to_vector(view::transform(
+		other.motherBoard.getCPUInterface().getWatchPoints(),
+		[&](const auto& wp) {
+			return createWatchPoint(
+				wp->getCommandObj(), wp->getConditionObj(),
+				wp->getType(),       wp->getBeginAddress(),
+				wp->getEndAddress(), wp->onlyOnce(),
+				wp->getId());
+		}));
+	motherBoard.getCPUInterface().setWatchPoints(wps);
 
 	// Copy probes to new machine.
 	assert(probeBreakPoints.empty());
@@ -233,12 +246,14 @@ void Debugger::Cmd::execute(
 		"step",              [&]{ debugger().motherBoard.getCPUInterface().doStep(); },
 		"cont",              [&]{ debugger().motherBoard.getCPUInterface().doContinue(); },
 		"disasm",            [&]{ debugger().cpu->disasmCommand(getInterpreter(), tokens, result); },
+		"profile",           [&]{ profile(tokens, result); },
 		"break",             [&]{ debugger().motherBoard.getCPUInterface().doBreak(); },
 		"breaked",           [&]{ result = debugger().motherBoard.getCPUInterface().isBreaked(); },
 		"set_bp",            [&]{ setBreakPoint(tokens, result); },
 		"remove_bp",         [&]{ removeBreakPoint(tokens, result); },
 		"list_bp",           [&]{ listBreakPoints(tokens, result); },
 		"set_watchpoint",    [&]{ setWatchPoint(tokens, result); },
+		"set_watchpoints",   [&]{ setWatchPoints(tokens, result); },
 		"remove_watchpoint", [&]{ removeWatchPoint(tokens, result); },
 		"list_watchpoints",  [&]{ listWatchPoints(tokens, result); },
 		"set_condition",     [&]{ setCondition(tokens, result); },
@@ -417,13 +432,49 @@ void Debugger::Cmd::listBreakPoints(
 }
 
 
+static WatchPoint::Type parseWatchPointType(std::string_view typeStr)
+{
+	if (typeStr == "read_io") {
+		return WatchPoint::READ_IO;
+	} else if (typeStr == "write_io") {
+		return WatchPoint::WRITE_IO;
+	} else if (typeStr == "read_mem") {
+		return WatchPoint::READ_MEM;
+	} else if (typeStr == "write_mem") {
+		return WatchPoint::WRITE_MEM;
+	} else {
+		throw CommandException("Invalid type: ", typeStr);
+	}
+}
+
+static std::pair<unsigned, unsigned> parseWatchPointRegion(
+	Interpreter& interp, const TclObject& region, WatchPoint::Type type)
+{
+	unsigned max = (type == one_of(WatchPoint::READ_IO, WatchPoint::WRITE_IO))
+	             ? 0x100 : 0x10000;
+	unsigned beginAddr, endAddr;
+	if (region.getListLength(interp) == 2) {
+		beginAddr = region.getListIndex(interp, 0).getInt(interp);
+		endAddr   = region.getListIndex(interp, 1).getInt(interp);
+		if (endAddr < beginAddr) {
+			throw CommandException(
+				"Not a valid range: end address may "
+				"not be smaller than begin address.");
+		}
+	} else {
+		beginAddr = endAddr = region.getInt(interp);
+	}
+	if (endAddr >= max) {
+		throw CommandException("Invalid address: out of range");
+	}
+	return {beginAddr, endAddr};
+}
+
 void Debugger::Cmd::setWatchPoint(span<const TclObject> tokens, TclObject& result)
 {
 	checkNumArgs(tokens, AtLeast{4}, Prefix{2}, "type address ?-once? ?condition? ?command?");
 	TclObject command("debug break");
 	TclObject condition;
-	unsigned beginAddr, endAddr;
-	WatchPoint::Type type;
 	bool once = false;
 
 	ArgsInfo info[] = { flagArg("-once", once) };
@@ -439,50 +490,52 @@ void Debugger::Cmd::setWatchPoint(span<const TclObject> tokens, TclObject& resul
 	case 3: // condition
 		condition = arguments[2];
 		[[fallthrough]];
-	case 2: { // address + type
-		string_view typeStr = arguments[0].getString();
-		unsigned max = [&] {
-			if (typeStr == "read_io") {
-				type = WatchPoint::READ_IO;
-				return 0x100;
-			} else if (typeStr == "write_io") {
-				type = WatchPoint::WRITE_IO;
-				return 0x100;
-			} else if (typeStr == "read_mem") {
-				type = WatchPoint::READ_MEM;
-				return 0x10000;
-			} else if (typeStr == "write_mem") {
-				type = WatchPoint::WRITE_MEM;
-				return 0x10000;
-			} else {
-				throw CommandException("Invalid type: ", typeStr);
-			}
-		}();
-		auto& interp = getInterpreter();
-		if (arguments[1].getListLength(interp) == 2) {
-			beginAddr = arguments[1].getListIndex(interp, 0).getInt(interp);
-			endAddr   = arguments[1].getListIndex(interp, 1).getInt(interp);
-			if (endAddr < beginAddr) {
-				throw CommandException(
-					"Not a valid range: end address may "
-					"not be smaller than begin address.");
-			}
-		} else {
-			beginAddr = endAddr = arguments[1].getInt(interp);
-		}
-		if (endAddr >= max) {
-			throw CommandException("Invalid address: out of range");
-		}
+	case 2: // address + type
 		break;
-	}
 	default:
 		UNREACHABLE; break;
 	}
+	auto type = parseWatchPointType(arguments[0].getString());
+	auto [beginAddr, endAddr] = parseWatchPointRegion(
+		getInterpreter(), arguments[1], type);
 	unsigned id = debugger().setWatchPoint(
 		command, condition, type, beginAddr, endAddr, once);
 	result = tmpStrCat("wp#", id);
 }
 
+void Debugger::Cmd::setWatchPoints(span<const TclObject> tokens, TclObject& result)
+{
+	checkNumArgs(tokens, AtLeast{4}, Prefix{2}, "type regions ?-once? ?condition? ?command?");
+	TclObject command("debug break");
+	TclObject condition;
+	bool once = false;
+
+	ArgsInfo info[] = { flagArg("-once", once) };
+	auto arguments = parseTclArgs(getInterpreter(), tokens.subspan(2), info);
+	if ((arguments.size() < 2) || (arguments.size() > 4)) {
+		throw SyntaxError();
+	}
+	if (arguments.size() >= 4) command   = arguments[3];
+	if (arguments.size() >= 3) condition = arguments[2];
+
+	// first parse all regions, so that nothing gets inserted on error
+	auto& interp = getInterpreter();
+	auto type = parseWatchPointType(arguments[0].getString());
+	auto numRegions = arguments[1].getListLength(interp);
+	std::vector<shared_ptr<WatchPoint>> wps;
+	wps.reserve(numRegions);
+	for (auto i : xrange(numRegions)) {
+		auto [beginAddr, endAddr] = parseWatchPointRegion(
+			interp, arguments[1].getListIndex(interp, i), type);
+		wps.push_back(debugger().createWatchPoint(
+			command, condition, type, beginAddr, endAddr, once));
+	}
+	debugger().motherBoard.getCPUInterface().setWatchPoints(wps);
+	result.addListElements(view::transform(wps, [](auto& wp) {
+		return tmpStrCat("wp#", wp->getId());
+	}));
+}
+
 void Debugger::Cmd::removeWatchPoint(
 	span<const TclObject> tokens, TclObject& /*result*/)
 {
@@ -687,6 +740,58 @@ void Debugger::Cmd::probeListBreakPoints(
 	result = res;
 }
 
+void Debugger::Cmd::profile(span<const TclObject> tokens, TclObject& result)
+{
+	checkNumArgs(tokens, AtLeast{3}, "subcommand ?arg ...?");
+	auto& cpu = *debugger().cpu;
+	executeSubCommand(tokens[2].getString(),
+		"start",  [&]{ checkNumArgs(tokens, 3, Prefix{3}, nullptr);
+		               cpu.setProfiling(true); },
+		"stop",   [&]{ checkNumArgs(tokens, 3, Prefix{3}, nullptr);
+		               cpu.setProfiling(false); },
+		"clear",  [&]{ checkNumArgs(tokens, 3, Prefix{3}, nullptr);
+		               cpu.getProfiler().clear(); },
+		"status", [&]{ checkNumArgs(tokens, 3, Prefix{3}, nullptr);
+		               result = cpu.isProfiling(); },
+		"list",   [&]{ profileList(tokens, result); },
+		"save",   [&]{ checkNumArgs(tokens, 4, Prefix{3}, "filename");
+		               cpu.getProfiler().save(FileOperations::expandTilde(
+		                       string(tokens[3].getString()))); });
+}
+void Debugger::Cmd::profileList(span<const TclObject> tokens, TclObject& result)
+{
+	checkNumArgs(tokens, Between{3, 4}, Prefix{3}, "?count?");
+	unsigned max = unsigned(-1);
+	if (tokens.size() == 4) {
+		int n = tokens[3].getInt(getInterpreter());
+		if (n < 0) throw CommandException("Invalid count: ", n);
+		max = n;
+	}
+	struct Entry {
+		int ps, ss;
+		word pc;
+		CPUProfiler::Counter counter;
+	};
+	std::vector<Entry> entries;
+	debugger().cpu->getProfiler().forEach(
+		[&](int ps, int ss, word pc, const CPUProfiler::Counter& counter) {
+			entries.push_back({ps, ss, pc, counter});
+		});
+	// most expensive first
+	ranges::stable_sort(entries, [](const Entry& x, const Entry& y) {
+		return x.counter.ticks > y.counter.ticks;
+	});
+	if (entries.size() > max) entries.resize(max);
+	for (const auto& e : entries) {
+		result.addListElement(makeTclList(
+			e.ps,
+			(e.ss == -1) ? TclObject("X") : TclObject(e.ss),
+			tmpStrCat("0x", hex_string<4>(e.pc)),
+			int64_t(e.counter.count),
+			int64_t(e.counter.ticks)));
+	}
+}
+
 string Debugger::Cmd::help(const vector<string>& tokens) const
 {
 	auto generalHelp =
@@ -703,12 +808,14 @@ string Debugger::Cmd::help(const vector<string>& tokens) const
 		"    remove_bp         remove a certain breakpoint\n"
 		"    list_bp           list the active breakpoints\n"
 		"    set_watchpoint    insert a new watchpoint\n"
+		"    set_watchpoints   insert many watchpoints at once\n"
 		"    remove_watchpoint remove a certain watchpoint\n"
 		"    list_watchpoints  list the active watchpoints\n"
 		"    set_condition     insert a new condition\n"
 		"    remove_condition  remove a certain condition\n"
 		"    list_conditions   list the active conditions\n"
 		"    probe             probe related subcommands\n"
+		"    profile           profile the executed CPU instructions\n"
 		"    cont              continue execution after break\n"
 		"    step              execute one instruction\n"
 		"    break             break CPU at current position\n"
@@ -812,6 +919,16 @@ string Debugger::Cmd::help(const vector<string>& tokens) const
 		"Examples:\n"
 		"  debug set_watchpoint write_io 0x99 {[reg A] == 0x81}\n"
 		"  debug set_watchpoint read_mem {0xfbe5 0xfbef}\n";
+	auto setWatchPointsHelp =
+		"debug set_watchpoints [-once] <type> <regions> [<cond>] [<cmd>]\n"
+		"  Insert a watchpoint for each region in the given list of "
+		"regions. All other arguments are the same as for the "
+		"'set_watchpoint' subcommand, and are shared by all the new "
+		"watchpoints. This is much faster than inserting many "
+		"watchpoints one by one.\n"
+		"  The result is the list of the new watchpoint IDs.\n"
+		"Example:\n"
+		"  debug set_watchpoints read_mem {0x4000 {0x8000 0x80ff} 0xc000}\n";
 	auto removeWatchPointHelp =
 		"debug remove_watchpoint <id>\n"
 		"  Remove the watchpoint with given ID again. You can use the "
@@ -849,6 +966,23 @@ string Debugger::Cmd::help(const vector<string>& tokens) const
 		"    set_bp <probe> [-once] [<cond>] [<cmd>]  set a breakpoint on the given probe\n"
 		"    remove_bp <id>                           remove the given breakpoint\n"
 		"    list_bp                                  returns a list of breakpoints that are set on probes\n";
+	auto profileHelp =
+		"debug profile <subcommand> [<arguments>]\n"
+		"  Collects the number of executed instructions and the number of "
+		"CPU clock cycles spent, per instruction address and slot. This "
+		"slows down emulation a bit (much less than using breakpoints "
+		"for the same purpose).\n"
+		"  Possible subcommands are:\n"
+		"    start            start (or resume) collecting profile data\n"
+		"    stop             stop collecting, the collected data is kept\n"
+		"    clear            discard all collected data\n"
+		"    status           returns whether profiling is active\n"
+		"    list [<count>]   returns a list of {<ps> <ss> <addr> "
+		"<instructions> <cycles>} entries, most cycles first. Optionally "
+		"only the first <count> entries. <ss> is 'X' for non-expanded "
+		"slots.\n"
+		"    save <filename>  write all data to a binary file, see "
+		"src/cpu/CPUProfiler.hh for the format\n";
 	auto contHelp =
 		"debug cont\n"
 		"  Continue execution after CPU was breaked.\n";
@@ -902,6 +1036,8 @@ string Debugger::Cmd::help(const vector<string>& tokens) const
 		return listBpHelp;
 	} else if (tokens[1] == "set_watchpoint") {
 		return setWatchPointHelp;
+	} else if (tokens[1] == "set_watchpoints") {
+		return setWatchPointsHelp;
 	} else if (tokens[1] == "remove_watchpoint") {
 		return removeWatchPointHelp;
 	} else if (tokens[1] == "list_watchpoints") {
@@ -914,6 +1050,8 @@ string Debugger::Cmd::help(const vector<string>& tokens) const
 		return listCondHelp;
 	} else if (tokens[1] == "probe") {
 		return probeHelp;
+	} else if (tokens[1] == "profile") {
+		return profileHelp;
 	} else if (tokens[1] == "cont") {
 		return contHelp;
 	} else if (tokens[1] == "step") {
@@ -961,8 +1099,8 @@ void Debugger::Cmd::tabCompletion(vector<string>& tokens) const
 	};
 	static constexpr std::array otherCmds = {
 		"disasm"sv, "set_bp"sv, "remove_bp"sv, "set_watchpoint"sv,
-		"remove_watchpoint"sv, "set_condition"sv, "remove_condition"sv,
-		"probe"sv,
+		"set_watchpoints"sv, "remove_watchpoint"sv, "set_condition"sv,
+		"remove_condition"sv, "probe"sv, "profile"sv,
 	};
 	switch (tokens.size()) {
 	case 2: {
@@ -984,7 +1122,7 @@ void Debugger::Cmd::tabCompletion(vector<string>& tokens) const
 			} else if (tokens[1] == "remove_condition") {
 				// this one takes a cond id
 				completeString(tokens, getConditionIds());
-			} else if (tokens[1] == "set_watchpoint") {
+			} else if (tokens[1] == one_of("set_watchpoint", "set_watchpoints")) {
 				static constexpr std::array types = {
 					"write_io"sv, "write_mem"sv,
 					"read_io"sv, "read_mem"sv,
@@ -996,6 +1134,12 @@ void Debugger::Cmd::tabCompletion(vector<string>& tokens) const
 					"remove_bp"sv, "list_bp"sv,
 				};
 				completeString(tokens, subCmds);
+			} else if (tokens[1] == "profile") {
+				static constexpr std::array subCmds = {
+					"start"sv, "stop"sv, "clear"sv, "status"sv,
+					"list"sv, "save"sv,
+				};
+				completeString(tokens, subCmds);
 			}
 		}
 		break;
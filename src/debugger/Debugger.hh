@@ -52,6 +52,10 @@ private:
 		ProbeBase& probe, bool once, unsigned newId = -1);
 	void removeProbeBreakPoint(std::string_view name);
 
+	[[nodiscard]] std::shared_ptr<WatchPoint> createWatchPoint(
+		TclObject command, TclObject condition,
+		WatchPoint::Type type, unsigned beginAddr, unsigned endAddr,
+		bool once, unsigned newId = -1);
 	unsigned setWatchPoint(TclObject command, TclObject condition,
 	                       WatchPoint::Type type,
 	                       unsigned beginAddr, unsigned endAddr,
@@ -87,6 +91,7 @@ private:
 		[[nodiscard]] std::vector<std::string> getWatchPointIds() const;
 		[[nodiscard]] std::vector<std::string> getConditionIds() const;
 		void setWatchPoint(span<const TclObject> tokens, TclObject& result);
+		void setWatchPoints(span<const TclObject> tokens, TclObject& result);
 		void removeWatchPoint(span<const TclObject> tokens, TclObject& result);
 		void listWatchPoints(span<const TclObject> tokens, TclObject& result);
 		void setCondition(span<const TclObject> tokens, TclObject& result);
@@ -99,6 +104,8 @@ private:
 		void probeSetBreakPoint(span<const TclObject> tokens, TclObject& result);
 		void probeRemoveBreakPoint(span<const TclObject> tokens, TclObject& result);
 		void probeListBreakPoints(span<const TclObject> tokens, TclObject& result);
+		void profile(span<const TclObject> tokens, TclObject& result);
+		void profileList(span<const TclObject> tokens, TclObject& result);
 	} cmd;
 
 	struct NameFromProbe {
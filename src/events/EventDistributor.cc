@@ -76,7 +76,10 @@ void EventDistributor::deliverEvents()
 
 	assert(Thread::isMainThread());
 
-	reactor.getInputEventGenerator().poll();
+	if (!reactor.isHeadless()) {
+		// in headless mode the Reactor polls less often
+		reactor.getInputEventGenerator().poll();
+	}
 	reactor.getInterpreter().poll();
 	reactor.getRTScheduler().execute();
 
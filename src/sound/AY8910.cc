@@ -15,6 +15,7 @@
 #include "MSXException.hh"
 #include "Math.hh"
 #include "StringOp.hh"
+#include "VgmRecorder.hh"
 #include "serialize.hh"
 #include "cstd.hh"
 #include "likely.hh"
@@ -475,6 +476,51 @@ inline void AY8910::Envelope::advanceFast(unsigned duration)
 
 
 
+// Bulk output:
+
+static inline void addRun(float*& buf, float val, unsigned num)
+{
+	// Like SoundDevice::addFill(), but inline: with short tone periods this
+	// is called for (almost) every sample.
+	for (auto i : xrange(num)) buf[i] += val;
+	buf += num;
+}
+
+// Add 'num' samples of a square wave with a fixed (half-)period. The first
+// 'first' samples have value 'val', after that the output alternates
+// between 'volume - val' and 'val' every 'period' samples. This produces
+// the same result as stepping a (non-detuned) ToneGenerator event by event,
+// but without the per-event bookkeeping.
+static inline void addSquareWave(float*& buf, float val, float volume,
+                                 unsigned first, unsigned period, unsigned num)
+{
+	if (num <= first) {
+		addRun(buf, val, num);
+		return;
+	}
+	addRun(buf, val, first);
+	num -= first;
+	val = volume - val;
+	if (period == 1) {
+		// tone period 0 or 1, often used to play samples via the
+		// volume register: a new value on every sample
+		float other = volume - val;
+		for (/**/; num >= 2; num -= 2) {
+			buf[0] += val;
+			buf[1] += other;
+			buf += 2;
+		}
+		if (num) *buf++ += val;
+		return;
+	}
+	for (/**/; num >= period; num -= period) {
+		addRun(buf, val, period);
+		val = volume - val;
+	}
+	if (num) addRun(buf, val, num);
+}
+
+
 // AY8910 main class:
 
 AY8910::AY8910(const std::string& name_, AY8910Periphery& periphery_,
@@ -584,6 +630,9 @@ byte AY8910::peekRegister(unsigned reg, EmuTime::param time) const
 void AY8910::writeRegister(unsigned reg, byte value, EmuTime::param time)
 {
 	if (reg >= 16) return;
+	if (auto* vgm = getVgmRecorder(); vgm && (reg < AY_PORTA)) {
+		vgm->writeAY8910(this, !isAY8910, reg, value, time);
+	}
 	if ((reg < AY_PORTA) && (reg == AY_ESHAPE || regs[reg] != value)) {
 		// Update the output buffer before changing the register.
 		updateStream(time);
@@ -719,7 +768,30 @@ void AY8910::generateChannels(float** bufs, unsigned num)
 		if (envelope.isChanging() && amplitude.followsEnvelope(chan)) {
 			envelopeUpdated = true;
 			envelope = initialEnvelope;
-			if ((chanEnable & 0x09) == 0x08) {
+			if (((chanEnable & 0x09) == 0x08) && !doDetune && bulkEnabled) {
+				// no noise, square wave with a fixed period: generate
+				// the wave in bulk between envelope steps.
+				unsigned remaining = num;
+				unsigned next = envelope.getNextEventTime();
+				while (next <= remaining) {
+					auto volume = envelope.getVolume();
+					addSquareWave(buf, t.getOutput() * volume, volume,
+					              t.getNextEventTime(), t.getPeriod(), next);
+					t.advance(next);
+					remaining -= next;
+					envelope.doNextEvent();
+					next = envelope.getNextEventTime();
+				}
+				if (remaining) {
+					// last interval (without envelope events)
+					auto volume = envelope.getVolume();
+					addSquareWave(buf, t.getOutput() * volume, volume,
+					              t.getNextEventTime(), t.getPeriod(), remaining);
+					t.advance(remaining);
+					envelope.advanceFast(remaining);
+				}
+
+			} else if ((chanEnable & 0x09) == 0x08) {
 				// no noise, square wave: alternating between 0 and 1.
 				auto val = t.getOutput() * envelope.getVolume();
 				unsigned remaining = num;
@@ -727,14 +799,14 @@ void AY8910::generateChannels(float** bufs, unsigned num)
 				unsigned nextT = t.getNextEventTime();
 				while ((nextT <= remaining) || (nextE <= remaining)) {
 					if (nextT < nextE) {
-						addFill(buf, val, nextT);
+						addRun(buf, val, nextT);
 						remaining -= nextT;
 						nextE -= nextT;
 						envelope.advanceFast(nextT);
 						t.doNextEvent(*this);
 						nextT = t.getNextEventTime();
 					} else if (nextE < nextT) {
-						addFill(buf, val, nextE);
+						addRun(buf, val, nextE);
 						remaining -= nextE;
 						nextT -= nextE;
 						t.advanceFast(nextE);
@@ -742,7 +814,7 @@ void AY8910::generateChannels(float** bufs, unsigned num)
 						nextE = envelope.getNextEventTime();
 					} else {
 						assert(nextT == nextE);
-						addFill(buf, val, nextT);
+						addRun(buf, val, nextT);
 						remaining -= nextT;
 						t.doNextEvent(*this);
 						nextT = t.getNextEventTime();
@@ -753,7 +825,7 @@ void AY8910::generateChannels(float** bufs, unsigned num)
 				}
 				if (remaining) {
 					// last interval (without events)
-					addFill(buf, val, remaining);
+					addRun(buf, val, remaining);
 					t.advanceFast(remaining);
 					envelope.advanceFast(remaining);
 				}
@@ -764,7 +836,7 @@ void AY8910::generateChannels(float** bufs, unsigned num)
 				unsigned remaining = num;
 				unsigned next = envelope.getNextEventTime();
 				while (next <= remaining) {
-					addFill(buf, val, next);
+					addRun(buf, val, next);
 					remaining -= next;
 					envelope.doNextEvent();
 					val = envelope.getVolume();
@@ -772,7 +844,7 @@ void AY8910::generateChannels(float** bufs, unsigned num)
 				}
 				if (remaining) {
 					// last interval (without events)
-					addFill(buf, val, remaining);
+					addRun(buf, val, remaining);
 					envelope.advanceFast(remaining);
 				}
 				t.advance(num);
@@ -787,7 +859,7 @@ void AY8910::generateChannels(float** bufs, unsigned num)
 				unsigned nextE = envelope.getNextEventTime();
 				unsigned next = std::min(std::min(nextT, nextN), nextE);
 				while (next <= remaining) {
-					addFill(buf, val, next);
+					addRun(buf, val, next);
 					remaining -= next;
 					nextT -= next;
 					nextN -= next;
@@ -815,7 +887,7 @@ void AY8910::generateChannels(float** bufs, unsigned num)
 				}
 				if (remaining) {
 					// last interval (without events)
-					addFill(buf, val, remaining);
+					addRun(buf, val, remaining);
 					t.advanceFast(remaining);
 					noise.advanceFast(remaining);
 					envelope.advanceFast(remaining);
@@ -830,14 +902,14 @@ void AY8910::generateChannels(float** bufs, unsigned num)
 				unsigned nextN = noise.getNextEventTime();
 				while ((nextN <= remaining) || (nextE <= remaining)) {
 					if (nextN < nextE) {
-						addFill(buf, val, nextN);
+						addRun(buf, val, nextN);
 						remaining -= nextN;
 						nextE -= nextN;
 						envelope.advanceFast(nextN);
 						noise.doNextEvent();
 						nextN = noise.getNextEventTime();
 					} else if (nextE < nextN) {
-						addFill(buf, val, nextE);
+						addRun(buf, val, nextE);
 						remaining -= nextE;
 						nextN -= nextE;
 						noise.advanceFast(nextE);
@@ -845,7 +917,7 @@ void AY8910::generateChannels(float** bufs, unsigned num)
 						nextE = envelope.getNextEventTime();
 					} else {
 						assert(nextN == nextE);
-						addFill(buf, val, nextN);
+						addRun(buf, val, nextN);
 						remaining -= nextN;
 						noise.doNextEvent();
 						nextN = noise.getNextEventTime();
@@ -856,7 +928,7 @@ void AY8910::generateChannels(float** bufs, unsigned num)
 				}
 				if (remaining) {
 					// last interval (without events)
-					addFill(buf, val, remaining);
+					addRun(buf, val, remaining);
 					noise.advanceFast(remaining);
 					envelope.advanceFast(remaining);
 				}
@@ -867,13 +939,20 @@ void AY8910::generateChannels(float** bufs, unsigned num)
 			auto volume = amplitude.followsEnvelope(chan)
 			            ? envelope.getVolume()
 			            : amplitude.getVolume(chan);
-			if ((chanEnable & 0x09) == 0x08) {
+			if (((chanEnable & 0x09) == 0x08) && !doDetune && bulkEnabled) {
+				// no noise, square wave with a fixed period: the whole
+				// output is known up front.
+				addSquareWave(buf, t.getOutput() * volume, volume,
+				              t.getNextEventTime(), t.getPeriod(), num);
+				t.advance(num);
+
+			} else if ((chanEnable & 0x09) == 0x08) {
 				// no noise, square wave: alternating between 0 and 1.
 				auto val = t.getOutput() * volume;
 				unsigned remaining = num;
 				unsigned next = t.getNextEventTime();
 				while (next <= remaining) {
-					addFill(buf, val, next);
+					addRun(buf, val, next);
 					val = volume - val;
 					remaining -= next;
 					t.doNextEvent(*this);
@@ -881,13 +960,13 @@ void AY8910::generateChannels(float** bufs, unsigned num)
 				}
 				if (remaining) {
 					// last interval (without events)
-					addFill(buf, val, remaining);
+					addRun(buf, val, remaining);
 					t.advanceFast(remaining);
 				}
 
 			} else if ((chanEnable & 0x09) == 0x09) {
 				// no noise, channel disabled: always 1.
-				addFill(buf, volume, num);
+				addRun(buf, volume, num);
 				t.advance(num);
 
 			} else if ((chanEnable & 0x09) == 0x00) {
@@ -900,7 +979,7 @@ void AY8910::generateChannels(float** bufs, unsigned num)
 				unsigned nextT = t.getNextEventTime();
 				while ((nextN <= remaining) || (nextT <= remaining)) {
 					if (nextT < nextN) {
-						addFill(buf, val2, nextT);
+						addRun(buf, val2, nextT);
 						remaining -= nextT;
 						nextN -= nextT;
 						noise.advanceFast(nextT);
@@ -909,7 +988,7 @@ void AY8910::generateChannels(float** bufs, unsigned num)
 						val1 = volume - val1;
 						val2 = val1 * noise.getOutput();
 					} else if (nextN < nextT) {
-						addFill(buf, val2, nextN);
+						addRun(buf, val2, nextN);
 						remaining -= nextN;
 						nextT -= nextN;
 						t.advanceFast(nextN);
@@ -918,7 +997,7 @@ void AY8910::generateChannels(float** bufs, unsigned num)
 						val2 = val1 * noise.getOutput();
 					} else {
 						assert(nextT == nextN);
-						addFill(buf, val2, nextT);
+						addRun(buf, val2, nextT);
 						remaining -= nextT;
 						t.doNextEvent(*this);
 						nextT = t.getNextEventTime();
@@ -930,7 +1009,7 @@ void AY8910::generateChannels(float** bufs, unsigned num)
 				}
 				if (remaining) {
 					// last interval (without events)
-					addFill(buf, val2, remaining);
+					addRun(buf, val2, remaining);
 					t.advanceFast(remaining);
 					noise.advanceFast(remaining);
 				}
@@ -942,7 +1021,7 @@ void AY8910::generateChannels(float** bufs, unsigned num)
 				auto val = noise.getOutput() * volume;
 				unsigned next = noise.getNextEventTime();
 				while (next <= remaining) {
-					addFill(buf, val, next);
+					addRun(buf, val, next);
 					remaining -= next;
 					noise.doNextEvent();
 					val = noise.getOutput() * volume;
@@ -950,7 +1029,7 @@ void AY8910::generateChannels(float** bufs, unsigned num)
 				}
 				if (remaining) {
 					// last interval (without events)
-					addFill(buf, val, remaining);
+					addRun(buf, val, remaining);
 					noise.advanceFast(remaining);
 				}
 				t.advance(num);
@@ -28,6 +28,12 @@ public:
 	void writeRegister(unsigned reg, byte value, EmuTime::param time);
 	void reset(EmuTime::param time);
 
+	/** Without detune, tone channels without noise are generated as a
+	  * square wave in one go instead of event by event. Only used by the
+	  * unittest, to compare both.
+	  */
+	static void setBulkEnabled(bool enabled) { bulkEnabled = enabled; }
+
 	template<typename Archive>
 	void serialize(Archive& ar, unsigned version);
 
@@ -35,6 +41,7 @@ private:
 	class Generator {
 	public:
 		inline void setPeriod(int value);
+		[[nodiscard]] unsigned getPeriod() const { return period; }
 		[[nodiscard]] inline unsigned getNextEventTime() const;
 		inline void advanceFast(unsigned duration);
 
@@ -161,6 +168,7 @@ private:
 
 	// SoundDevice
 	void generateChannels(float** bufs, unsigned num) override;
+	[[nodiscard]] bool supportsStateOnly() const override { return true; }
 	[[nodiscard]] float getAmplificationFactorImpl() const override;
 
 	// Observer<Setting>
@@ -191,6 +199,10 @@ private:
 	const bool ignorePortDirections;
 	bool doDetune;
 	bool detuneInitialized;
+
+	/** See setBulkEnabled().
+	 */
+	static inline bool bulkEnabled = true;
 };
 
 SERIALIZE_CLASS_VERSION(AY8910::Generator, 2);
@@ -0,0 +1,232 @@
+#include "AsyncWavWriter.hh"
+#include "MSXException.hh"
+#include "Math.hh"
+#include "one_of.hh"
+#include "xrange.hh"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace openmsx {
+
+// Upper bound for the amount of queued data (in samples, for all writers
+// together). This is 16MB, a few seconds of audio even when recording all
+// channels of several sound chips.
+constexpr size_t MAX_QUEUED_SAMPLES = 8 * 1024 * 1024;
+// Keep at most this many unused buffers in the pool.
+constexpr size_t MAX_POOL_SIZE = 64;
+
+class WavWriterThread
+{
+public:
+	[[nodiscard]] static WavWriterThread& instance();
+	~WavWriterThread();
+
+	/** Get an empty buffer (with some capacity) from the pool. */
+	[[nodiscard]] std::vector<int16_t> getBuffer();
+	/** Queue a buffer to be written to the given writer. Only waits when
+	  * the queue is full. */
+	void enqueue(AsyncWav16Writer& writer, std::vector<int16_t>&& buffer);
+	/** Wait till all queued buffers of the given writer are written. */
+	void waitIdle(AsyncWav16Writer& writer);
+	/** Returns the message of a write error of the given writer, but only
+	  * the first time this is called after the error occurred. */
+	[[nodiscard]] std::optional<std::string> takeError(AsyncWav16Writer& writer);
+
+private:
+	WavWriterThread();
+	void run();
+
+private:
+	struct Job {
+		AsyncWav16Writer* writer;
+		std::vector<int16_t> buffer;
+	};
+
+	std::mutex mutex;
+	std::condition_variable workCondition; // a job was added (or quit)
+	std::condition_variable doneCondition; // a job was finished
+	std::deque<Job> queue;
+	std::vector<std::vector<int16_t>> pool; // unused buffers
+	size_t queuedSamples = 0;
+	bool quit = false;
+	std::thread thread; // must be last
+};
+
+WavWriterThread& WavWriterThread::instance()
+{
+	static WavWriterThread oneInstance;
+	return oneInstance;
+}
+
+WavWriterThread::WavWriterThread()
+	: thread([this] { run(); })
+{
+}
+
+WavWriterThread::~WavWriterThread()
+{
+	{
+		std::lock_guard lock(mutex);
+		quit = true;
+	}
+	workCondition.notify_one();
+	thread.join();
+}
+
+std::vector<int16_t> WavWriterThread::getBuffer()
+{
+	std::lock_guard lock(mutex);
+	if (pool.empty()) return {};
+	auto result = std::move(pool.back());
+	pool.pop_back();
+	return result;
+}
+
+void WavWriterThread::enqueue(AsyncWav16Writer& writer, std::vector<int16_t>&& buffer)
+{
+	{
+		std::unique_lock lock(mutex);
+		// Back-pressure, only when the disk is (a lot) too slow.
+		doneCondition.wait(lock, [&] { return queuedSamples < MAX_QUEUED_SAMPLES; });
+		queuedSamples += buffer.size();
+		++writer.pending;
+		queue.push_back(Job{&writer, std::move(buffer)});
+	}
+	workCondition.notify_one();
+}
+
+void WavWriterThread::waitIdle(AsyncWav16Writer& writer)
+{
+	std::unique_lock lock(mutex);
+	doneCondition.wait(lock, [&] { return writer.pending == 0; });
+}
+
+std::optional<std::string> WavWriterThread::takeError(AsyncWav16Writer& writer)
+{
+	std::lock_guard lock(mutex);
+	if (!writer.failed || writer.reported) return {};
+	writer.reported = true;
+	return writer.error;
+}
+
+void WavWriterThread::run()
+{
+	std::unique_lock lock(mutex);
+	while (true) {
+		workCondition.wait(lock, [&] { return quit || !queue.empty(); });
+		if (queue.empty()) return; // quit, but only after all work is done
+
+		auto job = std::move(queue.front());
+		queue.pop_front();
+		auto& w = *job.writer;
+		if (!w.failed) {
+			lock.unlock();
+			std::optional<std::string> error;
+			try {
+				w.writer.write(job.buffer.data(), 1, unsigned(job.buffer.size()));
+			} catch (MSXException& e) {
+				error = e.getMessage();
+			}
+			lock.lock();
+			if (error) {
+				w.failed = true;
+				w.error = std::move(*error);
+			}
+		}
+		queuedSamples -= job.buffer.size();
+		--w.pending;
+		if (pool.size() < MAX_POOL_SIZE) {
+			job.buffer.clear(); // keeps the capacity
+			pool.push_back(std::move(job.buffer));
+		}
+		doneCondition.notify_all();
+	}
+}
+
+
+// class AsyncWav16Writer
+
+AsyncWav16Writer::AsyncWav16Writer(const Filename& filename,
+                                   unsigned channels, unsigned frequency)
+	: writer(filename, channels, frequency)
+{
+}
+
+AsyncWav16Writer::~AsyncWav16Writer()
+{
+	// Afterwards the destructor of 'writer' updates the header.
+	WavWriterThread::instance().waitIdle(*this);
+}
+
+void AsyncWav16Writer::flush()
+{
+	WavWriterThread::instance().waitIdle(*this);
+	checkError();
+	// nothing is queued anymore, so the background thread doesn't use
+	// 'writer' now
+	writer.flush();
+}
+
+void AsyncWav16Writer::checkError()
+{
+	if (auto message = WavWriterThread::instance().takeError(*this)) {
+		throw MSXException(std::move(*message));
+	}
+}
+
+static int16_t float2int16(float f)
+{
+	return Math::clipIntToShort(lrintf(32768.0f * f));
+}
+
+void AsyncWav16Writer::write(const int16_t* buffer, unsigned stereo, unsigned samples)
+{
+	assert(stereo == one_of(1u, 2u));
+	checkError();
+	auto& wt = WavWriterThread::instance();
+	auto buf = wt.getBuffer();
+	buf.assign(buffer, buffer + stereo * samples);
+	wt.enqueue(*this, std::move(buf));
+}
+
+void AsyncWav16Writer::write(const float* buffer, unsigned stereo, unsigned samples,
+                             float ampLeft, float ampRight)
+{
+	assert(stereo == one_of(1u, 2u));
+	checkError();
+	auto& wt = WavWriterThread::instance();
+	auto buf = wt.getBuffer();
+	buf.resize(stereo * samples);
+	if (stereo == 1) {
+		assert(ampLeft == ampRight);
+		for (auto i : xrange(samples)) {
+			buf[i] = float2int16(buffer[i] * ampLeft);
+		}
+	} else {
+		for (auto i : xrange(samples)) {
+			buf[2 * i + 0] = float2int16(buffer[2 * i + 0] * ampLeft);
+			buf[2 * i + 1] = float2int16(buffer[2 * i + 1] * ampRight);
+		}
+	}
+	wt.enqueue(*this, std::move(buf));
+}
+
+void AsyncWav16Writer::writeSilence(unsigned stereo, unsigned samples)
+{
+	assert(stereo == one_of(1u, 2u));
+	checkError();
+	auto& wt = WavWriterThread::instance();
+	auto buf = wt.getBuffer();
+	buf.assign(stereo * samples, 0);
+	wt.enqueue(*this, std::move(buf));
+}
+
+} // namespace openmsx
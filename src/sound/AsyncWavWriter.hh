@@ -0,0 +1,74 @@
+#ifndef ASYNCWAVWRITER_HH
+#define ASYNCWAVWRITER_HH
+
+#include "WavWriter.hh"
+#include <cstdint>
+#include <string>
+
+namespace openmsx {
+
+class Filename;
+class WavWriterThread;
+
+/** Like Wav16Writer, but the actual file I/O is done by a background thread,
+  * so that the caller (the emulation thread or one of the sound threads)
+  * doesn't have to wait for the disk.
+  *
+  * The samples are converted to 16-bit in buffers that are taken from a
+  * pool, and then queued for the background thread. The total amount of
+  * queued data is bounded. So only when the disk can't keep up with the
+  * data rate for a longer time, the caller has to wait.
+  *
+  * All writers share a single background thread. Different writers may be
+  * used concurrently from different threads, but one writer must only be
+  * used by one thread at a time.
+  */
+class AsyncWav16Writer
+{
+public:
+	/** Opens the file (synchronously, so errors are reported here). */
+	AsyncWav16Writer(const Filename& filename, unsigned channels, unsigned frequency);
+
+	/** Waits till all queued data of this writer is written and then
+	  * finalizes the file. Errors that were not yet reported are lost,
+	  * call flush() first to get them reported.
+	  */
+	~AsyncWav16Writer();
+
+	AsyncWav16Writer(const AsyncWav16Writer&) = delete;
+	AsyncWav16Writer& operator=(const AsyncWav16Writer&) = delete;
+
+	void write(const int16_t* buffer, unsigned stereo, unsigned samples);
+	void write(const float* buffer, unsigned stereo, unsigned samples,
+	           float ampLeft, float ampRight);
+	void writeSilence(unsigned stereo, unsigned samples);
+
+	/** Waits till all queued data of this writer is written and updates
+	  * the header of the file (so it's a valid file, also when the
+	  * recording continues).
+	  */
+	void flush();
+
+	// A write error in the background thread is reported (as an
+	// MSXException) by the next call to one of the methods above. After
+	// an error the remaining data is dropped.
+
+private:
+	void checkError();
+
+private:
+	friend class WavWriterThread;
+
+	// After construction, only used by the background thread (or after
+	// all queued data is written).
+	Wav16Writer writer;
+	// Protected by the mutex of the background thread.
+	std::string error;     // message of the first write error
+	unsigned pending = 0;  // number of queued buffers
+	bool failed = false;   // stop writing after an error
+	bool reported = false; // 'error' was already thrown
+};
+
+} // namespace openmsx
+
+#endif
@@ -11,9 +11,11 @@
 #include "BooleanSetting.hh"
 #include "CommandException.hh"
 #include "AviRecorder.hh"
+#include "VgmRecorder.hh"
 #include "Filename.hh"
 #include "FileOperations.hh"
 #include "CliComm.hh"
+#include "WorkerPool.hh"
 #include "stl.hh"
 #include "aligned.hh"
 #include "one_of.hh"
@@ -50,6 +52,7 @@ MSXMixer::MSXMixer(Mixer& mixer_, MSXMotherBoard& motherBoard_,
 	, prevTime(getCurrentTime(), 44100)
 	, soundDeviceInfo(commandController.getMachineInfoCommand())
 	, recorder(nullptr)
+	, vgmRecorderOwner(std::make_unique<VgmRecorder>(motherBoard, *this))
 	, synchronousCounter(0)
 {
 	hostSampleRate = 44100;
@@ -70,6 +73,7 @@ MSXMixer::~MSXMixer()
 	if (recorder) {
 		recorder->stop();
 	}
+	vgmRecorderOwner.reset(); // finishes an active VGM recording
 	assert(infos.empty());
 
 	throttleManager.detach(*this);
@@ -408,6 +412,20 @@ static bool approxEqual(float x, float y)
 	return std::abs(x - y) < threshold;
 }
 
+// In 'state-only' mode sound devices only emulate the state that's visible to
+// the MSX (timers, status flags, ...), but they don't generate any sound. This
+// is used when nobody listens to the output anyway: without sound driver (or
+// when muted) or during fast-forward (e.g. when jumping in the reverse
+// history). For devices that support it the emulation stays the same, so e.g.
+// replays remain in sync.
+// Note: at higher emulation speeds the sound is still generated, it's still
+// audible, only (much) faster.
+bool MSXMixer::isStateOnly() const
+{
+	return !recorder && (motherBoard.isFastForwarding() ||
+	                     (fragmentSize == 0) || (muteCount != 0));
+}
+
 void MSXMixer::generate(float* output, EmuTime::param time, unsigned samples)
 {
 	// The code below is specialized for a lot of cases (before this
@@ -417,11 +435,24 @@ void MSXMixer::generate(float* output, EmuTime::param time, unsigned samples)
 	// faster for the common cases (mono output or no sound at all).
 	// In total emulation time this gave a speedup of about 2%.
 
+	bool stateOnly = isStateOnly();
+	for (auto& info : infos) {
+		bool skip = stateOnly && info.device->canSkipGeneration();
+		if (info.skipped && !skip) {
+			// Restart sound generation at the current time (this
+			// resets the resampler).
+			info.device->setOutputRate(hostSampleRate);
+		}
+		info.skipped = skip;
+		if (skip) info.device->skipBuffer(time);
+	}
+
 	// When samples==0, call updateBuffer() but skip all further processing
 	// (handling this as a special case allows to simplify the code below).
 	if (samples == 0) {
 		ALIGNAS_SSE float dummyBuf[4];
 		for (auto& info : infos) {
+			if (info.skipped) continue;
 			bool ignore = info.device->updateBuffer(0, dummyBuf, time);
 			(void)ignore;
 		}
@@ -434,36 +465,65 @@ void MSXMixer::generate(float* output, EmuTime::param time, unsigned samples)
 	VLA_SSE_ALIGNED(float, stereoBuf, 2 * samples + 3);
 	VLA_SSE_ALIGNED(float, tmpBuf,    2 * samples + 3);
 
+	// Optionally let all devices generate their samples in parallel (each
+	// in their own buffer). The mixing below still happens in the same
+	// order and with the same operations, so the result is identical.
+	auto* pool = (infos.size() > 1) ? mixer.getWorkerPool() : nullptr;
+	unsigned pitch = (2 * samples + 3 + 3) & ~3; // keep SSE alignment
+	if (pool) {
+		size_t size = infos.size() * pitch;
+		if (deviceBuffersSize < size) {
+			deviceBuffers.resize(size);
+			deviceBuffersSize = size;
+		}
+		deviceResults.resize(infos.size());
+		pool->parallelFor(unsigned(infos.size()), [&](unsigned i) {
+			deviceResults[i] = !infos[i].skipped &&
+				infos[i].device->updateBuffer(
+					samples, &deviceBuffers[i * pitch], time);
+		});
+	}
+	auto updateBuffer = [&](size_t i, float* buf) {
+		if (infos[i].skipped) return false;
+		SoundDevice& device = *infos[i].device;
+		if (!pool) return device.updateBuffer(samples, buf, time);
+		if (!deviceResults[i]) return false;
+		unsigned num = device.isStereo() ? 2 * samples : samples;
+		memcpy(buf, &deviceBuffers[i * pitch], num * sizeof(float));
+		return true;
+	};
+
 	constexpr unsigned HAS_MONO_FLAG = 1;
 	constexpr unsigned HAS_STEREO_FLAG = 2;
 	unsigned usedBuffers = 0;
 
 	// FIXME: The Infos should be ordered such that all the mono
 	// devices are handled first
-	for (auto& info : infos) {
+	for (auto i : xrange(infos.size())) {
+		auto& info = infos[i];
 		SoundDevice& device = *info.device;
 		auto l1 = info.left1;
 		auto r1 = info.right1;
 		if (!device.isStereo()) {
 			if (l1 == r1) {
 				if (!(usedBuffers & HAS_MONO_FLAG)) {
-					if (device.updateBuffer(samples, monoBuf, time)) {
+					if (updateBuffer(i, monoBuf)) {
 						usedBuffers |= HAS_MONO_FLAG;
 						mul(monoBuf, samples, l1);
 					}
 				} else {
-					if (device.updateBuffer(samples, tmpBuf, time)) {
+					if (updateBuffer(i, tmpBuf)) {
 						mulAcc(monoBuf, tmpBuf, samples, l1);
 					}
 				}
 			} else {
 				if (!(usedBuffers & HAS_STEREO_FLAG)) {
-					if (device.updateBuffer(samples, stereoBuf, time)) {
+					if (updateBuffer(i, stereoBuf)) {
 						usedBuffers |= HAS_STEREO_FLAG;
 						mulExpand(stereoBuf, samples, l1, r1);
 					}
 				} else {
-					if (device.updateBuffer(samples, tmpBuf, time)) {
+					if (updateBuffer(i, tmpBuf)) {
 						mulExpandAcc(stereoBuf, tmpBuf, samples, l1, r1);
 					}
 				}
@@ -475,23 +535,23 @@ void MSXMixer::generate(float* output, EmuTime::param time, unsigned samples)
 				assert(l2 == 0.0f);
 				assert(r1 == 0.0f);
 				if (!(usedBuffers & HAS_STEREO_FLAG)) {
-					if (device.updateBuffer(samples, stereoBuf, time)) {
+					if (updateBuffer(i, stereoBuf)) {
 						usedBuffers |= HAS_STEREO_FLAG;
 						mul(stereoBuf, 2 * samples, l1);
 					}
 				} else {
-					if (device.updateBuffer(samples, tmpBuf, time)) {
+					if (updateBuffer(i, tmpBuf)) {
 						mulAcc(stereoBuf, tmpBuf, 2 * samples, l1);
 					}
 				}
 			} else {
 				if (!(usedBuffers & HAS_STEREO_FLAG)) {
-					if (device.updateBuffer(samples, stereoBuf, time)) {
+					if (updateBuffer(i, stereoBuf)) {
 						usedBuffers |= HAS_STEREO_FLAG;
 						mulMix2(stereoBuf, samples, l1, l2, r1, r2);
 					}
 				} else {
-					if (device.updateBuffer(samples, tmpBuf, time)) {
+					if (updateBuffer(i, tmpBuf)) {
 						mulMix2Acc(stereoBuf, tmpBuf, samples, l1, l2, r1, r2);
 					}
 				}
@@ -627,10 +687,17 @@ void MSXMixer::changeRecordSetting(const Setting& setting)
 		unsigned channel = 0;
 		for (auto& s : info.channelSettings) {
 			if (s.recordSetting.get() == &setting) {
-				info.device->recordChannel(
-					channel,
-					Filename(FileOperations::expandTilde(string(
-						s.recordSetting->getString()))));
+				try {
+					info.device->recordChannel(
+						channel,
+						Filename(FileOperations::expandTilde(string(
+							s.recordSetting->getString()))));
+				} catch (MSXException& e) {
+					commandController.getCliComm().printWarning(
+						"Error while recording channel ", channel + 1,
+						" of ", info.device->getName(), ": ",
+						e.getMessage());
+				}
 				return;
 			}
 			++channel;
@@ -6,6 +6,8 @@
 #include "InfoTopic.hh"
 #include "EmuTime.hh"
 #include "DynamicClock.hh"
+#include "MemBuffer.hh"
+#include "aligned.hh"
 #include <vector>
 #include <memory>
 
@@ -23,6 +25,7 @@ class StringSetting;
 class BooleanSetting;
 class Setting;
 class AviRecorder;
+class VgmRecorder;
 
 class MSXMixer final : private Schedulable, private Observer<Setting>
                      , private Observer<SpeedManager>
@@ -109,6 +112,14 @@ public:
 	[[nodiscard]] bool needStereoRecording() const;
 	void setRecorder(AviRecorder* recorder);
 
+	/** While a VGM recording is active, this returns the recorder. The
+	  * sound devices report their register writes to it. Otherwise this
+	  * returns nullptr.
+	  */
+	[[nodiscard]] VgmRecorder* getVgmRecorder() const { return vgmRecorder; }
+	// Called by VgmRecorder
+	void setVgmRecorder(VgmRecorder* recorder_) { vgmRecorder = recorder_; }
+
 	// Returns the nominal host sample rate (not adjusted for speed setting)
 	[[nodiscard]] unsigned getSampleRate() const { return hostSampleRate; }
 
@@ -128,6 +139,7 @@ private:
 		};
 		std::vector<ChannelSettings> channelSettings;
 		float left1, right1, left2, right2;
+		bool skipped = false; // in state-only mode, see generate()
 	};
 
 	void updateVolumeParams(SoundDeviceInfo& info);
@@ -135,6 +147,7 @@ private:
 	void reschedule();
 	void reschedule2();
 	void generate(float* output, EmuTime::param time, unsigned samples);
+	[[nodiscard]] bool isStateOnly() const;
 
 	// Schedulable
 	void executeUntil(EmuTime::param time) override;
@@ -156,6 +169,12 @@ private:
 
 	std::vector<SoundDeviceInfo> infos;
 
+	// Used when the sound devices are updated in parallel: one buffer
+	// per device, see generate().
+	MemBuffer<float, SSE_ALIGNMENT> deviceBuffers;
+	size_t deviceBuffersSize = 0;
+	std::vector<char> deviceResults; // bool, but thread-safe to write
+
 	Mixer& mixer;
 	MSXMotherBoard& motherBoard;
 	MSXCommandController& commandController;
@@ -175,6 +194,8 @@ private:
 	} soundDeviceInfo;
 
 	AviRecorder* recorder;
+	std::unique_ptr<VgmRecorder> vgmRecorderOwner; // owns the 'vgm_record' command
+	VgmRecorder* vgmRecorder = nullptr; // only while recording
 	unsigned synchronousCounter;
 
 	unsigned muteCount;
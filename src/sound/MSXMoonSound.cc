@@ -9,6 +9,9 @@
 
 #include "MSXMoonSound.hh"
 #include "Clock.hh"
+#include "MSXMixer.hh"
+#include "MSXMotherBoard.hh"
+#include "VgmRecorder.hh"
 #include "serialize.hh"
 #include "unreachable.hh"
 
@@ -176,6 +179,9 @@ void MSXMoonSound::writeIO(word port, byte value, EmuTime::param time)
 				} else if (opl4latch == 0xf9) {
 					ymf278.setMixLevel(value, time);
 				}
+				if (auto* vgm = getMotherBoard().getMSXMixer().getVgmRecorder()) {
+					vgm->writeYMF278(this, 2, opl4latch, value, time);
+				}
 				ymf278.writeReg(opl4latch, value, time);
 				break;
 			default:
@@ -200,6 +206,10 @@ void MSXMoonSound::writeIO(word port, byte value, EmuTime::param time)
 		case 1:
 		case 3: // write fm register
 			ymf278BusyTime = time + FM_REG_WRITE_DELAY;
+			if (auto* vgm = getMotherBoard().getMSXMixer().getVgmRecorder()) {
+				// both parts are recorded as a single YMF278B chip
+				vgm->writeYMF278(this, opl3latch >> 8, opl3latch & 0xFF, value, time);
+			}
 			ymf262.writeReg(opl3latch, value, time);
 			break;
 		default:
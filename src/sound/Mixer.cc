@@ -6,7 +6,11 @@
 #include "CommandController.hh"
 #include "CliComm.hh"
 #include "MSXException.hh"
+#include "Reactor.hh"
+#include "TclObject.hh"
+#include "WorkerPool.hh"
 #include "one_of.hh"
+#include "outer.hh"
 #include "stl.hh"
 #include "unreachable.hh"
 #include "build-info.hh"
@@ -55,6 +59,12 @@ Mixer::Mixer(Reactor& reactor_, CommandController& commandController_)
 	, samplesSetting(
 		commandController, "samples",
 		"mixer samples", defaultsamples, 64, 8192)
+	, soundThreadsSetting(
+		commandController, "sound_threads",
+		"number of threads used to generate the sound of the different "
+		"sound devices, 1 means all sound is generated in the emulation thread",
+		1, 1, 16)
+	, audioBufferInfo(reactor.getOpenMSXInfoCommand())
 	, muteCount(0)
 {
 	muteSetting       .attach(*this);
@@ -65,6 +75,13 @@ Mixer::Mixer(Reactor& reactor_, CommandController& commandController_)
 	// Set correct initial mute state.
 	if (muteSetting.getBoolean()) ++muteCount;
 
+	if (reactor.isHeadless()) {
+		// Don't even open the configured driver (and don't store
+		// this value in settings.xml).
+		soundDriverSetting.setDontSaveValue(TclObject("null"));
+		soundDriverSetting.setEnum(SND_NULL);
+	}
+
 	reloadDriver();
 }
 
@@ -169,6 +186,17 @@ void Mixer::uploadBuffer(MSXMixer& /*msxMixer*/, float* buffer, unsigned len)
 	driver->uploadBuffer(buffer, len);
 }
 
+WorkerPool* Mixer::getWorkerPool()
+{
+	auto numThreads = unsigned(soundThreadsSetting.getInt());
+	if (numThreads == 1) {
+		workerPool.reset();
+	} else if (!workerPool || (workerPool->getNumThreads() != numThreads)) {
+		workerPool = std::make_unique<WorkerPool>(numThreads);
+	}
+	return workerPool.get();
+}
+
 void Mixer::update(const Setting& setting) noexcept
 {
 	if (&setting == &muteSetting) {
@@ -184,4 +212,27 @@ void Mixer::update(const Setting& setting) noexcept
 	}
 }
 
+
+// class Mixer::AudioBufferInfo
+
+Mixer::AudioBufferInfo::AudioBufferInfo(InfoCommand& openMSXInfoCommand)
+	: InfoTopic(openMSXInfoCommand, "audio_buffer")
+{
+}
+
+void Mixer::AudioBufferInfo::execute(
+	span<const TclObject> /*tokens*/, TclObject& result) const
+{
+	auto& mixer = OUTER(Mixer, audioBufferInfo);
+	result.addDictKeyValues("underruns", int(mixer.driver->getUnderruns()),
+	                        "overruns",  int(mixer.driver->getOverruns()));
+}
+
+std::string Mixer::AudioBufferInfo::help(const std::vector<std::string>& /*tokens*/) const
+{
+	return "Returns the number of buffer underruns (silence was played "
+	       "because the emulation didn't produce sound in time) and "
+	       "overruns (sound was dropped) of the current sound driver.";
+}
+
 } // namespace openmsx
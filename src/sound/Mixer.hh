@@ -4,6 +4,7 @@
 #include "Observer.hh"
 #include "BooleanSetting.hh"
 #include "EnumSetting.hh"
+#include "InfoTopic.hh"
 #include "IntegerSetting.hh"
 #include <vector>
 #include <memory>
@@ -14,6 +15,7 @@ class SoundDriver;
 class Reactor;
 class CommandController;
 class MSXMixer;
+class WorkerPool;
 
 class Mixer final : private Observer<Setting>
 {
@@ -47,6 +49,12 @@ public:
 
 	[[nodiscard]] IntegerSetting& getMasterVolume() { return masterVolume; }
 
+	/** Pool of threads to generate the sound of different sound devices
+	  * in parallel, or nullptr if this is disabled ('sound_threads'
+	  * setting).
+	  */
+	[[nodiscard]] WorkerPool* getWorkerPool();
+
 private:
 	void reloadDriver();
 	void muteHelper();
@@ -58,6 +66,7 @@ private:
 	std::vector<MSXMixer*> msxMixers; // unordered
 
 	std::unique_ptr<SoundDriver> driver;
+	std::unique_ptr<WorkerPool> workerPool;
 	Reactor& reactor;
 	CommandController& commandController;
 
@@ -66,6 +75,14 @@ private:
 	IntegerSetting masterVolume;
 	IntegerSetting frequencySetting;
 	IntegerSetting samplesSetting;
+	IntegerSetting soundThreadsSetting;
+
+	struct AudioBufferInfo final : InfoTopic {
+		explicit AudioBufferInfo(InfoCommand& openMSXInfoCommand);
+		void execute(span<const TclObject> tokens,
+		             TclObject& result) const override;
+		[[nodiscard]] std::string help(const std::vector<std::string>& tokens) const override;
+	} audioBufferInfo;
 
 	int muteCount;
 };
@@ -10,6 +10,44 @@ namespace openmsx {
 
 class ResampledSoundDevice;
 
+/** The coefficient table for one resample ratio (shared between all users of
+  * that ratio) plus the routines that apply it. Separate from ResampleHQ so
+  * that it can be tested and benchmarked without a sound device.
+  */
+class ResampleHQFilter
+{
+public:
+	// Different implementations of the filter loop. Which ones are
+	// available depends on the build and on the host CPU.
+	enum Impl { GENERIC, SSE2, AVX2 };
+
+	explicit ResampleHQFilter(float ratio);
+	~ResampleHQFilter();
+	ResampleHQFilter(const ResampleHQFilter&) = delete;
+	ResampleHQFilter& operator=(const ResampleHQFilter&) = delete;
+
+	[[nodiscard]] unsigned getFilterLen() const { return filterLen; }
+
+	[[nodiscard]] static bool isSupported(Impl impl);
+	/** The fastest supported implementation (detected at runtime). */
+	[[nodiscard]] static Impl getBestImpl();
+
+	/** Calculate 'num' output samples. The first at position 'pos' (in
+	  * input samples, relative to 'buf'), each next one 'ratio' further.
+	  * 'buf' must contain at least 'int(pos) + filterLen' input samples
+	  * for each output sample.
+	  */
+	template<unsigned CHANNELS>
+	void calcOutput(Impl impl, const float* buf, float pos,
+	                float* output, unsigned num) const;
+
+private:
+	const float ratio;
+	float* table;
+	int16_t* permute;
+	unsigned filterLen;
+};
+
 template<unsigned CHANNELS>
 class ResampleHQ final : public ResampleAlgo
 {
@@ -23,19 +61,16 @@ public:
 	                        EmuTime::param time) override;
 
 private:
-	void calcOutput(float pos, float* output);
 	void prepareData(unsigned emuNum);
 
 private:
 	const DynamicClock& hostClock;
 	const float ratio;
+	const ResampleHQFilter filter;
 	unsigned bufStart;
 	unsigned bufEnd;
 	unsigned nonzeroSamples;
-	unsigned filterLen;
 	std::vector<float> buffer;
-	float* table;
-	int16_t* permute;
 };
 
 } // namespace openmsx
@@ -42,6 +42,13 @@ bool ResampledSoundDevice::updateBuffer(unsigned length, float* buffer,
 	return algo->generateOutput(buffer, length, time);
 }
 
+void ResampledSoundDevice::skipBuffer(EmuTime::param time)
+{
+	// E.g. YM2413::writePort() relies on this clock being up-to-date.
+	// (When generating sound, the resampler can run a bit ahead.)
+	if (emuClock.getTime() < time) emuClock.advance(time);
+}
+
 bool ResampledSoundDevice::generateInput(float* buffer, unsigned num)
 {
 	return mixChannels(buffer, num);
@@ -36,6 +36,7 @@ protected:
 	void setOutputRate(unsigned sampleRate) override;
 	bool updateBuffer(unsigned length, float* buffer,
 	                  EmuTime::param time) override;
+	void skipBuffer(EmuTime::param time) override;
 
 	// Observer<Setting>
 	void update(const Setting& setting) noexcept override;
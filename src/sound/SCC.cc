@@ -98,6 +98,7 @@
 
 #include "SCC.hh"
 #include "DeviceConfig.hh"
+#include "VgmRecorder.hh"
 #include "cstd.hh"
 #include "enumerate.hh"
 #include "likely.hh"
@@ -287,6 +288,7 @@ byte SCC::getFreqVol(unsigned address) const
 void SCC::writeMem(byte address, byte value, EmuTime::param time)
 {
 	updateStream(time);
+	if (getVgmRecorder()) recordWrite(address, value, time);
 
 	switch (currentChipMode) {
 	case SCC_Real:
@@ -338,6 +340,31 @@ void SCC::writeMem(byte address, byte value, EmuTime::param time)
 	}
 }
 
+// Translate a write to the SCC memory area to the (memory layout independent)
+// VGM K051649 ports, see VgmRecorder::writeSCC().
+void SCC::recordWrite(byte address, byte value, EmuTime::param time)
+{
+	bool plus = currentChipMode == SCC_plusmode;
+	byte waveEnd   = plus ? 0xA0 : 0x80;
+	byte deformBeg = (currentChipMode == SCC_Real) ? 0xE0 : 0xC0;
+	byte deformEnd = (currentChipMode == SCC_Real) ? 0x00 : 0xE0; // 0 -> 0x100
+	auto* vgm = getVgmRecorder();
+	if (address < waveEnd) {
+		vgm->writeSCC(this, plus, plus ? 4 : 0, address, value, time);
+	} else if (address < waveEnd + 0x20) {
+		byte reg = address & 0x0F;
+		if (reg < 0x0A) {
+			vgm->writeSCC(this, plus, 1, reg, value, time); // frequency
+		} else if (reg < 0x0F) {
+			vgm->writeSCC(this, plus, 2, reg - 0x0A, value, time); // volume
+		} else {
+			vgm->writeSCC(this, plus, 3, 0, value, time); // key on/off
+		}
+	} else if ((address >= deformBeg) && (!deformEnd || (address < deformEnd))) {
+		vgm->writeSCC(this, plus, 5, 0, value, time);
+	}
+}
+
 float SCC::getAmplificationFactorImpl() const
 {
 	return 1.0f / 128.0f;
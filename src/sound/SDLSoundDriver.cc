@@ -16,6 +16,8 @@ namespace openmsx {
 SDLSoundDriver::SDLSoundDriver(Reactor& reactor_,
                                unsigned wantedFreq, unsigned wantedSamples)
 	: reactor(reactor_)
+	, underruns(0)
+	, overruns(0)
 	, muted(true)
 {
 	SDL_AudioSpec desired;
@@ -36,8 +38,7 @@ SDLSoundDriver::SDLSoundDriver(Reactor& reactor_,
 	frequency = obtained.freq;
 	fragmentSize = obtained.samples;
 
-	mixBufferSize = 3 * (obtained.size / sizeof(float)) + 2;
-	mixBuffer.resize(mixBufferSize);
+	mixBuffer.setCapacity(3 * (obtained.size / sizeof(float)));
 	reInit();
 }
 
@@ -48,10 +49,9 @@ SDLSoundDriver::~SDLSoundDriver()
 
 void SDLSoundDriver::reInit()
 {
-	SDL_LockAudioDevice(deviceID);
-	readIdx  = 0;
-	writeIdx = 0;
-	SDL_UnlockAudioDevice(deviceID);
+	// Only called while the audio device is paused, so the audio callback
+	// is not running.
+	mixBuffer.clear();
 }
 
 void SDLSoundDriver::mute()
@@ -81,88 +81,62 @@ unsigned SDLSoundDriver::getSamples() const
 	return fragmentSize;
 }
 
-void SDLSoundDriver::audioCallbackHelper(void* userdata, uint8_t* strm, int len)
+unsigned SDLSoundDriver::getUnderruns() const
 {
-	assert((len & 7) == 0); // stereo, 32 bit float
-	static_cast<SDLSoundDriver*>(userdata)->
-		audioCallback(reinterpret_cast<float*>(strm), len / sizeof(float));
+	return underruns.load(std::memory_order_relaxed);
 }
 
-unsigned SDLSoundDriver::getBufferFilled() const
+unsigned SDLSoundDriver::getOverruns() const
 {
-	int result = writeIdx - readIdx;
-	if (result < 0) result += mixBufferSize;
-	assert((0 <= result) && (unsigned(result) < mixBufferSize));
-	return result;
+	return overruns;
 }
 
-unsigned SDLSoundDriver::getBufferFree() const
+void SDLSoundDriver::audioCallbackHelper(void* userdata, uint8_t* strm, int len)
 {
-	// we can't distinguish completely filled from completely empty
-	// (in both cases readIx would be equal to writeIdx), so instead
-	// we define full as '(writeIdx + 2) == readIdx' (note that index
-	// increases in steps of 2 (stereo)).
-	int result = mixBufferSize - 2 - getBufferFilled();
-	assert((0 <= result) && (unsigned(result) < mixBufferSize));
-	return result;
+	assert((len & 7) == 0); // stereo, 32 bit float
+	static_cast<SDLSoundDriver*>(userdata)->
+		audioCallback(reinterpret_cast<float*>(strm), len / sizeof(float));
 }
 
 void SDLSoundDriver::audioCallback(float* stream, unsigned len)
 {
 	assert((len & 1) == 0); // stereo
-	unsigned available = getBufferFilled();
-	unsigned num = std::min(len, available);
-	if ((readIdx + num) < mixBufferSize) {
-		memcpy(stream, &mixBuffer[readIdx], num * sizeof(float));
-		readIdx += num;
-	} else {
-		unsigned len1 = mixBufferSize - readIdx;
-		memcpy(stream, &mixBuffer[readIdx], len1 * sizeof(float));
-		unsigned len2 = num - len1;
-		memcpy(&stream[len1], &mixBuffer[0], len2 * sizeof(float));
-		readIdx = len2;
-	}
-	int missing = len - available;
-	if (missing > 0) {
+	auto num = unsigned(mixBuffer.pop(stream, len));
+	if (num < len) {
 		// buffer underrun
-		memset(&stream[available], 0, missing * sizeof(float));
+		memset(&stream[num], 0, (len - num) * sizeof(float));
+		underruns.fetch_add(1, std::memory_order_relaxed);
 	}
 }
 
 void SDLSoundDriver::uploadBuffer(float* buffer, unsigned len)
 {
-	SDL_LockAudioDevice(deviceID);
 	len *= 2; // stereo
-	unsigned free = getBufferFree();
+	auto free = unsigned(mixBuffer.getFree());
 	if (len > free) {
 		auto* board = reactor.getMotherBoard();
 		if (board && !board->getMSXMixer().isSynchronousMode() && // when not recording
 		    reactor.getGlobalSettings().getThrottleManager().isThrottled()) {
+			// Wait till the audio callback made room. Poll at least
+			// twice per fragment, so that small fragments don't
+			// underrun while we sleep.
+			auto sleep = std::min<uint64_t>(
+				5000, // 5ms
+				uint64_t(fragmentSize) * 1000000 / (2 * frequency));
 			do {
-				SDL_UnlockAudioDevice(deviceID);
-				Timer::sleep(5000); // 5ms
-				SDL_LockAudioDevice(deviceID);
+				Timer::sleep(sleep);
 				board->getRealTime().resync();
-				free = getBufferFree();
+				free = unsigned(mixBuffer.getFree());
 			} while (len > free);
 		} else {
 			// drop excess samples
 			len = free;
+			++overruns;
 		}
 	}
 	assert(len <= free);
-	if ((writeIdx + len) < mixBufferSize) {
-		memcpy(&mixBuffer[writeIdx], buffer, len * sizeof(float));
-		writeIdx += len;
-	} else {
-		unsigned len1 = mixBufferSize - writeIdx;
-		memcpy(&mixBuffer[writeIdx], buffer, len1 * sizeof(float));
-		unsigned len2 = len - len1;
-		memcpy(&mixBuffer[0], &buffer[len1], len2 * sizeof(float));
-		writeIdx = len2;
-	}
-
-	SDL_UnlockAudioDevice(deviceID);
+	auto written = mixBuffer.push(buffer, len);
+	assert(written == len); (void)written;
 }
 
 } // namespace openmsx
@@ -3,8 +3,9 @@
 
 #include "SoundDriver.hh"
 #include "SDLSurfacePtr.hh"
-#include "MemBuffer.hh"
+#include "SPSCRingBuffer.hh"
 #include <SDL.h>
+#include <atomic>
 
 namespace openmsx {
 
@@ -27,21 +28,24 @@ public:
 
 	void uploadBuffer(float* buffer, unsigned len) override;
 
+	[[nodiscard]] unsigned getUnderruns() const override;
+	[[nodiscard]] unsigned getOverruns() const override;
+
 private:
 	void reInit();
-	[[nodiscard]] unsigned getBufferFilled() const;
-	[[nodiscard]] unsigned getBufferFree() const;
 	static void audioCallbackHelper(void* userdata, uint8_t* strm, int len);
 	void audioCallback(float* stream, unsigned len);
 
 private:
 	Reactor& reactor;
 	SDL_AudioDeviceID deviceID;
-	MemBuffer<float> mixBuffer;
-	unsigned mixBufferSize;
+	// Written by the emulation thread (uploadBuffer()), read by the audio
+	// callback. No locking is needed for this.
+	SPSCRingBuffer<float> mixBuffer;
 	unsigned frequency;
 	unsigned fragmentSize;
-	unsigned readIdx, writeIdx;
+	std::atomic<unsigned> underruns; // only written by the audio callback
+	unsigned overruns;
 	bool muted;
 	SDLSubSystemInitializer<SDL_INIT_AUDIO> audioInitializer;
 };
@@ -1,6 +1,7 @@
 #include "SN76489.hh"
 #include "DeviceConfig.hh"
 #include "Math.hh"
+#include "VgmRecorder.hh"
 #include "cstd.hh"
 #include "one_of.hh"
 #include "outer.hh"
@@ -147,6 +148,9 @@ void SN76489::reset(EmuTime::param time)
 
 void SN76489::write(byte value, EmuTime::param time)
 {
+	if (auto* vgm = getVgmRecorder()) {
+		vgm->writeSN76489(this, value, time);
+	}
 	if (value & 0x80) {
 		registerLatch = (value & 0x70) >> 4;
 	}
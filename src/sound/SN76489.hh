@@ -29,6 +29,7 @@ public:
 
 	// ResampledSoundDevice
 	void generateChannels(float** buffers, unsigned num) override;
+	[[nodiscard]] bool supportsStateOnly() const override { return true; }
 
 	void reset(EmuTime::param time);
 	void write(byte value, EmuTime::param time);
@@ -2,7 +2,7 @@
 #include "MSXMixer.hh"
 #include "DeviceConfig.hh"
 #include "XMLElement.hh"
-#include "WavWriter.hh"
+#include "AsyncWavWriter.hh"
 #include "Filename.hh"
 #include "StringOp.hh"
 #include "MemoryOps.hh"
@@ -16,13 +16,15 @@
 #include "xrange.hh"
 #include <cassert>
 #include <memory>
+#include <utility>
 
 using std::string;
 
 namespace openmsx {
 
-static MemBuffer<float, SSE_ALIGNMENT> mixBuffer;
-static unsigned mixBufferSize = 0;
+// thread_local: sound devices can be updated in parallel (see 'sound_threads')
+static thread_local MemBuffer<float, SSE_ALIGNMENT> mixBuffer;
+static thread_local unsigned mixBufferSize = 0;
 
 static void allocateMixBuffer(unsigned size)
 {
@@ -84,6 +86,21 @@ bool SoundDevice::isStereo() const
 	return stereo == 2 || !balanceCenter;
 }
 
+bool SoundDevice::supportsStateOnly() const
+{
+	return false;
+}
+
+bool SoundDevice::canSkipGeneration() const
+{
+	return supportsStateOnly() &&
+	       ranges::none_of(writer, [](auto& w) { return w != nullptr; });
+}
+
+void SoundDevice::skipBuffer(EmuTime::param /*time*/)
+{
+}
+
 float SoundDevice::getAmplificationFactorImpl() const
 {
 	return 1.0f / 32768.0f;
@@ -159,13 +176,14 @@ void SoundDevice::setSoftwareVolume(float left, float right, EmuTime::param time
 void SoundDevice::recordChannel(unsigned channel, const Filename& filename)
 {
 	assert(channel < numChannels);
-	bool wasRecording = writer[channel] != nullptr;
+	// When opening the new file fails, the current recording continues.
+	std::unique_ptr<AsyncWav16Writer> newWriter;
 	if (!filename.empty()) {
-		writer[channel] = std::make_unique<Wav16Writer>(
+		newWriter = std::make_unique<AsyncWav16Writer>(
 			filename, stereo, inputSampleRate);
-	} else {
-		writer[channel].reset();
 	}
+	bool wasRecording = writer[channel] != nullptr;
+	auto oldWriter = std::exchange(writer[channel], std::move(newWriter));
 	bool recording = writer[channel] != nullptr;
 	if (recording != wasRecording) {
 		if (recording) {
@@ -182,6 +200,8 @@ void SoundDevice::recordChannel(unsigned channel, const Filename& filename)
 			}
 		}
 	}
+	// report write errors of the previous recording
+	if (oldWriter) oldWriter->flush();
 }
 
 void SoundDevice::muteChannel(unsigned channel, bool muted)
@@ -11,7 +11,7 @@
 namespace openmsx {
 
 class DeviceConfig;
-class Wav16Writer;
+class AsyncWav16Writer;
 class Filename;
 class DynamicClock;
 
@@ -68,6 +68,14 @@ public:
 	void recordChannel(unsigned channel, const Filename& filename);
 	void muteChannel  (unsigned channel, bool muted);
 
+	/** When the sound output isn't needed (see MSXMixer), the mixer can
+	  * run this device in 'state-only' mode: updateBuffer() is not called,
+	  * so no sound is generated. This is only possible when the device
+	  * supports it (see supportsStateOnly()) and when none of its
+	  * channels are being recorded.
+	  */
+	[[nodiscard]] bool canSkipGeneration() const;
+
 protected:
 	/** Constructor.
 	  * @param mixer The Mixer object
@@ -91,6 +99,15 @@ protected:
 	  */
 	[[nodiscard]] virtual float getAmplificationFactorImpl() const;
 
+	/** Is all state that's observable by the MSX emulated independently
+	  * of generateChannels()? For example timers, status flags or ADPCM
+	  * read pointers should not be updated as a side effect of sound
+	  * generation. Only then the MSXMixer may skip sound generation for
+	  * this device, while emulation remains deterministic.
+	  * The default implementation returns false.
+	  */
+	[[nodiscard]] virtual bool supportsStateOnly() const;
+
 	/**
 	 * Registers this sound device with the Mixer.
 	 * Call this method when the sound device is ready to start receiving
@@ -108,6 +125,12 @@ protected:
 	/** @see Mixer::updateStream */
 	void updateStream(EmuTime::param time);
 
+	/** Returns the active VGM recorder, or nullptr when not recording.
+	  * Devices that support VGM recording report their register writes
+	  * to it.
+	  */
+	[[nodiscard]] VgmRecorder* getVgmRecorder() const { return mixer.getVgmRecorder(); }
+
 	void setInputRate(unsigned sampleRate) { inputSampleRate = sampleRate; }
 	[[nodiscard]] unsigned getInputRate() const { return inputSampleRate; }
 
@@ -140,6 +163,13 @@ public: // Will be called by Mixer:
 	[[nodiscard]] virtual bool updateBuffer(unsigned length, float* buffer,
 	                                        EmuTime::param time) = 0;
 
+	/** In state-only mode (see canSkipGeneration()) the Mixer calls this
+	  * method instead of updateBuffer(). No sound is generated, but the
+	  * device should advance its sample clock as if it did.
+	  * The default implementation does nothing.
+	  */
+	virtual void skipBuffer(EmuTime::param time);
+
 protected:
 	/** Adds a number of samples that all have the same value.
 	  * Can be used to synthesize segments of a square wave.
@@ -189,7 +219,7 @@ private:
 	const std::string name;
 	const static_string_view description;
 
-	std::unique_ptr<Wav16Writer> writer[MAX_CHANNELS];
+	std::unique_ptr<AsyncWav16Writer> writer[MAX_CHANNELS];
 
 	float softwareVolumeLeft = 1.0f;
 	float softwareVolumeRight = 1.0f;
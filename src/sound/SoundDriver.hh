@@ -28,6 +28,15 @@ public:
 
 	virtual void uploadBuffer(float* buffer, unsigned len) = 0;
 
+	/** The number of buffer underruns (the driver had to output silence
+	  * because not enough sound data was uploaded in time) and overruns
+	  * (uploaded sound data was dropped because the buffer was full),
+	  * since the driver was created. Drivers without such a buffer
+	  * always return 0.
+	  */
+	[[nodiscard]] virtual unsigned getUnderruns() const { return 0; }
+	[[nodiscard]] virtual unsigned getOverruns() const { return 0; }
+
 protected:
 	SoundDriver() = default;
 };
@@ -0,0 +1,357 @@
+#include "VgmRecorder.hh"
+#include "MSXCommandController.hh"
+#include "MSXMixer.hh"
+#include "MSXMotherBoard.hh"
+#include "CliComm.hh"
+#include "CommandException.hh"
+#include "FileContext.hh"
+#include "FileException.hh"
+#include "FileOperations.hh"
+#include "TclArgParser.hh"
+#include "TclObject.hh"
+#include "outer.hh"
+#include "xrange.hh"
+#include <algorithm>
+#include <array>
+#include <cassert>
+
+namespace openmsx {
+
+// VGM files always use a 44100Hz time base.
+constexpr unsigned VGM_RATE = 44100;
+// Size of the header we write (VGM version 1.61). The music data starts
+// right after it.
+constexpr unsigned HEADER_SIZE = 0x100;
+// Write to disk in blocks of (at least) this size.
+constexpr size_t FLUSH_SIZE = 64 * 1024;
+
+VgmRecorder::VgmRecorder(MSXMotherBoard& motherBoard_, MSXMixer& mixer_)
+	: motherBoard(motherBoard_)
+	, mixer(mixer_)
+	, vgmRecordCommand(motherBoard.getMSXCommandController())
+	, fileSize(0)
+	, skippedDevices(false)
+	, ym2149(false)
+	, sccPlus(false)
+	, startTime(EmuTime::zero())
+	, started(false)
+	, samples(0)
+{
+	std::fill(std::begin(devices), std::end(devices), nullptr);
+}
+
+VgmRecorder::~VgmRecorder()
+{
+	if (isRecording()) {
+		// The machine is being destroyed, don't query the current time
+		// anymore. The recording ends at the last register write.
+		finish();
+	}
+}
+
+void VgmRecorder::start(const std::string& filename_)
+{
+	assert(!isRecording());
+	file = File(filename_, File::TRUNCATE);
+	filename = filename_;
+	// placeholder, the real header is written by finish()
+	buffer.assign(HEADER_SIZE, 0);
+	fileSize = HEADER_SIZE;
+	std::fill(std::begin(devices), std::end(devices), nullptr);
+	skippedDevices = false;
+	ym2149 = false;
+	sccPlus = false;
+	started = false;
+	samples = 0;
+	mixer.setVgmRecorder(this);
+}
+
+std::string VgmRecorder::stop()
+{
+	assert(isRecording());
+	if (started) advanceTime(motherBoard.getCurrentTime());
+	if (!isRecording()) return "Error while writing VGM file.";
+	return finish();
+}
+
+std::string VgmRecorder::finish()
+{
+	mixer.setVgmRecorder(nullptr);
+	buffer.push_back(0x66); // end of sound data
+	++fileSize;
+	std::string result;
+	try {
+		flush();
+		writeHeader();
+		result = strCat("Recorded ", double(samples) / VGM_RATE,
+		                " seconds to ", filename);
+		if (skippedDevices) {
+			strAppend(result, " (only the first sound chip of each "
+			                  "type was recorded)");
+		}
+	} catch (FileException& e) {
+		result = strCat("Error while writing VGM file: ", e.getMessage());
+	}
+	file.close();
+	buffer.clear();
+	return result;
+}
+
+bool VgmRecorder::accept(Chip chip, const void* device, EmuTime::param time)
+{
+	if (!devices[chip]) {
+		devices[chip] = device;
+	} else if (devices[chip] != device) {
+		skippedDevices = true;
+		return false;
+	}
+	advanceTime(time);
+	return true;
+}
+
+void VgmRecorder::advanceTime(EmuTime::param time)
+{
+	if (!started) {
+		// Start the recording at the first register write, this
+		// avoids silence at the start.
+		started = true;
+		startTime = time;
+		return;
+	}
+	if (time <= startTime) return;
+	auto target = (time - startTime).getTicksAt(VGM_RATE);
+	while (samples < target) {
+		auto n = std::min(target - samples, 0xFFFFu);
+		if (n <= 16) {
+			addCommand({uint8_t(0x70 + n - 1)});
+		} else if (n == 735) {
+			addCommand({0x62}); // 1/60 s
+		} else if (n == 882) {
+			addCommand({0x63}); // 1/50 s
+		} else {
+			addCommand({0x61, uint8_t(n & 0xFF), uint8_t(n >> 8)});
+		}
+		samples += n;
+	}
+}
+
+void VgmRecorder::addCommand(std::initializer_list<uint8_t> command)
+{
+	buffer.insert(buffer.end(), command);
+	fileSize += command.size();
+	if (buffer.size() >= FLUSH_SIZE) {
+		try {
+			flush();
+		} catch (FileException& e) {
+			// This is called from the sound devices, so don't throw.
+			motherBoard.getMSXCliComm().printWarning(
+				"Error while writing VGM file, recording stopped: ",
+				e.getMessage());
+			mixer.setVgmRecorder(nullptr);
+			file.close();
+			buffer.clear();
+		}
+	}
+}
+
+void VgmRecorder::flush()
+{
+	file.write(buffer.data(), buffer.size());
+	buffer.clear();
+}
+
+void VgmRecorder::writeHeader()
+{
+	std::array<uint8_t, HEADER_SIZE> header = {};
+	auto set8  = [&](unsigned offset, uint8_t value) { header[offset] = value; };
+	auto set16 = [&](unsigned offset, uint16_t value) {
+		set8(offset + 0, value & 0xFF);
+		set8(offset + 1, value >> 8);
+	};
+	auto set32 = [&](unsigned offset, uint32_t value) {
+		set16(offset + 0, value & 0xFFFF);
+		set16(offset + 2, value >> 16);
+	};
+	auto setClock = [&](unsigned offset, Chip chip, uint32_t clock) {
+		if (devices[chip]) set32(offset, clock);
+	};
+
+	set32(0x00, 0x206D6756); // "Vgm "
+	set32(0x04, uint32_t(fileSize - 4)); // EOF offset
+	set32(0x08, 0x161); // version 1.61
+	set32(0x18, samples);
+	set32(0x34, HEADER_SIZE - 0x34); // VGM data offset
+	setClock(0x0C, SN76489, 3579545);
+	if (devices[SN76489]) {
+		set16(0x28, 0x0003); // SN76489A noise feedback pattern
+		set8 (0x2A, 15);     // and shift register width
+	}
+	setClock(0x10, YM2413,  3579545);
+	setClock(0x30, YM2151,  3579545);
+	setClock(0x58, Y8950,   3579545);
+	setClock(0x5C, YMF262, 14318180);
+	setClock(0x60, YMF278, 33868800);
+	setClock(0x74, AY8910,  1789773);
+	if (devices[AY8910]) {
+		set8(0x78, ym2149 ? 0x10 : 0x00); // chip type
+		set8(0x79, 0x01); // flags: legacy output
+	}
+	// bit 31 set means K052539 (SCC+)
+	setClock(0x9C, SCC, 1789773 | (sccPlus ? 0x80000000 : 0));
+
+	file.seek(0);
+	file.write(header.data(), header.size());
+}
+
+void VgmRecorder::writeAY8910(const void* device, bool ym2149_, byte reg, byte value, EmuTime::param time)
+{
+	if (!accept(AY8910, device, time)) return;
+	ym2149 = ym2149_;
+	addCommand({0xA0, reg, value});
+}
+
+void VgmRecorder::writeSN76489(const void* device, byte value, EmuTime::param time)
+{
+	if (!accept(SN76489, device, time)) return;
+	addCommand({0x50, value});
+}
+
+void VgmRecorder::writeYM2413(const void* device, byte reg, byte value, EmuTime::param time)
+{
+	if (!accept(YM2413, device, time)) return;
+	addCommand({0x51, reg, value});
+}
+
+void VgmRecorder::writeY8950(const void* device, byte reg, byte value, EmuTime::param time)
+{
+	if (!accept(Y8950, device, time)) return;
+	addCommand({0x5C, reg, value});
+}
+
+void VgmRecorder::writeYMF262(const void* device, unsigned reg, byte value, EmuTime::param time)
+{
+	if (!accept(YMF262, device, time)) return;
+	addCommand({uint8_t((reg & 0x100) ? 0x5F : 0x5E), uint8_t(reg & 0xFF), value});
+}
+
+void VgmRecorder::writeYMF278(const void* device, byte port, byte reg, byte value, EmuTime::param time)
+{
+	if (!accept(YMF278, device, time)) return;
+	addCommand({0xD0, port, reg, value});
+}
+
+void VgmRecorder::writeYM2151(const void* device, byte reg, byte value, EmuTime::param time)
+{
+	if (!accept(YM2151, device, time)) return;
+	addCommand({0x54, reg, value});
+}
+
+void VgmRecorder::writeSCC(const void* device, bool plus, byte port, byte reg, byte value, EmuTime::param time)
+{
+	if (!accept(SCC, device, time)) return;
+	sccPlus |= plus;
+	addCommand({0xD2, port, reg, value});
+}
+
+void VgmRecorder::processStart(Interpreter& interp, span<const TclObject> tokens, TclObject& result)
+{
+	std::string_view prefix = "music";
+	ArgsInfo info[] = { valueArg("-prefix", prefix) };
+	auto arguments = parseTclArgs(interp, tokens.subspan(2), info);
+
+	std::string_view filenameArg;
+	switch (arguments.size()) {
+	case 0:
+		// nothing
+		break;
+	case 1:
+		filenameArg = arguments[0].getString();
+		break;
+	default:
+		throw SyntaxError();
+	}
+	auto name = FileOperations::parseCommandFileArgument(
+		filenameArg, "vgm_recordings", prefix, ".vgm");
+
+	if (isRecording()) {
+		result = "Already recording.";
+	} else {
+		try {
+			start(name);
+		} catch (FileException& e) {
+			throw CommandException("Couldn't start VGM recording: ", e.getMessage());
+		}
+		result = tmpStrCat("Recording to ", name);
+	}
+}
+
+void VgmRecorder::processToggle(Interpreter& interp, span<const TclObject> tokens, TclObject& result)
+{
+	if (isRecording()) {
+		result = stop();
+	} else {
+		processStart(interp, tokens, result);
+	}
+}
+
+void VgmRecorder::status(TclObject& result) const
+{
+	result.addDictKeyValue("status", isRecording() ? "recording" : "idle");
+}
+
+
+// class VgmRecorder::Cmd
+
+VgmRecorder::Cmd::Cmd(CommandController& commandController_)
+	: Command(commandController_, "vgm_record")
+{
+}
+
+void VgmRecorder::Cmd::execute(span<const TclObject> tokens, TclObject& result)
+{
+	if (tokens.size() < 2) {
+		throw CommandException("Missing argument");
+	}
+	auto& recorder = OUTER(VgmRecorder, vgmRecordCommand);
+	executeSubCommand(tokens[1].getString(),
+		"start",  [&]{ recorder.processStart(getInterpreter(), tokens, result); },
+		"stop",   [&]{
+			checkNumArgs(tokens, 2, Prefix{2}, nullptr);
+			if (recorder.isRecording()) result = recorder.stop(); },
+		"toggle", [&]{ recorder.processToggle(getInterpreter(), tokens, result); },
+		"status", [&]{
+			checkNumArgs(tokens, 2, Prefix{2}, nullptr);
+			recorder.status(result); });
+}
+
+std::string VgmRecorder::Cmd::help(const std::vector<std::string>& /*tokens*/) const
+{
+	return "Records the register writes to the sound chips to a .vgm file.\n"
+	       "vgm_record start              Record to file 'musicNNNN.vgm'\n"
+	       "vgm_record start <filename>   Record to given file\n"
+	       "vgm_record start -prefix foo  Record to file 'fooNNNN.vgm'\n"
+	       "vgm_record stop               Stop recording\n"
+	       "vgm_record toggle             Toggle recording (useful as keybinding)\n"
+	       "vgm_record status             Query recording state\n"
+	       "\n"
+	       "Supported chips: PSG (AY8910/YM2149), SN76489, MSX-MUSIC (YM2413), "
+	       "MSX-AUDIO (Y8950), OPL3 (YMF262), MoonSound (YMF278), SFG (YM2151) "
+	       "and SCC/SCC+. The recording starts at the first register write. "
+	       "Only the first chip of each type is recorded.";
+}
+
+void VgmRecorder::Cmd::tabCompletion(std::vector<std::string>& tokens) const
+{
+	using namespace std::literals;
+	if (tokens.size() == 2) {
+		static constexpr std::array cmds = {
+			"start"sv, "stop"sv, "toggle"sv, "status"sv,
+		};
+		completeString(tokens, cmds);
+	} else if ((tokens.size() >= 3) && (tokens[1] == "start")) {
+		static constexpr std::array options = { "-prefix"sv };
+		completeFileName(tokens, userFileContext(), options);
+	}
+}
+
+} // namespace openmsx
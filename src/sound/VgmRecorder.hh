@@ -0,0 +1,101 @@
+#ifndef VGMRECORDER_HH
+#define VGMRECORDER_HH
+
+#include "Command.hh"
+#include "EmuTime.hh"
+#include "File.hh"
+#include "openmsx.hh"
+#include "span.hh"
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+namespace openmsx {
+
+class MSXMixer;
+class MSXMotherBoard;
+class Interpreter;
+class TclObject;
+
+/** Records the register writes to the sound chips of one machine to a VGM
+  * file. This is a lot cheaper than recording the audio itself (both in CPU
+  * time and in file size), and the file can later be rendered offline at any
+  * quality.
+  *
+  * While recording, the sound devices report their register writes via
+  * MSXMixer::getVgmRecorder(). Only the first device of each type is
+  * recorded (e.g. only the first of two SCC cartridges).
+  */
+class VgmRecorder
+{
+public:
+	VgmRecorder(MSXMotherBoard& motherBoard, MSXMixer& mixer);
+	~VgmRecorder();
+
+	// Called by the sound devices. 'device' identifies the instance.
+	void writeAY8910(const void* device, bool ym2149, byte reg, byte value, EmuTime::param time);
+	void writeSN76489(const void* device, byte value, EmuTime::param time);
+	void writeYM2413(const void* device, byte reg, byte value, EmuTime::param time);
+	void writeY8950(const void* device, byte reg, byte value, EmuTime::param time);
+	void writeYMF262(const void* device, unsigned reg, byte value, EmuTime::param time);
+	/** @param port 0/1 for the FM register banks, 2 for the wave part */
+	void writeYMF278(const void* device, byte port, byte reg, byte value, EmuTime::param time);
+	void writeYM2151(const void* device, byte reg, byte value, EmuTime::param time);
+	/** @param port VGM K051649 port: 0 = waveform, 1 = frequency,
+	  *             2 = volume, 3 = key on/off, 4 = waveform (SCC+),
+	  *             5 = deformation register
+	  * @param plus Is the SCC in SCC+ mode?
+	  */
+	void writeSCC(const void* device, bool plus, byte port, byte reg, byte value, EmuTime::param time);
+
+private:
+	enum Chip {
+		AY8910, SN76489, YM2413, Y8950, YMF262, YMF278, YM2151, SCC,
+		NUM_CHIPS
+	};
+
+	void start(const std::string& filename);
+	std::string stop();
+	std::string finish();
+	[[nodiscard]] bool isRecording() const { return file.is_open(); }
+
+	[[nodiscard]] bool accept(Chip chip, const void* device, EmuTime::param time);
+	void addCommand(std::initializer_list<uint8_t> command);
+	void advanceTime(EmuTime::param time);
+	void flush();
+	void writeHeader();
+
+	void processStart(Interpreter& interp, span<const TclObject> tokens, TclObject& result);
+	void processToggle(Interpreter& interp, span<const TclObject> tokens, TclObject& result);
+	void status(TclObject& result) const;
+
+private:
+	MSXMotherBoard& motherBoard;
+	MSXMixer& mixer;
+
+	struct Cmd final : Command {
+		explicit Cmd(CommandController& commandController);
+		void execute(span<const TclObject> tokens, TclObject& result) override;
+		[[nodiscard]] std::string help(const std::vector<std::string>& tokens) const override;
+		void tabCompletion(std::vector<std::string>& tokens) const override;
+	} vgmRecordCommand;
+
+	File file;
+	std::string filename;
+	std::vector<uint8_t> buffer; // not yet written to 'file'
+	size_t fileSize; // including 'buffer'
+
+	const void* devices[NUM_CHIPS]; // first recorded device of each type
+	bool skippedDevices; // were there writes to other devices?
+	bool ym2149;
+	bool sccPlus;
+
+	EmuTime startTime; // time of the first register write
+	bool started;
+	uint32_t samples; // at 44100Hz, since 'startTime'
+};
+
+} // namespace openmsx
+
+#endif
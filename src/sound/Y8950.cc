@@ -10,6 +10,7 @@
 #include "DeviceConfig.hh"
 #include "MSXMotherBoard.hh"
 #include "Math.hh"
+#include "VgmRecorder.hh"
 #include "cstd.hh"
 #include "enumerate.hh"
 #include "outer.hh"
@@ -895,6 +896,9 @@ void Y8950::generateChannels(float** bufs, unsigned num)
 
 void Y8950::writeReg(byte rg, byte data, EmuTime::param time)
 {
+	if (auto* vgm = getVgmRecorder()) {
+		vgm->writeY8950(this, rg, data, time);
+	}
 	int sTbl[32] = {
 		 0,  2,  4,  1,  3,  5, -1, -1,
 		 6,  8, 10,  7,  9, 11, -1, -1,
@@ -76,6 +76,7 @@ private:
 	// SoundDevice
 	[[nodiscard]] float getAmplificationFactorImpl() const override;
 	void generateChannels(float** bufs, unsigned num) override;
+	[[nodiscard]] bool supportsStateOnly() const override { return true; }
 
 	inline void keyOn_BD();
 	inline void keyOn_SD();
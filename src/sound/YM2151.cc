@@ -7,6 +7,7 @@
 #include "YM2151.hh"
 #include "DeviceConfig.hh"
 #include "Math.hh"
+#include "VgmRecorder.hh"
 #include "cstd.hh"
 #include "enumerate.hh"
 #include "ranges.hh"
@@ -646,6 +647,9 @@ void YM2151::refreshEG(YM2151Operator* op)
 
 void YM2151::writeReg(byte r, byte v, EmuTime::param time)
 {
+	if (auto* vgm = getVgmRecorder()) {
+		vgm->writeYM2151(this, r, v, time);
+	}
 	updateStream(time);
 
 	YM2151Operator* op = &oper[(r & 0x07) * 4 + ((r & 0x18) >> 3)];
@@ -119,6 +119,7 @@ private:
 
 	// SoundDevice
 	void generateChannels(float** bufs, unsigned num) override;
+	[[nodiscard]] bool supportsStateOnly() const override { return true; }
 
 	void callback(byte flag) override;
 	void setStatus(byte flags);
@@ -5,6 +5,7 @@
 #include "YM2413OriginalNukeYKT.hh"
 #include "DeviceConfig.hh"
 #include "MSXException.hh"
+#include "VgmRecorder.hh"
 #include "serialize.hh"
 #include "cstd.hh"
 #include "outer.hh"
@@ -92,6 +93,12 @@ void YM2413::writePort(bool port, byte value, EmuTime::param time)
 	assert(offset < 18);
 
 	core->writePort(port, value, offset);
+
+	if (!port) {
+		registerLatch = value;
+	} else if (auto* vgm = getVgmRecorder()) {
+		vgm->writeYM2413(this, registerLatch, value, time);
+	}
 }
 
 void YM2413::pokeReg(byte reg, byte value, EmuTime::param time)
@@ -112,9 +119,12 @@ float YM2413::getAmplificationFactorImpl() const
 
 
 template<typename Archive>
-void YM2413::serialize(Archive& ar, unsigned /*version*/)
+void YM2413::serialize(Archive& ar, unsigned version)
 {
 	ar.serializePolymorphic("ym2413", *core);
+	if (ar.versionAtLeast(version, 2)) {
+		ar.serialize("registerLatch", registerLatch);
+	}
 }
 INSTANTIATE_SERIALIZE_METHODS(YM2413);
 
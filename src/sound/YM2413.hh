@@ -5,6 +5,7 @@
 #include "SimpleDebuggable.hh"
 #include "EmuTime.hh"
 #include "openmsx.hh"
+#include "serialize_meta.hh"
 #include <memory>
 #include <string>
 
@@ -28,10 +29,12 @@ public:
 private:
 	// SoundDevice
 	void generateChannels(float** bufs, unsigned num) override;
+	[[nodiscard]] bool supportsStateOnly() const override { return true; }
 	[[nodiscard]] float getAmplificationFactorImpl() const override;
 
 private:
 	const std::unique_ptr<YM2413Core> core;
+	byte registerLatch = 0; // last written register number
 
 	struct Debuggable final : SimpleDebuggable {
 		Debuggable(MSXMotherBoard& motherBoard, const std::string& name);
@@ -39,6 +42,7 @@ private:
 		void write(unsigned address, byte value, EmuTime::param time) override;
 	} debuggable;
 };
+SERIALIZE_CLASS_VERSION(YM2413, 2);
 
 } // namespace openmsx
 
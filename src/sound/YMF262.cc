@@ -41,23 +41,31 @@
 #include "DeviceConfig.hh"
 #include "MSXMotherBoard.hh"
 #include "Math.hh"
+#include "VgmRecorder.hh"
+#include "avx2.hh"
 #include "cstd.hh"
 #include "outer.hh"
 #include "serialize.hh"
+#include "unreachable.hh"
 #include "xrange.hh"
 #include <array>
+#include <cassert>
 #include <cmath>
 #include <cstring>
 #include <iostream>
+#include <iterator>
+#ifdef __SSE2__
+#include <immintrin.h>
+#endif
 
 namespace openmsx {
 
-[[nodiscard]] static constexpr YMF262::FreqIndex fnumToIncrement(unsigned block_fnum)
+[[nodiscard]] static constexpr YMF262Core::FreqIndex fnumToIncrement(unsigned block_fnum)
 {
 	// opn phase increment counter = 20bit
 	// chip works with 10.10 fixed point, while we use 16.16
 	unsigned block = (block_fnum & 0x1C00) >> 10;
-	return YMF262::FreqIndex(block_fnum & 0x03FF) >> (11 - block);
+	return YMF262Core::FreqIndex(block_fnum & 0x03FF) >> (11 - block);
 }
 
 // envelope output entries
@@ -481,13 +489,7 @@ static constexpr SinTab getSinTab()
 constexpr SinTab sin = getSinTab();
 
 
-// TODO clean this up
-static int phase_modulation;  // phase modulation input (SLOT 2)
-static int phase_modulation2; // phase modulation input (SLOT 3
-                              // in 4 operator channels)
-
-
-YMF262::Slot::Slot()
+YMF262Core::Slot::Slot()
 	: Cnt(0), Incr(0)
 {
 	ar = dr = rr = KSR = ksl = ksr = mul = 0;
@@ -502,7 +504,7 @@ YMF262::Slot::Slot()
 	wavetable = &sin.tab[0 * SIN_LEN];
 }
 
-YMF262::Channel::Channel()
+YMF262Core::Channel::Channel()
 {
 	block_fnum = ksl_base = kcode = 0;
 	extended = false;
@@ -552,7 +554,7 @@ void YMF262::changeStatusMask(byte flag)
 }
 
 
-void YMF262::Slot::advanceEnvelopeGenerator(unsigned egCnt)
+void YMF262Core::Slot::advanceEnvelopeGenerator(unsigned egCnt)
 {
 	switch (state) {
 	case EG_ATTACK:
@@ -611,7 +613,7 @@ void YMF262::Slot::advanceEnvelopeGenerator(unsigned egCnt)
 	}
 }
 
-void YMF262::Slot::advancePhaseGenerator(Channel& ch, unsigned lfo_pm)
+void YMF262Core::Slot::advancePhaseGenerator(Channel& ch, unsigned lfo_pm)
 {
 	if (vib) {
 		// LFO phase modulation active
@@ -625,8 +627,22 @@ void YMF262::Slot::advancePhaseGenerator(Channel& ch, unsigned lfo_pm)
 	}
 }
 
+// Amplitude modulation: 27 output levels (triangle waveform);
+// 1 level takes one of: 192, 256 or 448 samples
+// One entry from LFO_AM_TABLE lasts for 64 samples
+inline unsigned YMF262Core::advanceLfoAM()
+{
+	lfo_am_cnt.addQuantum();
+	if (lfo_am_cnt == LFOAMIndex(LFO_AM_TAB_ELEMENTS)) {
+		// lfo_am_table is 210 elements long
+		lfo_am_cnt = LFOAMIndex(0);
+	}
+	unsigned tmp = lfo_am_table[lfo_am_cnt.toInt()];
+	return lfo_am_depth ? tmp : tmp / 4;
+}
+
 // advance to next sample
-void YMF262::advance()
+void YMF262Core::advance()
 {
 	// Vibrato: 8 output levels (triangle waveform);
 	// 1 level takes 1024 samples
@@ -641,6 +657,11 @@ void YMF262::advance()
 		}
 	}
 
+	advanceNoise();
+}
+
+inline void YMF262Core::advanceNoise()
+{
 	// The Noise Generator of the YM3812 is 23-bit shift register.
 	// Period is equal to 2^23-2 samples.
 	// Register works at sampling frequency of the chip, so output
@@ -666,16 +687,21 @@ void YMF262::advance()
 	noise_rng >>= 1;
 }
 
-inline int YMF262::Slot::op_calc(unsigned phase, unsigned lfo_am) const
+// 'env' is the attenuation: total level + envelope + amplitude modulation
+[[nodiscard]] static inline int opOutput(unsigned env, const unsigned* wavetable, unsigned phase)
 {
-	unsigned env = (TLL + volume + (lfo_am & AMmask)) << 4;
-	int p = env + wavetable[phase & SIN_MASK];
+	int p = (env << 4) + wavetable[phase & SIN_MASK];
 	return (p < TL_TAB_LEN) ? tlTab[p] : 0;
 }
 
+inline int YMF262Core::Slot::op_calc(unsigned phase, unsigned lfo_am) const
+{
+	return opOutput(TLL + volume + (lfo_am & AMmask), wavetable, phase);
+}
+
 // calculate output of a standard 2 operator channel
 // (or 1st part of a 4-op channel)
-void YMF262::Channel::chan_calc(unsigned lfo_am)
+void YMF262Core::Channel::chan_calc(unsigned lfo_am, int& phase_modulation, int& phase_modulation2)
 {
 	// !! something is wrong with this, it caused bug
 	// !!    [2823673] moonsound 4 operator FM fail
@@ -714,7 +740,7 @@ void YMF262::Channel::chan_calc(unsigned lfo_am)
 }
 
 // calculate output of a 2nd part of 4-op channel
-void YMF262::Channel::chan_calc_ext(unsigned lfo_am)
+void YMF262Core::Channel::chan_calc_ext(unsigned lfo_am, int& phase_modulation, int phase_modulation2)
 {
 	// !! see remark in chan_cal(), something is wrong with this
 	// !! optimization disabled for now
@@ -770,14 +796,13 @@ void YMF262::Channel::chan_calc_ext(unsigned lfo_am)
 // The following formulas can be well optimized.
 // I leave them in direct form for now (in case I've missed something).
 
-inline int YMF262::genPhaseHighHat()
+[[nodiscard]] static inline int genPhaseHighHat(int op71phase, int op82phase, unsigned noise_rng)
 {
 	// high hat phase generation (verified on real YM3812):
 	// phase = d0 or 234 (based on frequency only)
 	// phase = 34 or 2d0 (based on noise)
 
 	// base frequency derived from operator 1 in channel 7
-	int op71phase = channel[7].slot[MOD].Cnt.toInt();
 	bool bit7 = (op71phase & 0x80) != 0;
 	bool bit3 = (op71phase & 0x08) != 0;
 	bool bit2 = (op71phase & 0x04) != 0;
@@ -787,7 +812,6 @@ inline int YMF262::genPhaseHighHat()
 	unsigned phase = res1 ? (0x200 | (0xd0 >> 2)) : 0xd0;
 
 	// enable gate based on frequency of operator 2 in channel 8
-	int op82phase = channel[8].slot[CAR].Cnt.toInt();
 	bool bit5e= (op82phase & 0x20) != 0;
 	bool bit3e= (op82phase & 0x08) != 0;
 	bool res2 = (bit3e ^ bit5e);
@@ -813,27 +837,25 @@ inline int YMF262::genPhaseHighHat()
 	return phase;
 }
 
-inline int YMF262::genPhaseSnare()
+[[nodiscard]] static inline int genPhaseSnare(int op71phase, unsigned noise_rng)
 {
 	// verified on real YM3812
 	// base frequency derived from operator 1 in channel 7
 	// noise bit XOR'es phase by 0x100
-	return ((channel[7].slot[MOD].Cnt.toInt() & 0x100) + 0x100)
+	return ((op71phase & 0x100) + 0x100)
 	     ^ ((noise_rng & 1) << 8);
 }
 
-inline int YMF262::genPhaseCymbal()
+[[nodiscard]] static inline int genPhaseCymbal(int op71phase, int op82phase)
 {
 	// verified on real YM3812
 	// enable gate based on frequency of operator 2 in channel 8
 	//  NOTE: YM2413_2 uses bit5 | bit3, this core uses bit5 ^ bit3
 	//        most likely only one of the two is correct
-	int op82phase = channel[8].slot[CAR].Cnt.toInt();
 	if ((op82phase ^ (op82phase << 2)) & 0x20) { // bit5 ^ bit3
 		return 0x300;
 	} else {
 		// base frequency derived from operator 1 in channel 7
-		int op71phase = channel[7].slot[MOD].Cnt.toInt();
 		bool bit7 = (op71phase & 0x80) != 0;
 		bool bit3 = (op71phase & 0x08) != 0;
 		bool bit2 = (op71phase & 0x04) != 0;
@@ -842,7 +864,7 @@ inline int YMF262::genPhaseCymbal()
 }
 
 // calculate rhythm
-void YMF262::chan_calc_rhythm(unsigned lfo_am)
+void YMF262Core::chan_calc_rhythm(unsigned lfo_am)
 {
 	// Bass Drum (verified on real YM3812):
 	//  - depends on the channel 6 'connect' register:
@@ -873,16 +895,18 @@ void YMF262::chan_calc_rhythm(unsigned lfo_am)
 	// TOM channel 8->slot1
 	// TOP channel 8->slot2
 	auto& mod7 = channel[7].slot[MOD];
-	chanout[7] += 2 * mod7.op_calc(genPhaseHighHat(), lfo_am);
 	auto& car7 = channel[7].slot[CAR];
-	chanout[7] += 2 * car7.op_calc(genPhaseSnare(),   lfo_am);
 	auto& mod8 = channel[8].slot[MOD];
-	chanout[8] += 2 * mod8.op_calc(mod8.Cnt.toInt(),  lfo_am);
 	auto& car8 = channel[8].slot[CAR];
-	chanout[8] += 2 * car8.op_calc(genPhaseCymbal(),  lfo_am);
+	int op71phase = mod7.Cnt.toInt();
+	int op82phase = car8.Cnt.toInt();
+	chanout[7] += 2 * mod7.op_calc(genPhaseHighHat(op71phase, op82phase, noise_rng), lfo_am);
+	chanout[7] += 2 * car7.op_calc(genPhaseSnare(op71phase, noise_rng),              lfo_am);
+	chanout[8] += 2 * mod8.op_calc(mod8.Cnt.toInt(),                                 lfo_am);
+	chanout[8] += 2 * car8.op_calc(genPhaseCymbal(op71phase, op82phase),             lfo_am);
 }
 
-void YMF262::Slot::FM_KEYON(byte key_set)
+void YMF262Core::Slot::FM_KEYON(byte key_set)
 {
 	if (!key) {
 		// restart Phase Generator
@@ -893,7 +917,7 @@ void YMF262::Slot::FM_KEYON(byte key_set)
 	key |= key_set;
 }
 
-void YMF262::Slot::FM_KEYOFF(byte key_clr)
+void YMF262Core::Slot::FM_KEYOFF(byte key_clr)
 {
 	if (key) {
 		key &= ~key_clr;
@@ -906,7 +930,7 @@ void YMF262::Slot::FM_KEYOFF(byte key_clr)
 	}
 }
 
-void YMF262::Slot::update_ar_dr()
+void YMF262Core::Slot::update_ar_dr()
 {
 	if ((ar + ksr) < 16 + 60) {
 		// verified on real YMF262 - all 15 x rates take "zero" time
@@ -921,7 +945,7 @@ void YMF262::Slot::update_ar_dr()
 	eg_sel_dr = eg_rate_select[dr + ksr];
 	eg_m_dr   = (1 << eg_sh_dr) - 1;
 }
-void YMF262::Slot::update_rr()
+void YMF262Core::Slot::update_rr()
 {
 	eg_sh_rr  = eg_rate_shift [rr + ksr];
 	eg_sel_rr = eg_rate_select[rr + ksr];
@@ -929,7 +953,7 @@ void YMF262::Slot::update_rr()
 }
 
 // update phase increment counter of operator (also update the EG rates if necessary)
-void YMF262::Slot::calc_fc(const Channel& ch)
+void YMF262Core::Slot::calc_fc(const Channel& ch)
 {
 	// (frequency) phase increment counter
 	Incr = ch.fc * mul;
@@ -947,7 +971,7 @@ static constexpr unsigned channelPairTab[18] = {
 	0,  1,  2,  0,  1,  2, unsigned(~0), unsigned(~0), unsigned(~0),
 	9, 10, 11,  9, 10, 11, unsigned(~0), unsigned(~0), unsigned(~0),
 };
-inline bool YMF262::isExtended(unsigned ch) const
+inline bool YMF262Core::isExtended(unsigned ch) const
 {
 	assert(ch < 18);
 	if (!OPL3_mode) return false;
@@ -959,17 +983,17 @@ static constexpr unsigned getFirstOfPairNum(unsigned ch)
 	assert((ch < 18) && (channelPairTab[ch] != unsigned(~0)));
 	return channelPairTab[ch];
 }
-inline YMF262::Channel& YMF262::getFirstOfPair(unsigned ch)
+inline YMF262Core::Channel& YMF262Core::getFirstOfPair(unsigned ch)
 {
 	return channel[getFirstOfPairNum(ch) + 0];
 }
-inline YMF262::Channel& YMF262::getSecondOfPair(unsigned ch)
+inline YMF262Core::Channel& YMF262Core::getSecondOfPair(unsigned ch)
 {
 	return channel[getFirstOfPairNum(ch) + 3];
 }
 
 // set multi,am,vib,EG-TYP,KSR,mul
-void YMF262::set_mul(unsigned sl, byte v)
+void YMF262Core::set_mul(unsigned sl, byte v)
 {
 	unsigned chan_no = sl / 2;
 	auto& ch = channel[chan_no];
@@ -992,7 +1016,7 @@ void YMF262::set_mul(unsigned sl, byte v)
 }
 
 // set ksl & tl
-void YMF262::set_ksl_tl(unsigned sl, byte v)
+void YMF262Core::set_ksl_tl(unsigned sl, byte v)
 {
 	unsigned chan_no = sl / 2;
 	auto& ch = channel[chan_no];
@@ -1016,7 +1040,7 @@ void YMF262::set_ksl_tl(unsigned sl, byte v)
 }
 
 // set attack rate & decay rate
-void YMF262::set_ar_dr(unsigned sl, byte v)
+void YMF262Core::set_ar_dr(unsigned sl, byte v)
 {
 	auto& ch = channel[sl / 2];
 	auto& slot = ch.slot[sl & 1];
@@ -1027,7 +1051,7 @@ void YMF262::set_ar_dr(unsigned sl, byte v)
 }
 
 // set sustain level & release rate
-void YMF262::set_sl_rr(unsigned sl, byte v)
+void YMF262Core::set_sl_rr(unsigned sl, byte v)
 {
 	auto& ch = channel[sl / 2];
 	auto& slot = ch.slot[sl & 1];
@@ -1045,12 +1069,12 @@ byte YMF262::readReg(unsigned r)
 
 byte YMF262::peekReg(unsigned r) const
 {
-	return reg[r];
+	return core.peekReg(r);
 }
 
 void YMF262::writeReg(unsigned r, byte v, EmuTime::param time)
 {
-	if (!OPL3_mode && (r != 0x105)) {
+	if (!core.isOPL3Mode() && (r != 0x105)) {
 		// in OPL2 mode the only accessible in set #2 is register 0x05
 		r &= ~0x100;
 	}
@@ -1058,10 +1082,55 @@ void YMF262::writeReg(unsigned r, byte v, EmuTime::param time)
 }
 void YMF262::writeReg512(unsigned r, byte v, EmuTime::param time)
 {
+	if (auto* vgm = getVgmRecorder(); vgm && !isYMF278) {
+		// (the YMF278 registers are recorded by MSXMoonSound)
+		vgm->writeYMF262(this, r, v, time);
+	}
 	updateStream(time); // TODO optimize only for regs that directly influence sound
 	writeRegDirect(r, v, time);
 }
 void YMF262::writeRegDirect(unsigned r, byte v, EmuTime::param time)
+{
+	if (r == 0x105) {
+		// Verified on real YMF278: When NEW2 bit is first set, a read
+		// from the status register (once) returns bit 1 set (0x02).
+		// This only happens once after reset, so clearing NEW2 and
+		// setting it again doesn't cause another change in the status
+		// register. Also, only bit 1 changes.
+		if ((v & 0x02) && !alreadySignaledNEW2 && isYMF278) {
+			status2 = 0x02;
+			alreadySignaledNEW2 = true;
+		}
+	} else if (((r & 0xE0) == 0x00) && (r != 0x104)) {
+		// 00-1F:control
+		switch (r & 0x1F) {
+		case 0x02: // Timer 1
+			timer1->setValue(v);
+			break;
+
+		case 0x03: // Timer 2
+			timer2->setValue(v);
+			break;
+
+		case 0x04: // IRQ clear / mask and Timer enable
+			if (v & 0x80) {
+				// IRQ flags clear
+				resetStatus(0x60);
+			} else {
+				changeStatusMask((~v) & 0x60);
+				timer1->setStart((v & R04_ST1) != 0, time);
+				timer2->setStart((v & R04_ST2) != 0, time);
+			}
+			break;
+
+		default:
+			break;
+		}
+	}
+	core.writeReg(r, v);
+}
+
+void YMF262Core::writeReg(unsigned r, byte v)
 {
 	reg[r] = v;
 
@@ -1080,16 +1149,6 @@ void YMF262::writeRegDirect(unsigned r, byte v, EmuTime::param time)
 		// OPL3 mode when bit0=1 otherwise it is OPL2 mode
 		OPL3_mode = v & 0x01;
 
-		// Verified on real YMF278: When NEW2 bit is first set, a read
-		// from the status register (once) returns bit 1 set (0x02).
-		// This only happens once after reset, so clearing NEW2 and
-		// setting it again doesn't cause another change in the status
-		// register. Also, only bit 1 changes.
-		if ((v & 0x02) && !alreadySignaledNEW2 && isYMF278) {
-			status2 = 0x02;
-			alreadySignaledNEW2 = true;
-		}
-
 		// following behaviour was tested on real YMF262,
 		// switching OPL3/OPL2 modes on the fly:
 		//  - does not change the waveform previously selected
@@ -1109,24 +1168,7 @@ void YMF262::writeRegDirect(unsigned r, byte v, EmuTime::param time)
 		case 0x01: // test register
 			break;
 
-		case 0x02: // Timer 1
-			timer1->setValue(v);
-			break;
-
-		case 0x03: // Timer 2
-			timer2->setValue(v);
-			break;
-
-		case 0x04: // IRQ clear / mask and Timer enable
-			if (v & 0x80) {
-				// IRQ flags clear
-				resetStatus(0x60);
-			} else {
-				changeStatusMask((~v) & 0x60);
-				timer1->setStart((v & R04_ST1) != 0, time);
-				timer2->setStart((v & R04_ST2) != 0, time);
-			}
-			break;
+		// 0x02-0x04: timers and IRQ, handled in YMF262
 
 		case 0x08: // x,NTS,x,x, x,x,x,x
 			nts = (v & 0x40) != 0;
@@ -1407,29 +1449,24 @@ void YMF262::writeRegDirect(unsigned r, byte v, EmuTime::param time)
 }
 
 
-void YMF262::reset(EmuTime::param time)
+void YMF262Core::reset()
 {
 	eg_cnt = 0;
 
 	noise_rng = 1; // noise shift register
 	nts = false; // note split
-	alreadySignaledNEW2 = false;
-	resetStatus(0x60);
 
 	// reset with register write
-	writeRegDirect(0x01, 0, time); // test register
-	writeRegDirect(0x02, 0, time); // Timer1
-	writeRegDirect(0x03, 0, time); // Timer2
-	writeRegDirect(0x04, 0, time); // IRQ mask clear
+	writeReg(0x01, 0); // test register
 
 	// FIX IT  registers 101, 104 and 105
 	// FIX IT (dont change CH.D, CH.C, CH.B and CH.A in C0-C8 registers)
 	for (int c = 0xFF; c >= 0x20; c--) {
-		writeRegDirect(c, 0, time);
+		writeReg(c, 0);
 	}
 	// FIX IT (dont change CH.D, CH.C, CH.B and CH.A in C0-C8 registers)
 	for (int c = 0x1FF; c >= 0x120; c--) {
-		writeRegDirect(c, 0, time);
+		writeReg(c, 0);
 	}
 
 	// reset operator parameters
@@ -1439,10 +1476,47 @@ void YMF262::reset(EmuTime::param time)
 			sl.volume = MAX_ATT_INDEX;
 		}
 	}
+}
+
+void YMF262::reset(EmuTime::param time)
+{
+	alreadySignaledNEW2 = false;
+	resetStatus(0x60);
+
+	// reset with register write
+	writeRegDirect(0x02, 0, time); // Timer1
+	writeRegDirect(0x03, 0, time); // Timer2
+	writeRegDirect(0x04, 0, time); // IRQ mask clear
+
+	core.reset();
 
 	setMixLevel(0x1b, time); // -9dB left and right
 }
 
+YMF262Core::YMF262Core()
+	: lfo_am_cnt(0), lfo_pm_cnt(0)
+	, impl(getBestImpl())
+{
+	lfo_am_depth = false;
+	lfo_pm_depth_range = 0;
+	rhythm = 0;
+	OPL3_mode = false;
+
+	// avoid (harmless) UMR in serialize()
+	memset(chanout, 0, sizeof(chanout));
+	memset(reg, 0, sizeof(reg));
+
+	// For debugging: print out tables to be able to compare before/after
+	// when the calculation changes.
+	if (false) {
+		for (const auto& e : tlTab) std::cout << e << '\n';
+		std::cout << '\n';
+		for (const auto& e : sin.tab) std::cout << e << '\n';
+	}
+
+	reset();
+}
+
 static unsigned calcInputRate(bool isYMF278)
 {
 	return unsigned(lrintf(isYMF278 ?    33868800.0f / (19 * 36)
@@ -1460,27 +1534,10 @@ YMF262::YMF262(const std::string& name_,
 	         ? EmuTimer::createOPL4_2(config.getScheduler(), *this)
 	         : EmuTimer::createOPL3_2(config.getScheduler(), *this))
 	, irq(config.getMotherBoard(), getName() + ".IRQ")
-	, lfo_am_cnt(0), lfo_pm_cnt(0)
 	, isYMF278(isYMF278_)
 {
-	lfo_am_depth = false;
-	lfo_pm_depth_range = 0;
-	rhythm = 0;
-	OPL3_mode = false;
 	status = status2 = statusMask = 0;
 
-	// avoid (harmless) UMR in serialize()
-	memset(chanout, 0, sizeof(chanout));
-	memset(reg, 0, sizeof(reg));
-
-	// For debugging: print out tables to be able to compare before/after
-	// when the calculation changes.
-	if (false) {
-		for (const auto& e : tlTab) std::cout << e << '\n';
-		std::cout << '\n';
-		for (const auto& e : sin.tab) std::cout << e << '\n';
-	}
-
 	registerSound(config);
 	reset(config.getMotherBoard().getCurrentTime()); // must come after registerSound() because of call to setSoftwareVolume() via setMixLevel()
 }
@@ -1503,7 +1560,7 @@ byte YMF262::peekStatus() const
 	return status | status2;
 }
 
-bool YMF262::checkMuteHelper()
+bool YMF262Core::checkMuteHelper() const
 {
 	// TODO this doesn't always mute when possible
 	for (auto& ch : channel) {
@@ -1542,27 +1599,15 @@ float YMF262::getAmplificationFactorImpl() const
 
 void YMF262::generateChannels(float** bufs, unsigned num)
 {
-	// TODO implement per-channel mute (instead of all-or-nothing)
-	// TODO output rhythm on separate channels?
-	if (checkMuteHelper()) {
-		// TODO update internal state, even if muted
-		std::fill_n(bufs, 18, nullptr);
-		return;
-	}
+	core.generateChannels(bufs, num);
+}
 
+void YMF262Core::generateChannelsGeneric(float** bufs, unsigned num)
+{
 	bool rhythmEnabled = (rhythm & 0x20) != 0;
 
 	for (auto j : xrange(num)) {
-		// Amplitude modulation: 27 output levels (triangle waveform);
-		// 1 level takes one of: 192, 256 or 448 samples
-		// One entry from LFO_AM_TABLE lasts for 64 samples
-		lfo_am_cnt.addQuantum();
-		if (lfo_am_cnt == LFOAMIndex(LFO_AM_TAB_ELEMENTS)) {
-			// lfo_am_table is 210 elements long
-			lfo_am_cnt = LFOAMIndex(0);
-		}
-		unsigned tmp = lfo_am_table[lfo_am_cnt.toInt()];
-		unsigned lfo_am = lfo_am_depth ? tmp : tmp / 4;
+		unsigned lfo_am = advanceLfoAM();
 
 		// clear channel outputs
 		memset(chanout, 0, sizeof(chanout));
@@ -1574,31 +1619,31 @@ void YMF262::generateChannels(float** bufs, unsigned num)
 				auto& ch0 = channel[k + i + 0];
 				auto& ch3 = channel[k + i + 3];
 				// extended 4op ch#0 part 1 or 2op ch#0
-				ch0.chan_calc(lfo_am);
+				ch0.chan_calc(lfo_am, phase_modulation, phase_modulation2);
 				if (ch0.extended) {
 					// extended 4op ch#0 part 2
-					ch3.chan_calc_ext(lfo_am);
+					ch3.chan_calc_ext(lfo_am, phase_modulation, phase_modulation2);
 				} else {
 					// standard 2op ch#3
-					ch3.chan_calc(lfo_am);
+					ch3.chan_calc(lfo_am, phase_modulation, phase_modulation2);
 				}
 			}
 		}
 
 		// channels 6,7,8 rhythm or 2op mode
 		if (!rhythmEnabled) {
-			channel[6].chan_calc(lfo_am);
-			channel[7].chan_calc(lfo_am);
-			channel[8].chan_calc(lfo_am);
+			channel[6].chan_calc(lfo_am, phase_modulation, phase_modulation2);
+			channel[7].chan_calc(lfo_am, phase_modulation, phase_modulation2);
+			channel[8].chan_calc(lfo_am, phase_modulation, phase_modulation2);
 		} else {
 			// Rhythm part
 			chan_calc_rhythm(lfo_am);
 		}
 
 		// channels 15,16,17 are fixed 2-operator channels only
-		channel[15].chan_calc(lfo_am);
-		channel[16].chan_calc(lfo_am);
-		channel[17].chan_calc(lfo_am);
+		channel[15].chan_calc(lfo_am, phase_modulation, phase_modulation2);
+		channel[16].chan_calc(lfo_am, phase_modulation, phase_modulation2);
+		channel[17].chan_calc(lfo_am, phase_modulation, phase_modulation2);
 
 		for (auto i : xrange(18)) {
 			bufs[i][2 * j + 0] += int(chanout[i] & pan[4 * i + 0]);
@@ -1611,18 +1656,423 @@ void YMF262::generateChannels(float** bufs, unsigned num)
 	}
 }
 
+#ifdef AVX2_TARGET
+// Alternative implementation that calculates all operators at once using
+// AVX2 (gather instructions for the table lookups and the per-lane variable
+// shifts), see avx2.hh. SSE4 has no gather instructions, there the lookups
+// would have to be done one by one, and that turned out to be no faster than
+// the GENERIC implementation.
+
+// The rows of 'eg_inc' packed in a 32-bit word, 4 bits per cycle. This
+// allows to lookup the increment with a shift instead of a gather.
+constexpr auto eg_inc_packed = [] {
+	std::array<int, std::size(eg_inc) / RATE_STEPS> result = {};
+	for (auto i : xrange(std::size(eg_inc))) {
+		assert(eg_inc[i] < 16);
+		result[i / RATE_STEPS] |= eg_inc[i] << (4 * (i % RATE_STEPS));
+	}
+	return result;
+}();
+
+namespace {
+
+// The operator state in structure-of-arrays form. Index [MOD] is the
+// modulator, index [CAR] the carrier slot of each of the 18 channels (padded
+// to a multiple of 8 channels). While generating samples only 'cnt',
+// 'volume', 'state' and 'op1out' change, all other values stay constant
+// during one generateChannels() call (registers are only written in between
+// calls).
+struct SoAState {
+	static constexpr int N = 24;
+
+	// phase generator
+	alignas(32) int cnt   [2][N]; // raw FreqIndex value
+	alignas(32) int incr  [2][N]; // raw FreqIndex value, including vibrato
+	// envelope generator
+	alignas(32) int volume [2][N];
+	alignas(32) int state  [2][N];
+	alignas(32) int sustain[2][N]; // sustain level
+	alignas(32) int egType [2][N]; // 0 or ~0
+	alignas(32) int egM  [3][2][N]; // for attack, decay and release
+	alignas(32) int egSh [3][2][N];
+	alignas(32) int egInc[3][2][N]; // row of 'eg_inc_packed'
+	// operator output
+	alignas(32) int tll   [2][N];
+	alignas(32) int amMask[2][N];
+	alignas(32) int wave  [2][N]; // offset of the waveform in 'sin.tab'
+	// modulator feedback
+	alignas(32) int fbShift  [N];
+	alignas(32) int op1out[2][N];
+	// per channel: 0 or ~0
+	alignas(32) int modToOut[N]; // else modulator output goes to carrier input
+	alignas(32) int carToOut[N]; // else carrier output goes to 2nd half of 4-op channel
+	alignas(32) int calc[N]; // 2-op channel or 1st half of 4-op channel
+	alignas(32) int ext [N]; // 2nd half of 4-op channel
+	alignas(32) int chanout[N];
+	bool anyExt;
+	bool rhythmCon; // only used in rhythm mode
+
+	// needed to recalculate 'incr' for vibrato
+	unsigned lfo_pm = unsigned(-1);
+	YMF262Core::FreqIndex Incr[2][N];
+	unsigned block_fnum[2][N];
+	byte mul[2][N];
+	bool vib[2][N];
+
+	void setVibrato(unsigned newLfoPm);
+};
+
+} // namespace
+
+void SoAState::setVibrato(unsigned newLfoPm)
+{
+	// see YMF262Core::Slot::advancePhaseGenerator()
+	lfo_pm = newLfoPm;
+	for (auto sl : xrange(2)) {
+		for (auto c : xrange(18)) {
+			if (vib[sl][c]) {
+				unsigned fnum_lfo = (block_fnum[sl][c] & 0x0380) >> 7;
+				int lfo_fn_table_index_offset = lfo_pm_table[lfo_pm + 16 * fnum_lfo];
+				incr[sl][c] = (fnumToIncrement(block_fnum[sl][c] + lfo_fn_table_index_offset) * mul[sl][c]).getRawValue();
+			} else {
+				incr[sl][c] = Incr[sl][c].getRawValue();
+			}
+		}
+	}
+}
+
+AVX2_TARGET static inline __m256i load8(const int* p)
+{
+	return _mm256_load_si256(reinterpret_cast<const __m256i*>(p));
+}
+AVX2_TARGET static inline void store8(int* p, __m256i x)
+{
+	_mm256_store_si256(reinterpret_cast<__m256i*>(p), x);
+}
+
+// See YMF262Core::Slot::op_calc(), for 8 operators.
+AVX2_TARGET static inline __m256i opCalc8(const SoAState& s, int sl, int i, __m256i lfo_am, __m256i phase)
+{
+	auto env = _mm256_slli_epi32(_mm256_add_epi32(
+		_mm256_add_epi32(load8(&s.tll[sl][i]), load8(&s.volume[sl][i])),
+		_mm256_and_si256(lfo_am, load8(&s.amMask[sl][i]))), 4);
+	// Gathers are relatively slow, skip them for operators that are
+	// anyway silent (e.g. because the envelope is off).
+	auto zero = _mm256_setzero_si256();
+	auto tlLen = _mm256_set1_epi32(TL_TAB_LEN);
+	auto audible = _mm256_cmpgt_epi32(tlLen, env);
+	if (_mm256_testz_si256(audible, audible)) return zero;
+
+	auto idx = _mm256_add_epi32(load8(&s.wave[sl][i]),
+	                            _mm256_and_si256(phase, _mm256_set1_epi32(SIN_MASK)));
+	auto w = _mm256_mask_i32gather_epi32(zero, reinterpret_cast<const int*>(sin.tab), idx, audible, 4);
+	auto p = _mm256_add_epi32(env, w);
+	auto inRange = _mm256_and_si256(audible, _mm256_cmpgt_epi32(tlLen, p));
+	return _mm256_mask_i32gather_epi32(zero, tlTab.data(), p, inRange, 4);
+}
+
+AVX2_TARGET static inline __m256i phase8(const SoAState& s, int sl, int i)
+{
+	return _mm256_srai_epi32(load8(&s.cnt[sl][i]), YMF262Core::FreqIndex::FRACTION_BITS);
+}
+
+// See YMF262Core::Channel::chan_calc() and chan_calc_ext(), for all
+// channels (except for the rhythm channels in rhythm mode).
+AVX2_TARGET static void calcOperatorsAvx2(SoAState& s, unsigned lfo_am_)
+{
+	constexpr int N = SoAState::N;
+	auto lfo_am = _mm256_set1_epi32(int(lfo_am_));
+	auto zero = _mm256_setzero_si256();
+
+	// carrier output of the 1st half of the 4-op channels, stored 3
+	// channels further, so that it lines up with the 2nd half
+	alignas(32) int pm2[N + 8];
+	pm2[0] = pm2[1] = pm2[2] = 0; // unused, but avoid reading uninitialized memory
+
+	for (int i = 0; i < N; i += 8) {
+		auto calc = load8(&s.calc[i]);
+		auto modToOut = load8(&s.modToOut[i]);
+		auto carToOut = load8(&s.carToOut[i]);
+
+		auto o0 = load8(&s.op1out[0][i]);
+		auto o1 = load8(&s.op1out[1][i]);
+		auto fb = load8(&s.fbShift[i]);
+		auto feedback = _mm256_andnot_si256(_mm256_cmpeq_epi32(fb, zero),
+		                                    _mm256_srav_epi32(_mm256_add_epi32(o0, o1), fb));
+		auto modOut = opCalc8(s, MOD, i, lfo_am, _mm256_add_epi32(phase8(s, MOD, i), feedback));
+		store8(&s.op1out[0][i], _mm256_blendv_epi8(o0, o1,     calc));
+		store8(&s.op1out[1][i], _mm256_blendv_epi8(o1, modOut, calc));
+
+		auto pm = _mm256_andnot_si256(modToOut, modOut);
+		auto carOut = opCalc8(s, CAR, i, lfo_am, _mm256_add_epi32(phase8(s, CAR, i), pm));
+
+		auto out = _mm256_add_epi32(_mm256_and_si256(modToOut, modOut),
+		                            _mm256_and_si256(carToOut, carOut));
+		store8(&s.chanout[i], _mm256_and_si256(calc, out));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(&pm2[i + 3]),
+		                    _mm256_andnot_si256(carToOut, carOut));
+	}
+	if (!s.anyExt) return;
+
+	for (int i = 0; i < N; i += 8) {
+		auto ext = load8(&s.ext[i]);
+		if (_mm256_testz_si256(ext, ext)) continue;
+		auto modToOut = load8(&s.modToOut[i]);
+		auto carToOut = load8(&s.carToOut[i]);
+
+		auto pm2In = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&pm2[i]));
+		auto modOut = opCalc8(s, MOD, i, lfo_am, _mm256_add_epi32(phase8(s, MOD, i), pm2In));
+
+		auto pm = _mm256_andnot_si256(modToOut, modOut);
+		auto carOut = opCalc8(s, CAR, i, lfo_am, _mm256_add_epi32(phase8(s, CAR, i), pm));
+
+		auto out = _mm256_add_epi32(_mm256_and_si256(modToOut, modOut),
+		                            _mm256_and_si256(carToOut, carOut));
+		store8(&s.chanout[i], _mm256_blendv_epi8(load8(&s.chanout[i]), out, ext));
+	}
+}
+
+// Select the attack, decay or release rate parameter, depending on the
+// envelope state. Sustain (and off) use the release rate.
+AVX2_TARGET static inline __m256i selectRate(const int (&x)[3][2][SoAState::N], int sl, int i,
+                                             __m256i isA, __m256i isD)
+{
+	return _mm256_blendv_epi8(
+		_mm256_blendv_epi8(load8(&x[2][sl][i]), load8(&x[1][sl][i]), isD),
+		load8(&x[0][sl][i]), isA);
+}
+
+// See YMF262Core::Slot::advanceEnvelopeGenerator() and
+// advancePhaseGenerator(), for all operators.
+AVX2_TARGET static void advanceOperatorsAvx2(SoAState& s, unsigned egCnt_)
+{
+	constexpr int N = SoAState::N;
+	auto egCnt = _mm256_set1_epi32(int(egCnt_));
+	auto zero = _mm256_setzero_si256();
+	auto maxAtt = _mm256_set1_epi32(MAX_ATT_INDEX);
+
+	for (auto sl : xrange(2)) {
+		for (int i = 0; i < N; i += 8) {
+			store8(&s.cnt[sl][i], _mm256_add_epi32(load8(&s.cnt[sl][i]), load8(&s.incr[sl][i])));
+
+			auto state = load8(&s.state[sl][i]);
+			auto isA = _mm256_cmpeq_epi32(state, _mm256_set1_epi32(YMF262Core::EG_ATTACK));
+			auto isD = _mm256_cmpeq_epi32(state, _mm256_set1_epi32(YMF262Core::EG_DECAY));
+			auto isS = _mm256_cmpeq_epi32(state, _mm256_set1_epi32(YMF262Core::EG_SUSTAIN));
+			auto isR = _mm256_cmpeq_epi32(state, _mm256_set1_epi32(YMF262Core::EG_RELEASE));
+			// in sustain state only percussive mode changes the volume
+			auto changing = _mm256_or_si256(_mm256_or_si256(isA, isD),
+			                                _mm256_or_si256(isR, _mm256_andnot_si256(load8(&s.egType[sl][i]), isS)));
+			if (_mm256_testz_si256(changing, changing)) continue;
+
+			auto m   = selectRate(s.egM,   sl, i, isA, isD);
+			auto sh  = selectRate(s.egSh,  sl, i, isA, isD);
+			auto row = selectRate(s.egInc, sl, i, isA, isD);
+			auto active = _mm256_and_si256(changing, _mm256_cmpeq_epi32(_mm256_and_si256(egCnt, m), zero));
+			if (_mm256_testz_si256(active, active)) continue;
+
+			auto cycle = _mm256_and_si256(_mm256_srlv_epi32(egCnt, sh), _mm256_set1_epi32(7));
+			auto inc = _mm256_and_si256(_mm256_srlv_epi32(row, _mm256_slli_epi32(cycle, 2)),
+			                            _mm256_set1_epi32(15));
+			auto volume = load8(&s.volume[sl][i]);
+			auto attackInc = _mm256_srai_epi32(
+				_mm256_mullo_epi32(_mm256_xor_si256(volume, _mm256_set1_epi32(-1)), inc), 3);
+			auto newVolume = _mm256_add_epi32(volume, _mm256_blendv_epi8(inc, attackInc, isA));
+			volume = _mm256_blendv_epi8(volume, newVolume, active);
+
+			// attack -> decay when reaching MIN_ATT_INDEX
+			auto toDecay = _mm256_and_si256(_mm256_and_si256(active, isA),
+			                                _mm256_cmpgt_epi32(_mm256_set1_epi32(MIN_ATT_INDEX + 1), volume));
+			// decay -> sustain when reaching the sustain level
+			auto toSustain = _mm256_andnot_si256(_mm256_cmpgt_epi32(load8(&s.sustain[sl][i]), volume),
+			                                     _mm256_and_si256(active, isD));
+			// sustain (percussive) and release: clip at MAX_ATT_INDEX,
+			// release -> off
+			auto clip = _mm256_andnot_si256(_mm256_cmpgt_epi32(maxAtt, volume),
+			                                _mm256_and_si256(active, _mm256_or_si256(isS, isR)));
+			auto toOff = _mm256_and_si256(clip, isR);
+
+			volume = _mm256_andnot_si256(toDecay, volume); // MIN_ATT_INDEX == 0
+			volume = _mm256_blendv_epi8(volume, maxAtt, clip);
+			state = _mm256_blendv_epi8(state, _mm256_set1_epi32(YMF262Core::EG_DECAY),   toDecay);
+			state = _mm256_blendv_epi8(state, _mm256_set1_epi32(YMF262Core::EG_SUSTAIN), toSustain);
+			state = _mm256_blendv_epi8(state, _mm256_set1_epi32(YMF262Core::EG_OFF),     toOff);
+			store8(&s.volume[sl][i], volume);
+			store8(&s.state [sl][i], state);
+		}
+	}
+}
+
+// See YMF262Core::chan_calc_rhythm().
+static void calcRhythmSoA(SoAState& s, unsigned lfo_am, unsigned noise_rng)
+{
+	auto phase = [&](int sl, int c) {
+		return YMF262Core::FreqIndex::create(s.cnt[sl][c]).toInt();
+	};
+	auto op_calc = [&](int sl, int c, unsigned ph) {
+		unsigned env = s.tll[sl][c] + s.volume[sl][c] + (lfo_am & s.amMask[sl][c]);
+		return opOutput(env, &sin.tab[s.wave[sl][c]], ph);
+	};
+
+	// Bass Drum
+	int fb_shift = s.fbShift[6];
+	int out = fb_shift ? s.op1out[0][6] + s.op1out[1][6] : 0;
+	s.op1out[0][6] = s.op1out[1][6];
+	int pm = s.rhythmCon ? 0 : s.op1out[0][6];
+	s.op1out[1][6] = op_calc(MOD, 6, phase(MOD, 6) + (out >> fb_shift));
+	s.chanout[6] += 2 * op_calc(CAR, 6, phase(CAR, 6) + pm);
+
+	// High Hat, Snare Drum, Tom Tom, Top Cymbal
+	int op71phase = phase(MOD, 7);
+	int op82phase = phase(CAR, 8);
+	s.chanout[7] += 2 * op_calc(MOD, 7, genPhaseHighHat(op71phase, op82phase, noise_rng));
+	s.chanout[7] += 2 * op_calc(CAR, 7, genPhaseSnare(op71phase, noise_rng));
+	s.chanout[8] += 2 * op_calc(MOD, 8, phase(MOD, 8));
+	s.chanout[8] += 2 * op_calc(CAR, 8, genPhaseCymbal(op71phase, op82phase));
+}
+
+void YMF262Core::generateChannelsSoA(float** bufs, unsigned num)
+{
+	bool rhythmEnabled = (rhythm & 0x20) != 0;
+
+	SoAState s = {};
+	for (auto c : xrange(18)) {
+		auto& ch = channel[c];
+		for (auto sl : xrange(2)) {
+			auto& op = ch.slot[sl];
+			s.cnt[sl][c] = op.Cnt.getRawValue();
+			s.volume[sl][c] = op.volume;
+			s.state[sl][c] = op.state;
+			s.sustain[sl][c] = op.sl;
+			s.egType[sl][c] = op.eg_type ? ~0 : 0;
+			s.egM  [0][sl][c] = op.eg_m_ar;
+			s.egSh [0][sl][c] = op.eg_sh_ar;
+			s.egInc[0][sl][c] = eg_inc_packed[op.eg_sel_ar / RATE_STEPS];
+			s.egM  [1][sl][c] = op.eg_m_dr;
+			s.egSh [1][sl][c] = op.eg_sh_dr;
+			s.egInc[1][sl][c] = eg_inc_packed[op.eg_sel_dr / RATE_STEPS];
+			s.egM  [2][sl][c] = op.eg_m_rr;
+			s.egSh [2][sl][c] = op.eg_sh_rr;
+			s.egInc[2][sl][c] = eg_inc_packed[op.eg_sel_rr / RATE_STEPS];
+			s.tll[sl][c] = op.TLL;
+			s.amMask[sl][c] = op.AMmask;
+			s.wave[sl][c] = int(op.wavetable - sin.tab);
+			s.Incr[sl][c] = op.Incr;
+			s.block_fnum[sl][c] = ch.block_fnum;
+			s.mul[sl][c] = op.mul;
+			s.vib[sl][c] = op.vib;
+		}
+		auto& mod = ch.slot[MOD];
+		auto& car = ch.slot[CAR];
+		s.fbShift[c] = mod.fb_shift;
+		s.op1out[0][c] = mod.op1_out[0];
+		s.op1out[1][c] = mod.op1_out[1];
+
+		// see register #C0-#C8 writes and chan_calc()
+		assert((mod.connect == &phase_modulation ) || (mod.connect == &chanout[c]));
+		assert((car.connect == &phase_modulation2) || (car.connect == &chanout[c]));
+		s.modToOut[c] = (mod.connect != &phase_modulation ) ? ~0 : 0;
+		s.carToOut[c] = (car.connect != &phase_modulation2) ? ~0 : 0;
+
+		bool ext = ((c % 9) >= 3) && ((c % 9) < 6) && channel[c - 3].extended;
+		bool rhythmChannel = rhythmEnabled && (c >= 6) && (c < 9);
+		s.ext[c] = ext ? ~0 : 0;
+		s.calc[c] = (!ext && !rhythmChannel) ? ~0 : 0;
+		s.anyExt |= ext;
+	}
+	s.rhythmCon = channel[6].slot[MOD].CON;
+
+	for (auto j : xrange(num)) {
+		unsigned lfo_am = advanceLfoAM();
+
+		calcOperatorsAvx2(s, lfo_am);
+		if (rhythmEnabled) {
+			calcRhythmSoA(s, lfo_am, noise_rng);
+		}
+
+		for (auto i : xrange(18)) {
+			bufs[i][2 * j + 0] += int(s.chanout[i] & pan[4 * i + 0]);
+			bufs[i][2 * j + 1] += int(s.chanout[i] & pan[4 * i + 1]);
+		}
+
+		// see advance()
+		lfo_pm_cnt.addQuantum();
+		unsigned lfo_pm = (lfo_pm_cnt.toInt() & 7) | lfo_pm_depth_range;
+		if (lfo_pm != s.lfo_pm) s.setVibrato(lfo_pm);
+		++eg_cnt;
+		advanceOperatorsAvx2(s, eg_cnt);
+		advanceNoise();
+	}
+
+	for (auto c : xrange(18)) {
+		auto& ch = channel[c];
+		for (auto sl : xrange(2)) {
+			auto& op = ch.slot[sl];
+			op.Cnt = FreqIndex::create(s.cnt[sl][c]);
+			op.volume = s.volume[sl][c];
+			op.state = EnvelopeState(s.state[sl][c]);
+		}
+		ch.slot[MOD].op1_out[0] = s.op1out[0][c];
+		ch.slot[MOD].op1_out[1] = s.op1out[1][c];
+		chanout[c] = s.chanout[c];
+	}
+}
+
+#endif
+
+void YMF262Core::generateChannels(float** bufs, unsigned num)
+{
+	// TODO implement per-channel mute (instead of all-or-nothing)
+	// TODO output rhythm on separate channels?
+	if (checkMuteHelper()) {
+		// TODO update internal state, even if muted
+		std::fill_n(bufs, 18, nullptr);
+		return;
+	}
+
+	assert(isSupported(impl));
+	switch (impl) {
+#ifdef AVX2_TARGET
+	case AVX2:
+		generateChannelsSoA(bufs, num);
+		break;
+#endif
+	default:
+		generateChannelsGeneric(bufs, num);
+		break;
+	}
+}
+
+bool YMF262Core::isSupported(Impl impl)
+{
+	switch (impl) {
+	case GENERIC:
+		return true;
+	case AVX2:
+		return hasAVX2();
+	default:
+		UNREACHABLE; return false;
+	}
+}
+
+YMF262Core::Impl YMF262Core::getBestImpl()
+{
+	static const Impl best = isSupported(AVX2) ? AVX2 : GENERIC;
+	return best;
+}
+
 
-static constexpr std::initializer_list<enum_string<YMF262::EnvelopeState>> envelopeStateInfo = {
-	{ "ATTACK",  YMF262::EG_ATTACK  },
-	{ "DECAY",   YMF262::EG_DECAY   },
-	{ "SUSTAIN", YMF262::EG_SUSTAIN },
-	{ "RELEASE", YMF262::EG_RELEASE },
-	{ "OFF",     YMF262::EG_OFF     }
+static constexpr std::initializer_list<enum_string<YMF262Core::EnvelopeState>> envelopeStateInfo = {
+	{ "ATTACK",  YMF262Core::EG_ATTACK  },
+	{ "DECAY",   YMF262Core::EG_DECAY   },
+	{ "SUSTAIN", YMF262Core::EG_SUSTAIN },
+	{ "RELEASE", YMF262Core::EG_RELEASE },
+	{ "OFF",     YMF262Core::EG_OFF     }
 };
-SERIALIZE_ENUM(YMF262::EnvelopeState, envelopeStateInfo);
+SERIALIZE_ENUM(YMF262Core::EnvelopeState, envelopeStateInfo);
 
 template<typename Archive>
-void YMF262::Slot::serialize(Archive& a, unsigned /*version*/)
+void YMF262Core::Slot::serialize(Archive& a, unsigned /*version*/)
 {
 	// wavetable
 	auto waveform = unsigned((wavetable - sin.tab) / SIN_LEN);
@@ -1666,7 +2116,7 @@ void YMF262::Slot::serialize(Archive& a, unsigned /*version*/)
 }
 
 template<typename Archive>
-void YMF262::Channel::serialize(Archive& a, unsigned /*version*/)
+void YMF262Core::Channel::serialize(Archive& a, unsigned /*version*/)
 {
 	a.serialize("slots",      slot,
 	            "block_fnum", block_fnum,
@@ -1676,15 +2126,12 @@ void YMF262::Channel::serialize(Archive& a, unsigned /*version*/)
 	            "extended",   extended);
 }
 
-// version 1: initial version
-// version 2: added alreadySignaledNEW2
+// Serialized inline in YMF262::serialize() (not as a separate tag), this
+// keeps savestates compatible with the time these were both one class.
 template<typename Archive>
-void YMF262::serialize(Archive& a, unsigned version)
+void YMF262Core::serialize(Archive& a, unsigned /*version*/)
 {
-	a.serialize("timer1",  *timer1,
-	            "timer2",  *timer2,
-	            "irq",     irq,
-	            "chanout", chanout);
+	a.serialize("chanout", chanout);
 	a.serialize_blob("registers", reg, sizeof(reg));
 	a.serialize("channels",           channel,
 	            "eg_cnt",             eg_cnt,
@@ -1695,8 +2142,26 @@ void YMF262::serialize(Archive& a, unsigned version)
 	            "lfo_pm_depth_range", lfo_pm_depth_range,
 	            "rhythm",             rhythm,
 	            "nts",                nts,
-	            "OPL3_mode",          OPL3_mode,
-	            "status",             status,
+	            "OPL3_mode",          OPL3_mode);
+
+	// TODO restore more state by rewriting register values
+	//   this handles pan
+	for (auto i : xrange(0xC0, 0xC9)) {
+		writeReg(i + 0x000, reg[i + 0x000]);
+		writeReg(i + 0x100, reg[i + 0x100]);
+	}
+}
+
+// version 1: initial version
+// version 2: added alreadySignaledNEW2
+template<typename Archive>
+void YMF262::serialize(Archive& a, unsigned version)
+{
+	a.serialize("timer1",  *timer1,
+	            "timer2",  *timer2,
+	            "irq",     irq);
+	core.serialize(a, version);
+	a.serialize("status",             status,
 	            "status2",            status2,
 	            "statusMask",         statusMask);
 	if (a.versionAtLeast(version, 2)) {
@@ -1706,14 +2171,6 @@ void YMF262::serialize(Archive& a, unsigned version)
 		alreadySignaledNEW2 = true; // we can't know the actual value,
 									// but 'true' is the safest value
 	}
-
-	// TODO restore more state by rewriting register values
-	//   this handles pan
-	EmuTime::param time = timer1->getCurrentTime();
-	for (auto i : xrange(0xC0, 0xC9)) {
-		writeRegDirect(i + 0x000, reg[i + 0x000], time);
-		writeRegDirect(i + 0x100, reg[i + 0x100], time);
-	}
 }
 
 INSTANTIATE_SERIALIZE_METHODS(YMF262);
@@ -9,29 +9,51 @@
 #include "IRQHelper.hh"
 #include "openmsx.hh"
 #include "serialize_meta.hh"
-#include <string>
+#include <cassert>
 #include <memory>
+#include <string>
 
 namespace openmsx {
 
 class DeviceConfig;
 
-class YMF262 final : private ResampledSoundDevice, private EmuTimerCallback
+/** The sound generation part of the YMF262: the FM operators, their
+  * registers and the LFO and noise generators. The timers, the IRQ and the
+  * status register (the parts that interact with the rest of the emulator)
+  * are handled in class YMF262. Separate so that it can be tested and
+  * benchmarked in isolation, driven by a sequence of register writes.
+  */
+class YMF262Core
 {
 public:
-	YMF262(const std::string& name, const DeviceConfig& config,
-	       bool isYMF278);
-	~YMF262();
-
-	void reset(EmuTime::param time);
-	void writeReg   (unsigned r, byte v, EmuTime::param time);
-	void writeReg512(unsigned r, byte v, EmuTime::param time);
-	[[nodiscard]] byte readReg(unsigned reg);
-	[[nodiscard]] byte peekReg(unsigned reg) const;
-	[[nodiscard]] byte readStatus();
-	[[nodiscard]] byte peekStatus() const;
-
-	void setMixLevel(uint8_t x, EmuTime::param time);
+	// Different implementations of the sample generation loop, they all
+	// produce exactly the same output. Which ones are available depends
+	// on the build and on the host CPU.
+	//  GENERIC: channel by channel, slot by slot
+	//  AVX2:    all operators at once, with the operator state in
+	//           structure-of-arrays form
+	enum Impl { GENERIC, AVX2 };
+
+	YMF262Core();
+
+	/** Reset the sound generation related registers and state. */
+	void reset();
+	/** Write a register, 'r' is in range [0..0x1FF]. */
+	void writeReg(unsigned r, byte v);
+	[[nodiscard]] byte peekReg(unsigned r) const { return reg[r]; }
+	[[nodiscard]] bool isOPL3Mode() const { return OPL3_mode; }
+
+	/** Generate 'num' stereo samples for each of the 18 channels, see
+	  * SoundDevice::generateChannels(). Sets all buffer pointers to
+	  * nullptr when all channels are muted.
+	  */
+	void generateChannels(float** bufs, unsigned num);
+
+	[[nodiscard]] Impl getImpl() const { return impl; }
+	void setImpl(Impl impl_) { assert(isSupported(impl_)); impl = impl_; }
+	[[nodiscard]] static bool isSupported(Impl impl);
+	/** The fastest supported implementation (detected at runtime). */
+	[[nodiscard]] static Impl getBestImpl();
 
 	template<typename Archive>
 	void serialize(Archive& ar, unsigned version);
@@ -115,8 +137,8 @@ private:
 	class Channel {
 	public:
 		Channel();
-		void chan_calc(unsigned lfo_am);
-		void chan_calc_ext(unsigned lfo_am);
+		void chan_calc(unsigned lfo_am, int& phase_modulation, int& phase_modulation2);
+		void chan_calc_ext(unsigned lfo_am, int& phase_modulation, int phase_modulation2);
 
 		template<typename Archive>
 		void serialize(Archive& ar, unsigned version);
@@ -141,34 +163,85 @@ private:
 			       // channels, ie 0,1,2 and 9,10,11)
 	};
 
-	// SoundDevice
-	[[nodiscard]] float getAmplificationFactorImpl() const override;
-	void generateChannels(float** bufs, unsigned num) override;
-
-	void callback(byte flag) override;
-
-	void writeRegDirect(unsigned r, byte v, EmuTime::param time);
-	void init_tables();
-	void setStatus(byte flag);
-	void resetStatus(byte flag);
-	void changeStatusMask(byte flag);
+	void generateChannelsGeneric(float** bufs, unsigned num);
+	void generateChannelsSoA(float** bufs, unsigned num);
+	[[nodiscard]] inline unsigned advanceLfoAM();
 	void advance();
-
-	[[nodiscard]] inline int genPhaseHighHat();
-	[[nodiscard]] inline int genPhaseSnare();
-	[[nodiscard]] inline int genPhaseCymbal();
+	inline void advanceNoise();
 
 	void chan_calc_rhythm(unsigned lfo_am);
 	void set_mul(unsigned sl, byte v);
 	void set_ksl_tl(unsigned sl, byte v);
 	void set_ar_dr(unsigned sl, byte v);
 	void set_sl_rr(unsigned sl, byte v);
-	bool checkMuteHelper();
+	[[nodiscard]] bool checkMuteHelper() const;
 
 	[[nodiscard]] inline bool isExtended(unsigned ch) const;
 	[[nodiscard]] inline Channel& getFirstOfPair(unsigned ch);
 	[[nodiscard]] inline Channel& getSecondOfPair(unsigned ch);
 
+private:
+	int chanout[18]; // 18 channels
+	int phase_modulation;  // phase modulation input (SLOT 2)
+	int phase_modulation2; // phase modulation input (SLOT 3
+	                       // in 4 operator channels)
+
+	byte reg[512];
+	Channel channel[18];	// OPL3 chips have 18 channels
+
+	unsigned pan[18 * 4];		// channels output masks 4 per channel
+	                                //    0xffffffff = enable
+	unsigned eg_cnt;		// global envelope generator counter
+	unsigned noise_rng;		// 23 bit noise shift register
+
+	// LFO
+	using LFOAMIndex = FixedPoint< 6>;
+	using LFOPMIndex = FixedPoint<10>;
+	LFOAMIndex lfo_am_cnt;
+	LFOPMIndex lfo_pm_cnt;
+	bool lfo_am_depth;
+	byte lfo_pm_depth_range;
+
+	byte rhythm;			// Rhythm mode
+	bool nts;			// NTS (note select)
+	bool OPL3_mode;			// OPL3 extension enable flag
+
+	Impl impl;
+};
+
+class YMF262 final : private ResampledSoundDevice, private EmuTimerCallback
+{
+public:
+	YMF262(const std::string& name, const DeviceConfig& config,
+	       bool isYMF278);
+	~YMF262();
+
+	void reset(EmuTime::param time);
+	void writeReg   (unsigned r, byte v, EmuTime::param time);
+	void writeReg512(unsigned r, byte v, EmuTime::param time);
+	[[nodiscard]] byte readReg(unsigned reg);
+	[[nodiscard]] byte peekReg(unsigned reg) const;
+	[[nodiscard]] byte readStatus();
+	[[nodiscard]] byte peekStatus() const;
+
+	void setMixLevel(uint8_t x, EmuTime::param time);
+
+	template<typename Archive>
+	void serialize(Archive& ar, unsigned version);
+
+private:
+	// SoundDevice
+	[[nodiscard]] float getAmplificationFactorImpl() const override;
+	void generateChannels(float** bufs, unsigned num) override;
+	[[nodiscard]] bool supportsStateOnly() const override { return true; }
+
+	void callback(byte flag) override;
+
+	void writeRegDirect(unsigned r, byte v, EmuTime::param time);
+	void setStatus(byte flag);
+	void resetStatus(byte flag);
+	void changeStatusMask(byte flag);
+
 	struct Debuggable final : SimpleDebuggable {
 		Debuggable(MSXMotherBoard& motherBoard, const std::string& name);
 		[[nodiscard]] byte read(unsigned address) override;
@@ -191,27 +264,7 @@ private:
 
 	IRQHelper irq;
 
-	int chanout[18]; // 18 channels
-
-	byte reg[512];
-	Channel channel[18];	// OPL3 chips have 18 channels
-
-	unsigned pan[18 * 4];		// channels output masks 4 per channel
-	                                //    0xffffffff = enable
-	unsigned eg_cnt;		// global envelope generator counter
-	unsigned noise_rng;		// 23 bit noise shift register
-
-	// LFO
-	using LFOAMIndex = FixedPoint< 6>;
-	using LFOPMIndex = FixedPoint<10>;
-	LFOAMIndex lfo_am_cnt;
-	LFOPMIndex lfo_pm_cnt;
-	bool lfo_am_depth;
-	byte lfo_pm_depth_range;
-
-	byte rhythm;			// Rhythm mode
-	bool nts;			// NTS (note select)
-	bool OPL3_mode;			// OPL3 extension enable flag
+	YMF262Core core;
 
 	byte status;			// status flag
 	byte status2;
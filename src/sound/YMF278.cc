@@ -41,6 +41,7 @@
 #include "serialize.hh"
 #include "xrange.hh"
 #include <algorithm>
+#include <cassert>
 
 namespace openmsx {
 
@@ -291,7 +292,7 @@ int YMF278::Slot::compute_decay_rate(int val) const
 	return compute_rate(val);
 }
 
-int16_t YMF278::Slot::compute_vib() const
+int16_t YMF278::Slot::compute_vib(uint32_t lfoCnt) const
 {
 	// verified via hardware recording:
 	//  With LFO speed 0 (period 262144 samples), each vibrato step takes
@@ -300,7 +301,7 @@ int16_t YMF278::Slot::compute_vib() const
 	//  Also, with vibrato depth 7 (80 cents) and an F-Num of 0x400, the
 	//  final F-Nums are: 0x400 .. 0x43C, 0x43C .. 0x400, 0x400 .. 0x3C4,
 	//  0x3C4 .. 0x400
-	int16_t lfo_fm = lfo_cnt / (LFO_PERIOD / 0x40);
+	int16_t lfo_fm = lfoCnt / (LFO_PERIOD / 0x40);
 	// results in +0x00..+0x0F, +0x0F..+0x00, -0x00..-0x0F, -0x0F..-0x00
 	if (lfo_fm & 0x10) lfo_fm ^= 0x1F;
 	if (lfo_fm & 0x20) lfo_fm = -(lfo_fm & 0x0F);
@@ -308,13 +309,13 @@ int16_t YMF278::Slot::compute_vib() const
 	return (lfo_fm * vib_depth[vib]) / 12;
 }
 
-uint16_t YMF278::Slot::compute_am() const
+uint16_t YMF278::Slot::compute_am(uint32_t lfoCnt) const
 {
 	// verified via hardware recording:
 	//  With LFO speed 0 (period 262144 samples), each tremolo step takes
 	//  1024 samples.
 	//  -> 256 steps total
-	uint16_t lfo_am = lfo_cnt / (LFO_PERIOD / 0x100);
+	uint16_t lfo_am = lfoCnt / (LFO_PERIOD / 0x100);
 	// results in 0x00..0x7F, 0x7F..0x00
 	if (lfo_am >= 0x80) lfo_am ^= 0xFF;
 
@@ -322,99 +323,97 @@ uint16_t YMF278::Slot::compute_am() const
 }
 
 
-void YMF278::advance()
+// Advance the state of one slot by one sample. 'egCnt' is the (already
+// incremented) global envelope counter.
+void YMF278::advance(Slot& op, unsigned egCnt)
 {
-	eg_cnt++;
-
 	// modulo counters for volume interpolation
-	int tl_int_cnt  =  eg_cnt % 9;      // 0 .. 8
-	int tl_int_step = (eg_cnt / 9) % 3; // 0 .. 2
-
-	for (auto& op : slots) {
-		// volume interpolation
-		if (tl_int_cnt == 0) {
-			if (tl_int_step == 0) {
-				// decrease volume by one step every 27 samples
-				if (op.TL < op.TLdest) ++op.TL;
-			} else {
-				// increase volume by one step every 13.5 samples
-				if (op.TL > op.TLdest) --op.TL;
-			}
+	int tl_int_cnt  =  egCnt % 9;      // 0 .. 8
+	int tl_int_step = (egCnt / 9) % 3; // 0 .. 2
+
+	// volume interpolation
+	if (tl_int_cnt == 0) {
+		if (tl_int_step == 0) {
+			// decrease volume by one step every 27 samples
+			if (op.TL < op.TLdest) ++op.TL;
+		} else {
+			// increase volume by one step every 13.5 samples
+			if (op.TL > op.TLdest) --op.TL;
 		}
+	}
 
-		if (op.lfo_active) {
-			op.lfo_cnt = (op.lfo_cnt + lfo_period[op.lfo]) & (LFO_PERIOD - 1);
-		}
+	if (op.lfo_active) {
+		op.lfo_cnt = (op.lfo_cnt + lfo_period[op.lfo]) & (LFO_PERIOD - 1);
+	}
 
-		// Envelope Generator
-		switch (op.state) {
-		case EG_ATT: { // attack phase
-			uint8_t rate = op.compute_rate(op.AR);
-			// Verified by HW recording (and matches Nemesis' tests of the YM2612):
-			// AR = 0xF during KeyOn results in instant switch to EG_DEC. (see keyOnHelper)
-			// Setting AR = 0xF while the attack phase is in progress freezes the envelope.
-			if (rate >= 63) {
-				break;
-			}
-			uint8_t shift = eg_rate_shift[rate];
-			if (!(eg_cnt & ((1 << shift) - 1))) {
-				uint8_t select = eg_rate_select[rate];
-				// >>4 makes the attack phase's shape match the actual chip -Valley Bell
-				op.env_vol += (~op.env_vol * eg_inc[select + ((eg_cnt >> shift) & 7)]) >> 4;
-				if (op.env_vol <= MIN_ATT_INDEX) {
-					op.env_vol = MIN_ATT_INDEX;
-					// TODO does the real HW skip EG_DEC completely,
-					//      or is it active for 1 sample?
-					op.state = op.DL ? EG_DEC : EG_SUS;
-				}
-			}
+	// Envelope Generator
+	switch (op.state) {
+	case EG_ATT: { // attack phase
+		uint8_t rate = op.compute_rate(op.AR);
+		// Verified by HW recording (and matches Nemesis' tests of the YM2612):
+		// AR = 0xF during KeyOn results in instant switch to EG_DEC. (see keyOnHelper)
+		// Setting AR = 0xF while the attack phase is in progress freezes the envelope.
+		if (rate >= 63) {
 			break;
 		}
-		case EG_DEC: { // decay phase
-			uint8_t rate = op.compute_decay_rate(op.D1R);
-			uint8_t shift = eg_rate_shift[rate];
-			if (!(eg_cnt & ((1 << shift) - 1))) {
-				uint8_t select = eg_rate_select[rate];
-				op.env_vol += eg_inc[select + ((eg_cnt >> shift) & 7)];
-				if (op.env_vol >= op.DL) {
-					op.state = (op.env_vol < MAX_ATT_INDEX) ? EG_SUS : EG_OFF;
-				}
+		uint8_t shift = eg_rate_shift[rate];
+		if (!(egCnt & ((1 << shift) - 1))) {
+			uint8_t select = eg_rate_select[rate];
+			// >>4 makes the attack phase's shape match the actual chip -Valley Bell
+			op.env_vol += (~op.env_vol * eg_inc[select + ((egCnt >> shift) & 7)]) >> 4;
+			if (op.env_vol <= MIN_ATT_INDEX) {
+				op.env_vol = MIN_ATT_INDEX;
+				// TODO does the real HW skip EG_DEC completely,
+				//      or is it active for 1 sample?
+				op.state = op.DL ? EG_DEC : EG_SUS;
 			}
-			break;
 		}
-		case EG_SUS: { // sustain phase
-			uint8_t rate = op.compute_decay_rate(op.D2R);
-			uint8_t shift = eg_rate_shift[rate];
-			if (!(eg_cnt & ((1 << shift) - 1))) {
-				uint8_t select = eg_rate_select[rate];
-				op.env_vol += eg_inc[select + ((eg_cnt >> shift) & 7)];
-				if (op.env_vol >= MAX_ATT_INDEX) {
-					op.env_vol = MAX_ATT_INDEX;
-					op.state = EG_OFF;
-				}
+		break;
+	}
+	case EG_DEC: { // decay phase
+		uint8_t rate = op.compute_decay_rate(op.D1R);
+		uint8_t shift = eg_rate_shift[rate];
+		if (!(egCnt & ((1 << shift) - 1))) {
+			uint8_t select = eg_rate_select[rate];
+			op.env_vol += eg_inc[select + ((egCnt >> shift) & 7)];
+			if (op.env_vol >= op.DL) {
+				op.state = (op.env_vol < MAX_ATT_INDEX) ? EG_SUS : EG_OFF;
 			}
-			break;
 		}
-		case EG_REL: { // release phase
-			uint8_t rate = op.compute_decay_rate(op.RR);
-			uint8_t shift = eg_rate_shift[rate];
-			if (!(eg_cnt & ((1 << shift) - 1))) {
-				uint8_t select = eg_rate_select[rate];
-				op.env_vol += eg_inc[select + ((eg_cnt >> shift) & 7)];
-				if (op.env_vol >= MAX_ATT_INDEX) {
-					op.env_vol = MAX_ATT_INDEX;
-					op.state = EG_OFF;
-				}
+		break;
+	}
+	case EG_SUS: { // sustain phase
+		uint8_t rate = op.compute_decay_rate(op.D2R);
+		uint8_t shift = eg_rate_shift[rate];
+		if (!(egCnt & ((1 << shift) - 1))) {
+			uint8_t select = eg_rate_select[rate];
+			op.env_vol += eg_inc[select + ((egCnt >> shift) & 7)];
+			if (op.env_vol >= MAX_ATT_INDEX) {
+				op.env_vol = MAX_ATT_INDEX;
+				op.state = EG_OFF;
 			}
-			break;
 		}
-		case EG_OFF:
-			// nothing
-			break;
-
-		default:
-			UNREACHABLE;
+		break;
+	}
+	case EG_REL: { // release phase
+		uint8_t rate = op.compute_decay_rate(op.RR);
+		uint8_t shift = eg_rate_shift[rate];
+		if (!(egCnt & ((1 << shift) - 1))) {
+			uint8_t select = eg_rate_select[rate];
+			op.env_vol += eg_inc[select + ((egCnt >> shift) & 7)];
+			if (op.env_vol >= MAX_ATT_INDEX) {
+				op.env_vol = MAX_ATT_INDEX;
+				op.state = EG_OFF;
+			}
 		}
+		break;
+	}
+	case EG_OFF:
+		// nothing
+		break;
+
+	default:
+		UNREACHABLE;
 	}
 }
 
@@ -483,6 +482,9 @@ void YMF278::setMixLevel(uint8_t x, EmuTime::param time)
 	setSoftwareVolume(level[x & 7], level[(x >> 3) & 7], time);
 }
 
+// Number of samples that are generated per slot in one go, see generateSlot().
+constexpr unsigned BLOCK_SIZE = 128;
+
 void YMF278::generateChannels(float** bufs, unsigned num)
 {
 	if (!anyActive()) {
@@ -492,58 +494,95 @@ void YMF278::generateChannels(float** bufs, unsigned num)
 		return;
 	}
 
-	for (auto j : xrange(num)) {
+	// The slots don't influence each other, so each slot can be generated
+	// for a whole block of samples before moving to the next slot.
+	unsigned blockSize = bulkEnabled ? BLOCK_SIZE : 1;
+	for (unsigned start = 0; start < num; start += blockSize) {
+		unsigned len = std::min(num - start, blockSize);
 		for (auto i : xrange(24)) {
-			auto& sl = slots[i];
-			if (sl.state == EG_OFF) {
-				//bufs[i][2 * j + 0] += 0;
-				//bufs[i][2 * j + 1] += 0;
-				continue;
-			}
+			generateSlot(slots[i], bufs[i] + 2 * start, len);
+		}
+		eg_cnt += len;
+	}
+}
 
-			int16_t sample = (sl.sample1 * (0x10000 - sl.stepptr) +
-			                  sl.sample2 * sl.stepptr) >> 16;
-			// TL levels are 00..FF internally (TL register value 7F is mapped to TL level FF)
-			// Envelope levels have 4x the resolution (000..3FF)
-			// Volume levels are approximate logarithmic. -6dB result in half volume. Steps in between use linear interpolation.
-			// A volume of -60dB or lower results in silence. (value 0x280..0x3FF).
-			// Recordings from actual hardware indicate that TL level and envelope level are applied separarely.
-			// Each of them is clipped to silence below -60dB, but TL+envelope might result in a lower volume. -Valley Bell
-			uint16_t envVol = std::min(sl.env_vol + ((sl.lfo_active && sl.AM) ? sl.compute_am() : 0),
-			                           MAX_ATT_INDEX);
-			int smplOut = vol_factor(vol_factor(sample, envVol), sl.TL << TL_SHIFT);
-
-			// Panning is also done separately. (low-volume TL + low-volume panning goes below -60dB)
-			// I'll be taking wild guess and assume that -3dB is approximated with 75%. (same as with TL and envelope levels)
-			// The same applies to the PCM mix level.
-			int32_t volLeft  = pan_left [sl.pan]; // note: register 0xF9 is handled externally
-			int32_t volRight = pan_right[sl.pan];
-			// 0 -> 0x20, 8 -> 0x18, 16 -> 0x10, 24 -> 0x0C, etc. (not using vol_factor here saves array boundary checks)
-			volLeft  = (0x20 - (volLeft  & 0x0f)) >> (volLeft  >> 4);
-			volRight = (0x20 - (volRight & 0x0f)) >> (volRight >> 4);
-
-			bufs[i][2 * j + 0] += (smplOut * volLeft ) >> 5;
-			bufs[i][2 * j + 1] += (smplOut * volRight) >> 5;
-
-			unsigned step = (sl.lfo_active && sl.vib)
-			              ? calcStep(sl.OCT, sl.FN, sl.compute_vib())
-			              : sl.step;
-			sl.stepptr += step;
-
-			// If there is a 4-sample loop and you advance 12 samples per step,
-			// it may exceed the end offset.
-			// This is abused by the "Lizard Star" song to generate noise at 0:52. -Valley Bell
-			if (sl.stepptr >= 0x10000) {
-				sl.sample1 = sl.sample2;
-				sl.sample2 = getSample(sl);
-				sl.pos += (sl.stepptr >> 16);
-				sl.stepptr &= 0xffff;
-				if ((uint32_t(sl.pos) + sl.endaddr) >= 0x10000) { // check position >= (negated) end address
-					sl.pos += sl.endaddr + sl.loopaddr; // This is how the actual chip does it.
-				}
+// Generate 'num' samples for one slot, in three passes. The result is
+// identical to generating all slots sample per sample (interleaved with
+// advance()), but the passes are simpler loops:
+// - Run the envelope generator. This also determines for how many samples
+//   the slot is active (once a slot is off, it stays off).
+// - Walk through the sample memory and interpolate. This is the only part
+//   with data dependent memory accesses.
+// - Apply volume and panning. There are no dependencies between the samples
+//   in this loop, so the compiler can vectorize it.
+void YMF278::generateSlot(Slot& sl, float* buf, unsigned num)
+{
+	assert(num <= BLOCK_SIZE);
+
+	// Values at the start of each sample (before advance()).
+	int16_t envVols[BLOCK_SIZE];
+	uint8_t tls[BLOCK_SIZE];
+	uint32_t lfoCnts[BLOCK_SIZE];
+	unsigned active = 0;
+	for (auto j : xrange(num)) {
+		if (sl.state != EG_OFF) {
+			envVols[j] = sl.env_vol;
+			tls[j] = sl.TL;
+			lfoCnts[j] = sl.lfo_cnt;
+			active = j + 1;
+		}
+		// also when off: volume interpolation and LFO keep running
+		advance(sl, eg_cnt + j + 1);
+	}
+	if (active == 0) return;
+
+	int16_t samples[BLOCK_SIZE];
+	bool vib = sl.lfo_active && sl.vib;
+	for (auto j : xrange(active)) {
+		samples[j] = (sl.sample1 * (0x10000 - sl.stepptr) +
+		              sl.sample2 * sl.stepptr) >> 16;
+
+		unsigned step = vib ? calcStep(sl.OCT, sl.FN, sl.compute_vib(lfoCnts[j]))
+		                    : sl.step;
+		sl.stepptr += step;
+
+		// If there is a 4-sample loop and you advance 12 samples per step,
+		// it may exceed the end offset.
+		// This is abused by the "Lizard Star" song to generate noise at 0:52. -Valley Bell
+		if (sl.stepptr >= 0x10000) {
+			sl.sample1 = sl.sample2;
+			sl.sample2 = getSample(sl);
+			sl.pos += (sl.stepptr >> 16);
+			sl.stepptr &= 0xffff;
+			if ((uint32_t(sl.pos) + sl.endaddr) >= 0x10000) { // check position >= (negated) end address
+				sl.pos += sl.endaddr + sl.loopaddr; // This is how the actual chip does it.
 			}
 		}
-		advance();
+	}
+
+	// Panning is also done separately. (low-volume TL + low-volume panning goes below -60dB)
+	// I'll be taking wild guess and assume that -3dB is approximated with 75%. (same as with TL and envelope levels)
+	// The same applies to the PCM mix level.
+	int32_t volLeft  = pan_left [sl.pan]; // note: register 0xF9 is handled externally
+	int32_t volRight = pan_right[sl.pan];
+	// 0 -> 0x20, 8 -> 0x18, 16 -> 0x10, 24 -> 0x0C, etc. (not using vol_factor here saves array boundary checks)
+	volLeft  = (0x20 - (volLeft  & 0x0f)) >> (volLeft  >> 4);
+	volRight = (0x20 - (volRight & 0x0f)) >> (volRight >> 4);
+
+	bool am = sl.lfo_active && sl.AM;
+	for (auto j : xrange(active)) {
+		// TL levels are 00..FF internally (TL register value 7F is mapped to TL level FF)
+		// Envelope levels have 4x the resolution (000..3FF)
+		// Volume levels are approximate logarithmic. -6dB result in half volume. Steps in between use linear interpolation.
+		// A volume of -60dB or lower results in silence. (value 0x280..0x3FF).
+		// Recordings from actual hardware indicate that TL level and envelope level are applied separarely.
+		// Each of them is clipped to silence below -60dB, but TL+envelope might result in a lower volume. -Valley Bell
+		uint16_t envVol = std::min(envVols[j] + (am ? sl.compute_am(lfoCnts[j]) : 0),
+		                           MAX_ATT_INDEX);
+		int smplOut = vol_factor(vol_factor(samples[j], envVol), tls[j] << TL_SHIFT);
+
+		buf[2 * j + 0] += (smplOut * volLeft ) >> 5;
+		buf[2 * j + 1] += (smplOut * volRight) >> 5;
 	}
 }
 
@@ -31,6 +31,11 @@ public:
 
 	void setMixLevel(uint8_t x, EmuTime::param time);
 
+	/** The wave slots are generated per block of samples instead of all
+	  * slots sample per sample. Only used by the unittest, to compare both.
+	  */
+	static void setBulkEnabled(bool enabled) { bulkEnabled = enabled; }
+
 	template<typename Archive>
 	void serialize(Archive& ar, unsigned version);
 
@@ -43,8 +48,8 @@ private:
 		[[nodiscard]] int compute_decay_rate(int val) const;
 		[[nodiscard]] unsigned decay_rate(int num, int sample_rate);
 		void envelope_next(int sample_rate);
-		[[nodiscard]] int16_t compute_vib() const;
-		[[nodiscard]] uint16_t compute_am() const;
+		[[nodiscard]] int16_t compute_vib(uint32_t lfoCnt) const;
+		[[nodiscard]] uint16_t compute_am(uint32_t lfoCnt) const;
 
 		template<typename Archive>
 		void serialize(Archive& ar, unsigned version);
@@ -89,11 +94,13 @@ private:
 
 	// SoundDevice
 	void generateChannels(float** bufs, unsigned num) override;
+	[[nodiscard]] bool supportsStateOnly() const override { return true; }
 
 	void writeRegDirect(byte reg, byte data, EmuTime::param time);
 	[[nodiscard]] unsigned getRamAddress(unsigned addr) const;
+	void generateSlot(Slot& sl, float* buf, unsigned num);
 	[[nodiscard]] int16_t getSample(Slot& op) const;
-	void advance();
+	static void advance(Slot& op, unsigned egCnt);
 	[[nodiscard]] bool anyActive();
 	void keyOnHelper(Slot& slot);
 
@@ -122,6 +129,10 @@ private:
 	TrackedRam ram;
 
 	byte regs[256];
+
+	/** See setBulkEnabled().
+	 */
+	static inline bool bulkEnabled = true;
 };
 SERIALIZE_CLASS_VERSION(YMF278::Slot, 5);
 SERIALIZE_CLASS_VERSION(YMF278, 4);
@@ -0,0 +1,95 @@
+#include "WorkerPool.hh"
+#include "xrange.hh"
+#include <cassert>
+#include <utility>
+
+namespace openmsx {
+
+WorkerPool::WorkerPool(unsigned numThreads)
+{
+	assert(numThreads >= 1);
+	threads.reserve(numThreads - 1);
+	for ([[maybe_unused]] auto i : xrange(numThreads - 1)) {
+		threads.emplace_back([this]() { run(); });
+	}
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard lock(mutex);
+		quit = true;
+	}
+	startCondition.notify_all();
+	for (auto& t : threads) t.join();
+}
+
+void WorkerPool::parallelFor(unsigned count, const std::function<void(unsigned)>& func)
+{
+	if (count == 0) return;
+	if (threads.empty() || (count == 1)) {
+		// avoid the synchronization overhead
+		for (auto i : xrange(count)) func(i);
+		return;
+	}
+
+	{
+		std::lock_guard lock(mutex);
+		assert(busy == 0);
+		job = &func;
+		jobSize = count;
+		next = 0;
+		busy = unsigned(threads.size());
+		++generation;
+	}
+	startCondition.notify_all();
+
+	work();
+
+	std::unique_lock lock(mutex);
+	// also when 'func' threw: the workers may still be using it
+	doneCondition.wait(lock, [&] { return busy == 0; });
+	job = nullptr;
+	if (exception) {
+		std::rethrow_exception(std::exchange(exception, nullptr));
+	}
+}
+
+void WorkerPool::work()
+{
+	// 'job' and 'jobSize' don't change while workers are busy
+	try {
+		while (true) {
+			unsigned i = next.fetch_add(1);
+			if (i >= jobSize) break;
+			(*job)(i);
+		}
+	} catch (...) {
+		// skip the calls that didn't start yet
+		next = jobSize;
+		std::lock_guard lock(mutex);
+		if (!exception) exception = std::current_exception();
+	}
+}
+
+void WorkerPool::run()
+{
+	unsigned seen = 0;
+	while (true) {
+		{
+			std::unique_lock lock(mutex);
+			startCondition.wait(lock, [&] { return quit || (generation != seen); });
+			if (quit) return;
+			seen = generation;
+		}
+		work();
+		bool last;
+		{
+			std::lock_guard lock(mutex);
+			last = --busy == 0;
+		}
+		if (last) doneCondition.notify_one();
+	}
+}
+
+} // namespace openmsx
@@ -0,0 +1,61 @@
+#ifndef WORKERPOOL_HH
+#define WORKERPOOL_HH
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace openmsx {
+
+/** A small fixed-size pool of worker threads to split up a computation
+  * into independent parts. The thread that calls parallelFor() also takes
+  * part in the work, so a pool constructed with N threads uses N-1 extra
+  * (background) threads.
+  */
+class WorkerPool
+{
+public:
+	explicit WorkerPool(unsigned numThreads);
+	~WorkerPool();
+
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool& operator=(const WorkerPool&) = delete;
+
+	/** Total number of threads, including the calling thread. */
+	[[nodiscard]] unsigned getNumThreads() const { return unsigned(threads.size() + 1); }
+
+	/** Call 'func(i)' for all 0 <= i < count. The calls are distributed
+	  * over the worker threads (in unspecified order) and this method
+	  * only returns after all calls have finished. 'func' must be safe to
+	  * call concurrently for different 'i'.
+	  * Must not be called concurrently from different threads.
+	  */
+	void parallelFor(unsigned count, const std::function<void(unsigned)>& func);
+
+private:
+	void run();
+	void work();
+
+private:
+	std::vector<std::thread> threads;
+	std::mutex mutex;
+	std::condition_variable startCondition;
+	std::condition_variable doneCondition;
+
+	// current job, protected by 'mutex' (except 'next')
+	const std::function<void(unsigned)>* job = nullptr;
+	unsigned jobSize = 0;
+	std::atomic<unsigned> next = 0;
+	unsigned generation = 0; // incremented for each new job
+	unsigned busy = 0; // number of worker threads still working on 'job'
+	std::exception_ptr exception; // first exception thrown by 'job'
+	bool quit = false;
+};
+
+} // namespace openmsx
+
+#endif
@@ -0,0 +1,99 @@
+#include "catch.hpp"
+#include "TestMachine.hh"
+#include "AY8910.hh"
+#include "AY8910Periphery.hh"
+#include "DeviceConfig.hh"
+#include "HardwareConfig.hh"
+#include "MSXMotherBoard.hh"
+#include "XMLElement.hh"
+#include "xrange.hh"
+#include <cstdint>
+#include <random>
+#include <vector>
+
+using namespace openmsx;
+
+namespace {
+
+// Nothing connected to the I/O ports.
+struct NoPeriphery final : AY8910Periphery {};
+
+struct Result {
+	std::vector<float> samples;
+	std::vector<bool> silent; // per generateInput() call
+};
+
+} // namespace
+
+static Result run(TestMachine& machine, bool bulk)
+{
+	AY8910::setBulkEnabled(bulk);
+	auto& board = machine.getMotherBoard();
+	XMLElement xml("PSG");
+	xml.addChild("sound").addChild("volume", "21000");
+	DeviceConfig config(*board.getMachineConfig(), xml);
+	NoPeriphery periphery;
+	EmuTime time = machine.getCurrentTime();
+	AY8910 ay8910("PSG", periphery, config, time);
+
+	std::minstd_rand rnd(1234);
+	auto random = [&](unsigned n) { return unsigned(rnd() % n); };
+	auto randomPeriod = [&] {
+		// mostly short periods: many events per generated block
+		return random(2) ? random(4) : random(2) ? random(64) : random(0x1000);
+	};
+
+	Result result;
+	alignas(16) float buffer[2048];
+	for ([[maybe_unused]] auto i : xrange(2000)) {
+		// All writes happen at the same moment in time, so the output is
+		// only generated by the generateInput() calls below.
+		switch (random(4)) {
+		case 0: { // tone period
+			unsigned chan = random(3);
+			unsigned period = randomPeriod();
+			ay8910.writeRegister(2 * chan + 0, uint8_t(period), time);
+			ay8910.writeRegister(2 * chan + 1, uint8_t(period >> 8), time);
+			break;
+		}
+		case 1: // mixer: tone/noise per channel (port bits don't matter)
+			ay8910.writeRegister(7, uint8_t(random(64)), time);
+			break;
+		case 2: // volume, or follow the envelope
+			ay8910.writeRegister(8 + random(3), uint8_t(random(32)), time);
+			break;
+		case 3: { // noise period, envelope period and shape
+			unsigned period = randomPeriod();
+			ay8910.writeRegister(6, uint8_t(random(32)), time);
+			ay8910.writeRegister(11, uint8_t(period), time);
+			ay8910.writeRegister(12, uint8_t(period >> 8), time);
+			ay8910.writeRegister(13, uint8_t(random(16)), time);
+			break;
+		}
+		}
+		unsigned num = 1 + random(2048);
+		bool sound = ay8910.generateInput(buffer, num);
+		result.silent.push_back(!sound);
+		if (sound) result.samples.insert(result.samples.end(), buffer, buffer + num);
+	}
+	AY8910::setBulkEnabled(true);
+	return result;
+}
+
+TEST_CASE("AY8910: bulk square waves give the same result")
+{
+	// The same (random) register writes, once generated event by event and
+	// once with the fixed-period square waves generated in one go. The
+	// output must be exactly the same.
+	TestMachine machine("");
+	auto slow = run(machine, false);
+	auto fast = run(machine, true);
+
+	CHECK(!slow.samples.empty());
+	CHECK(fast.silent == slow.silent);
+	REQUIRE(fast.samples.size() == slow.samples.size());
+	for (auto i : xrange(slow.samples.size())) {
+		INFO("sample " << i);
+		REQUIRE(fast.samples[i] == slow.samples[i]);
+	}
+}
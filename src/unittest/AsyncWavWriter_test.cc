@@ -0,0 +1,91 @@
+#include "catch.hpp"
+#include "AsyncWavWriter.hh"
+#include "WavWriter.hh"
+#include "Filename.hh"
+#include "FileOperations.hh"
+#include "MSXException.hh"
+#include "TestMachine.hh"
+#include "xrange.hh"
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+using namespace openmsx;
+
+static std::vector<char> readFile(const std::string& filename)
+{
+	std::ifstream is(filename, std::ios::binary);
+	return {std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>()};
+}
+
+// Write the same data with both writers, in chunks of different sizes.
+template<typename Writer>
+static void writeTestData(Writer& writer, unsigned stereo)
+{
+	std::vector<int16_t> ints;
+	std::vector<float> floats;
+	for (auto i : xrange(5000 * stereo)) {
+		ints.push_back(int16_t(i * 997));
+		// also some values that need clipping
+		floats.push_back(1.5f * std::sin(float(i) * 0.01f));
+	}
+	unsigned pos = 0;
+	for (unsigned samples : {1u, 7u, 100u, 1000u, 0u, 3000u}) {
+		writer.write(&ints[pos * stereo], stereo, samples);
+		writer.write(&floats[pos * stereo], stereo, samples,
+		             0.75f, (stereo == 2) ? 0.5f : 0.75f);
+		writer.writeSilence(stereo, samples);
+		pos += samples;
+	}
+}
+
+TEST_CASE("AsyncWav16Writer: same output as Wav16Writer")
+{
+	auto tmp = TestMachine::getDataDir() + "/asyncwavwriter";
+	FileOperations::deleteRecursive(tmp);
+	FileOperations::mkdirp(tmp);
+
+	for (unsigned stereo : {1u, 2u}) {
+		auto syncName  = tmp + "/sync.wav";
+		auto asyncName = tmp + "/async.wav";
+		{
+			Wav16Writer writer(Filename(syncName), stereo, 44100);
+			writeTestData(writer, stereo);
+			writer.writeSilence(stereo, 10);
+		}
+		{
+			AsyncWav16Writer writer(Filename(asyncName), stereo, 44100);
+			writeTestData(writer, stereo);
+			// a flush in the middle of the recording gives a
+			// complete file
+			writer.flush();
+			CHECK(readFile(asyncName).size() == (44 + 2 * stereo * 3 * 4108));
+			writer.writeSilence(stereo, 10);
+		}
+		auto syncData  = readFile(syncName);
+		auto asyncData = readFile(asyncName);
+		CHECK(syncData.size() == (44 + 2 * stereo * (3 * 4108 + 10)));
+		CHECK(syncData == asyncData);
+	}
+
+	FileOperations::deleteRecursive(tmp);
+}
+
+#ifdef __linux__
+TEST_CASE("AsyncWav16Writer: report write errors")
+{
+	// every write to /dev/full fails (with ENOSPC)
+	AsyncWav16Writer writer(Filename("/dev/full"), 2, 44100);
+	std::vector<int16_t> buffer(2 * 100000);
+	CHECK_THROWS_AS([&] {
+		// the error is reported by one of the later calls
+		for ([[maybe_unused]] auto i : xrange(10)) {
+			writer.write(buffer.data(), 2, 100000);
+		}
+		writer.flush();
+	}(), MSXException);
+}
+#endif
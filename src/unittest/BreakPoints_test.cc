@@ -0,0 +1,73 @@
+#include "catch.hpp"
+#include "TestMachine.hh"
+#include "BreakPoint.hh"
+#include "MSXCPUInterface.hh"
+#include "TclObject.hh"
+#include "xrange.hh"
+#include <bitset>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace openmsx;
+
+// A fixed stream of program counter values: mostly short steps forward
+// (instruction lengths), sometimes a jump to a random address.
+static std::vector<uint16_t> generatePCs(size_t num)
+{
+	std::minstd_rand rnd(1234);
+	std::vector<uint16_t> result;
+	result.reserve(num);
+	uint16_t pc = 0x4000;
+	for ([[maybe_unused]] auto i : xrange(num)) {
+		result.push_back(pc);
+		if ((rnd() % 10) == 0) {
+			pc = uint16_t(rnd());
+		} else {
+			pc += uint16_t(1 + rnd() % 3);
+		}
+	}
+	return result;
+}
+
+// Not run by default, run with:  unittest "[benchmark]"
+TEST_CASE("BreakPoints: benchmark", "[.benchmark]")
+{
+	TestMachine machine("");
+	auto& board = machine.getMotherBoard();
+	REQUIRE(MSXCPUInterface::getBreakPoints().empty());
+	REQUIRE(MSXCPUInterface::getConditions().empty());
+
+	auto pcs = generatePCs(10000000);
+	for (unsigned num : {0, 10, 1000, 10000}) {
+		// Spread over the address space (odd multiplier -> distinct
+		// addresses). With condition '0' they never actually break.
+		std::bitset<0x10000> addresses;
+		for (auto i : xrange(num)) {
+			auto address = uint16_t(i * 40503);
+			addresses[address] = true;
+			MSXCPUInterface::insertBreakPoint(
+				BreakPoint(address, TclObject(), TclObject("0"), false));
+		}
+		size_t hits = 0;
+		for (auto pc : pcs) hits += addresses[pc];
+
+		unsigned breaks = 0;
+		auto start = std::chrono::steady_clock::now();
+		for (auto pc : pcs) {
+			breaks += MSXCPUInterface::checkBreakPoints(pc, board);
+		}
+		auto stop = std::chrono::steady_clock::now();
+		CHECK(breaks == 0);
+		auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count();
+		std::cout << num << " breakpoints: " << double(ns) / pcs.size()
+		          << " ns/instruction, " << 100.0 * double(hits) / pcs.size()
+		          << "% of the instructions at a breakpoint\n";
+
+		while (!MSXCPUInterface::getBreakPoints().empty()) {
+			MSXCPUInterface::removeBreakPoint(MSXCPUInterface::getBreakPoints().back());
+		}
+	}
+}
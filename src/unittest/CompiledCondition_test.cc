@@ -0,0 +1,109 @@
+#include "catch.hpp"
+#include "CompiledCondition.hh"
+#include "CPURegs.hh"
+#include <array>
+
+using namespace openmsx;
+
+struct TestContext final : CompiledCondition::Context
+{
+	const CPURegs& getRegisters() override { return regs; }
+	byte peekMem(word address) override { return mem[address]; }
+	std::pair<int, int> getSlot(int page) override { return slots[page]; }
+
+	CPURegs regs{false};
+	std::array<byte, 0x10000> mem = {};
+	std::array<std::pair<int, int>, 4> slots = {
+		std::pair{0, -1}, std::pair{3, 2}, std::pair{3, 2}, std::pair{3, 0}};
+};
+
+static std::optional<bool> eval(std::string_view expr, TestContext& context)
+{
+	auto cond = CompiledCondition::compile(expr);
+	REQUIRE(cond);
+	return cond->evaluate(context);
+}
+
+TEST_CASE("CompiledCondition: not supported")
+{
+	// these must be handled by Tcl
+	for (auto* expr : {
+		"", "$x == 1", "[reg a", "[reg XYZ] == 1", "[reg $r]", "[foo 1]",
+		"1.5 > 1", "010 == 8", "2 ** 3", "\"a\" eq \"a\"", "{1}",
+		"[peek 0x100 VRAM]", "[pc_in_slot 1] == 1", "[pc_in_slot 4]",
+		"1 +", "(1", "1 ? 2", "0x", "4294967296 > 1", "1 1",
+		"[reg A]\n[reg B]", "abs(-1)", "[peek -1]",
+	}) {
+		INFO(expr);
+		CHECK(!CompiledCondition::compile(expr));
+	}
+}
+
+TEST_CASE("CompiledCondition: operators")
+{
+	TestContext context;
+	CHECK(*eval("1", context));
+	CHECK(!*eval("0", context));
+	CHECK(*eval("1 + 2 * 3 == 7", context));
+	CHECK(*eval("(1 + 2) * 3 == 9", context));
+	CHECK(*eval("10 - 4 - 3 == 3", context));
+	CHECK(*eval("-7 / 2 == -4", context)); // rounds towards -inf (like Tcl)
+	CHECK(*eval("-7 % 2 == 1", context));
+	CHECK(*eval("7 % -2 == -1", context));
+	CHECK(*eval("0x10 == 16 && 0b101 == 5", context));
+	CHECK(*eval("(0xF0 | 0x0F) == 255", context));
+	CHECK(*eval("(0xF0 & 0x3C) == 0x30", context));
+	CHECK(*eval("(0xF0 ^ 0x3C) == 0xCC", context));
+	CHECK(*eval("~0 == -1", context));
+	CHECK(*eval("!0", context));
+	CHECK(*eval("1 << 4 == 16 && 256 >> 4 == 16", context));
+	CHECK(*eval("1 < 2 && 2 <= 2 && 3 > 2 && 2 >= 2 && 1 != 2", context));
+	CHECK(!*eval("1 < 2 && 2 > 3", context));
+	CHECK(*eval("0 || 5", context));
+	CHECK(*eval("((1 || 0) + (0 || 7)) == 2", context)); // || gives 0 or 1
+	CHECK(*eval("1 ? 0 ? 2 : 3 : 4", context));
+	CHECK(*eval("(0 ? 5 : 6) == 6", context));
+	CHECK(*eval("- -1 == +1", context));
+
+	// evaluation errors or overflow -> fall back to Tcl
+	CHECK(!eval("1 / 0", context));
+	CHECK(!eval("0 || 1 % 0", context));
+	CHECK(*eval("1 || 1 % 0", context)); // short-circuit
+	CHECK(!eval("0x7fffffff + 1", context));
+	CHECK(!eval("1 << -1", context));
+}
+
+TEST_CASE("CompiledCondition: machine state")
+{
+	TestContext context;
+	auto& regs = context.regs;
+	regs.setA(0x12);
+	regs.setHL(0x4000);
+	regs.setIX(0xC000);
+	regs.setPC(0x4123);
+	context.mem[0x4000] = 0x34;
+	context.mem[0x4001] = 0x56;
+	context.mem[0xFFFF] = 0x78;
+
+	CHECK(*eval("[reg A] == 0x12", context));
+	CHECK(*eval("[reg a] == 0x12", context));
+	CHECK(*eval("[reg hl] == 0x4000 && [reg H] == 0x40", context));
+	CHECK(*eval("[reg IXH] == 0xC0", context));
+	CHECK(*eval("[reg PC]==0x4123", context));
+	CHECK(*eval("[peek 0x4000] == 0x34", context));
+	CHECK(*eval("[peek [reg HL]] == 0x34", context));
+	CHECK(*eval("[peek16 [reg HL]] == 0x5634", context));
+	CHECK(*eval("[peek_u16 [reg HL] memory] == 0x5634", context));
+	CHECK(*eval("[debug read memory 0xFFFF] == 0x78", context));
+	CHECK(!eval("[peek16 0xFFFF]", context));
+
+	CHECK(*eval("[pc_in_slot 3]", context));
+	CHECK(*eval("[pc_in_slot 3 2]", context));
+	CHECK(*eval("[pc_in_slot X 2]", context));
+	CHECK(!*eval("[pc_in_slot 3 1]", context));
+	CHECK(!*eval("[pc_in_slot 0]", context));
+	CHECK(*eval("[pc_in_slot 3 2] && [reg A] == 0x12", context));
+	CHECK(*eval("![pc_in_slot 0]", context));
+	regs.setPC(0x0000);
+	CHECK(*eval("[pc_in_slot 0 1]", context)); // not expanded
+}
@@ -0,0 +1,266 @@
+#include "catch.hpp"
+#include "TestMachine.hh"
+#include "FBPostProcessor.hh"
+#include "Display.hh"
+#include "GlobalCommandController.hh"
+#include "MSXMotherBoard.hh"
+#include "RawFrame.hh"
+#include "Reactor.hh"
+#include "SDLOutputSurface.hh"
+#include "SDLSnow.hh"
+#include "SDLSurfacePtr.hh"
+#include "SettingsManager.hh"
+#include "TclObject.hh"
+#include "build-info.hh"
+#include "xrange.hh"
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+
+#if HAVE_32BPP
+
+using namespace openmsx;
+
+namespace {
+
+using Pixel = uint32_t;
+
+// Only the alpha byte of this value is non-zero, the scalers (on the frames
+// below) only produce pixels with alpha zero.
+constexpr Pixel MARKER = 0xA5000000;
+
+// An in-memory frame buffer. Before each paint it's filled with MARKER, so
+// that afterwards we can see which lines were (re)painted.
+class FakeSurface final : public SDLOutputSurface
+{
+public:
+	FakeSurface(int width, int height)
+		: surface(width, height, 32,
+		          0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000)
+	{
+		gl::ivec2 size(width, height);
+		calculateViewPort(size, size);
+		setSDLPixelFormat(*surface->format);
+		setSDLSurface(surface.get());
+	}
+
+	void fill(Pixel value) {
+		auto pixelAccess = getDirectPixelAccess();
+		auto [w, h] = getLogicalSize();
+		for (auto y : xrange(h)) {
+			auto* line = pixelAccess.getLinePtr<Pixel>(y);
+			for (auto x : xrange(w)) line[x] = value;
+		}
+	}
+
+	[[nodiscard]] std::vector<bool> paintedLines() {
+		auto pixelAccess = getDirectPixelAccess();
+		auto [w, h] = getLogicalSize();
+		std::vector<bool> result(h);
+		for (auto y : xrange(h)) {
+			auto* line = pixelAccess.getLinePtr<Pixel>(y);
+			auto unpainted = std::count(line, line + w, MARKER);
+			// each line is either completely painted or not at all
+			REQUIRE(((unpainted == 0) || (unpainted == w)));
+			result[y] = unpainted == 0;
+		}
+		return result;
+	}
+
+	// SDLOutputSurface
+	void clearScreen() override {
+		fill(0);
+		setFrameBufferOwner(nullptr);
+	}
+
+private:
+	// OutputSurface
+	void saveScreenshot(const std::string& /*filename*/) override {}
+
+private:
+	SDLSurfacePtr surface;
+};
+
+template<typename T>
+void setSetting(TestMachine& machine, std::string_view name, T value)
+{
+	auto& settingsManager = machine.getMotherBoard().getReactor()
+		.getGlobalCommandController().getSettingsManager();
+	auto* setting = settingsManager.findSetting(name);
+	REQUIRE(setting);
+	setting->setValue(TclObject(value));
+}
+
+// Random content in all lines (with alpha zero), so that each line has a
+// different hash. All lines are 320 pixels wide (but contain 640 pixels).
+void fillFrame(RawFrame& frame)
+{
+	std::minstd_rand rnd(1234);
+	for (auto y : xrange(frame.getHeight())) {
+		auto* line = frame.getLinePtrDirect<Pixel>(y);
+		for (auto x : xrange(640)) line[x] = Pixel(rnd()) & 0x00FFFFFF;
+		frame.setLineWidth(y, 320);
+	}
+}
+
+} // namespace
+
+TEST_CASE("FBPostProcessor: only repaint the groups of changed lines")
+{
+	TestMachine machine("");
+	auto& board = machine.getMotherBoard();
+	auto& display = board.getReactor().getDisplay();
+	unsigned factor = display.getRenderSettings().getScaleFactor();
+	setSetting(machine, "scale_algorithm", "simple");
+	setSetting(machine, "scale_threads", 1);
+	setSetting(machine, "noise", 0);
+
+	FakeSurface surface(320 * factor, 240 * factor);
+	FBPostProcessor<Pixel> postProcessor(
+		board, display, surface, "unittest", 640, 240, false);
+	SDLSnow<Pixel> snow(surface, display);
+
+	auto frame = std::make_unique<RawFrame>(surface.getPixelFormat(), 640, 240);
+	fillFrame(*frame);
+
+	// Paint the frame and return the output lines that were repainted.
+	auto paint = [&](FakeSurface& output) {
+		frame->init(FrameSource::FIELD_NONINTERLACED);
+		frame->calcLineHashes();
+		frame = postProcessor.rotateFrames(std::move(frame), machine.getCurrentTime());
+		output.fill(MARKER);
+		postProcessor.paint(output);
+		return output.paintedLines();
+	};
+	auto all = [&](bool painted) {
+		return std::vector<bool>(240 * factor, painted);
+	};
+	// The source lines [begin, end) are repainted, each also influences
+	// the output of MARGIN (2) neighbouring source lines on both sides.
+	auto range = [&](int begin, int end) {
+		auto result = all(false);
+		for (auto y : xrange(std::max(begin - 2, 0), std::min(end + 2, 240))) {
+			for (auto i : xrange(factor)) result[y * factor + i] = true;
+		}
+		return result;
+	};
+
+	CHECK(paint(surface) == all(true)); // first paint
+	CHECK(paint(surface) == all(false)); // nothing changed
+
+	SECTION("changed lines") {
+		frame->getLinePtrDirect<Pixel>(100)[17] ^= 1;
+		CHECK(paint(surface) == range(100, 101));
+		CHECK(paint(surface) == all(false));
+
+		// at the top and bottom border
+		frame->getLinePtrDirect<Pixel>(0)[0] ^= 1;
+		frame->getLinePtrDirect<Pixel>(239)[319] ^= 1;
+		auto expected = range(0, 1);
+		auto bottom = range(239, 240);
+		for (auto i : xrange(expected.size())) expected[i] = expected[i] || bottom[i];
+		CHECK(paint(surface) == expected);
+
+		// a different line width (e.g. screen 7), the first half of the
+		// line is unchanged
+		frame->setLineWidth(50, 640);
+		CHECK(paint(surface) == range(50, 51));
+		CHECK(paint(surface) == all(false));
+	}
+	SECTION("frame buffer overwritten by someone else") {
+		surface.clearScreen();
+		CHECK(paint(surface) == all(true));
+		CHECK(paint(surface) == all(false));
+
+		snow.paint(surface);
+		CHECK(paint(surface) == all(true));
+		CHECK(paint(surface) == all(false));
+	}
+	SECTION("scaler settings") {
+		setSetting(machine, "scanline", 50);
+		CHECK(paint(surface) == all(true));
+		CHECK(paint(surface) == all(false));
+
+		setSetting(machine, "blur", 10);
+		CHECK(paint(surface) == all(true));
+		CHECK(paint(surface) == all(false));
+
+		if (factor > 1) {
+			setSetting(machine, "scale_algorithm", "TV");
+			CHECK(paint(surface) == all(true));
+			CHECK(paint(surface) == all(false));
+			setSetting(machine, "scale_algorithm", "simple");
+			CHECK(paint(surface) == all(true));
+		}
+	}
+	SECTION("different output surface") {
+		FakeSurface other(320 * factor, 240 * factor);
+		CHECK(paint(other) == all(true));
+		CHECK(paint(other) == all(false));
+		// 'surface' still contains our output, but it's not known whether
+		// that's up-to-date
+		CHECK(paint(surface) == all(true));
+		CHECK(paint(surface) == all(false));
+	}
+	SECTION("different source height") {
+		// Twice as many source lines (e.g. interlace): a different number
+		// of source lines per group.
+		auto frame2 = std::make_unique<RawFrame>(surface.getPixelFormat(), 640, 480);
+		fillFrame(*frame2);
+		frame2->calcLineHashes();
+		frame2 = postProcessor.rotateFrames(std::move(frame2), machine.getCurrentTime());
+		surface.fill(MARKER);
+		postProcessor.paint(surface);
+		CHECK(surface.paintedLines() == all(true));
+		CHECK(paint(surface) == all(true));
+		CHECK(paint(surface) == all(false));
+	}
+}
+
+TEST_CASE("FBPostProcessor: partial repaint of interlaced frames")
+{
+	TestMachine machine("");
+	auto& board = machine.getMotherBoard();
+	auto& display = board.getReactor().getDisplay();
+	unsigned factor = display.getRenderSettings().getScaleFactor();
+	setSetting(machine, "scale_algorithm", "simple");
+	setSetting(machine, "scale_threads", 1);
+	setSetting(machine, "noise", 0);
+	setSetting(machine, "deinterlace", false);
+
+	FakeSurface surface(320 * factor, 240 * factor);
+	FBPostProcessor<Pixel> postProcessor(
+		board, display, surface, "unittest", 640, 240, true);
+
+	// Without deinterlace each field is shown with all its lines doubled,
+	// odd fields are shifted down by one black line (see DoubledFrame).
+	auto frame = std::make_unique<RawFrame>(surface.getPixelFormat(), 640, 240);
+	auto paint = [&](FrameSource::FieldType field, int changedLine) {
+		fillFrame(*frame);
+		if (changedLine >= 0) {
+			frame->getLinePtrDirect<Pixel>(changedLine)[17] ^= 1;
+		}
+		frame->init(field);
+		frame->calcLineHashes();
+		frame = postProcessor.rotateFrames(std::move(frame), machine.getCurrentTime());
+		surface.fill(MARKER);
+		postProcessor.paint(surface);
+		return surface.paintedLines();
+	};
+	auto all = [&](bool painted) {
+		return std::vector<bool>(240 * factor, painted);
+	};
+
+	for (auto field : {FrameSource::FIELD_ODD, FrameSource::FIELD_EVEN}) {
+		CHECK(paint(field, -1) == all(true)); // first paint (of this field)
+		CHECK(paint(field, -1) == all(false)); // nothing changed
+		auto painted = paint(field, 100);
+		CHECK(painted != all(false));
+		CHECK(painted != all(true));
+		CHECK(paint(field, 100) == all(false));
+	}
+}
+
+#endif
@@ -5,6 +5,7 @@
 #include "FileOperations.hh"
 #include "one_of.hh"
 #include "StringOp.hh"
+#include "TestMachine.hh"
 #include "Timer.hh"
 #include <iostream>
 #include <fstream>
@@ -30,7 +31,7 @@ static std::vector<std::string> readLines(const std::string& filename)
 
 TEST_CASE("FilePoolCore")
 {
-	auto tmp = FileOperations::getTempDir() + "/filepool_unittest";
+	auto tmp = TestMachine::getDataDir() + "/filepool";
 	FileOperations::deleteRecursive(tmp);
 	FileOperations::mkdirp(tmp);
 	createFile(tmp + "/a",  "aaa"); // 7e240de74fb1ed08fa08d38063f6a6a91462a815
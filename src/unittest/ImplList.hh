@@ -0,0 +1,51 @@
+#ifndef IMPLLIST_HH
+#define IMPLLIST_HH
+
+#include "catch.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+
+namespace openmsx {
+
+/** Helpers for the tests and benchmarks of a class with several
+  * implementations of the same routine, e.g. YMF262Core or ResampleHQFilter.
+  * Such a class has an enum 'Impl', a static isSupported(Impl) and a static
+  * getBestImpl(). The first implementation in the list is the reference (the
+  * generic C++ version), the others must give the same result.
+  */
+template<typename T>
+struct NamedImpl {
+	typename T::Impl impl;
+	const char* name; // all of the same length, for the benchmark output
+};
+
+/** The reference must always be supported, and so must the implementation
+  * that's selected at runtime.
+  */
+template<typename T, size_t N>
+void checkImplList(const NamedImpl<T> (&impls)[N])
+{
+	CHECK(T::isSupported(impls[0].impl));
+	auto best = T::getBestImpl();
+	CHECK(T::isSupported(best));
+	CHECK(std::any_of(std::begin(impls), std::end(impls),
+	                  [&](const auto& i) { return i.impl == best; }));
+}
+
+/** Call 'f(namedImpl)' for each implementation in the list that's supported
+  * by this build and by the host CPU.
+  */
+template<typename T, size_t N, typename F>
+void forEachSupportedImpl(const NamedImpl<T> (&impls)[N], F f)
+{
+	for (const auto& i : impls) {
+		if (!T::isSupported(i.impl)) continue;
+		INFO("implementation " << i.name);
+		f(i);
+	}
+}
+
+} // namespace openmsx
+
+#endif
@@ -0,0 +1,152 @@
+#include "catch.hpp"
+#include "LineScalers.hh"
+#include "PixelFormat.hh"
+#include "ScalerAVX2.hh"
+#include "Scanline.hh"
+#include "xrange.hh"
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace openmsx;
+
+namespace {
+
+using Pixel = uint32_t;
+using LineFunc = std::function<void(const Pixel* in1, const Pixel* in2,
+                                    Pixel* out, size_t outWidth)>;
+
+const size_t widths[] = {256, 512, 640};
+
+PixelOperations<Pixel> getPixelOps()
+{
+	// PixelOperations only keeps a reference to the format
+	static const PixelFormat format(32,
+		0x00FF0000, 16, 0, 0x0000FF00, 8, 0,
+		0x000000FF,  0, 0, 0xFF000000, 24, 0);
+	return PixelOperations<Pixel>(format);
+}
+
+std::vector<Pixel> randomLine(size_t size, unsigned seed)
+{
+	std::minstd_rand rnd(seed);
+	std::vector<Pixel> result(size);
+	for (auto& p : result) p = Pixel(rnd());
+	return result;
+}
+
+// The input lines are big enough for the widest input (6x the output width).
+std::vector<Pixel> calc(const LineFunc& func, bool avx2, size_t width)
+{
+	ScalerAVX2::setEnabled(avx2);
+	auto in1 = randomLine(6 * width, 1234);
+	auto in2 = randomLine(6 * width, 5678);
+	std::vector<Pixel> out(width + 1, 0x12345678); // +1 to detect overrun
+	func(in1.data(), in2.data(), out.data(), width);
+	ScalerAVX2::setEnabled(true);
+	return out;
+}
+
+struct NamedFunc {
+	const char* name;
+	unsigned step; // the output width must be a multiple of this
+	LineFunc func;
+};
+
+std::vector<NamedFunc> getLineFuncs()
+{
+	auto pixelOps = getPixelOps();
+	auto scale = [](auto scaler) {
+		return [scaler](const Pixel* in, const Pixel*, Pixel* out, size_t width) mutable {
+			scaler(in, out, width);
+		};
+	};
+	auto blend = [](auto blender) {
+		return [blender](const Pixel* in1, const Pixel* in2, Pixel* out, size_t width) mutable {
+			blender(in1, in2, out, width);
+		};
+	};
+	return {
+		{"Scale_1on1  ", 1, scale(Scale_1on1<Pixel>())},
+		{"Scale_1on2  ", 2, scale(Scale_1on2<Pixel>())},
+		{"Scale_1on3  ", 3, scale(Scale_1on3<Pixel>())},
+		{"Scale_1on4  ", 4, scale(Scale_1on4<Pixel>())},
+		{"Scale_1on6  ", 6, scale(Scale_1on6<Pixel>())},
+		{"Scale_2on1  ", 1, scale(Scale_2on1<Pixel>(pixelOps))},
+		{"Scale_3on1  ", 1, scale(Scale_3on1<Pixel>(pixelOps))},
+		{"Scale_4on1  ", 1, scale(Scale_4on1<Pixel>(pixelOps))},
+		{"Scale_6on1  ", 1, scale(Scale_6on1<Pixel>(pixelOps))},
+		{"Scale_2on3  ", 3, scale(Scale_2on3<Pixel>(pixelOps))},
+		{"Scale_2on9  ", 9, scale(Scale_2on9<Pixel>(pixelOps))},
+		{"Scale_3on2  ", 2, scale(Scale_3on2<Pixel>(pixelOps))},
+		{"Scale_3on4  ", 4, scale(Scale_3on4<Pixel>(pixelOps))},
+		{"Scale_3on8  ", 8, scale(Scale_3on8<Pixel>(pixelOps))},
+		{"Scale_4on3  ", 3, scale(Scale_4on3<Pixel>(pixelOps))},
+		{"Scale_4on5  ", 5, scale(Scale_4on5<Pixel>(pixelOps))},
+		{"Scale_4on9  ", 9, scale(Scale_4on9<Pixel>(pixelOps))},
+		{"Scale_7on8  ", 8, scale(Scale_7on8<Pixel>(pixelOps))},
+		{"Scale_8on3  ", 3, scale(Scale_8on3<Pixel>(pixelOps))},
+		{"Scale_8on9  ", 9, scale(Scale_8on9<Pixel>(pixelOps))},
+		{"Scale_9on10 ", 10, scale(Scale_9on10<Pixel>(pixelOps))},
+		{"Scale_17on20", 20, scale(Scale_17on20<Pixel>(pixelOps))},
+		{"BlendLines  ", 1, blend(BlendLines<Pixel>(pixelOps))},
+		{"AlphaBlend  ", 1, blend(AlphaBlendLines<Pixel>(pixelOps))},
+		{"ZoomLine    ", 1, [zoom = ZoomLine<Pixel>(pixelOps)](
+				const Pixel* in, const Pixel*, Pixel* out, size_t width) {
+			zoom(in, unsigned(width * 2 / 3), out, unsigned(width));
+		}},
+		{"Scanline    ", 1, [scanline = std::make_shared<Scanline<Pixel>>(pixelOps)](
+				const Pixel* in1, const Pixel* in2, Pixel* out, size_t width) {
+			scanline->draw(in1, in2, out, 192, width);
+		}},
+	};
+}
+
+} // namespace
+
+TEST_CASE("LineScalers: AVX2 and SSE2 versions give the same result")
+{
+	if (!ScalerAVX2::isSupported()) return;
+	for (const auto& [name, step, func] : getLineFuncs()) {
+		INFO(name);
+		// also some widths that are not a multiple of the AVX2 block size
+		for (size_t width : {256, 512, 640, 112, 80, 48}) {
+			width -= width % step;
+			INFO(width);
+			CHECK(calc(func, true, width) == calc(func, false, width));
+		}
+	}
+}
+
+// Not run by default, run with:  unittest "[benchmark]"
+TEST_CASE("LineScalers: benchmark", "[.benchmark]")
+{
+	const char* const implNames[] = {"SSE2", "AVX2"};
+	auto in1 = randomLine(6 * 640, 1234);
+	auto in2 = randomLine(6 * 640, 5678);
+	std::vector<Pixel> out(640);
+	for (const auto& [name, step, func] : getLineFuncs()) {
+		for (size_t width : widths) {
+			width -= width % step;
+			for (auto avx2 : xrange(2)) {
+				if (avx2 && !ScalerAVX2::isSupported()) continue;
+				ScalerAVX2::setEnabled(avx2);
+				int repeat = 20000;
+				auto start = std::chrono::steady_clock::now();
+				for ([[maybe_unused]] auto r : xrange(repeat)) {
+					func(in1.data(), in2.data(), out.data(), width);
+				}
+				auto stop = std::chrono::steady_clock::now();
+				auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count();
+				std::cout << name << ' ' << width << " pixels, "
+				          << implNames[avx2] << ": "
+				          << double(ns) / repeat << " ns/line\n";
+			}
+		}
+	}
+	ScalerAVX2::setEnabled(true);
+}
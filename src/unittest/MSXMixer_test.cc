@@ -0,0 +1,102 @@
+#include "catch.hpp"
+#include "TestMachine.hh"
+#include "DeviceConfig.hh"
+#include "Filename.hh"
+#include "HardwareConfig.hh"
+#include "MSXMixer.hh"
+#include "MSXMotherBoard.hh"
+#include "ResampledSoundDevice.hh"
+#include "XMLElement.hh"
+
+using namespace openmsx;
+
+namespace {
+
+// A silent sound device that counts how often it has to generate sound.
+class CountingDevice final : public ResampledSoundDevice
+{
+public:
+	CountingDevice(MSXMotherBoard& motherBoard, const DeviceConfig& config)
+		: ResampledSoundDevice(motherBoard, "counter", "unittest", 1, 44100, false)
+	{
+		registerSound(config);
+	}
+
+	~CountingDevice()
+	{
+		unregisterSound();
+	}
+
+	unsigned count = 0;
+
+private:
+	void generateChannels(float** buffers, unsigned /*num*/) override
+	{
+		++count;
+		buffers[0] = nullptr;
+	}
+
+	[[nodiscard]] bool supportsStateOnly() const override { return true; }
+};
+
+} // namespace
+
+TEST_CASE("MSXMixer: state-only mode")
+{
+	TestMachine machine("");
+	auto& board = machine.getMotherBoard();
+	board.powerUp(); // a powered down machine is muted
+	auto& mixer = board.getMSXMixer();
+
+	XMLElement xml("counter");
+	xml.addChild("sound").addChild("volume", "10000");
+	DeviceConfig config(*board.getMachineConfig(), xml);
+	CountingDevice device(board, config);
+
+	EmuTime time = machine.getCurrentTime();
+	auto run = [&] {
+		device.count = 0;
+		time += EmuDuration::msec(100);
+		machine.runUntil(time);
+		return device.count;
+	};
+
+	// the null sound driver doesn't need any output
+	CHECK(run() == 0);
+
+	// pretend there is a real sound driver
+	mixer.setMixerParams(512, 44100);
+	CHECK(run() != 0);
+
+	// muted: no sound needed
+	mixer.mute();
+	CHECK(run() == 0);
+	mixer.unmute();
+	mixer.setMixerParams(512, 44100); // unmute() restored the null driver params
+	CHECK(run() != 0);
+}
+
+TEST_CASE("MSXMixer: channel recording")
+{
+	TestMachine machine("");
+	auto& board = machine.getMotherBoard();
+	auto& mixer = board.getMSXMixer();
+
+	XMLElement xml("counter");
+	xml.addChild("sound").addChild("volume", "10000");
+	DeviceConfig config(*board.getMachineConfig(), xml);
+	CountingDevice device(board, config);
+
+	// recording a channel needs synchronous mode
+	CHECK(!mixer.isSynchronousMode());
+	device.recordChannel(0, Filename(TestMachine::getDataDir() + "/channel.wav"));
+	CHECK(mixer.isSynchronousMode());
+
+	// when the new file can't be opened, the old recording continues
+	CHECK_THROWS(device.recordChannel(
+		0, Filename(TestMachine::getDataDir() + "/no/such/dir/channel.wav")));
+	CHECK(mixer.isSynchronousMode());
+
+	device.recordChannel(0, Filename());
+	CHECK(!mixer.isSynchronousMode());
+}
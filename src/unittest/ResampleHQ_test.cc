@@ -0,0 +1,123 @@
+#include "catch.hpp"
+#include "ImplList.hh"
+#include "ResampleHQ.hh"
+#include "xrange.hh"
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace openmsx;
+
+namespace {
+
+// Input sample rates of the resampled sound chips.
+struct Chip {
+	const char* name;
+	double rate;
+};
+const Chip chips[] = {
+	{"AY8910/SN76489", 3579545.0 / 16},
+	{"SCC",            3579545.0 / 32},
+	{"YM2151",         3579545.0 / 64},
+	{"YM2413/Y8950",   3579545.0 / 72},
+	{"YMF262",         4 * 3579545.0 / (8 * 36)},
+	{"YMF278-FM",      33868800.0 / (19 * 36)},
+	{"YMF278-wave",    44100.0},
+	{"VLM5030",        3579545.0 / 440},
+};
+const double hostRates[] = {22050.0, 44100.0, 48000.0};
+
+const NamedImpl<ResampleHQFilter> impls[] = {
+	{ResampleHQFilter::GENERIC, "generic"},
+	{ResampleHQFilter::SSE2,    "SSE2   "},
+	{ResampleHQFilter::AVX2,    "AVX2   "},
+};
+
+std::vector<float> randomInput(size_t size)
+{
+	std::minstd_rand rnd(1234);
+	std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+	std::vector<float> result(size);
+	for (auto& f : result) f = dist(rnd);
+	return result;
+}
+
+template<unsigned CHANNELS>
+std::vector<float> calc(const ResampleHQFilter& filter, ResampleHQFilter::Impl impl,
+                        const std::vector<float>& input, float pos, unsigned num)
+{
+	std::vector<float> output(num * CHANNELS);
+	filter.calcOutput<CHANNELS>(impl, input.data(), pos, output.data(), num);
+	return output;
+}
+
+template<unsigned CHANNELS>
+void testRatio(float ratio)
+{
+	ResampleHQFilter filter(ratio);
+	unsigned num = 1000;
+	float pos = 0.3f;
+	auto input = randomInput((size_t(pos + num * ratio) + filter.getFilterLen() + 1) * CHANNELS);
+	auto expected = calc<CHANNELS>(filter, ResampleHQFilter::GENERIC, input, pos, num);
+	forEachSupportedImpl(impls, [&](const auto& i) {
+		auto output = calc<CHANNELS>(filter, i.impl, input, pos, num);
+		// different summation order (and FMA) give small differences
+		for (auto j : xrange(expected.size())) {
+			CHECK(std::abs(output[j] - expected[j]) < 1e-5f);
+		}
+	});
+}
+
+} // namespace
+
+TEST_CASE("ResampleHQ: all implementations give the same result")
+{
+	checkImplList(impls);
+	for (const auto& chip : chips) {
+		for (double host : hostRates) {
+			float ratio = float(chip.rate / host);
+			testRatio<1>(ratio);
+			testRatio<2>(ratio);
+		}
+	}
+}
+
+namespace {
+
+template<unsigned CHANNELS>
+void benchmarkRatio(const char* name, double host, float ratio)
+{
+	ResampleHQFilter filter(ratio);
+	unsigned num = 4096;
+	auto input = randomInput((size_t(num * ratio) + filter.getFilterLen() + 1) * CHANNELS);
+	std::vector<float> output(num * CHANNELS);
+	forEachSupportedImpl(impls, [&](const auto& i) {
+		int repeat = 200;
+		auto start = std::chrono::steady_clock::now();
+		for ([[maybe_unused]] auto r : xrange(repeat)) {
+			filter.calcOutput<CHANNELS>(i.impl, input.data(), 0.0f, output.data(), num);
+		}
+		auto stop = std::chrono::steady_clock::now();
+		auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count();
+		std::cout << name << (CHANNELS == 1 ? " mono   " : " stereo ")
+		          << host << "Hz, " << filter.getFilterLen() << " taps, "
+		          << i.name << ": "
+		          << double(ns) / (double(repeat) * num) << " ns/sample\n";
+	});
+}
+
+} // namespace
+
+// Not run by default, run with:  unittest "[benchmark]"
+TEST_CASE("ResampleHQ: benchmark", "[.benchmark]")
+{
+	for (const auto& chip : chips) {
+		for (double host : hostRates) {
+			float ratio = float(chip.rate / host);
+			benchmarkRatio<1>(chip.name, host, ratio);
+			benchmarkRatio<2>(chip.name, host, ratio);
+		}
+	}
+}
@@ -0,0 +1,75 @@
+#include "catch.hpp"
+#include "SPSCRingBuffer.hh"
+#include "xrange.hh"
+#include <thread>
+#include <vector>
+
+using namespace openmsx;
+
+TEST_CASE("SPSCRingBuffer: single thread")
+{
+	SPSCRingBuffer<int> buf(5);
+	CHECK(buf.getCapacity() == 5);
+	CHECK(buf.size() == 0);
+	CHECK(buf.getFree() == 5);
+
+	int in[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+	int out[8] = {};
+	CHECK(buf.pop(out, 1) == 0); // empty
+
+	CHECK(buf.push(in, 3) == 3);
+	CHECK(buf.size() == 3);
+	CHECK(buf.pop(out, 2) == 2);
+	CHECK(out[0] == 1);
+	CHECK(out[1] == 2);
+
+	// wraps around, and only 4 elements fit
+	CHECK(buf.push(in + 3, 5) == 4);
+	CHECK(buf.size() == 5);
+	CHECK(buf.getFree() == 0);
+	CHECK(buf.push(in, 1) == 0); // full
+
+	CHECK(buf.pop(out, 8) == 5);
+	CHECK(out[0] == 3);
+	CHECK(out[1] == 4);
+	CHECK(out[2] == 5);
+	CHECK(out[3] == 6);
+	CHECK(out[4] == 7);
+	CHECK(buf.size() == 0);
+
+	buf.push(in, 2);
+	buf.clear();
+	CHECK(buf.size() == 0);
+	CHECK(buf.getFree() == 5);
+}
+
+TEST_CASE("SPSCRingBuffer: two threads")
+{
+	constexpr unsigned TOTAL = 1000000;
+	SPSCRingBuffer<unsigned> buf(97);
+
+	std::thread producer([&] {
+		unsigned chunk[13];
+		unsigned next = 0;
+		while (next < TOTAL) {
+			unsigned n = std::min<unsigned>(std::size(chunk), TOTAL - next);
+			for (auto i : xrange(n)) chunk[i] = next + i;
+			next += unsigned(buf.push(chunk, n));
+		}
+	});
+
+	// consumer
+	std::vector<unsigned> chunk(17);
+	unsigned expected = 0;
+	unsigned errors = 0;
+	while (expected < TOTAL) {
+		auto n = buf.pop(chunk.data(), chunk.size());
+		for (auto i : xrange(n)) {
+			if (chunk[i] != expected) ++errors;
+			++expected;
+		}
+	}
+	producer.join();
+	CHECK(errors == 0);
+	CHECK(buf.size() == 0);
+}
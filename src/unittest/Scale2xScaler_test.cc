@@ -0,0 +1,118 @@
+#include "catch.hpp"
+#include "Scale2xScaler.hh"
+#include "PixelFormat.hh"
+#include "PixelOperations.hh"
+#include "RawFrame.hh"
+#include "ScalerAVX2.hh"
+#include "ScalerOutput.hh"
+#include "build-info.hh"
+#include "xrange.hh"
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+using namespace openmsx;
+
+namespace {
+
+// Keeps the scaled image in memory.
+template<typename Pixel>
+class MemoryScalerOutput final : public ScalerOutput<Pixel>
+{
+public:
+	MemoryScalerOutput(unsigned width_, unsigned height_)
+		: width(width_), height(height_), pixels(size_t(width) * height) {}
+
+	[[nodiscard]] unsigned getWidth()  const override { return width; }
+	[[nodiscard]] unsigned getHeight() const override { return height; }
+
+	[[nodiscard]] Pixel* acquireLine(unsigned y) override {
+		return &pixels[size_t(y) * width];
+	}
+	void releaseLine(unsigned /*y*/, Pixel* /*buf*/) override {}
+	void fillLine(unsigned y, Pixel color) override {
+		std::fill_n(acquireLine(y), width, color);
+	}
+
+	[[nodiscard]] const std::vector<Pixel>& getPixels() const { return pixels; }
+
+private:
+	unsigned width;
+	unsigned height;
+	std::vector<Pixel> pixels;
+};
+
+// PixelOperations only keeps a reference to the format
+template<typename Pixel> const PixelFormat& getPixelFormat();
+template<> const PixelFormat& getPixelFormat<uint16_t>()
+{
+	static const PixelFormat format(16,
+		0xF800, 11, 3, 0x07E0, 5, 2,
+		0x001F,  0, 3, 0x0000, 0, 8);
+	return format;
+}
+template<> const PixelFormat& getPixelFormat<uint32_t>()
+{
+	static const PixelFormat format(32,
+		0x00FF0000, 16, 0, 0x0000FF00, 8, 0,
+		0x000000FF,  0, 0, 0xFF000000, 24, 0);
+	return format;
+}
+
+// Only a few different colors, so that (unlike with completely random
+// content) neighbouring pixels are often equal and all Scale2x rules are
+// exercised.
+template<typename Pixel>
+void fillFrame(RawFrame& frame, unsigned width)
+{
+	std::minstd_rand rnd(1234);
+	for (auto y : xrange(frame.getHeight())) {
+		auto* line = frame.getLinePtrDirect<Pixel>(y);
+		for (auto x : xrange(width)) line[x] = Pixel(0x1234567 * (rnd() % 4));
+		frame.setLineWidth(y, width);
+	}
+	frame.init(FrameSource::FIELD_NONINTERLACED);
+}
+
+template<typename Pixel>
+std::vector<Pixel> scale(RawFrame& frame, unsigned width, bool avx2)
+{
+	ScalerAVX2::setEnabled(avx2);
+	PixelOperations<Pixel> pixelOps(getPixelFormat<Pixel>());
+	Scale2xScaler<Pixel> scaler(pixelOps);
+	MemoryScalerOutput<Pixel> output(640, 480);
+	scaler.scaleImage(frame, nullptr, 0, 240, width, output, 0, 480);
+	ScalerAVX2::setEnabled(true);
+	return output.getPixels();
+}
+
+template<typename Pixel>
+void compare()
+{
+	for (unsigned width : {320, 640}) {
+		INFO(width);
+		RawFrame frame(getPixelFormat<Pixel>(), 640, 240);
+		fillFrame<Pixel>(frame, width);
+		auto fast = scale<Pixel>(frame, width, true);
+		auto slow = scale<Pixel>(frame, width, false);
+		REQUIRE(fast.size() == slow.size());
+		for (auto i : xrange(slow.size())) {
+			INFO("x=" << i % 640 << " y=" << i / 640);
+			REQUIRE(fast[i] == slow[i]);
+		}
+	}
+}
+
+} // namespace
+
+TEST_CASE("Scale2xScaler: AVX2 and SSE2 versions give the same result")
+{
+	if (!ScalerAVX2::isSupported()) return;
+#if HAVE_16BPP
+	SECTION("16bpp") { compare<uint16_t>(); }
+#endif
+#if HAVE_32BPP
+	SECTION("32bpp") { compare<uint32_t>(); }
+#endif
+}
@@ -0,0 +1,248 @@
+#include "catch.hpp"
+#include "SchedulerHeap.hh"
+#include "SchedulerQueue.hh"
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+using namespace openmsx;
+
+namespace {
+
+struct Item {
+	uint64_t time;
+	int id;
+};
+
+// position of each item (by id) in the heap
+std::vector<size_t> heapIndex;
+
+struct ItemTraits {
+	static bool less(const Item& x, const Item& y) { return x.time < y.time; }
+	static void setIndex(Item& item, size_t index) { heapIndex[item.id] = index; }
+};
+
+using Heap = SchedulerHeap<Item, ItemTraits>;
+using Queue = SchedulerQueue<Item>;
+
+void insert(Queue& queue, const Item& item)
+{
+	queue.insert(item,
+	             [](Item& i) { i.time = std::numeric_limits<uint64_t>::max(); },
+	             [](const Item& x, const Item& y) { return x.time < y.time; });
+}
+
+void insert(Heap& heap, const Item& item)
+{
+	heap.insert(item);
+}
+
+} // namespace
+
+TEST_CASE("SchedulerHeap: same order as SchedulerQueue")
+{
+	std::minstd_rand rnd(12345);
+	Queue queue;
+	Heap heap;
+	heapIndex.assign(1000, size_t(-1));
+	int nextId = 0;
+	for (int step = 0; step < 20000; ++step) {
+		auto r = rnd() % 10;
+		if ((r < 5) && (nextId < 1000)) {
+			// few distinct times -> many equivalent elements
+			Item item{rnd() % 50, nextId++};
+			insert(queue, item);
+			insert(heap, item);
+		} else if ((r < 8) && !queue.empty()) {
+			CHECK(heap.front().id == queue.front().id);
+			queue.remove_front();
+			heap.remove_front();
+		} else if ((r < 9) && !queue.empty()) {
+			// remove via the handle
+			int id = queue.begin()[rnd() % queue.size()].id;
+			CHECK(heap[heapIndex[id]].id == id);
+			heap.removeAt(heapIndex[id]);
+			queue.remove([&](const Item& i) { return i.id == id; });
+		} else if (!queue.empty()) {
+			// remove the first of (usually) several matches
+			int group = queue.begin()[rnd() % queue.size()].id % 8;
+			auto pred = [&](const Item& i) { return (i.id % 8) == group; };
+			CHECK(heap.remove(pred));
+			CHECK(queue.remove(pred));
+		}
+		REQUIRE(heap.size() == queue.size());
+		if (nextId == 1000) {
+			int limit = rnd() % 50;
+			auto pred = [&](const Item& i) { return i.time < uint64_t(limit); };
+			queue.remove_all(pred);
+			heap.remove_all(pred);
+			REQUIRE(heap.size() == queue.size());
+			// ids must be unique for 'heapIndex', start over
+			nextId = 0;
+			while (!queue.empty()) {
+				CHECK(heap.front().id == queue.front().id);
+				queue.remove_front();
+				heap.remove_front();
+			}
+			REQUIRE(heap.empty());
+		}
+	}
+}
+
+TEST_CASE("SchedulerHeap: remove the earliest match")
+{
+	// Device 1 has three pending sync points (the later ones inserted
+	// first), removing one of them must remove the earliest (like
+	// SchedulerQueue does).
+	heapIndex.assign(5, 0);
+	Queue queue;
+	Heap heap;
+	for (auto item : {Item{40, 1}, Item{10, 2}, Item{50, 1}, Item{20, 3},
+	                  Item{30, 1}, Item{60, 4}}) {
+		insert(queue, item);
+		insert(heap, item);
+	}
+	auto isDevice1 = [](const Item& i) { return i.id == 1; };
+	CHECK(queue.remove(isDevice1));
+	CHECK(heap.remove(isDevice1));
+	CHECK(heap.remove(isDevice1));
+	CHECK(queue.remove(isDevice1));
+
+	for (uint64_t time : {10, 20, 50, 60}) {
+		REQUIRE(!heap.empty());
+		CHECK(heap.front().time == time);
+		CHECK(queue.front().time == time);
+		heap.remove_front();
+		queue.remove_front();
+	}
+	CHECK(heap.empty());
+	CHECK(!heap.remove(isDevice1));
+}
+
+// A sync point trace, similar to what a machine with many active timers
+// produces (VDP, PSG, FDCs, MoonSound, MIDI, RTC, ...). Each device has at
+// most one pending sync point (the typical case). When its sync point is
+// reached, a device schedules its next one. In between, devices also cancel
+// and reschedule their sync point (e.g. because of an I/O access).
+// Note: this trace is synthetic, the mix of operations and the periods are
+// guesses and were not recorded from real machines. So the benchmark only
+// compares both data structures, it doesn't predict the speedup for a
+// particular machine (use the scheduler statistics, see SchedulerStats.hh,
+// to check how many sync points a machine really uses).
+namespace {
+
+enum class OpType { EXECUTE, RESCHEDULE, PENDING };
+struct Op {
+	OpType type;
+	int device;
+	uint64_t delta;
+};
+
+std::vector<Op> generateTrace(int numDevices, int numOps)
+{
+	std::minstd_rand rnd(42);
+	std::vector<Op> trace;
+	for (int i = 0; i < numOps; ++i) {
+		auto r = rnd() % 8;
+		int device = rnd() % numDevices;
+		if (r < 4) {
+			trace.push_back({OpType::EXECUTE, -1, 0});
+		} else if (r < 6) {
+			trace.push_back({OpType::RESCHEDULE, device, 1 + rnd() % 300000});
+		} else {
+			trace.push_back({OpType::PENDING, device, 0});
+		}
+	}
+	return trace;
+}
+
+template<typename Q> struct Replay
+{
+	Q queue;
+	std::vector<uint64_t> periods;
+	uint64_t now = 0;
+	uint64_t checksum = 0;
+
+	explicit Replay(int numDevices)
+	{
+		std::minstd_rand rnd(7);
+		for (int i = 0; i < numDevices; ++i) {
+			periods.push_back(1000 + rnd() % 300000);
+			insert(queue, Item{periods[i], i});
+		}
+	}
+
+	void remove(int device)
+	{
+		if constexpr (std::is_same_v<Q, Heap>) {
+			queue.removeAt(heapIndex[device]);
+		} else {
+			queue.remove([&](const Item& i) { return i.id == device; });
+		}
+	}
+	uint64_t lookup(int device) const
+	{
+		if constexpr (std::is_same_v<Q, Heap>) {
+			return queue[heapIndex[device]].time;
+		} else {
+			for (const auto& i : queue) {
+				if (i.id == device) return i.time;
+			}
+			return 0;
+		}
+	}
+
+	void run(const std::vector<Op>& trace)
+	{
+		for (const auto& op : trace) {
+			switch (op.type) {
+			case OpType::EXECUTE: {
+				Item item = queue.front();
+				queue.remove_front();
+				now = item.time;
+				checksum = checksum * 31 + item.id;
+				insert(queue, Item{now + periods[item.id], item.id});
+				break;
+			}
+			case OpType::RESCHEDULE:
+				remove(op.device);
+				insert(queue, Item{now + op.delta, op.device});
+				break;
+			case OpType::PENDING:
+				checksum += lookup(op.device);
+				break;
+			}
+		}
+	}
+};
+
+template<typename Q> uint64_t benchmark(const char* name, int numDevices,
+                                        const std::vector<Op>& trace)
+{
+	heapIndex.assign(numDevices, 0);
+	Replay<Q> replay(numDevices);
+	auto start = std::chrono::steady_clock::now();
+	replay.run(trace);
+	auto stop = std::chrono::steady_clock::now();
+	auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count();
+	std::cout << name << ' ' << numDevices << " sync points: "
+	          << double(ns) / trace.size() << " ns/operation\n";
+	return replay.checksum;
+}
+
+} // namespace
+
+// Not run by default, run with:  unittest "[benchmark]"
+TEST_CASE("SchedulerHeap: benchmark", "[.benchmark]")
+{
+	for (int numDevices : {8, 30, 60, 200}) {
+		auto trace = generateTrace(numDevices, 2000000);
+		auto q = benchmark<Queue>("SchedulerQueue", numDevices, trace);
+		auto h = benchmark<Heap >("SchedulerHeap ", numDevices, trace);
+		CHECK(q == h);
+	}
+}
@@ -0,0 +1,169 @@
+#include "catch.hpp"
+#include "TestMachine.hh"
+#include "MSXMotherBoard.hh"
+#include "Schedulable.hh"
+#include "Scheduler.hh"
+#include "xrange.hh"
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+
+// Checks the Scheduler (with the backend that's selected at compile time,
+// see USE_SCHEDULER_HEAP in Scheduler.hh) against a simple reference model.
+
+using namespace openmsx;
+
+namespace {
+
+struct Executed {
+	unsigned device;
+	EmuTime time;
+	bool operator==(const Executed& other) const {
+		return (device == other.device) && (time == other.time);
+	}
+};
+
+// Records when it gets executed. The even devices immediately set a new sync
+// point from within executeUntil(), like periodic timers.
+class TestDevice final : public Schedulable
+{
+public:
+	TestDevice(Scheduler& scheduler_, unsigned id_, std::vector<Executed>& log_)
+		: Schedulable(scheduler_), id(id_), log(log_) {}
+
+	void executeUntil(EmuTime::param time) override {
+		log.push_back({id, time});
+		if (isPeriodic(id)) setSyncPoint(time + period(id));
+	}
+
+	[[nodiscard]] static bool isPeriodic(unsigned id) { return (id % 2) == 0; }
+	[[nodiscard]] static EmuDuration period(unsigned id) { return EmuDuration(uint64_t(100 + 10 * id)); }
+
+	using Schedulable::setSyncPoint;
+	using Schedulable::removeSyncPoint;
+	using Schedulable::removeSyncPoints;
+	using Schedulable::pendingSyncPoint;
+
+private:
+	unsigned id;
+	std::vector<Executed>& log;
+};
+
+// The pending sync points, sorted on time and then on insertion order.
+class Model
+{
+public:
+	void set(unsigned device, EmuTime::param time) {
+		entries.push_back({time, counter++, device});
+	}
+	bool remove(unsigned device) {
+		auto it = findFirst(device);
+		if (it == entries.end()) return false;
+		entries.erase(it);
+		return true;
+	}
+	void removeAll(unsigned device) {
+		entries.erase(std::remove_if(entries.begin(), entries.end(),
+		                             [&](const auto& e) { return e.device == device; }),
+		              entries.end());
+	}
+	bool pending(unsigned device, EmuTime& time) const {
+		auto it = findFirst(device);
+		if (it == entries.end()) return false;
+		time = it->time;
+		return true;
+	}
+	void runUntil(EmuTime::param limit, std::vector<Executed>& log) {
+		while (true) {
+			auto it = std::min_element(entries.begin(), entries.end(), less);
+			if ((it == entries.end()) || (it->time > limit)) break;
+			auto e = *it;
+			entries.erase(it);
+			log.push_back({e.device, e.time});
+			if (TestDevice::isPeriodic(e.device)) {
+				set(e.device, e.time + TestDevice::period(e.device));
+			}
+		}
+	}
+
+private:
+	struct Entry {
+		EmuTime time;
+		uint64_t order;
+		unsigned device;
+	};
+	static bool less(const Entry& x, const Entry& y) {
+		return (x.time != y.time) ? (x.time < y.time) : (x.order < y.order);
+	}
+	[[nodiscard]] std::vector<Entry>::const_iterator findFirst(unsigned device) const {
+		auto result = entries.end();
+		for (auto it = entries.begin(); it != entries.end(); ++it) {
+			if ((it->device == device) && ((result == entries.end()) || less(*it, *result))) {
+				result = it;
+			}
+		}
+		return result;
+	}
+
+	std::vector<Entry> entries;
+	uint64_t counter = 0;
+};
+
+} // namespace
+
+TEST_CASE("Scheduler: same behaviour as the reference model")
+{
+	TestMachine machine("");
+	auto& scheduler = machine.getMotherBoard().getScheduler();
+
+	std::vector<Executed> log, expectedLog;
+	std::vector<std::unique_ptr<TestDevice>> devices;
+	for (auto id : xrange(8)) {
+		devices.push_back(std::make_unique<TestDevice>(scheduler, id, log));
+	}
+	Model model;
+
+	std::minstd_rand rnd(1234);
+	auto random = [&](unsigned n) { return unsigned(rnd() % n); };
+	EmuTime now = machine.getCurrentTime();
+	for ([[maybe_unused]] auto i : xrange(20000)) {
+		unsigned id = random(8);
+		auto& device = *devices[id];
+		switch (random(8)) {
+		case 0: case 1: case 2: {
+			// also sync points at the same time (e.g. 'now')
+			auto delta = random(2) ? random(4) : random(1000);
+			EmuTime time = now + EmuDuration(uint64_t(delta));
+			device.setSyncPoint(time);
+			model.set(id, time);
+			break;
+		}
+		case 3:
+			CHECK(device.removeSyncPoint() == model.remove(id));
+			break;
+		case 4:
+			device.removeSyncPoints();
+			model.removeAll(id);
+			break;
+		case 5: {
+			EmuTime time1 = EmuTime::zero();
+			EmuTime time2 = EmuTime::zero();
+			bool pending = device.pendingSyncPoint(time1);
+			REQUIRE(pending == model.pending(id, time2));
+			if (pending) CHECK(time1 == time2);
+			break;
+		}
+		default: {
+			now += EmuDuration(uint64_t(random(300)));
+			machine.runUntil(now);
+			model.runUntil(now, expectedLog);
+			REQUIRE(log.size() == expectedLog.size());
+			CHECK(log == expectedLog);
+			break;
+		}
+		}
+	}
+	CHECK(!log.empty());
+}
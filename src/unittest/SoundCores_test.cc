@@ -0,0 +1,468 @@
+#include "catch.hpp"
+#include "SoundLog.hh"
+#include "TestMachine.hh"
+#include "AY8910.hh"
+#include "AY8910Periphery.hh"
+#include "SCC.hh"
+#include "YM2151.hh"
+#include "YM2413Burczynski.hh"
+#include "YM2413NukeYKT.hh"
+#include "YM2413Okazaki.hh"
+#include "YM2413OriginalNukeYKT.hh"
+#include "YMF262.hh"
+#include "YMF278.hh"
+#include "DeviceConfig.hh"
+#include "HardwareConfig.hh"
+#include "MSXDevice.hh"
+#include "MSXException.hh"
+#include "MSXMixer.hh"
+#include "MSXMotherBoard.hh"
+#include "StringOp.hh"
+#include "XMLElement.hh"
+#include "unreachable.hh"
+#include "xrange.hh"
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <random>
+#include <vector>
+
+// Replays register write logs into all (stand-alone) sound chip cores. For
+// each core this measures the speed and calculates a checksum of the output.
+// The checksums of a few random logs are compared against known values to
+// catch (unintended) changes in the output. When a change in the output is
+// intended, update the values in the 'expected' table below: a failing check
+// prints the new value (e.g. "YM2151, seed 2: 0123456789abcdef").
+//
+// The other sound devices (AY8910, SCC, Y8950, YM2151, YMF278) are tied to a
+// MSXMotherBoard, they're instantiated in a minimal TestMachine.
+
+using namespace openmsx;
+
+namespace {
+
+// Common interface to write registers and generate sound.
+class Chip
+{
+public:
+	virtual ~Chip() = default;
+	virtual void writeReg(unsigned reg, uint8_t value) = 0;
+	virtual void generateChannels(float** bufs, unsigned num) = 0;
+};
+
+class YM2413Chip final : public Chip
+{
+public:
+	explicit YM2413Chip(std::unique_ptr<YM2413Core> core_)
+		: core(std::move(core_)) {}
+
+	void writeReg(unsigned reg, uint8_t value) override {
+		// Data must be written at least 12 cycles after the address
+		// (that's 3 steps in the 18-step timescale of writePort()).
+		core->writePort(false, uint8_t(reg), 0);
+		core->writePort(true, value, 3);
+	}
+	void generateChannels(float** bufs, unsigned num) override {
+		core->generateChannels(bufs, num);
+	}
+
+private:
+	std::unique_ptr<YM2413Core> core;
+};
+
+class YMF262Chip final : public Chip
+{
+public:
+	explicit YMF262Chip(YMF262Core::Impl impl) { core.setImpl(impl); }
+
+	void writeReg(unsigned reg, uint8_t value) override {
+		core.writeReg(reg, value);
+	}
+	void generateChannels(float** bufs, unsigned num) override {
+		core.generateChannels(bufs, num);
+	}
+
+private:
+	YMF262Core core;
+};
+
+// For the sound devices in a TestMachine only the mix of all channels is
+// accessible. That's generated in the first buffer (mono or stereo).
+class DeviceChip : public Chip
+{
+public:
+	void generateChannels(float** bufs, unsigned num) override {
+		if (!device->generateInput(bufs[0], num)) {
+			// silent, the content of the buffer is unspecified
+			std::fill(bufs[0], bufs[0] + (device->isStereo() ? 2 : 1) * num, 0.0f);
+		}
+	}
+
+protected:
+	explicit DeviceChip(std::string_view devicesXml = {})
+		: machine(devicesXml) {}
+
+	// For a device that's directly instantiated (not via the machine config).
+	// The XMLElement must outlive the device.
+	DeviceConfig createConfig(XMLElement& xml) {
+		xml.addChild("sound").addChild("volume", "10000");
+		return {*machine.getMotherBoard().getMachineConfig(), xml};
+	}
+	EmuTime::param getTime() { return machine.getCurrentTime(); }
+
+	TestMachine machine;
+	ResampledSoundDevice* device = nullptr;
+};
+
+class AY8910Chip final : public DeviceChip, private AY8910Periphery
+{
+public:
+	AY8910Chip()
+		: xml("PSG")
+		, ay8910("PSG", *this, createConfig(xml), getTime())
+	{
+		device = &ay8910;
+	}
+
+	void writeReg(unsigned reg, uint8_t value) override {
+		ay8910.writeRegister(reg, value, getTime());
+	}
+
+private:
+	XMLElement xml;
+	AY8910 ay8910;
+};
+
+class SCCChip final : public DeviceChip
+{
+public:
+	SCCChip()
+		: xml("SCC")
+		, scc("SCC", createConfig(xml), getTime(), SCC::SCC_Real)
+	{
+		device = &scc;
+	}
+
+	void writeReg(unsigned reg, uint8_t value) override {
+		scc.writeMem(uint8_t(reg), value, getTime());
+	}
+
+private:
+	XMLElement xml;
+	SCC scc;
+};
+
+// The Y8950 can only be instantiated as part of a MSX-AUDIO device, so the
+// registers are written via its I/O ports.
+class Y8950Chip final : public DeviceChip
+{
+public:
+	Y8950Chip()
+		: DeviceChip("<MSX-AUDIO id=\"MSX-AUDIO\">"
+		             "<io base=\"0xC0\" num=\"2\"/>"
+		             "<sound><volume>10000</volume></sound>"
+		             "</MSX-AUDIO>")
+		, audio(*machine.getMotherBoard().findDevice("MSX-AUDIO"))
+	{
+		// (ResampledSoundDevice is a private base of Y8950, but a public
+		// base of SoundDevice)
+		auto& mixer = machine.getMotherBoard().getMSXMixer();
+		device = static_cast<ResampledSoundDevice*>(mixer.findDevice("MSX-AUDIO"));
+	}
+
+	void writeReg(unsigned reg, uint8_t value) override {
+		audio.writeIO(0xC0, uint8_t(reg), getTime());
+		audio.writeIO(0xC1, value, getTime());
+	}
+
+private:
+	MSXDevice& audio;
+};
+
+class YM2151Chip final : public DeviceChip
+{
+public:
+	YM2151Chip()
+		: xml("YM2151")
+		, ym2151("YM2151", "YM2151", createConfig(xml), getTime())
+	{
+		device = &ym2151;
+	}
+
+	void writeReg(unsigned reg, uint8_t value) override {
+		ym2151.writeReg(uint8_t(reg), value, getTime());
+	}
+
+private:
+	XMLElement xml;
+	YM2151 ym2151;
+};
+
+// Only the wave part, without sample RAM. The wave data comes from a random
+// ROM image.
+class YMF278Chip final : public DeviceChip
+{
+public:
+	YMF278Chip()
+		: xml("MoonSound")
+	{
+		std::string romFile = TestMachine::getDataDir() + "/yrw801.rom";
+		{
+			std::minstd_rand rnd(5678);
+			std::vector<char> rom(0x200000);
+			for (auto& b : rom) b = char(rnd());
+			std::ofstream file(romFile, std::ios::binary);
+			file.write(rom.data(), rom.size());
+		}
+		xml.addChild("rom").addChild("filename", romFile);
+		ymf278.emplace("MoonSound", 0, createConfig(xml));
+		device = &*ymf278;
+	}
+
+	void writeReg(unsigned reg, uint8_t value) override {
+		ymf278->writeReg(uint8_t(reg), value, getTime());
+	}
+
+private:
+	XMLElement xml;
+	std::optional<YMF278> ymf278;
+};
+
+struct CoreInfo {
+	const char* name;
+	VgmChip type;
+	unsigned numChannels;
+	unsigned samplesPerChannel; // 1 for mono, 2 for stereo
+	double sampleRate;
+	bool supported;
+	std::unique_ptr<Chip> (*create)();
+};
+
+constexpr double YM2413_RATE = 3579545.0 / 72;
+constexpr double YMF262_RATE = 4 * 3579545.0 / (8 * 36);
+constexpr double AY8910_RATE = 3579545.0 / 16;
+constexpr double SCC_RATE    = 3579545.0 / 32;
+constexpr double Y8950_RATE  = 3579545.0 / 72;
+constexpr double YM2151_RATE = 3579545.0 / 64;
+constexpr double YMF278_RATE = 44100.0;
+
+const CoreInfo cores[] = {
+	{"YM2413 Okazaki", VgmChip::YM2413, 9 + 5, 1, YM2413_RATE, true, [] {
+		return std::unique_ptr<Chip>(std::make_unique<YM2413Chip>(
+			std::make_unique<YM2413Okazaki::YM2413>())); }},
+	{"YM2413 Burczynski", VgmChip::YM2413, 9 + 5, 1, YM2413_RATE, true, [] {
+		return std::unique_ptr<Chip>(std::make_unique<YM2413Chip>(
+			std::make_unique<YM2413Burczynski::YM2413>())); }},
+	{"YM2413 NukeYKT", VgmChip::YM2413, 9 + 5, 1, YM2413_RATE, true, [] {
+		return std::unique_ptr<Chip>(std::make_unique<YM2413Chip>(
+			std::make_unique<YM2413NukeYKT::YM2413>())); }},
+	{"YM2413 Original-NukeYKT", VgmChip::YM2413, 9 + 5, 1, YM2413_RATE, true, [] {
+		return std::unique_ptr<Chip>(std::make_unique<YM2413Chip>(
+			std::make_unique<YM2413OriginalNukeYKT::YM2413>())); }},
+	{"YMF262 generic", VgmChip::YMF262, 18, 2, YMF262_RATE, true, [] {
+		return std::unique_ptr<Chip>(std::make_unique<YMF262Chip>(YMF262Core::GENERIC)); }},
+	{"YMF262 AVX2", VgmChip::YMF262, 18, 2, YMF262_RATE,
+	 YMF262Core::isSupported(YMF262Core::AVX2), [] {
+		return std::unique_ptr<Chip>(std::make_unique<YMF262Chip>(YMF262Core::AVX2)); }},
+	// (only the mix of all channels)
+	{"AY8910", VgmChip::AY8910, 1, 1, AY8910_RATE, true, [] {
+		return std::unique_ptr<Chip>(std::make_unique<AY8910Chip>()); }},
+	{"SCC", VgmChip::SCC, 1, 1, SCC_RATE, true, [] {
+		return std::unique_ptr<Chip>(std::make_unique<SCCChip>()); }},
+	{"Y8950", VgmChip::Y8950, 1, 1, Y8950_RATE, true, [] {
+		return std::unique_ptr<Chip>(std::make_unique<Y8950Chip>()); }},
+	{"YM2151", VgmChip::YM2151, 1, 2, YM2151_RATE, true, [] {
+		return std::unique_ptr<Chip>(std::make_unique<YM2151Chip>()); }},
+	{"YMF278", VgmChip::YMF278, 1, 2, YMF278_RATE, true, [] {
+		return std::unique_ptr<Chip>(std::make_unique<YMF278Chip>()); }},
+};
+
+struct Result {
+	uint64_t checksum = 0xcbf29ce484222325; // FNV-1a offset basis
+	uint64_t samples = 0;
+	std::chrono::steady_clock::duration time{}; // spent in generateChannels()
+};
+
+Result replay(const CoreInfo& info, const SoundLog& log)
+{
+	auto chip = info.create();
+
+	unsigned maxSamples = 0;
+	for (const auto& w : log) maxSamples = std::max(maxSamples, w.samples);
+	unsigned chanSize = info.samplesPerChannel * maxSamples;
+	std::vector<float> buffer(info.numChannels * chanSize);
+	std::vector<float*> bufs(info.numChannels);
+
+	Result result;
+	for (const auto& w : log) {
+		chip->writeReg(w.reg, w.value);
+		if (w.samples == 0) continue;
+
+		// (muted channels are left at zero)
+		std::fill(buffer.begin(), buffer.end(), 0.0f);
+		for (auto i : xrange(info.numChannels)) bufs[i] = &buffer[i * chanSize];
+		auto start = std::chrono::steady_clock::now();
+		chip->generateChannels(bufs.data(), w.samples);
+		result.time += std::chrono::steady_clock::now() - start;
+		result.samples += w.samples;
+
+		unsigned size = info.samplesPerChannel * w.samples;
+		for (auto i : xrange(info.numChannels)) {
+			for (auto s : xrange(size)) {
+				uint32_t bits;
+				memcpy(&bits, &buffer[i * chanSize + s], sizeof(bits));
+				result.checksum = (result.checksum ^ bits) * 0x100000001b3; // FNV-1a prime
+			}
+		}
+	}
+	return result;
+}
+
+SoundLog randomLog(VgmChip type, unsigned seed, unsigned numEvents)
+{
+	switch (type) {
+	case VgmChip::YM2413: return randomYM2413Log(seed, numEvents);
+	case VgmChip::YMF262: return randomYMF262Log(seed, numEvents, seed != 1);
+	case VgmChip::AY8910: return randomAY8910Log(seed, numEvents);
+	case VgmChip::SCC:    return randomSCCLog   (seed, numEvents);
+	case VgmChip::Y8950:  return randomY8950Log (seed, numEvents);
+	case VgmChip::YM2151: return randomYM2151Log(seed, numEvents);
+	case VgmChip::YMF278: return randomYMF278Log(seed, numEvents);
+	}
+	UNREACHABLE;
+}
+
+void report(const char* logName, const CoreInfo& info, const Result& result)
+{
+	auto sec = std::chrono::duration<double>(result.time).count();
+	auto samplesPerSec = double(result.samples) / sec;
+	std::cout << logName << ' ' << info.name << ": "
+	          << samplesPerSec << " samples/s ("
+	          << samplesPerSec / info.sampleRate << "x realtime), checksum "
+	          << strCat(hex_string<16>(result.checksum)) << '\n';
+}
+
+} // namespace
+
+TEST_CASE("SoundCores: output checksums")
+{
+	// For each entry in 'cores', for random logs with seed 1, 2 and 3
+	static constexpr uint64_t expected[][3] = {
+		{0xf700d50af1ee3fd5, 0x4098afb007dd1c45, 0xc6fcb4229bebb61d}, // YM2413 Okazaki
+		{0x897feb41d13cffd5, 0x93b51036339afc45, 0xc11b570bb5c1961d}, // YM2413 Burczynski
+		{0x7f1d6e2893a93fd5, 0xf24a2d4a8d181c45, 0x2bdb906d400cb61d}, // YM2413 NukeYKT
+		{0xb6c5513f69083fd5, 0x8f0e2974f62d1c45, 0x685b4a1383b1b61d}, // YM2413 Original-NukeYKT
+		// YMF262, all implementations must give the same result
+		// (seed 1 is in OPL2 mode)
+		{0x722bb33859eb0335, 0xf157ad48395001f5, 0xd08c166447b26cf5}, // YMF262 generic
+		{0x722bb33859eb0335, 0xf157ad48395001f5, 0xd08c166447b26cf5}, // YMF262 AVX2
+		{0x54f27494ebffd42c, 0x86dca35582b0337d, 0x25ef9c15bbb51a78}, // AY8910
+		{0xb67a483d47408b7d, 0x76e9c7acbe2e08b7, 0x56fcb0135b5a868f}, // SCC
+		{0xc441d4ea3afeaaaf, 0x65f08d0024d91dd7, 0x71dddc0bf741ab47}, // Y8950
+		{0xd0ba887551ae6835, 0xb87c68084c576fe5, 0x9f980baed430f985}, // YM2151
+		{0xdde14236ec48438d, 0x6598b951e27e2a35, 0x8d48a0f461921b9d}, // YMF278
+	};
+	static_assert(std::size(expected) == std::size(cores));
+
+	for (auto c : xrange(std::size(cores))) {
+		const auto& info = cores[c];
+		if (!info.supported) continue;
+		for (auto i : xrange(3)) {
+			unsigned seed = i + 1;
+			auto result = replay(info, randomLog(info.type, seed, 300));
+			INFO(info.name << ", seed " << seed << ": " << strCat(hex_string<16>(result.checksum)));
+			CHECK(result.checksum == expected[c][i]);
+		}
+	}
+}
+
+TEST_CASE("SoundCores: parse VGM")
+{
+	static constexpr uint8_t vgm[] = {
+		// header: "Vgm ", version 1.51, data at 0x40
+		'V', 'g', 'm', ' ', 0x00, 0x00, 0x00, 0x00, 0x51, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		0x00, 0x00, 0x00, 0x00, 0x0C, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		0x70,             // wait 1 (before the first write, dropped)
+		0x51, 0x30, 0x12, // YM2413 write
+		0x62,             // wait 735
+		0xA0, 0x07, 0x38, // AY8910 write
+		0x5E, 0x20, 0x01, // YMF262 port 0 write
+		0x61, 0x10, 0x00, // wait 16
+		0x67, 0x66, 0x00, 0x02, 0x00, 0x00, 0x00, 0xAA, 0xBB, // data block
+		0x5F, 0x05, 0x01, // YMF262 port 1 write
+		0x51, 0x0E, 0x20, // YM2413 write
+		0x63,             // wait 882
+		0x66,             // end
+		0x51, 0x00, 0x00, // (after the end)
+	};
+	auto ym2413 = parseVGM(vgm, VgmChip::YM2413, 44100.0);
+	REQUIRE(ym2413.size() == 2);
+	CHECK(ym2413[0].reg == 0x30);
+	CHECK(ym2413[0].value == 0x12);
+	CHECK(ym2413[0].samples == 735 + 16);
+	CHECK(ym2413[1].reg == 0x0E);
+	CHECK(ym2413[1].value == 0x20);
+	CHECK(ym2413[1].samples == 882);
+
+	auto ymf262 = parseVGM(vgm, VgmChip::YMF262, 2 * 44100.0);
+	REQUIRE(ymf262.size() == 2);
+	CHECK(ymf262[0].reg == 0x020);
+	CHECK(ymf262[0].samples == 2 * 16);
+	CHECK(ymf262[1].reg == 0x105);
+	CHECK(ymf262[1].value == 0x01);
+	CHECK(ymf262[1].samples == 2 * 882);
+
+	auto ay8910 = parseVGM(vgm, VgmChip::AY8910, AY8910_RATE);
+	REQUIRE(ay8910.size() == 1);
+	CHECK(ay8910[0].reg == 0x07);
+	CHECK(ay8910[0].value == 0x38);
+
+	CHECK(parseVGM(vgm, VgmChip::SCC, SCC_RATE).empty());
+
+	CHECK_THROWS_AS(parseVGM(span<const uint8_t>(vgm, 0x20), VgmChip::YM2413, 44100.0),
+	                MSXException);
+	CHECK_THROWS_AS(parseVGM(span<const uint8_t>(vgm, 0x48), VgmChip::YM2413, 44100.0),
+	                MSXException);
+}
+
+// Not run by default, run with:  unittest "[benchmark]"
+// Besides random logs, this also replays the VGM files listed (separated by
+// ':') in the environment variable OPENMSX_BENCHMARK_VGM.
+TEST_CASE("SoundCores: benchmark", "[.benchmark]")
+{
+	for (auto type : {VgmChip::YM2413, VgmChip::YMF262, VgmChip::AY8910, VgmChip::SCC,
+	                  VgmChip::Y8950, VgmChip::YM2151, VgmChip::YMF278}) {
+		auto log = randomLog(type, 1234, 10000);
+		for (const auto& info : cores) {
+			if (!info.supported || (info.type != type)) continue;
+			report("random", info, replay(info, log));
+		}
+	}
+
+	const char* files = getenv("OPENMSX_BENCHMARK_VGM");
+	if (!files) return;
+	for (auto filename : StringOp::split(files, ':')) {
+		std::string name(filename);
+		std::ifstream file(name, std::ios::binary);
+		std::vector<uint8_t> vgm((std::istreambuf_iterator<char>(file)),
+		                         std::istreambuf_iterator<char>());
+		try {
+			for (const auto& info : cores) {
+				if (!info.supported) continue;
+				auto log = parseVGM(vgm, info.type, info.sampleRate);
+				if (log.empty()) continue; // chip not used in this file
+				report(name.c_str(), info, replay(info, log));
+			}
+		} catch (MSXException& e) {
+			std::cout << name << ": " << e.getMessage() << '\n';
+		}
+	}
+}
@@ -0,0 +1,633 @@
+#include "SoundLog.hh"
+#include "MSXException.hh"
+#include "one_of.hh"
+#include "xrange.hh"
+#include <random>
+
+namespace openmsx {
+
+static unsigned read32(span<const uint8_t> data, size_t pos)
+{
+	return data[pos + 0] <<  0 | data[pos + 1] <<  8 |
+	       data[pos + 2] << 16 | data[pos + 3] << 24;
+}
+
+namespace {
+
+// Helper to produce the random logs. Note: the random() calls are never
+// combined in a single expression, the (unspecified) evaluation order would
+// make the result compiler dependent.
+class LogGenerator
+{
+public:
+	explicit LogGenerator(unsigned seed) : rnd(seed) {}
+
+	unsigned random(unsigned n) { return unsigned(rnd() % n); }
+
+	void write(unsigned reg, unsigned value) {
+		log.push_back({uint16_t(reg), uint8_t(value), 0});
+	}
+	void wait(unsigned samples) {
+		log.back().samples = samples;
+	}
+	// make sure the last write is followed by some samples
+	void endEvent() {
+		if (log.back().samples == 0) wait(random(200));
+	}
+
+	SoundLog log;
+
+private:
+	std::minstd_rand rnd;
+};
+
+} // namespace
+
+SoundLog randomYM2413Log(unsigned seed, unsigned numEvents)
+{
+	LogGenerator g(seed);
+	auto programInstrument = [&] {
+		for (auto reg : xrange(8)) {
+			auto value = g.random(256);
+			if (reg == one_of(4, 5)) value |= 0x80; // AR (not 0)
+			g.write(reg, value);
+		}
+	};
+	auto programChannel = [&](unsigned ch) {
+		g.write(0x30 + ch, g.random(256));
+	};
+
+	programInstrument();
+	g.write(0x0E, 0);
+	for (auto ch : xrange(9)) programChannel(ch);
+
+	for ([[maybe_unused]] auto e : xrange(numEvents)) {
+		unsigned ch = g.random(9);
+		switch (g.random(10)) {
+		case 0: case 1: case 2: case 3: case 4: {
+			// note on (possibly retrigger) or off
+			unsigned block_fnum = g.random(0x1000);
+			g.write(0x10 + ch, block_fnum & 0xFF);
+			unsigned keyOn = (g.random(4) != 0) ? 0x10 : 0x00;
+			unsigned sustain = 0x20 * g.random(2);
+			g.write(0x20 + ch, (block_fnum >> 8) | keyOn | sustain);
+			g.wait(g.random(1000));
+			break;
+		}
+		case 5:
+			programChannel(ch);
+			break;
+		case 6:
+			programInstrument();
+			break;
+		case 7:
+			// rhythm mode, key on/off of the drums
+			g.write(0x0E, g.random(64));
+			g.wait(g.random(500));
+			break;
+		default: {
+			// random register (but not the test register)
+			static constexpr uint8_t regs[] = {
+				0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x0E,
+				0x10, 0x20, 0x30,
+			};
+			unsigned reg = regs[g.random(std::size(regs))];
+			if (reg >= 0x10) reg += ch;
+			g.write(reg, g.random(256));
+			g.wait(g.random(100));
+			break;
+		}
+		}
+		g.endEvent();
+	}
+	return std::move(g.log);
+}
+
+// register offsets of the 18 operators within a bank
+constexpr unsigned opOffsets[18] = {
+	0x00, 0x01, 0x02, 0x03, 0x04, 0x05,
+	0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D,
+	0x10, 0x11, 0x12, 0x13, 0x14, 0x15,
+};
+
+SoundLog randomYMF262Log(unsigned seed, unsigned numEvents, bool opl3)
+{
+	LogGenerator g(seed);
+	auto programOperator = [&](unsigned bank, unsigned op) {
+		unsigned base = bank * 0x100 + opOffsets[op];
+		g.write(base + 0x20, g.random(256));               // AM, VIB, EGT, KSR, MULT
+		g.write(base + 0x40, g.random(256) & 0xDF);        // KSL, TL (not too soft)
+		unsigned ar = 1 + g.random(15); // not 0
+		g.write(base + 0x60, 0x10 * ar + g.random(16)); // AR, DR
+		g.write(base + 0x80, g.random(256));               // SL, RR
+		g.write(base + 0xE0, g.random(8));                 // waveform
+	};
+	auto programChannel = [&](unsigned bank, unsigned ch) {
+		unsigned pan = 0x10 << g.random(4);
+		unsigned stereo = 0x30 * g.random(2);
+		g.write(bank * 0x100 + 0xC0 + ch, pan | stereo | g.random(16));
+	};
+
+	g.write(0x105, opl3 ? 1 : 0);
+	g.write(0x104, g.random(64));
+	g.write(0x08, g.random(2) * 0x40);
+	g.write(0xBD, g.random(256) & 0xC0);
+	for (auto bank : xrange(2)) {
+		for (auto op : xrange(18)) programOperator(bank, op);
+		for (auto ch : xrange(9)) programChannel(bank, ch);
+	}
+
+	for ([[maybe_unused]] auto e : xrange(numEvents)) {
+		unsigned bank = g.random(2);
+		unsigned ch = g.random(9);
+		switch (g.random(16)) {
+		case 0: case 1: case 2: case 3: case 4: case 5: {
+			// note on (possibly retrigger) or off
+			unsigned block_fnum = g.random(0x2000);
+			g.write(bank * 0x100 + 0xA0 + ch, block_fnum & 0xFF);
+			unsigned keyOn = (g.random(4) != 0) ? 0x20 : 0x00;
+			g.write(bank * 0x100 + 0xB0 + ch, (block_fnum >> 8) | keyOn);
+			g.wait(g.random(1000));
+			break;
+		}
+		case 6: case 7:
+			programOperator(bank, g.random(18));
+			break;
+		case 8:
+			programChannel(bank, ch);
+			break;
+		case 9:
+			// LFO depths and rhythm mode, key on/off of the drums
+			g.write(0xBD, g.random(256));
+			g.wait(g.random(500));
+			break;
+		case 10:
+			g.write(0x104, g.random(64));
+			break;
+		case 11:
+			if (g.random(8) == 0) g.write(0x105, g.random(2));
+			break;
+		case 12:
+			g.write(0x08, g.random(256));
+			break;
+		default:
+			// random register
+			unsigned reg = 0x20 + g.random(0x1E0);
+			g.write(reg, g.random(256));
+			g.wait(g.random(100));
+			break;
+		}
+		g.endEvent();
+	}
+	return std::move(g.log);
+}
+
+SoundLog randomAY8910Log(unsigned seed, unsigned numEvents)
+{
+	LogGenerator g(seed);
+	auto setPeriod = [&](unsigned ch) {
+		// mostly notes, sometimes the shortest periods (used to play
+		// samples via the volume registers)
+		unsigned period = (g.random(8) != 0) ? (0x20 + g.random(0x800)) : g.random(4);
+		g.write(2 * ch + 0, period & 0xFF);
+		g.write(2 * ch + 1, period >> 8);
+	};
+	auto setEnvelope = [&] {
+		unsigned period = (g.random(2) != 0) ? g.random(0x100) : g.random(0x10000);
+		g.write(11, period & 0xFF);
+		g.write(12, period >> 8);
+		g.write(13, g.random(16));
+	};
+
+	g.write(7, 0xB8); // tone on, noise off (port A input, port B output)
+	for (auto ch : xrange(3)) {
+		setPeriod(ch);
+		g.write(8 + ch, g.random(16));
+	}
+	setEnvelope();
+
+	for ([[maybe_unused]] auto e : xrange(numEvents)) {
+		unsigned ch = g.random(3);
+		switch (g.random(10)) {
+		case 0: case 1: case 2: case 3: {
+			// note, fixed volume or following the envelope
+			setPeriod(ch);
+			unsigned volume = (g.random(4) != 0) ? g.random(16) : 0x10;
+			g.write(8 + ch, volume);
+			g.wait(g.random(10000));
+			break;
+		}
+		case 4:
+			// tone and noise per channel
+			g.write(7, 0x80 | g.random(64));
+			g.wait(g.random(5000));
+			break;
+		case 5:
+			g.write(6, g.random(32));
+			break;
+		case 6:
+			setEnvelope();
+			g.wait(g.random(10000));
+			break;
+		case 7:
+			// play a sample via the volume register
+			for ([[maybe_unused]] auto i : xrange(1 + g.random(50))) {
+				g.write(8 + ch, g.random(16));
+				g.wait(g.random(30));
+			}
+			break;
+		default:
+			// random register
+			unsigned reg = g.random(14);
+			g.write(reg, g.random(256));
+			g.wait(g.random(100));
+			break;
+		}
+		g.endEvent();
+	}
+	return std::move(g.log);
+}
+
+SoundLog randomSCCLog(unsigned seed, unsigned numEvents)
+{
+	LogGenerator g(seed);
+	auto programWave = [&](unsigned ch) {
+		for (auto i : xrange(32)) g.write(32 * ch + i, g.random(256));
+	};
+
+	for (auto ch : xrange(4)) programWave(ch);
+	g.write(0x8F, 0x1F); // all channels on
+
+	for ([[maybe_unused]] auto e : xrange(numEvents)) {
+		unsigned ch = g.random(5);
+		switch (g.random(10)) {
+		case 0: case 1: case 2: case 3: case 4: {
+			// note (also the shortest periods)
+			unsigned period = (g.random(8) != 0) ? g.random(0x1000) : g.random(16);
+			g.write(0x80 + 2 * ch, period & 0xFF);
+			g.write(0x81 + 2 * ch, period >> 8);
+			g.write(0x8A + ch, g.random(16));
+			g.wait(g.random(5000));
+			break;
+		}
+		case 5:
+			// new waveform while playing (channel 4 shares the one
+			// of channel 3)
+			programWave(g.random(4));
+			break;
+		case 6:
+			g.write(0x8F, g.random(32));
+			g.wait(g.random(1000));
+			break;
+		case 7:
+			// deformation register, mostly off
+			g.write(0xE0, (g.random(4) != 0) ? 0 : g.random(256));
+			g.wait(g.random(1000));
+			break;
+		default:
+			// random address
+			unsigned addr = g.random(256);
+			g.write(addr, g.random(256));
+			g.wait(g.random(100));
+			break;
+		}
+		g.endEvent();
+	}
+	return std::move(g.log);
+}
+
+SoundLog randomY8950Log(unsigned seed, unsigned numEvents)
+{
+	LogGenerator g(seed);
+	auto programOperator = [&](unsigned op) {
+		unsigned base = opOffsets[op];
+		g.write(base + 0x20, g.random(256));        // AM, VIB, EGT, KSR, MULT
+		g.write(base + 0x40, g.random(256) & 0xDF); // KSL, TL (not too soft)
+		unsigned ar = 1 + g.random(15); // not 0
+		g.write(base + 0x60, 0x10 * ar + g.random(16)); // AR, DR
+		g.write(base + 0x80, g.random(256));        // SL, RR
+	};
+	auto programChannel = [&](unsigned ch) {
+		g.write(0xC0 + ch, g.random(16)); // FB, CON
+	};
+	auto playAdpcm = [&] {
+		// write some random ADPCM data to the sample RAM and play it
+		unsigned start = g.random(0x100);
+		unsigned stop = start + g.random(4);
+		g.write(0x07, 0x01); // reset
+		g.write(0x08, 0x00); // RAM
+		g.write(0x09, start & 0xFF);
+		g.write(0x0A, start >> 8);
+		g.write(0x0B, stop & 0xFF);
+		g.write(0x0C, stop >> 8);
+		g.write(0x07, 0x60); // record, memory data
+		for ([[maybe_unused]] auto i : xrange(32 * (stop - start + 1))) {
+			g.write(0x0F, g.random(256));
+		}
+		g.write(0x07, 0x01); // reset
+		g.write(0x10, g.random(256)); // delta-N
+		g.write(0x11, g.random(256));
+		g.write(0x12, g.random(256)); // volume
+		g.write(0x07, 0xA0 | (0x10 * g.random(2))); // start, memory data, maybe repeat
+		g.wait(g.random(2000));
+	};
+
+	g.write(0x08, g.random(2) * 0x40);
+	g.write(0xBD, g.random(256) & 0xC0);
+	for (auto op : xrange(18)) programOperator(op);
+	for (auto ch : xrange(9)) programChannel(ch);
+
+	for ([[maybe_unused]] auto e : xrange(numEvents)) {
+		unsigned ch = g.random(9);
+		switch (g.random(14)) {
+		case 0: case 1: case 2: case 3: case 4: {
+			// note on (possibly retrigger) or off
+			unsigned block_fnum = g.random(0x2000);
+			g.write(0xA0 + ch, block_fnum & 0xFF);
+			unsigned keyOn = (g.random(4) != 0) ? 0x20 : 0x00;
+			g.write(0xB0 + ch, (block_fnum >> 8) | keyOn);
+			g.wait(g.random(1000));
+			break;
+		}
+		case 5: case 6:
+			programOperator(g.random(18));
+			break;
+		case 7:
+			programChannel(ch);
+			break;
+		case 8:
+			// LFO depths and rhythm mode, key on/off of the drums
+			g.write(0xBD, g.random(256));
+			g.wait(g.random(500));
+			break;
+		case 9:
+			playAdpcm();
+			break;
+		case 10: {
+			// ADPCM frequency and volume
+			unsigned reg = 0x10 + g.random(3);
+			g.write(reg, g.random(256));
+			g.wait(g.random(500));
+			break;
+		}
+		default:
+			// random register (but not the ADPCM data or the timers)
+			unsigned reg = 0x20 + g.random(0xC0);
+			g.write(reg, g.random(256));
+			g.wait(g.random(100));
+			break;
+		}
+		g.endEvent();
+	}
+	return std::move(g.log);
+}
+
+SoundLog randomYM2151Log(unsigned seed, unsigned numEvents)
+{
+	LogGenerator g(seed);
+	auto programOperator = [&](unsigned op) {
+		g.write(0x40 + op, g.random(128));         // DT1, MUL
+		g.write(0x60 + op, g.random(0x60));        // TL (not too soft)
+		unsigned ks = g.random(4);
+		g.write(0x80 + op, ks << 6 | (1 + g.random(31))); // KS, AR (not 0)
+		g.write(0xA0 + op, g.random(256) & 0x9F);  // AMS-EN, D1R
+		g.write(0xC0 + op, g.random(256) & 0xDF);  // DT2, D2R
+		g.write(0xE0 + op, g.random(256));         // D1L, RR
+	};
+	auto programChannel = [&](unsigned ch) {
+		unsigned rl = 1 + g.random(3); // not muted
+		g.write(0x20 + ch, rl << 6 | g.random(64)); // RL, FB, CONNECT
+		g.write(0x38 + ch, g.random(256) & 0x73);   // PMS, AMS
+	};
+	auto programLfo = [&] {
+		g.write(0x18, g.random(256));        // LFRQ
+		g.write(0x19, 0x80 | g.random(128)); // PMD
+		g.write(0x19, g.random(128));        // AMD
+		g.write(0x1B, g.random(4));          // waveform
+	};
+
+	programLfo();
+	for (auto op : xrange(32)) programOperator(op);
+	for (auto ch : xrange(8)) programChannel(ch);
+
+	for ([[maybe_unused]] auto e : xrange(numEvents)) {
+		unsigned ch = g.random(8);
+		switch (g.random(12)) {
+		case 0: case 1: case 2: case 3: case 4: case 5: {
+			// note on (possibly retrigger, also only some operators)
+			// or off
+			g.write(0x28 + ch, g.random(128));       // KC
+			g.write(0x30 + ch, g.random(256) & 0xFC); // KF
+			unsigned slots = (g.random(4) != 0) ? g.random(16) : 0;
+			g.write(0x08, slots << 3 | ch);
+			g.wait(g.random(1000));
+			break;
+		}
+		case 6: case 7:
+			programOperator(g.random(32));
+			break;
+		case 8:
+			programChannel(ch);
+			break;
+		case 9:
+			programLfo();
+			g.wait(g.random(500));
+			break;
+		case 10:
+			// noise on channel 7
+			g.write(0x0F, g.random(256));
+			g.wait(g.random(500));
+			break;
+		default:
+			// random register (but not the timers or the test register)
+			unsigned reg = 0x20 + g.random(0xE0);
+			g.write(reg, g.random(256));
+			g.wait(g.random(100));
+			break;
+		}
+		g.endEvent();
+	}
+	return std::move(g.log);
+}
+
+SoundLog randomYMF278Log(unsigned seed, unsigned numEvents)
+{
+	LogGenerator g(seed);
+	auto programSlot = [&](unsigned slot) {
+		// The wave header (from memory) also sets the LFO, VIB, AR,
+		// D1R, DL, D2R, RC, RR and AM registers.
+		unsigned wave = g.random(512);
+		g.write(0x20 + slot, g.random(128) << 1 | (wave >> 8)); // FN, wave
+		g.write(0x08 + slot, wave & 0xFF);
+		g.write(0x38 + slot, g.random(256)); // OCT, PRVB, FN
+		g.write(0x50 + slot, g.random(256)); // TL, LD
+	};
+	auto programEnvelope = [&](unsigned slot) {
+		g.write(0x80 + slot, g.random(64));  // LFO, VIB
+		g.write(0x98 + slot, g.random(256)); // AR, D1R
+		g.write(0xB0 + slot, g.random(256)); // DL, D2R
+		g.write(0xC8 + slot, g.random(256)); // RC, RR
+		g.write(0xE0 + slot, g.random(8));   // AM
+	};
+
+	for (auto slot : xrange(24)) programSlot(slot);
+
+	for ([[maybe_unused]] auto e : xrange(numEvents)) {
+		unsigned slot = g.random(24);
+		switch (g.random(10)) {
+		case 0: case 1: case 2: case 3: case 4: {
+			// note on (possibly retrigger) or off
+			programSlot(slot);
+			unsigned keyOn = (g.random(4) != 0) ? 0x80 : 0x00;
+			g.write(0x68 + slot, keyOn | g.random(0x80)); // DAMP, LFO RST, CH, pan
+			g.wait(g.random(1000));
+			break;
+		}
+		case 5: case 6:
+			programEnvelope(slot);
+			break;
+		case 7:
+			// frequency change while playing
+			g.write(0x38 + slot, g.random(256));
+			g.wait(g.random(500));
+			break;
+		default:
+			// random slot register
+			unsigned reg = 0x08 + g.random(0xF0);
+			g.write(reg, g.random(256));
+			g.wait(g.random(100));
+			break;
+		}
+		g.endEvent();
+	}
+	return std::move(g.log);
+}
+
+SoundLog parseVGM(span<const uint8_t> vgm, VgmChip chip, double sampleRate)
+{
+	if ((vgm.size() < 0x40) || (read32(vgm, 0) != 0x206D6756)) { // "Vgm "
+		throw MSXException("Not a VGM file");
+	}
+	unsigned version = read32(vgm, 0x08);
+	size_t pos = 0x40;
+	if (version >= 0x150) {
+		if (unsigned offset = read32(vgm, 0x34)) pos = 0x34 + offset;
+	}
+
+	SoundLog result;
+	uint64_t vgmSamples = 0;    // total time in 44100Hz samples
+	uint64_t nativeSamples = 0; // same, but already converted to 'sampleRate'
+	auto wait = [&](unsigned n) {
+		vgmSamples += n;
+		auto total = uint64_t(double(vgmSamples) * sampleRate / 44100.0);
+		// The time before the first write to this chip is dropped. The
+		// chip doesn't produce sound before it's programmed anyway.
+		if (!result.empty()) result.back().samples += unsigned(total - nativeSamples);
+		nativeSamples = total;
+	};
+	auto write = [&](unsigned reg, uint8_t value) {
+		result.push_back({uint16_t(reg), value, 0});
+	};
+	auto need = [&](size_t n) {
+		if ((pos + n) > vgm.size()) throw MSXException("Truncated VGM file");
+	};
+
+	while (true) {
+		need(1);
+		uint8_t cmd = vgm[pos++];
+		// number of operand bytes of the commands we skip
+		size_t skip = 0;
+		switch (cmd) {
+		case 0x51: // YM2413 write
+		case 0x5E: // YMF262 port 0 write
+		case 0x5F: // YMF262 port 1 write
+			need(2);
+			if ((cmd == 0x51) && (chip == VgmChip::YM2413)) {
+				write(vgm[pos] & 0x3F, vgm[pos + 1]);
+			} else if ((cmd != 0x51) && (chip == VgmChip::YMF262)) {
+				write(((cmd & 1) << 8) | vgm[pos], vgm[pos + 1]);
+			}
+			skip = 2;
+			break;
+		case 0x54: // YM2151 write
+		case 0x5C: // Y8950 write
+			need(2);
+			if (chip == ((cmd == 0x54) ? VgmChip::YM2151 : VgmChip::Y8950)) {
+				write(vgm[pos], vgm[pos + 1]);
+			}
+			skip = 2;
+			break;
+		case 0xA0: // AY8910 write (bit 7 of the register selects the 2nd chip)
+			need(2);
+			if ((chip == VgmChip::AY8910) && !(vgm[pos] & 0x80)) {
+				write(vgm[pos] & 0x0F, vgm[pos + 1]);
+			}
+			skip = 2;
+			break;
+		case 0xD0: // YMF278B write: port, register, value
+			need(3);
+			if ((chip == VgmChip::YMF262) && (vgm[pos] < 2)) {
+				write((vgm[pos] << 8) | vgm[pos + 1], vgm[pos + 2]);
+			} else if ((chip == VgmChip::YMF278) && (vgm[pos] == 2)) {
+				write(vgm[pos + 1], vgm[pos + 2]);
+			}
+			skip = 3;
+			break;
+		case 0xD2: // SCC write: port, register, value
+			need(3);
+			if (chip == VgmChip::SCC) {
+				// waveform, frequency, volume, key on/off, (5th
+				// waveform, only on SCC-I), deformation
+				static constexpr int base[] = {0x00, 0x80, 0x8A, 0x8F, -1, 0xE0};
+				unsigned port = vgm[pos];
+				if ((port < std::size(base)) && (base[port] >= 0)) {
+					write(base[port] + vgm[pos + 1], vgm[pos + 2]);
+				}
+			}
+			skip = 3;
+			break;
+		case 0x61:
+			need(2);
+			wait(vgm[pos] | vgm[pos + 1] << 8);
+			skip = 2;
+			break;
+		case 0x62: wait(735); break;
+		case 0x63: wait(882); break;
+		case 0x66: return result; // end of sound data
+		case 0x67: // data block: 0x66 tt ss ss ss ss <data>
+			need(6);
+			skip = 6 + read32(vgm, pos + 2);
+			break;
+		case 0x68: skip = 11; break; // PCM RAM write
+		case 0x90: case 0x91: case 0x95: skip = 4; break; // DAC stream
+		case 0x92: skip = 5; break;
+		case 0x93: skip = 10; break;
+		case 0x94: skip = 1; break;
+		default:
+			if ((cmd & 0xF0) == 0x70) {
+				wait((cmd & 0x0F) + 1);
+			} else if ((cmd & 0xF0) == 0x80) {
+				wait(cmd & 0x0F); // YM2612 DAC write + wait
+			} else if ((0x30 <= cmd) && (cmd <= 0x3F)) {
+				skip = 1;
+			} else if ((0x40 <= cmd) && (cmd <= 0x4E)) {
+				skip = 2;
+			} else if (cmd == one_of(0x4F, 0x50)) {
+				skip = 1;
+			} else if (((0x51 <= cmd) && (cmd <= 0x5F)) ||
+			           ((0xA0 <= cmd) && (cmd <= 0xBF))) {
+				skip = 2;
+			} else if ((0xC0 <= cmd) && (cmd <= 0xDF)) {
+				skip = 3;
+			} else if (cmd >= 0xE0) {
+				skip = 4;
+			} else {
+				throw MSXException("Unknown VGM command 0x", hex_string<2>(cmd));
+			}
+		}
+		need(skip);
+		pos += skip;
+	}
+}
+
+} // namespace openmsx
@@ -0,0 +1,56 @@
+#ifndef SOUNDLOG_HH
+#define SOUNDLOG_HH
+
+#include "span.hh"
+#include <cstdint>
+#include <vector>
+
+namespace openmsx {
+
+/** A register write log for a sound chip: a sequence of register writes,
+  * each followed by the number of (native rate) samples to generate before
+  * the next write. Used to replay the exact same input into different
+  * implementations of a chip, for conformance tests and benchmarks.
+  */
+struct RegWrite {
+	uint16_t reg;
+	uint8_t value;
+	unsigned samples;
+};
+using SoundLog = std::vector<RegWrite>;
+
+/** Produce a random log that resembles music: instruments get programmed,
+  * notes get played (also with the chip specific features, like rhythm mode,
+  * waveforms, feedback, envelopes, LFO settings or ADPCM). In between there
+  * are some completely random writes to also cover the less common
+  * combinations. The same seed always gives the same log.
+  */
+[[nodiscard]] SoundLog randomYM2413Log(unsigned seed, unsigned numEvents);
+[[nodiscard]] SoundLog randomYMF262Log(unsigned seed, unsigned numEvents, bool opl3);
+[[nodiscard]] SoundLog randomAY8910Log(unsigned seed, unsigned numEvents);
+[[nodiscard]] SoundLog randomSCCLog(unsigned seed, unsigned numEvents);
+[[nodiscard]] SoundLog randomY8950Log(unsigned seed, unsigned numEvents);
+[[nodiscard]] SoundLog randomYM2151Log(unsigned seed, unsigned numEvents);
+[[nodiscard]] SoundLog randomYMF278Log(unsigned seed, unsigned numEvents);
+
+/** Chips that can be extracted from a VGM file, see parseVGM(). */
+enum class VgmChip {
+	YM2413, // registers 0x00-0x3F
+	YMF262, // registers 0x000-0x1FF (port 1 at 0x100)
+	AY8910, // registers 0x00-0x0F
+	SCC,    // addresses 0x00-0xFF of a SCC in 'real' mode
+	Y8950,  // registers 0x00-0xFF
+	YM2151, // registers 0x00-0xFF
+	YMF278, // registers 0x00-0xFF of the wave part
+};
+
+/** Extract the register writes for one chip from a VGM file (all versions,
+  * uncompressed). The VGM wait times (at 44100Hz) are converted to the
+  * given native sample rate of the chip. Writes to other chips are skipped.
+  * Throws MSXException when the data is not a valid VGM file.
+  */
+[[nodiscard]] SoundLog parseVGM(span<const uint8_t> vgm, VgmChip chip, double sampleRate);
+
+} // namespace openmsx
+
+#endif
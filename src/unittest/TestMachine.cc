@@ -0,0 +1,101 @@
+#include "TestMachine.hh"
+#include "FileException.hh"
+#include "FileOperations.hh"
+#include "MSXMotherBoard.hh"
+#include "Reactor.hh"
+#include "Scheduler.hh"
+#include "Thread.hh"
+#include "strCat.hh"
+#include <cassert>
+#include <cstdlib>
+#include <fstream>
+#ifdef _WIN32
+#include <process.h>
+#endif
+
+namespace openmsx {
+
+static void setEnv(const char* name, const std::string& value)
+{
+#ifdef _WIN32
+	_putenv_s(name, value.c_str());
+#else
+	setenv(name, value.c_str(), 1);
+#endif
+}
+
+static std::string dataDir;
+
+const std::string& TestMachine::getDataDir()
+{
+	assert(!dataDir.empty());
+	return dataDir;
+}
+
+void TestMachine::createDataDir()
+{
+	assert(dataDir.empty());
+	auto base = FileOperations::getTempDir() + "/openmsx_unittest_";
+#ifdef _WIN32
+	dataDir = strCat(base, _getpid());
+	FileOperations::mkdirp(dataDir);
+#else
+	std::string name = base + "XXXXXX";
+	if (!mkdtemp(name.data())) {
+		throw FileException("Couldn't create directory ", name);
+	}
+	dataDir = std::move(name);
+#endif
+	// The data dirs are cached on first use (e.g. also by the Interpreter
+	// constructor, in other tests), so they must be set before any test
+	// runs.
+	setEnv("OPENMSX_USER_DATA",   dataDir);
+	setEnv("OPENMSX_SYSTEM_DATA", dataDir);
+}
+
+void TestMachine::removeDataDir()
+{
+	if (dataDir.empty()) return;
+	FileOperations::deleteRecursive(dataDir);
+	dataDir.clear();
+}
+
+TestMachine::TestMachine(std::string_view devicesXml)
+{
+	const auto& dir = getDataDir();
+	FileOperations::mkdirp(dir + "/machines");
+	{
+		std::ofstream file(dir + "/machines/unittest.xml");
+		file << "<?xml version=\"1.0\" ?>\n"
+		        "<!DOCTYPE msxconfig SYSTEM 'msxconfig2.dtd'>\n"
+		        "<msxconfig>\n"
+		        "<info><type>MSX2</type></info>\n"
+		        "<devices>\n" << devicesXml << "\n</devices>\n"
+		        "</msxconfig>\n";
+	}
+
+	static bool mainThreadSet = false;
+	if (!mainThreadSet) {
+		Thread::setMainThread();
+		mainThreadSet = true;
+	}
+	reactor = std::make_unique<Reactor>();
+	reactor->init();
+	reactor->setHeadless();
+	reactor->switchMachine("unittest");
+	board = reactor->getMotherBoard();
+}
+
+TestMachine::~TestMachine() = default;
+
+EmuTime::param TestMachine::getCurrentTime()
+{
+	return board->getCurrentTime();
+}
+
+void TestMachine::runUntil(EmuTime::param time)
+{
+	board->getScheduler().schedule(time);
+}
+
+} // namespace openmsx
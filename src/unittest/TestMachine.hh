@@ -0,0 +1,57 @@
+#ifndef TESTMACHINE_HH
+#define TESTMACHINE_HH
+
+#include "EmuTime.hh"
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace openmsx {
+
+class MSXMotherBoard;
+class Reactor;
+
+/** A Reactor running a minimal MSX machine, for tests that need complete
+  * devices (with a scheduler, a mixer, debuggables, ...) instead of only
+  * some helper classes. The machine contains the given devices (the content
+  * of the <devices> tag of a machine config). There's no CPU emulation, no
+  * display and no sound output: the test drives the devices itself (e.g.
+  * with writeIO()) and advances the emulated time with runUntil().
+  */
+class TestMachine
+{
+public:
+	explicit TestMachine(std::string_view devicesXml);
+	~TestMachine();
+
+	[[nodiscard]] MSXMotherBoard& getMotherBoard() { return *board; }
+	[[nodiscard]] EmuTime::param getCurrentTime();
+
+	/** Execute all sync points up to the given moment in time. */
+	void runUntil(EmuTime::param time);
+
+	/** All tests use the same directory as user and system data dir (the
+	  * location is cached by openMSX). It can e.g. also hold ROM images
+	  * for the machine. It's unique for each run of the unittest binary,
+	  * so that runs in parallel don't interfere.
+	  */
+	[[nodiscard]] static const std::string& getDataDir();
+
+	/** Create the data dir and point openMSX to it (via the environment
+	  * variables OPENMSX_USER_DATA and OPENMSX_SYSTEM_DATA). Must be
+	  * called before any test runs, see unittest/main.cc.
+	  */
+	static void createDataDir();
+
+	/** Remove the data dir, and all files in it, once all tests are done.
+	  */
+	static void removeDataDir();
+
+private:
+	std::unique_ptr<Reactor> reactor;
+	MSXMotherBoard* board;
+};
+
+} // namespace openmsx
+
+#endif
@@ -0,0 +1,256 @@
+#include "catch.hpp"
+#include "TestMachine.hh"
+#include "MSXMotherBoard.hh"
+#include "V9990.hh"
+#include "V9990CmdEngine.hh"
+#include "V9990VRAM.hh"
+#include "xrange.hh"
+#include <chrono>
+#include <cstdint>
+#include <initializer_list>
+#include <iostream>
+#include <random>
+#include <utility>
+#include <vector>
+
+using namespace openmsx;
+
+namespace {
+
+struct V9990Command {
+	unsigned sx, sy, dx, dy, nx, ny;
+	unsigned arg, log, wm, fc, cmd;
+};
+
+struct Result {
+	std::vector<uint64_t> hashes; // of the VRAM content
+	std::vector<unsigned> durations; // in steps of 2us
+};
+
+// The V9990 I/O ports and registers that are used below.
+constexpr uint8_t REGISTER_DATA = 3;
+constexpr uint8_t REGISTER_SELECT = 4;
+constexpr uint8_t STATUS = 5;
+constexpr uint8_t SCREEN_MODE_0 = 6;
+constexpr uint8_t CMD_PARAM_SRC_ADDRESS_0 = 32;
+
+constexpr uint8_t LMMV = 0x20;
+constexpr uint8_t LMMM = 0x40;
+constexpr uint8_t BMXL = 0x80;
+constexpr uint8_t BMLX = 0x90;
+constexpr uint8_t BMLL = 0xA0;
+
+} // namespace
+
+// Random commands for an image with the given width in pixels. In the Bx
+// modes all of VRAM is one image, so also the coordinates near the end of
+// VRAM (and beyond, they wrap around) are used.
+static std::vector<V9990Command> getCommands(
+	unsigned width, unsigned bpp, std::minstd_rand& rnd)
+{
+	auto random = [&](unsigned n) { return unsigned(rnd() % n); };
+	auto randomWM = [&] {
+		// mostly all bits, sometimes only some
+		return random(2) ? 0xFFFF : random(0x10000);
+	};
+
+	std::vector<V9990Command> result;
+	for ([[maybe_unused]] auto i : xrange(12)) {
+		// LMMV, all logical operations, with and without transparency
+		result.push_back({0, 0, random(width), random(4096),
+		                  1 + random(width), 1 + random(20),
+		                  random(16) & 0x0C, random(32),
+		                  randomWM(), random(0x10000), LMMV});
+	}
+	for ([[maybe_unused]] auto i : xrange(12)) {
+		// LMMM, random positions
+		result.push_back({random(width), random(4096), random(width), random(4096),
+		                  1 + random(width), 1 + random(20),
+		                  random(16) & 0x0C, random(32),
+		                  randomWM(), 0, LMMM});
+	}
+	for ([[maybe_unused]] auto i : xrange(12)) {
+		// LMMM, overlapping source and destination (e.g. scrolling)
+		unsigned sx = random(width);
+		unsigned sy = random(4096);
+		unsigned dx = (sx + random(17) - 8) & (width - 1);
+		unsigned dy = (sy + random(3) - 1) & 4095;
+		result.push_back({sx, sy, dx, dy,
+		                  1 + random(width), 1 + random(20),
+		                  random(16) & 0x0C, random(32),
+		                  randomWM(), 0, LMMM});
+	}
+	// The linear address (in the Bx address space) of pixel (x, y).
+	auto linear = [&](unsigned x, unsigned y) {
+		return ((x + y * width) * bpp / 8) & 0x7FFFF;
+	};
+	for ([[maybe_unused]] auto i : xrange(16)) {
+		// BMXL: from a linear address to a rectangle, sometimes with
+		// the source near (or in) the first destination line
+		unsigned dx = random(width);
+		unsigned dy = random(4096);
+		unsigned src = random(2) ? random(0x80000)
+		                         : ((linear(dx, dy) + random(65) - 32) & 0x7FFFF);
+		result.push_back({src & 0xFF, src >> 8, dx, dy,
+		                  1 + random(width), 1 + random(20),
+		                  random(16) & 0x0C, random(32),
+		                  randomWM(), 0, BMXL});
+	}
+	for ([[maybe_unused]] auto i : xrange(16)) {
+		// BMLX: from a rectangle to a linear address, idem
+		unsigned sx = random(width);
+		unsigned sy = random(4096);
+		unsigned dst = random(2) ? random(0x80000)
+		                         : ((linear(sx, sy) + random(65) - 32) & 0x7FFFF);
+		result.push_back({sx, sy, dst & 0xFF, dst >> 8,
+		                  1 + random(width), 1 + random(20),
+		                  random(16) & 0x0C, 0,
+		                  0, 0, BMLX});
+	}
+	for ([[maybe_unused]] auto i : xrange(12)) {
+		// BMLL: source and destination are linear addresses, also
+		// overlapping and wrapping around the end of VRAM
+		unsigned src = random(0x80000);
+		unsigned dst = random(2) ? random(0x80000)
+		                         : ((src + random(33) - 16) & 0x7FFFF);
+		unsigned num = 1 + random(5000);
+		result.push_back({src & 0xFF, src >> 8, dst & 0xFF, dst >> 8,
+		                  num & 0xFF, num >> 8,
+		                  0, random(32), randomWM(), 0, BMLL});
+	}
+	return result;
+}
+
+static void writeRegs(V9990& vdp, uint8_t reg, std::initializer_list<unsigned> values,
+                      EmuTime::param time)
+{
+	vdp.writeIO(REGISTER_SELECT, reg, time); // auto-increment
+	for (auto v : values) vdp.writeIO(REGISTER_DATA, uint8_t(v), time);
+}
+
+static void startCommand(V9990& vdp, const V9990Command& c, EmuTime::param time)
+{
+	writeRegs(vdp, CMD_PARAM_SRC_ADDRESS_0, {
+		c.sx, c.sx >> 8, c.sy, c.sy >> 8,
+		c.dx, c.dx >> 8, c.dy, c.dy >> 8,
+		c.nx, c.nx >> 8, c.ny, c.ny >> 8,
+		c.arg, c.log, c.wm, c.wm >> 8,
+		c.fc, c.fc >> 8, 0, 0, c.cmd}, time); // last one starts the command
+}
+
+static Result run(bool bulk)
+{
+	V9990CmdEngine::setBulkEnabled(bulk);
+	TestMachine machine(
+		"<V9990 id=\"V9990\"><io base=\"0x60\" num=\"0x10\"/></V9990>");
+	auto& vdp = dynamic_cast<V9990&>(*machine.getMotherBoard().findDevice("V9990"));
+	auto& vram = vdp.getVRAM();
+
+	EmuTime time = machine.getCurrentTime();
+	auto advance = [&](EmuDuration::param d) {
+		time += d;
+		machine.runUntil(time);
+	};
+	auto hash = [&] {
+		// (don't keep 512kB snapshots of all intermediate states)
+		vram.sync(time);
+		uint64_t result = 0xcbf29ce484222325; // FNV-1a
+		for (auto addr : xrange(0x80000)) {
+			result = (result ^ vram.readVRAMDirect(addr)) * 0x100000001b3;
+		}
+		return result;
+	};
+
+	Result result;
+	std::minstd_rand rnd(1234);
+	// 2, 4, 8 and 16 bits per pixel, each with two different image widths
+	for (auto [clrm, ximm] : {std::pair{0u, 0u}, std::pair{0u, 3u},
+	                          std::pair{1u, 1u}, std::pair{1u, 2u},
+	                          std::pair{2u, 0u}, std::pair{2u, 2u},
+	                          std::pair{3u, 0u}, std::pair{3u, 1u}}) {
+		INFO("mode " << clrm << ' ' << ximm);
+		writeRegs(vdp, SCREEN_MODE_0, {0x80 | (ximm << 2) | clrm}, time);
+		advance(EmuDuration::msec(1)); // mode change takes effect
+		for (auto addr : xrange(0x80000)) {
+			vram.writeVRAMDirect(addr, uint8_t(rnd()));
+		}
+		unsigned width = 256 << ximm;
+		unsigned bpp = 2 << clrm;
+		for (const auto& c : getCommands(width, bpp, rnd)) {
+			startCommand(vdp, c, time);
+
+			unsigned steps = 0;
+			while (vdp.readIO(STATUS, time) & V9990CmdEngine::CE) {
+				if (++steps == 50) {
+					// intermediate state of a long command
+					result.hashes.push_back(hash());
+				}
+				REQUIRE(steps < 1000000);
+				advance(EmuDuration::usec(2));
+			}
+			result.durations.push_back(steps);
+			result.hashes.push_back(hash());
+		}
+	}
+	V9990CmdEngine::setBulkEnabled(true);
+	return result;
+}
+
+TEST_CASE("V9990CmdEngine: bulk processing gives the same result")
+{
+	// The same (random) commands on the same (random) VRAM content, once
+	// pixel by pixel and once with the runs of whole bytes processed at
+	// once. The content and the timing must be exactly the same.
+	auto slow = run(false);
+	auto fast = run(true);
+
+	CHECK(fast.durations == slow.durations);
+	REQUIRE(fast.hashes.size() == slow.hashes.size());
+	for (auto i : xrange(slow.hashes.size())) {
+		INFO("snapshot " << i);
+		CHECK(fast.hashes[i] == slow.hashes[i]);
+	}
+}
+
+// Not run by default, run with:  unittest "[benchmark]"
+TEST_CASE("V9990CmdEngine: benchmark", "[.benchmark]")
+{
+	TestMachine machine(
+		"<V9990 id=\"V9990\"><io base=\"0x60\" num=\"0x10\"/></V9990>");
+	auto& vdp = dynamic_cast<V9990&>(*machine.getMotherBoard().findDevice("V9990"));
+	EmuTime time = machine.getCurrentTime();
+	writeRegs(vdp, SCREEN_MODE_0, {0x80 | (1 << 2) | 2}, time); // 512 pixels, 8bpp
+	time += EmuDuration::msec(1);
+	machine.runUntil(time);
+
+	// Commands on a whole 512x424 image (0x35000 bytes), copies are from
+	// or to the image at VRAM address 0x40000.
+	static constexpr std::pair<const char*, V9990Command> commands[] = {
+		{"LMMV", {0, 0,     0, 0,     512, 424,   0, 0x0C, 0xFFFF, 0x12, LMMV}},
+		{"LMMM", {0, 0x200, 0, 0,     512, 424,   0, 0x0C, 0xFFFF, 0,    LMMM}},
+		{"BMXL", {0, 0x400, 0, 0,     512, 424,   0, 0x0C, 0xFFFF, 0,    BMXL}},
+		{"BMLX", {0, 0,     0, 0x400, 512, 424,   0, 0,    0,      0,    BMLX}},
+		{"BMLL", {0, 0,     0, 0x400, 0,   0x350, 0, 0x0C, 0xFFFF, 0,    BMLL}},
+	};
+	for (const auto& [name, c] : commands) {
+		double ns[2];
+		for (bool bulk : {false, true}) {
+			V9990CmdEngine::setBulkEnabled(bulk);
+			std::chrono::steady_clock::duration total{};
+			for ([[maybe_unused]] auto i : xrange(10)) {
+				startCommand(vdp, c, time);
+				auto start = std::chrono::steady_clock::now();
+				do {
+					time += EmuDuration::msec(100);
+				} while (vdp.readIO(STATUS, time) & V9990CmdEngine::CE);
+				total += std::chrono::steady_clock::now() - start;
+				machine.runUntil(time);
+			}
+			auto t = std::chrono::duration_cast<std::chrono::nanoseconds>(total);
+			ns[bulk] = double(t.count()) / 10;
+		}
+		std::cout << name << ": per pixel " << ns[0] / 1000000 << " ms, in runs "
+		          << ns[1] / 1000000 << " ms (" << ns[0] / ns[1] << "x)\n";
+	}
+	V9990CmdEngine::setBulkEnabled(true);
+}
@@ -0,0 +1,167 @@
+#include "catch.hpp"
+#include "TestMachine.hh"
+#include "MSXMotherBoard.hh"
+#include "VDP.hh"
+#include "VDPVRAM.hh"
+#include "VRAMObserver.hh"
+#include "xrange.hh"
+#include <cstdint>
+#include <random>
+#include <vector>
+
+using namespace openmsx;
+
+namespace {
+
+// Takes the place of the renderer as observer of the visible bitmap. It
+// decides whether the command engine may skip the notifications (and thus
+// use its fast paths), and counts the notifications it does get.
+class TestObserver final : public VRAMObserver
+{
+public:
+	explicit TestObserver(bool observing_) : observing(observing_) {}
+
+	void updateVRAM(unsigned /*offset*/, EmuTime::param /*time*/) override {
+		++count;
+	}
+	void updateWindow(bool /*enabled*/, EmuTime::param /*time*/) override {}
+	[[nodiscard]] bool isObserving(unsigned /*address*/, unsigned /*size*/) const override {
+		return observing;
+	}
+
+	const bool observing;
+	unsigned count = 0;
+};
+
+struct VdpCommand {
+	unsigned sx, sy, dx, dy, nx, ny;
+	uint8_t clr, arg, cmd;
+};
+
+struct Result {
+	std::vector<std::vector<uint8_t>> snapshots;
+	std::vector<unsigned> durations; // in steps of 10us
+	unsigned notifications = 0; // by the commands
+};
+
+} // namespace
+
+static std::vector<VdpCommand> getCommands(unsigned width)
+{
+	// All commands work on VRAM page 1 (y=256..511), not on the displayed
+	// page nor on the sprite tables. ARG: 0x04 = DIX, 0x08 = DIY,
+	// 0x01 = MAJ. CMD: high nibble is the command, low nibble the logop.
+	return {
+		// LMMV: the fast path is only used for IMP and TIMP
+		{0,   0,   3, 260, width - 7, 40, 0x5A, 0x00, 0x80},
+		{0,   0,   0, 256,         0, 80, 0xA5, 0x00, 0x80}, // NX=0: full line
+		{0,   0,   9, 270,        40, 20, 0x00, 0x00, 0x88}, // TIMP color 0
+		{0,   0, width - 2, 300, width / 2 + 1, 30, 0x37, 0x04, 0x88},
+		{0,   0, 100, 400,         1, 10, 0x0F, 0x0C, 0x80},
+		{0,   0, 101, 410,         2,  1, 0x33, 0x08, 0x80},
+		{0,   0,  50, 330,       100, 50, 0x6C, 0x00, 0x83}, // XOR
+		// HMMV
+		{0,   0,   5, 320, width - 10, 20, 0xC3, 0x04, 0xC0},
+		{0,   0,   0, 450,          0,  9, 0x1E, 0x08, 0xC0},
+		// HMMM, also overlapping
+		{0, 256,  20, 350, width / 2, 40, 0x00, 0x00, 0xD0},
+		{10, 300, 12, 305, 64, 30, 0x00, 0x0C, 0xD0},
+		// YMMM, also overlapping
+		{0, 260,  30, 420, 0, 50, 0x00, 0x00, 0xE0},
+		{0, 410, 200, 415, 0, 30, 0x00, 0x0C, 0xE0},
+		// LMMM (no fast path)
+		{7, 270,  60, 380, 90, 25, 0x00, 0x00, 0x98},
+		// LINE
+		{0,   0,  10, 280, 200, 50, 0x09, 0x00, 0x70},
+		{0,   0, 250, 500, 150, 90, 0x06, 0x0D, 0x78},
+	};
+}
+
+static Result run(bool observing)
+{
+	TestObserver observer(observing);
+	TestMachine machine(
+		"<VDP id=\"VDP\"><version>V9958</version><vram>128</vram>"
+		"<io base=\"0x98\" num=\"4\"/></VDP>");
+	auto& vdp = dynamic_cast<VDP&>(*machine.getMotherBoard().findDevice("VDP"));
+	auto& vram = vdp.getVRAM();
+	vram.bitmapVisibleWindow.setObserver(&observer);
+
+	EmuTime time = machine.getCurrentTime();
+	auto advance = [&](EmuDuration::param d) {
+		time += d;
+		machine.runUntil(time);
+	};
+	auto writeReg = [&](uint8_t reg, uint8_t value) {
+		vdp.writeIO(0x99, value, time);
+		vdp.writeIO(0x99, 0x80 | reg, time);
+	};
+	auto snapshot = [&] {
+		std::vector<uint8_t> result;
+		for (auto addr : xrange(0x20000)) {
+			result.push_back(vram.cpuRead(addr, time));
+		}
+		return result;
+	};
+
+	Result result;
+	std::minstd_rand rnd(1234);
+	writeReg(8, 0x0A); // 64kB chips, no sprites
+	writeReg(9, 0x80); // 212 lines
+	for (auto [reg0, width] : {std::pair{0x06u, 256u},   // GRAPHIC4
+	                           std::pair{0x08u, 512u},   // GRAPHIC5
+	                           std::pair{0x0Au, 512u},   // GRAPHIC6
+	                           std::pair{0x0Eu, 256u}}) { // GRAPHIC7
+		writeReg(0, uint8_t(reg0));
+		writeReg(1, 0x40);
+		advance(EmuDuration::msec(1)); // mode change takes effect
+		for (auto addr : xrange(0x20000)) {
+			vram.cpuWrite(addr, uint8_t(rnd()), time);
+		}
+		unsigned notifications = observer.count;
+		for (const auto& c : getCommands(width)) {
+			writeReg(17, 32); // indirect access from R#32 on
+			for (auto v : {c.sx, c.sy, c.dx, c.dy, c.nx, c.ny}) {
+				vdp.writeIO(0x9B, uint8_t(v >> 0), time);
+				vdp.writeIO(0x9B, uint8_t(v >> 8), time);
+			}
+			vdp.writeIO(0x9B, c.clr, time);
+			vdp.writeIO(0x9B, c.arg, time);
+			vdp.writeIO(0x9B, c.cmd, time);
+
+			writeReg(15, 2); // read S#2
+			unsigned steps = 0;
+			while (vdp.readIO(0x99, time) & 0x01) { // CE
+				if (++steps == 100) {
+					// intermediate state of a long command
+					result.snapshots.push_back(snapshot());
+				}
+				advance(EmuDuration::usec(10));
+			}
+			result.durations.push_back(steps);
+			result.snapshots.push_back(snapshot());
+		}
+		result.notifications += observer.count - notifications;
+	}
+	return result;
+}
+
+TEST_CASE("VDPCmdEngine: fast paths give the same result")
+{
+	// Once with all writes observed (the fast paths are not allowed),
+	// once without any observer (all fast paths are used whenever the
+	// command allows it). The content and timing must be exactly the same.
+	auto slow = run(true);
+	auto fast = run(false);
+
+	CHECK(fast.durations == slow.durations);
+	REQUIRE(fast.snapshots.size() == slow.snapshots.size());
+	for (auto i : xrange(slow.snapshots.size())) {
+		INFO("snapshot " << i);
+		// (don't let catch print 128kB of VRAM on a mismatch)
+		bool equal = fast.snapshots[i] == slow.snapshots[i];
+		CHECK(equal);
+	}
+	// The fast paths were really taken.
+	CHECK(fast.notifications < slow.notifications / 2);
+}
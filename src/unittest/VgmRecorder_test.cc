@@ -0,0 +1,85 @@
+#include "catch.hpp"
+#include "TestMachine.hh"
+#include "SoundLog.hh"
+#include "DeviceConfig.hh"
+#include "HardwareConfig.hh"
+#include "MSXCommandController.hh"
+#include "MSXMotherBoard.hh"
+#include "XMLElement.hh"
+#include "YM2413.hh"
+#include "YMF262.hh"
+#include "xrange.hh"
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+using namespace openmsx;
+
+// The recorder rounds down to whole 44100Hz samples, use an exact multiple
+// of the (rounded) sample period to get predictable waits.
+static constexpr uint64_t SAMPLE = MAIN_FREQ32 / 44100;
+
+static void checkLog(const SoundLog& actual, const SoundLog& expected)
+{
+	REQUIRE(actual.size() == expected.size());
+	for (auto i : xrange(expected.size())) {
+		INFO("write " << i);
+		CHECK(actual[i].reg     == expected[i].reg);
+		CHECK(actual[i].value   == expected[i].value);
+		CHECK(actual[i].samples == expected[i].samples);
+	}
+}
+
+TEST_CASE("VgmRecorder: round trip through parseVGM")
+{
+	TestMachine machine("");
+	auto& board = machine.getMotherBoard();
+	XMLElement xml("chip");
+	xml.addChild("sound").addChild("volume", "10000");
+	DeviceConfig config(*board.getMachineConfig(), xml);
+	YM2413 ym2413("ym2413", config);
+	YMF262 ymf262("ymf262", config, false);
+
+	// Play both logs at the same time. The waits in the logs are used as
+	// 44100Hz samples here (whatever their original rate).
+	auto log2413 = randomYM2413Log(1, 200);
+	auto log262  = randomYMF262Log(2, 200, true);
+	auto filename = TestMachine::getDataDir() + "/roundtrip.vgm";
+	auto& controller = board.getMSXCommandController();
+	controller.executeCommand("vgm_record start " + filename);
+
+	EmuTime start = machine.getCurrentTime();
+	uint64_t pos2413 = 0, pos262 = 0; // in 44100Hz samples
+	size_t i2413 = 0, i262 = 0;
+	while ((i2413 < log2413.size()) || (i262 < log262.size())) {
+		bool first = (i262 == log262.size()) ||
+		             ((i2413 < log2413.size()) && (pos2413 <= pos262));
+		EmuTime time = start + EmuDuration(SAMPLE * (first ? pos2413 : pos262));
+		machine.runUntil(time);
+		if (first) {
+			const auto& w = log2413[i2413++];
+			ym2413.writePort(false, uint8_t(w.reg), time);
+			ym2413.writePort(true, w.value, time);
+			pos2413 += w.samples;
+		} else {
+			const auto& w = log262[i262++];
+			ymf262.writeReg512(w.reg, w.value, time);
+			pos262 += w.samples;
+		}
+	}
+	// the recording stops at the current time
+	machine.runUntil(start + EmuDuration(SAMPLE * std::max(pos2413, pos262)));
+	controller.executeCommand("vgm_record stop");
+
+	std::ifstream file(filename, std::ios::binary);
+	std::vector<uint8_t> vgm{std::istreambuf_iterator<char>(file),
+	                         std::istreambuf_iterator<char>()};
+	REQUIRE(vgm.size() > 0x100);
+	// the last write of each chip is followed by the rest of the recording
+	log2413.back().samples += unsigned(std::max(pos2413, pos262) - pos2413);
+	log262 .back().samples += unsigned(std::max(pos2413, pos262) - pos262);
+	checkLog(parseVGM(vgm, VgmChip::YM2413, 44100.0), log2413);
+	checkLog(parseVGM(vgm, VgmChip::YMF262, 44100.0), log262);
+}
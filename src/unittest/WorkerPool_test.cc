@@ -0,0 +1,57 @@
+#include "catch.hpp"
+#include "WorkerPool.hh"
+#include "xrange.hh"
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace openmsx;
+
+TEST_CASE("WorkerPool: all calls are made")
+{
+	for (unsigned numThreads : {1, 2, 4}) {
+		WorkerPool pool(numThreads);
+		CHECK(pool.getNumThreads() == numThreads);
+		for (unsigned count : {0, 1, 3, 100}) {
+			std::vector<std::atomic<int>> calls(count);
+			pool.parallelFor(count, [&](unsigned i) { ++calls[i]; });
+			for (auto i : xrange(count)) CHECK(calls[i] == 1);
+		}
+	}
+}
+
+TEST_CASE("WorkerPool: exceptions")
+{
+	for (unsigned numThreads : {1, 2, 4}) {
+		WorkerPool pool(numThreads);
+		auto mainThread = std::this_thread::get_id();
+
+		// throw on the calling thread and on the worker threads
+		for (bool onMain : {true, false}) {
+			std::atomic<int> running = 0;
+			std::atomic<int> finished = 0;
+			CHECK_THROWS_AS(pool.parallelFor(100, [&](unsigned /*i*/) {
+				++running;
+				bool isMain = std::this_thread::get_id() == mainThread;
+				if ((isMain == onMain) || (numThreads == 1)) {
+					throw std::runtime_error("error");
+				}
+				// keep the other threads busy for a while
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				++finished;
+			}), std::runtime_error);
+			// every call that started also finished (or threw) before
+			// parallelFor() returned
+			CHECK(running > finished);
+			int r = running;
+			std::this_thread::sleep_for(std::chrono::milliseconds(20));
+			CHECK(running == r);
+		}
+
+		// the pool is still usable afterwards
+		std::atomic<int> sum = 0;
+		pool.parallelFor(10, [&](unsigned i) { sum += i; });
+		CHECK(sum == 45);
+	}
+}
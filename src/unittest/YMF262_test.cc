@@ -0,0 +1,97 @@
+#include "catch.hpp"
+#include "ImplList.hh"
+#include "SoundLog.hh"
+#include "YMF262.hh"
+#include "xrange.hh"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+using namespace openmsx;
+
+namespace {
+
+struct Output {
+	std::vector<float> samples;
+	std::vector<bool> muted; // for each generateChannels() call
+	std::chrono::steady_clock::duration time{}; // spent in generateChannels()
+};
+
+Output run(YMF262Core::Impl impl, const SoundLog& log)
+{
+	YMF262Core core;
+	core.setImpl(impl);
+
+	unsigned maxSamples = 0;
+	for (const auto& w : log) maxSamples = std::max(maxSamples, w.samples);
+	std::vector<float> buffer(18 * 2 * maxSamples);
+
+	Output result;
+	for (const auto& w : log) {
+		core.writeReg(w.reg, w.value);
+		if (w.samples == 0) continue;
+
+		std::fill_n(buffer.begin(), 18 * 2 * w.samples, 0.0f);
+		float* bufs[18];
+		for (auto i : xrange(18)) bufs[i] = &buffer[i * 2 * w.samples];
+		auto start = std::chrono::steady_clock::now();
+		core.generateChannels(bufs, w.samples);
+		result.time += std::chrono::steady_clock::now() - start;
+
+		bool muted = bufs[0] == nullptr;
+		result.muted.push_back(muted);
+		if (!muted) {
+			result.samples.insert(result.samples.end(),
+			                      buffer.begin(), buffer.begin() + 18 * 2 * w.samples);
+		}
+	}
+	return result;
+}
+
+const NamedImpl<YMF262Core> impls[] = {
+	{YMF262Core::GENERIC, "generic"},
+	{YMF262Core::AVX2,    "AVX2   "},
+};
+
+} // namespace
+
+TEST_CASE("YMF262: all implementations give the same result")
+{
+	checkImplList(impls);
+	for (auto seed : xrange(8)) {
+		bool opl3 = seed != 0;
+		auto log = randomYMF262Log(seed, 1500, opl3);
+		auto expected = run(YMF262Core::GENERIC, log);
+		// the test is only meaningful when there's sound
+		CHECK(std::count(expected.muted.begin(), expected.muted.end(), false) > 0);
+		CHECK(std::any_of(expected.samples.begin(), expected.samples.end(),
+		                  [](float f) { return f != 0.0f; }));
+
+		forEachSupportedImpl(impls, [&](const auto& i) {
+			auto output = run(i.impl, log);
+			CHECK(output.muted == expected.muted);
+			REQUIRE(output.samples.size() == expected.samples.size());
+			auto [it1, it2] = std::mismatch(output.samples.begin(), output.samples.end(),
+			                                expected.samples.begin());
+			INFO("seed " << seed << ", first difference at " << (it1 - output.samples.begin()));
+			CHECK(it1 == output.samples.end());
+		});
+	}
+}
+
+// Not run by default, run with:  unittest "[benchmark]"
+TEST_CASE("YMF262: benchmark", "[.benchmark]")
+{
+	auto log = randomYMF262Log(1234, 20000, true);
+	unsigned total = 0;
+	for (const auto& w : log) total += w.samples;
+	forEachSupportedImpl(impls, [&](const auto& i) {
+		auto output = run(i.impl, log);
+		auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(output.time).count();
+		std::cout << "YMF262 " << i.name << ": "
+		          << double(ns) / total << " ns/sample ("
+		          << std::count(output.muted.begin(), output.muted.end(), true)
+		          << " of " << output.muted.size() << " fragments muted)\n";
+	});
+}
@@ -0,0 +1,153 @@
+#include "catch.hpp"
+#include "TestMachine.hh"
+#include "YMF278.hh"
+#include "DeviceConfig.hh"
+#include "HardwareConfig.hh"
+#include "MSXMotherBoard.hh"
+#include "XMLElement.hh"
+#include "xrange.hh"
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace openmsx;
+
+namespace {
+
+struct Result {
+	std::vector<float> samples;
+	std::vector<bool> silent; // per generateInput() call
+};
+
+} // namespace
+
+// A wave ROM with random content (so also random wave headers), the same
+// for each call.
+static std::string writeRandomRom()
+{
+	std::string romFile = TestMachine::getDataDir() + "/yrw801.rom";
+	std::minstd_rand rnd(5678);
+	std::vector<char> rom(0x200000);
+	for (auto& b : rom) b = char(rnd());
+	std::ofstream file(romFile, std::ios::binary);
+	file.write(rom.data(), rom.size());
+	return romFile;
+}
+
+static XMLElement createConfig(const std::string& romFile)
+{
+	XMLElement xml("MoonSound");
+	xml.addChild("rom").addChild("filename", romFile);
+	xml.addChild("sound").addChild("volume", "10000");
+	return xml;
+}
+
+static Result run(TestMachine& machine, const std::string& romFile, bool bulk)
+{
+	YMF278::setBulkEnabled(bulk);
+	auto& board = machine.getMotherBoard();
+	auto xml = createConfig(romFile);
+	DeviceConfig config(*board.getMachineConfig(), xml);
+	YMF278 ymf278("MoonSound", 0, config);
+
+	std::minstd_rand rnd(1234);
+	auto random = [&](unsigned n) { return unsigned(rnd() % n); };
+	EmuTime time = machine.getCurrentTime();
+
+	Result result;
+	alignas(16) float buffer[2 * 1000];
+	for ([[maybe_unused]] auto i : xrange(1500)) {
+		// Random slot registers: the wave headers in the (random) ROM
+		// select random sample formats, addresses, loops and envelopes.
+		// All writes happen at the same moment in time, so the output is
+		// only generated by the generateInput() calls below.
+		for ([[maybe_unused]] auto j : xrange(1 + random(8))) {
+			ymf278.writeReg(uint8_t(0x08 + random(0xF0)), uint8_t(rnd()), time);
+		}
+		// mostly short blocks, sometimes longer than one internal block
+		unsigned num = 1 + (random(4) ? random(50) : random(1000));
+		bool sound = ymf278.generateInput(buffer, num);
+		result.silent.push_back(!sound);
+		if (sound) result.samples.insert(result.samples.end(), buffer, buffer + 2 * num);
+	}
+	YMF278::setBulkEnabled(true);
+	return result;
+}
+
+TEST_CASE("YMF278: bulk generation gives the same result")
+{
+	TestMachine machine("");
+	std::string romFile = writeRandomRom();
+
+	// The same (random) register writes, once with all slots generated
+	// sample per sample and once with each slot generated per block. The
+	// output must be exactly the same.
+	auto slow = run(machine, romFile, false);
+	auto fast = run(machine, romFile, true);
+
+	CHECK(!slow.samples.empty());
+	CHECK(fast.silent == slow.silent);
+	REQUIRE(fast.samples.size() == slow.samples.size());
+	for (auto i : xrange(slow.samples.size())) {
+		INFO("sample " << i);
+		REQUIRE(fast.samples[i] == slow.samples[i]);
+	}
+}
+
+// Not run by default, run with:  unittest "[benchmark]"
+TEST_CASE("YMF278: benchmark", "[.benchmark]")
+{
+	TestMachine machine("");
+	auto& board = machine.getMotherBoard();
+	std::string romFile = writeRandomRom();
+
+	for (bool bulk : {false, true}) {
+		YMF278::setBulkEnabled(bulk);
+		auto xml = createConfig(romFile);
+		DeviceConfig config(*board.getMachineConfig(), xml);
+		YMF278 ymf278("MoonSound", 0, config);
+
+		// All 24 slots keep playing: a random wave (from the random wave
+		// headers) at a random pitch, attack/decay so that the envelope
+		// stays at maximum volume, and for half of the slots LFO
+		// vibrato and tremolo.
+		std::minstd_rand rnd(1234);
+		EmuTime time = machine.getCurrentTime();
+		for (auto s : xrange(24)) {
+			auto write = [&](unsigned group, unsigned value) {
+				ymf278.writeReg(uint8_t(0x08 + group * 24 + s), uint8_t(value), time);
+			};
+			write(0, rnd()); // wave number, loads the header
+			write(1, rnd() & 0xFE); // F-number
+			write(2, rnd() & 0x77); // octave, F-number
+			write(3, 0x01); // total level: loudest, direct
+			write(5, (s & 1) ? (rnd() & 0x3F) : 0); // LFO, vibrato
+			write(6, 0xF0); // attack rate, decay 1 rate
+			write(7, 0x00); // decay level, decay 2 rate
+			write(8, 0x00); // rate correction, release rate
+			write(9, (s & 1) ? (rnd() & 0x07) : 0); // AM
+			write(4, 0x80); // key on
+		}
+
+		// typical size of a mixer fragment
+		static constexpr unsigned NUM = 512;
+		alignas(16) float buffer[2 * NUM];
+		unsigned total = 0;
+		unsigned silent = 0;
+		auto start = std::chrono::steady_clock::now();
+		while (total < 1000000) {
+			silent += !ymf278.generateInput(buffer, NUM);
+			total += NUM;
+		}
+		auto stop = std::chrono::steady_clock::now();
+		CHECK(silent == 0);
+		auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count();
+		std::cout << (bulk ? "per block:  " : "per sample: ")
+		          << double(ns) / total << " ns/sample\n";
+	}
+	YMF278::setBulkEnabled(true);
+}
@@ -1,2 +1,11 @@
-#define CATCH_CONFIG_MAIN
+#define CATCH_CONFIG_RUNNER
 #include "catch.hpp"
+#include "TestMachine.hh"
+
+int main(int argc, char* argv[])
+{
+	openmsx::TestMachine::createDataDir();
+	int result = Catch::Session().run(argc, argv);
+	openmsx::TestMachine::removeDataDir();
+	return result;
+}
@@ -0,0 +1,121 @@
+#ifndef SPSCRINGBUFFER_HH
+#define SPSCRINGBUFFER_HH
+
+#include "MemBuffer.hh"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+namespace openmsx {
+
+/** Lock-free ring buffer between exactly one producer thread and exactly one
+  * consumer thread (e.g. the emulation thread and the audio callback).
+  * Elements are transferred in bulk (with memcpy), so T must be trivially
+  * copyable.
+  *
+  * Both indices only ever increase, the position in the buffer is the index
+  * modulo the capacity. This way a full buffer can be distinguished from an
+  * empty buffer, so the full capacity is usable. Each index is only written
+  * by one side.
+  */
+template<typename T>
+class SPSCRingBuffer
+{
+	static_assert(std::is_trivially_copyable_v<T>);
+
+public:
+	explicit SPSCRingBuffer(size_t capacity_ = 0)
+	{
+		setCapacity(capacity_);
+	}
+
+	/** Change the capacity. This discards the content. Not thread-safe:
+	  * neither the producer nor the consumer may be active.
+	  */
+	void setCapacity(size_t capacity_)
+	{
+		capacity = capacity_;
+		buffer.resize(capacity);
+		clear();
+	}
+
+	/** Discard the content. Same restrictions as setCapacity(). */
+	void clear()
+	{
+		readIdx .store(0, std::memory_order_relaxed);
+		writeIdx.store(0, std::memory_order_relaxed);
+	}
+
+	[[nodiscard]] size_t getCapacity() const { return capacity; }
+
+	/** Number of elements in the buffer. When called from the producer
+	  * (consumer) this is an upper (lower) bound, the other side may
+	  * already have removed (added) elements.
+	  */
+	[[nodiscard]] size_t size() const
+	{
+		auto r = readIdx .load(std::memory_order_acquire);
+		auto w = writeIdx.load(std::memory_order_acquire);
+		return w - r;
+	}
+	[[nodiscard]] size_t getFree() const { return capacity - size(); }
+
+	/** Producer: append (at most) 'num' elements. Returns the number of
+	  * elements actually added, this is less than 'num' when the buffer
+	  * is full.
+	  */
+	size_t push(const T* data, size_t num)
+	{
+		auto w = writeIdx.load(std::memory_order_relaxed); // only written by us
+		auto r = readIdx .load(std::memory_order_acquire);
+		num = std::min(num, capacity - (w - r));
+		copy(data, num, w, [&](size_t pos, const T* src, size_t n) {
+			memcpy(buffer.data() + pos, src, n * sizeof(T));
+		});
+		writeIdx.store(w + num, std::memory_order_release);
+		return num;
+	}
+
+	/** Consumer: remove (at most) 'num' elements. Returns the number of
+	  * elements actually removed, this is less than 'num' when the buffer
+	  * runs empty.
+	  */
+	size_t pop(T* data, size_t num)
+	{
+		auto r = readIdx .load(std::memory_order_relaxed); // only written by us
+		auto w = writeIdx.load(std::memory_order_acquire);
+		num = std::min(num, w - r);
+		copy(data, num, r, [&](size_t pos, T* dst, size_t n) {
+			memcpy(dst, buffer.data() + pos, n * sizeof(T));
+		});
+		readIdx.store(r + num, std::memory_order_release);
+		return num;
+	}
+
+private:
+	// Split a transfer of 'num' elements starting at index 'idx' in (at
+	// most) two contiguous parts.
+	template<typename P, typename F>
+	void copy(P* data, size_t num, size_t idx, F f)
+	{
+		if (num == 0) return;
+		size_t pos = idx % capacity;
+		size_t len1 = std::min(num, capacity - pos);
+		f(pos, data, len1);
+		if (len1 < num) f(0, data + len1, num - len1);
+	}
+
+private:
+	MemBuffer<T> buffer;
+	size_t capacity;
+	// On different cache lines, to avoid false sharing between the
+	// producer and the consumer.
+	alignas(64) std::atomic<size_t> readIdx;  // only written by consumer
+	alignas(64) std::atomic<size_t> writeIdx; // only written by producer
+};
+
+} // namespace openmsx
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef AVX2_HH
+#define AVX2_HH
+
+// Some of the hot loops (sound chip emulation, resampling, scalers) also have
+// an AVX2 version. Those functions are marked with AVX2_TARGET, so they're
+// compiled for AVX2 (and FMA) without requiring these instructions for the
+// rest of the code. They may only be called after checking hasAVX2() at
+// runtime, so that the same binary still runs on CPUs without AVX.
+//
+// When AVX2_TARGET is not defined (no SSE2 build, or a compiler without
+// function specific target attributes) the AVX2 versions are not compiled.
+
+#if defined(__SSE2__) && defined(__GNUC__)
+#define AVX2_TARGET __attribute__((target("avx2,fma")))
+#endif
+
+namespace openmsx {
+
+/** Are the AVX2 versions compiled in and supported by the host CPU? */
+[[nodiscard]] inline bool hasAVX2()
+{
+#ifdef AVX2_TARGET
+	static const bool supported = [] {
+		// might be called before the constructors of the runtime
+		// library have run, e.g. from another static initializer
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+	}();
+	return supported;
+#else
+	return false;
+#endif
+}
+
+} // namespace openmsx
+
+#endif
@@ -1,6 +1,6 @@
 #include "AviRecorder.hh"
 #include "AviWriter.hh"
-#include "WavWriter.hh"
+#include "AsyncWavWriter.hh"
 #include "Reactor.hh"
 #include "MSXMotherBoard.hh"
 #include "FileContext.hh"
@@ -94,7 +94,7 @@ void AviRecorder::start(bool recordAudio, bool recordVideo, bool recordMono,
 		}
 	} else {
 		assert(recordAudio);
-		wavWriter = std::make_unique<Wav16Writer>(
+		wavWriter = std::make_unique<AsyncWav16Writer>(
 			filename, stereo ? 2 : 1, sampleRate);
 	}
 	// only set recorders when all errors are checked for
@@ -116,7 +116,16 @@ void AviRecorder::stop()
 	}
 	sampleRate = 0;
 	aviWriter.reset();
-	wavWriter.reset();
+	if (wavWriter) {
+		auto writer = std::move(wavWriter);
+		try {
+			writer->flush();
+		} catch (MSXException& e) {
+			reactor.getCliComm().printWarning(
+				"Error while writing the audio recording: ",
+				e.getMessage());
+		}
+	}
 }
 
 static int16_t float2int16(float f)
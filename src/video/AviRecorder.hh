@@ -10,6 +10,7 @@
 
 namespace openmsx {
 
+class AsyncWav16Writer;
 class AviWriter;
 class Filename;
 class FrameSource;
@@ -18,7 +19,6 @@ class MSXMixer;
 class PostProcessor;
 class Reactor;
 class TclObject;
-class Wav16Writer;
 
 class AviRecorder
 {
@@ -52,7 +52,7 @@ private:
 
 	std::vector<int16_t> audioBuf;
 	std::unique_ptr<AviWriter>   aviWriter; // can be nullptr
-	std::unique_ptr<Wav16Writer> wavWriter; // can be nullptr
+	std::unique_ptr<AsyncWav16Writer> wavWriter; // can be nullptr
 	std::vector<PostProcessor*> postProcessors;
 	MSXMixer* mixer;
 	EmuDuration duration;
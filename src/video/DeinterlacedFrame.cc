@@ -32,4 +32,9 @@ const void* DeinterlacedFrame::getLineInfo(
 	return fields[line & 1]->getLineInfo(line >> 1, width, buf, bufWidth);
 }
 
+bool DeinterlacedFrame::getLineHash(unsigned line, uint64_t& hash) const
+{
+	return fields[line & 1]->getLineHash(line >> 1, hash);
+}
+
 } // namespace openmsx
@@ -20,6 +20,7 @@ private:
 	[[nodiscard]] const void* getLineInfo(
 		unsigned line, unsigned& width,
 		void* buf, unsigned bufWidth) const override;
+	[[nodiscard]] bool getLineHash(unsigned line, uint64_t& hash) const override;
 
 private:
 	/** The original frames whose data will be deinterlaced.
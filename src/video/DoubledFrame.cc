@@ -35,4 +35,16 @@ const void* DoubledFrame::getLineInfo(
 	}
 }
 
+bool DoubledFrame::getLineHash(unsigned line, uint64_t& hash) const
+{
+	int t = line - skip;
+	if (t >= 0) {
+		return field->getLineHash(t / 2, hash);
+	} else {
+		// The black line above never changes, so any fixed value will do.
+		hash = 0x8C0D0B1E5C6A7D93;
+		return true;
+	}
+}
+
 } // namespace openmsx
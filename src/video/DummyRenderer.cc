@@ -83,6 +83,10 @@ void DummyRenderer::updateVRAM(unsigned /*offset*/, EmuTime::param /*time*/) {
 void DummyRenderer::updateWindow(bool /*enabled*/, EmuTime::param /*time*/) {
 }
 
+bool DummyRenderer::isObserving(unsigned /*address*/, unsigned /*size*/) const {
+	return false;
+}
+
 void DummyRenderer::paint(OutputSurface& /*output*/) {
 }
 
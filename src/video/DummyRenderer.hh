@@ -38,6 +38,7 @@ public:
 	void updateSpritesEnabled(bool enabled, EmuTime::param time) override;
 	void updateVRAM(unsigned offset, EmuTime::param time) override;
 	void updateWindow(bool enabled, EmuTime::param time) override;
+	[[nodiscard]] bool isObserving(unsigned address, unsigned size) const override;
 
 	// Layer interface:
 	void paint(OutputSurface& output) override;
@@ -6,6 +6,7 @@
 #include "Scaler.hh"
 #include "ScalerFactory.hh"
 #include "SDLOutputSurface.hh"
+#include "WorkerPool.hh"
 #include "aligned.hh"
 #include "checked_cast.hh"
 #include "random.hh"
@@ -16,6 +17,7 @@
 #include <cstdint>
 #include <cstddef>
 #include <numeric>
+#include <vector>
 #ifdef __SSE2__
 #include <emmintrin.h>
 #endif
@@ -218,6 +220,39 @@ void FBPostProcessor<Pixel>::drawNoise(OutputSurface& output_)
 	}
 }
 
+template<typename Pixel>
+bool FBPostProcessor<Pixel>::calcGroupHashes(
+	unsigned srcStep, unsigned numGroups, std::vector<uint64_t>& result)
+{
+	// The scalers also look at (at most) 2 lines above and below a group.
+	constexpr int MARGIN = 2;
+	constexpr uint64_t K = 0x9E3779B97F4A7C15ULL;
+
+	int srcHeight = paintFrame->getHeight();
+	std::vector<uint64_t> lineHashes(srcHeight);
+	for (auto y : xrange(srcHeight)) {
+		if (!paintFrame->getLineHash(y, lineHashes[y])) return false;
+	}
+
+	// Settings that are used while scaling are also part of the hash.
+	uint64_t seed = srcStep;
+	seed = seed * K + renderSettings.getScanlineFactor();
+	seed = seed * K + renderSettings.getBlurFactor();
+
+	result.resize(numGroups);
+	for (auto g : xrange(numGroups)) {
+		uint64_t h = seed;
+		int begin = g * srcStep - MARGIN;
+		int end = (g + 1) * srcStep + MARGIN;
+		for (auto y : xrange(begin, end)) {
+			h = (h ^ lineHashes[std::clamp(y, 0, srcHeight - 1)]) * K;
+			h = (h << 27) | (h >> 37);
+		}
+		result[g] = h;
+	}
+	return true;
+}
+
 template<typename Pixel>
 void FBPostProcessor<Pixel>::update(const Setting& setting) noexcept
 {
@@ -270,20 +305,33 @@ void FBPostProcessor<Pixel>::paint(OutputSurface& output_)
 	if (!paintFrame) return;
 
 	// New scaler algorithm selected? Or different horizontal stretch?
+	// Or a different number of threads?
 	auto algo = renderSettings.getScaleAlgorithm();
 	unsigned factor = renderSettings.getScaleFactor();
 	unsigned inWidth = lrintf(renderSettings.getHorizontalStretch());
+	unsigned numThreads = renderSettings.getScaleThreads();
 	if ((scaleAlgorithm != algo) || (scaleFactor != factor) ||
-	    (inWidth != stretchWidth) || (lastOutput != &output)) {
+	    (inWidth != stretchWidth) || (lastOutput != &output) ||
+	    (currScalers.size() != numThreads)) {
 		scaleAlgorithm = algo;
 		scaleFactor = factor;
 		stretchWidth = inWidth;
 		lastOutput = &output;
-		currScaler = ScalerFactory<Pixel>::createScaler(
-			PixelOperations<Pixel>(output.getPixelFormat()),
-			renderSettings);
-		stretchScaler = StretchScalerOutputFactory<Pixel>::create(
-			output, pixelOps, inWidth);
+		currScalers.clear();
+		stretchScalers.clear();
+		groupHashes.clear();
+		for ([[maybe_unused]] auto i : xrange(numThreads)) {
+			currScalers.push_back(ScalerFactory<Pixel>::createScaler(
+				PixelOperations<Pixel>(output.getPixelFormat()),
+				renderSettings));
+			stretchScalers.push_back(StretchScalerOutputFactory<Pixel>::create(
+				output, pixelOps, inWidth));
+		}
+		if (numThreads == 1) {
+			workerPool.reset();
+		} else if (!workerPool || (workerPool->getNumThreads() != numThreads)) {
+			workerPool = std::make_unique<WorkerPool>(numThreads);
+		}
 	}
 
 	// Scale image.
@@ -293,9 +341,29 @@ void FBPostProcessor<Pixel>::paint(OutputSurface& output_)
 	unsigned g = std::gcd(srcHeight, dstHeight);
 	unsigned srcStep = srcHeight / g;
 	unsigned dstStep = dstHeight / g;
+	unsigned numGroups = dstHeight / dstStep;
+
+	// Only scale the groups of lines whose input changed since the last
+	// paint, the output of the other groups is still in the frame buffer.
+	// Not possible when something else is drawn on top of the scaled image.
+	std::vector<uint64_t> newHashes;
+	bool hashed = (renderSettings.getNoise() == 0.0f) &&
+	              !superImposeVideoFrame &&
+	              currScalers[0]->canScaleInBands() &&
+	              calcGroupHashes(srcStep, numGroups, newHashes);
+	bool reuse = hashed && (output.getFrameBufferOwner() == this) &&
+	             (groupHashes.size() == numGroups);
+	auto isDirty = [&](unsigned dstY) {
+		unsigned group = dstY / dstStep;
+		return !reuse || (groupHashes[group] != newHashes[group]);
+	};
 
 	// TODO: Store all MSX lines in RawFrame and only scale the ones that fit
 	//       on the PC screen, as a preparation for resizable output window.
+	struct Region {
+		unsigned srcStartY, srcEndY, lineWidth, dstStartY, dstEndY;
+	};
+	std::vector<Region> regions;
 	unsigned srcStartY = 0;
 	unsigned dstStartY = 0;
 	while (dstStartY < dstHeight) {
@@ -303,29 +371,65 @@ void FBPostProcessor<Pixel>::paint(OutputSurface& output_)
 		// is always >= dstHeight/(dstStep/srcStep).
 		assert(srcStartY < srcHeight);
 
+		if (!isDirty(dstStartY)) {
+			srcStartY += srcStep;
+			dstStartY += dstStep;
+			continue;
+		}
+
 		// get region with equal lineWidth
 		unsigned lineWidth = getLineWidth(paintFrame, srcStartY, srcStep);
 		unsigned srcEndY = srcStartY + srcStep;
 		unsigned dstEndY = dstStartY + dstStep;
 		while ((srcEndY < srcHeight) && (dstEndY < dstHeight) &&
+		       isDirty(dstEndY) &&
 		       (getLineWidth(paintFrame, srcEndY, srcStep) == lineWidth)) {
 			srcEndY += srcStep;
 			dstEndY += dstStep;
 		}
 
-		// fill region
-		//fprintf(stderr, "post processing lines %d-%d: %d\n",
-		//        srcStartY, srcEndY, lineWidth);
-		currScaler->scaleImage(
-			*paintFrame, superImposeVideoFrame,
-			srcStartY, srcEndY, lineWidth, // source
-			*stretchScaler, dstStartY, dstEndY); // dest
+		regions.push_back({srcStartY, srcEndY, lineWidth, dstStartY, dstEndY});
 
 		// next region
 		srcStartY = srcEndY;
 		dstStartY = dstEndY;
 	}
 
+	// fill regions
+	auto scale = [&](unsigned thread, const Region& r) {
+		//fprintf(stderr, "post processing lines %d-%d: %d\n",
+		//        r.srcStartY, r.srcEndY, r.lineWidth);
+		currScalers[thread]->scaleImage(
+			*paintFrame, superImposeVideoFrame,
+			r.srcStartY, r.srcEndY, r.lineWidth, // source
+			*stretchScalers[thread], r.dstStartY, r.dstEndY); // dest
+	};
+	if (workerPool && currScalers[0]->canScaleInBands()) {
+		// Split the output in horizontal bands of (about) equal height,
+		// one per thread. The band borders are multiples of
+		// srcStep/dstStep lines, so each band scales whole groups of
+		// lines (and regions get split the same way).
+		workerPool->parallelFor(numThreads, [&](unsigned band) {
+			unsigned bandBegin = numGroups * band / numThreads;
+			unsigned bandEnd = numGroups * (band + 1) / numThreads;
+			for (const auto& r : regions) {
+				unsigned begin = std::max(bandBegin, r.dstStartY / dstStep);
+				unsigned end = std::min(bandEnd, r.dstEndY / dstStep);
+				if (begin >= end) continue;
+				scale(band, {begin * srcStep, end * srcStep, r.lineWidth,
+				             begin * dstStep, end * dstStep});
+			}
+		});
+	} else {
+		for (const auto& r : regions) scale(0, r);
+	}
+	if (hashed) {
+		groupHashes.swap(newHashes);
+	} else {
+		groupHashes.clear();
+	}
+	output.setFrameBufferOwner(this);
+
 	drawNoise(output);
 
 	output.flushFrameBuffer();
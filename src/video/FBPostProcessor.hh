@@ -5,12 +5,15 @@
 #include "RenderSettings.hh"
 #include "PixelOperations.hh"
 #include "ScalerOutput.hh"
+#include <cstdint>
+#include <memory>
 #include <vector>
 
 namespace openmsx {
 
 class MSXMotherBoard;
 class Display;
+class WorkerPool;
 template<typename Pixel> class Scaler;
 
 /** Rasterizer using SDL.
@@ -38,18 +41,27 @@ private:
 	void drawNoise(OutputSurface& output);
 	void drawNoiseLine(Pixel* buf, signed char* noise,
 	                   size_t width);
+	[[nodiscard]] bool calcGroupHashes(
+		unsigned srcStep, unsigned numGroups, std::vector<uint64_t>& result);
 
 	// Observer<Setting>
 	void update(const Setting& setting) noexcept override;
 
 private:
-	/** The currently active scaler.
+	/** The currently active scaler, one instance per thread (the scalers
+	  * have internal state).
 	  */
-	std::unique_ptr<Scaler<Pixel>> currScaler;
+	std::vector<std::unique_ptr<Scaler<Pixel>>> currScalers;
 
-	/** The currently active stretch-scaler (horizontal stretch setting).
+	/** The currently active stretch-scaler (horizontal stretch setting),
+	  * also one per thread (they contain line buffers).
 	 */
-	std::unique_ptr<ScalerOutput<Pixel>> stretchScaler;
+	std::vector<std::unique_ptr<ScalerOutput<Pixel>>> stretchScalers;
+
+	/** Threads to scale the image in bands ('scale_threads' setting),
+	  * nullptr when only the main thread is used.
+	  */
+	std::unique_ptr<WorkerPool> workerPool;
 
 	/** Currently active scale algorithm, used to detect scaler changes.
 	  */
@@ -67,6 +79,13 @@ private:
 	  */
 	OutputSurface* lastOutput = nullptr;
 
+	/** For each group of srcStep input lines (scaled to dstStep output
+	  * lines): a hash of everything the output of that group depends on,
+	  * as it was at the last paint. Groups with unchanged hashes don't
+	  * need to be scaled again. Empty when the output can't be reused.
+	  */
+	std::vector<uint64_t> groupHashes;
+
 	/** Remember the noise values to get a stable image when paused.
 	 */
 	std::vector<unsigned> noiseShift;
@@ -6,6 +6,7 @@
 #include "xrange.hh"
 #include <algorithm>
 #include <cassert>
+#include <cstdint>
 
 namespace openmsx {
 
@@ -155,6 +156,16 @@ public:
 		unsigned line, unsigned& lineWidth,
 		void* buf, unsigned bufWidth) const = 0;
 
+	/** Get a hash of the content (width and pixels) of the given line.
+	  * Lines with equal hashes have (with very high probability) the same
+	  * content, this allows to skip work for unchanged lines.
+	  * @return false when no hashes are available for this frame.
+	  */
+	[[nodiscard]] virtual bool getLineHash(
+		unsigned /*line*/, uint64_t& /*hash*/) const {
+		return false;
+	}
+
 	/** Get a pointer to a given line in this frame, the frame is scaled
 	  * to 320x240 pixels. The difference between this method and
 	  * getLinePtr() is that this method also does vertical scaling.
@@ -489,16 +489,8 @@ inline bool PixelRenderer::checkSync(int offset, EmuTime::param time)
 			// TODO could be improved
 			return true;
 		}
-		// Is the address inside the visual page(s)?
 		// TODO: Also look at which lines are touched inside pages.
-		int visiblePage = vram.nameTable.getMask()
-			& (0x10000 | (vdp.getEvenOddMask() << 7));
-		if (vdp.isMultiPageScrolling()) {
-			return (offset & 0x18000) == visiblePage
-				|| (offset & 0x18000) == (visiblePage & 0x10000);
-		} else {
-			return (offset & 0x18000) == visiblePage;
-		}
+		return isVisiblePage(offset);
 	}
 	case DisplayMode::GRAPHIC6:
 	case DisplayMode::GRAPHIC7:
@@ -511,6 +503,38 @@ inline bool PixelRenderer::checkSync(int offset, EmuTime::param time)
 	}
 }
 
+inline bool PixelRenderer::isVisiblePage(unsigned address) const
+{
+	unsigned visiblePage = vram.nameTable.getMask()
+		& (0x10000 | (vdp.getEvenOddMask() << 7));
+	if (vdp.isMultiPageScrolling()) {
+		return (address & 0x18000) == visiblePage
+			|| (address & 0x18000) == (visiblePage & 0x10000);
+	} else {
+		return (address & 0x18000) == visiblePage;
+	}
+}
+
+bool PixelRenderer::isObserving(unsigned address, unsigned size) const
+{
+	// This must return true whenever checkSync() could return true for
+	// some address in the range, at any moment in time.
+	if (!renderFrame || !displayEnabled) return false;
+	if (accuracy == RenderSettings::ACC_SCREEN) return false;
+	switch (vdp.getDisplayMode().getBase()) {
+	case DisplayMode::GRAPHIC4:
+	case DisplayMode::GRAPHIC5: {
+		if (vdp.isFastBlinkEnabled()) return true;
+		unsigned last = address + size - 1;
+		if ((address ^ last) & ~0x7FFF) return true; // spans pages
+		return isVisiblePage(address);
+	}
+	default:
+		// Other modes: the exact check depends on the time.
+		return true;
+	}
+}
+
 void PixelRenderer::updateVRAM(unsigned offset, EmuTime::param time)
 {
 	// Note: No need to sync if display is disabled, because then the
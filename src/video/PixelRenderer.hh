@@ -59,6 +59,7 @@ public:
 	void updateSpritesEnabled(bool enabled, EmuTime::param time) override;
 	void updateVRAM(unsigned offset, EmuTime::param time) override;
 	void updateWindow(bool enabled, EmuTime::param time) override;
+	[[nodiscard]] bool isObserving(unsigned address, unsigned size) const override;
 
 private:
 	/** Indicates whether the area to be drawn is border or display. */
@@ -87,6 +88,12 @@ private:
 
 	[[nodiscard]] inline bool checkSync(int offset, EmuTime::param time);
 
+	/** In GRAPHIC4/5 mode: is the given address inside the visible
+	  * page(s)?
+	  * @pre !vdp.isFastBlinkEnabled()
+	  */
+	[[nodiscard]] inline bool isVisiblePage(unsigned address) const;
+
 	/** Update renderer state to specified moment in time.
 	  * @param time Moment in emulated time to update to.
 	  * @param force When screen accuracy is used,
@@ -1,5 +1,6 @@
 #include "RawFrame.hh"
 #include <cstdint>
+#include <cstring>
 
 namespace openmsx {
 
@@ -7,6 +8,7 @@ RawFrame::RawFrame(
 		const PixelFormat& format, unsigned maxWidth_, unsigned height_)
 	: FrameSource(format)
 	, lineWidths(height_)
+	, lineHashes(height_)
 	, maxWidth(maxWidth_)
 {
 	setHeight(height_);
@@ -51,6 +53,50 @@ unsigned RawFrame::getRowLength() const
 	return maxWidth; // in pixels (not in bytes)
 }
 
+// Fast (non-cryptographic) 64-bit hash, only used to detect changed lines.
+static uint64_t hashLine(const char* data, size_t size, unsigned width)
+{
+	constexpr uint64_t K1 = 0x9E3779B97F4A7C15ULL;
+	constexpr uint64_t K2 = 0xC2B2AE3D27D4EB4FULL;
+	auto mix = [](uint64_t h, uint64_t w) {
+		h ^= w * K1;
+		h = (h << 31) | (h >> 33);
+		return h * K2;
+	};
+	uint64_t h = mix(0, width);
+	size_t i = 0;
+	for (/**/; (i + 8) <= size; i += 8) {
+		uint64_t w;
+		memcpy(&w, data + i, 8);
+		h = mix(h, w);
+	}
+	if (i < size) {
+		uint64_t w = 0;
+		memcpy(&w, data + i, size - i);
+		h = mix(h, w);
+	}
+	return h ^ (h >> 29);
+}
+
+void RawFrame::calcLineHashes()
+{
+	unsigned bytesPerPixel = getPixelFormat().getBytesPerPixel();
+	for (auto line : xrange(getHeight())) {
+		unsigned width = lineWidths[line];
+		lineHashes[line] = hashLine(data.data() + line * pitch,
+		                            width * bytesPerPixel, width);
+	}
+	lineHashesValid = true;
+}
+
+bool RawFrame::getLineHash(unsigned line, uint64_t& hash) const
+{
+	assert(line < getHeight());
+	if (!lineHashesValid) return false;
+	hash = lineHashes[line];
+	return true;
+}
+
 bool RawFrame::hasContiguousStorage() const
 {
 	return true;
@@ -4,6 +4,7 @@
 #include "FrameSource.hh"
 #include "MemBuffer.hh"
 #include <cassert>
+#include <cstdint>
 
 namespace openmsx {
 
@@ -15,6 +16,20 @@ class RawFrame final : public FrameSource
 public:
 	RawFrame(const PixelFormat& format, unsigned maxWidth, unsigned height);
 
+	/** (Re)initialize this frame before rendering a new image in it.
+	  * This also invalidates the line hashes.
+	  */
+	void init(FieldType fieldType_) {
+		FrameSource::init(fieldType_);
+		lineHashesValid = false;
+	}
+
+	/** Calculate the hashes for getLineHash(). Should be called once the
+	  * frame is completely rendered, the hashes remain valid till the next
+	  * call to init().
+	  */
+	void calcLineHashes();
+
 	template<typename Pixel>
 	[[nodiscard]] Pixel* getLinePtrDirect(unsigned y) {
 		return reinterpret_cast<Pixel*>(data.data() + y * pitch);
@@ -39,6 +54,7 @@ public:
 	}
 
 	[[nodiscard]] unsigned getRowLength() const override;
+	[[nodiscard]] bool getLineHash(unsigned line, uint64_t& hash) const override;
 
 protected:
 	[[nodiscard]] unsigned getLineWidth(unsigned line) const override;
@@ -50,8 +66,10 @@ protected:
 private:
 	MemBuffer<char, 64> data;
 	MemBuffer<unsigned> lineWidths;
+	MemBuffer<uint64_t> lineHashes;
 	unsigned maxWidth;
 	unsigned pitch;
+	bool lineHashesValid = false;
 };
 
 } // namespace openmsx
@@ -117,6 +117,11 @@ RenderSettings::RenderSettings(CommandController& commandController)
 		"scale_factor", "scale factor",
 		std::min(2, MAX_SCALE_FACTOR), MIN_SCALE_FACTOR, MAX_SCALE_FACTOR)
 
+	, scaleThreadsSetting(commandController,
+		"scale_threads", "number of threads used to scale the image "
+		"in the SDL renderer, the image is split in horizontal bands",
+		1, 1, 16)
+
 	, scanlineAlphaSetting(commandController,
 		"scanline", "amount of scanline effect: 0 = none, 100 = full",
 		20, 0, 100)
@@ -119,6 +119,9 @@ public:
 	[[nodiscard]] IntegerSetting& getScaleFactorSetting() { return scaleFactorSetting; }
 	[[nodiscard]] int getScaleFactor() const { return scaleFactorSetting.getInt(); }
 
+	/** The number of threads used to scale the image (SDL renderer). */
+	[[nodiscard]] unsigned getScaleThreads() const { return scaleThreadsSetting.getInt(); }
+
 	/** Limit number of sprites per line?
 	  * If true, limit number of sprites per line as real VDP does.
 	  * If false, display all sprites.
@@ -220,6 +223,7 @@ private:
 	IntegerSetting horizontalBlurSetting;
 	EnumSetting<ScaleAlgorithm> scaleAlgorithmSetting;
 	IntegerSetting scaleFactorSetting;
+	IntegerSetting scaleThreadsSetting;
 	IntegerSetting scanlineAlphaSetting;
 	BooleanSetting limitSpritesSetting;
 	BooleanSetting disableSpritesSetting;
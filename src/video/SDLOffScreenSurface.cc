@@ -43,6 +43,7 @@ void SDLOffScreenSurface::saveScreenshot(const std::string& filename)
 void SDLOffScreenSurface::clearScreen()
 {
 	memset(surface->pixels, 0, uint32_t(surface->pitch) * surface->h);
+	setFrameBufferOwner(nullptr);
 }
 
 } // namespace openmsx
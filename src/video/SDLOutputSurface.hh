@@ -61,6 +61,13 @@ public:
 	 */
 	virtual void clearScreen() {}
 
+	/** Who painted the current content of the frame buffer (nullptr when
+	  * unknown). A layer that only repaints the changed parts of its image
+	  * must check that it was also the last one that painted.
+	  */
+	void setFrameBufferOwner(const void* owner) { frameBufferOwner = owner; }
+	[[nodiscard]] const void* getFrameBufferOwner() const { return frameBufferOwner; }
+
 protected:
 	SDLOutputSurface() = default;
 
@@ -71,6 +78,7 @@ protected:
 private:
 	SDL_Surface* surface = nullptr;
 	SDL_Renderer* renderer = nullptr;
+	const void* frameBufferOwner = nullptr;
 };
 
 } // namespace openmsx
@@ -170,6 +170,8 @@ void SDLRasterizer<Pixel>::frameStart(EmuTime::param time)
 template<typename Pixel>
 void SDLRasterizer<Pixel>::frameEnd()
 {
+	// Allows the post processor to skip unchanged lines.
+	workFrame->calcLineHashes();
 }
 
 template<typename Pixel>
@@ -132,6 +132,7 @@ void SDLVisibleSurface::saveScreenshotSDL(
 void SDLVisibleSurface::clearScreen()
 {
 	SDL_FillRect(surface.get(), nullptr, 0);
+	setFrameBufferOwner(nullptr);
 }
 
 void SDLVisibleSurface::fullScreenUpdated(bool /*fullscreen*/)
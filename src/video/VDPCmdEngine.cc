@@ -41,6 +41,7 @@ TODO:
 #include <algorithm>
 #include <cassert>
 #include <iostream>
+#include <type_traits>
 
 using std::min;
 using std::max;
@@ -171,6 +172,7 @@ struct Graphic4Mode
 	static constexpr byte PIXELS_PER_BYTE = 2;
 	static constexpr byte PIXELS_PER_BYTE_SHIFT = 1;
 	static constexpr unsigned PIXELS_PER_LINE = 256;
+	static constexpr bool PLANAR = false;
 	static inline unsigned addressOf(unsigned x, unsigned y, bool extVRAM);
 	static inline byte point(VDPVRAM& vram, unsigned x, unsigned y, bool extVRAM);
 	template<typename LogOp>
@@ -221,6 +223,7 @@ struct Graphic5Mode
 	static constexpr byte PIXELS_PER_BYTE = 4;
 	static constexpr byte PIXELS_PER_BYTE_SHIFT = 2;
 	static constexpr unsigned PIXELS_PER_LINE = 512;
+	static constexpr bool PLANAR = false;
 	static inline unsigned addressOf(unsigned x, unsigned y, bool extVRAM);
 	static inline byte point(VDPVRAM& vram, unsigned x, unsigned y, bool extVRAM);
 	template<typename LogOp>
@@ -273,6 +276,7 @@ struct Graphic6Mode
 	static constexpr byte PIXELS_PER_BYTE = 2;
 	static constexpr byte PIXELS_PER_BYTE_SHIFT = 1;
 	static constexpr unsigned PIXELS_PER_LINE = 512;
+	static constexpr bool PLANAR = true;
 	static inline unsigned addressOf(unsigned x, unsigned y, bool extVRAM);
 	static inline byte point(VDPVRAM& vram, unsigned x, unsigned y, bool extVRAM);
 	template<typename LogOp>
@@ -323,6 +327,7 @@ struct Graphic7Mode
 	static constexpr byte PIXELS_PER_BYTE = 1;
 	static constexpr byte PIXELS_PER_BYTE_SHIFT = 0;
 	static constexpr unsigned PIXELS_PER_LINE = 256;
+	static constexpr bool PLANAR = true;
 	static inline unsigned addressOf(unsigned x, unsigned y, bool extVRAM);
 	static inline byte point(VDPVRAM& vram, unsigned x, unsigned y, bool extVRAM);
 	template<typename LogOp>
@@ -371,6 +376,7 @@ struct NonBitmapMode
 	static constexpr byte PIXELS_PER_BYTE = 1;
 	static constexpr byte PIXELS_PER_BYTE_SHIFT = 0;
 	static constexpr unsigned PIXELS_PER_LINE = 256;
+	static constexpr bool PLANAR = false;
 	static inline unsigned addressOf(unsigned x, unsigned y, bool extVRAM);
 	static inline byte point(VDPVRAM& vram, unsigned x, unsigned y, bool extVRAM);
 	template<typename LogOp>
@@ -717,6 +723,160 @@ using TXorOp = TransparentOp<XorOp>;
 using TNotOp = TransparentOp<NotOp>;
 
 
+// Fast paths for the block commands:
+//
+// Normally the commands access VRAM one byte (or pixel) at a time, and each
+// write is notified (at the exact moment in time) to the renderer and the
+// sprite checker. However when no observer is interested in a part of a line
+// (e.g. the command works on a page that is not displayed), only the timing
+// of the accesses is calculated and afterwards all bytes are written at once.
+
+/** The bytes in columns [col, col + num) of line 'y' in a bitmap mode
+  * (without extended VRAM). In the planar modes even and odd columns are
+  * stored in different halves of VRAM. Block 'i' contains the bytes at
+  * offsets i, i+2, i+4, ... (planar) or all bytes (non-planar), so this is
+  * one or two blocks that are each contiguous in VRAM.
+  */
+struct LineBlocks
+{
+	unsigned addr[2];
+	unsigned size[2];
+};
+
+template<typename Mode>
+static LineBlocks getLineBlocks(unsigned col, unsigned num, unsigned y)
+{
+	constexpr unsigned SHIFT = Mode::PIXELS_PER_BYTE_SHIFT;
+	if constexpr (Mode::PLANAR) {
+		return {{Mode::addressOf((col + 0) << SHIFT, y, false),
+		         Mode::addressOf((col + 1) << SHIFT, y, false)},
+		        {(num + 1) / 2, num / 2}};
+	} else {
+		return {{Mode::addressOf(col << SHIFT, y, false), 0},
+		        {num, 0}};
+	}
+}
+
+/** Like above, but for 'num' bytes starting at pixel 'x' in direction 'tx'.
+  */
+template<typename Mode>
+static LineBlocks getLineBlocks(unsigned x, unsigned num, int tx, unsigned y)
+{
+	unsigned col = x >> Mode::PIXELS_PER_BYTE_SHIFT;
+	if (tx < 0) col -= num - 1;
+	return getLineBlocks<Mode>(col, num, y);
+}
+
+static bool canWriteLine(const VDPVRAM& vram, const LineBlocks& dst)
+{
+	for (auto i : {0, 1}) {
+		if (dst.size[i] && !vram.cmdCanWriteBlock(dst.addr[i], dst.size[i])) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool canCopyLine(const VDPVRAM& vram, const LineBlocks& src, const LineBlocks& dst)
+{
+	if (!canWriteLine(vram, dst)) return false;
+	for (auto i : {0, 1}) {
+		if (!src.size[i]) continue;
+		if (!vram.cmdCanReadBlock(src.addr[i], src.size[i])) return false;
+		for (auto j : {0, 1}) {
+			if (dst.size[j] && vram.cmdBlocksOverlap(
+				src.addr[i], src.size[i], dst.addr[j], dst.size[j])) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+static void fillLine(VDPVRAM& vram, const LineBlocks& dst, byte value)
+{
+	for (auto i : {0, 1}) {
+		if (dst.size[i]) vram.cmdFillBlock(dst.addr[i], dst.size[i], value);
+	}
+}
+
+static void copyLine(VDPVRAM& vram, const LineBlocks& src, const LineBlocks& dst)
+{
+	for (auto i : {0, 1}) {
+		if (src.size[i]) vram.cmdCopyBlock(src.addr[i], dst.addr[i], src.size[i]);
+	}
+}
+
+/** Set the pixels [x, x + num) of line 'y' to 'color'. Only allowed when
+  * canWriteLine() is true for the corresponding bytes.
+  */
+template<typename Mode>
+static void fillPixels(EmuTime::param time, VDPVRAM& vram,
+                       unsigned x, unsigned num, unsigned y, byte color)
+{
+	constexpr unsigned PPB = Mode::PIXELS_PER_BYTE;
+	constexpr unsigned SHIFT = Mode::PIXELS_PER_BYTE_SHIFT;
+	auto pset = [&](unsigned px) {
+		unsigned addr = Mode::addressOf(px, y, false);
+		Mode::pset(time, vram, px, addr, vram.cmdWriteWindow.readNP(addr),
+		           color, ImpOp());
+	};
+	// Partially covered bytes at the start and at the end of the range
+	// are written per pixel, the other bytes in one go.
+	unsigned end = x + num;
+	unsigned fullBegin = min(end, (x + PPB - 1) & ~(PPB - 1));
+	unsigned fullEnd   = max(fullBegin, end & ~(PPB - 1));
+	for (unsigned px = x; px < fullBegin; ++px) pset(px);
+	if (fullBegin < fullEnd) {
+		fillLine(vram, getLineBlocks<Mode>(fullBegin >> SHIFT,
+		                                   (fullEnd - fullBegin) >> SHIFT, y),
+		         Mode::duplicate(color));
+	}
+	for (unsigned px = fullEnd; px < end; ++px) pset(px);
+}
+
+/** Calculate the timing of (at most) 'num' accesses, each 'delta' apart,
+  * without actually doing them. Returns the number of accesses that happen
+  * before the limit. Afterwards the calculator is positioned one 'delta'
+  * after the last access, like in the regular command loops.
+  */
+static unsigned countSlots(Calculator& calculator, unsigned num, Delta delta)
+{
+	unsigned n = 0;
+	while (n < num) {
+		assert(!calculator.limitReached());
+		++n;
+		calculator.next(delta);
+		if (calculator.limitReached()) break;
+	}
+	return n;
+}
+
+/** Like above, but for commands that do a read followed by a write per byte
+  * (or pixel). Returns the number of complete read+write pairs. When after
+  * those there was still time for a read, but not for the corresponding
+  * write, 'readPending' is set to true.
+  */
+static unsigned countSlots(Calculator& calculator, unsigned num,
+                           Delta readDelta, Delta writeDelta, bool& readPending)
+{
+	unsigned n = 0;
+	readPending = false;
+	while (n < num) {
+		assert(!calculator.limitReached());
+		calculator.next(readDelta);
+		if (calculator.limitReached()) {
+			readPending = true;
+			break;
+		}
+		++n;
+		calculator.next(writeDelta);
+		if (calculator.limitReached()) break;
+	}
+	return n;
+}
+
+
 // Commands
 
 void VDPCmdEngine::setStatusChangeTime(EmuTime::param t)
@@ -976,6 +1136,36 @@ void VDPCmdEngine::executeLmmv(EmuTime::param limit)
 	switch (phase) {
 	case 0:
 loop:		if (unlikely(calculator.limitReached())) { phase = 0; break; }
+		if constexpr (std::is_same_v<LogOp, ImpOp> ||
+		              std::is_same_v<LogOp, TImpOp>) {
+			if ((ANX > 1) && likely(!dstExt)) {
+				// The last pixel of the line always takes the
+				// regular path below, that handles the end-of-line.
+				unsigned x = (TX > 0) ? ADX : ADX - (ANX - 2);
+				unsigned lastX = x + (ANX - 2);
+				unsigned col = x >> Mode::PIXELS_PER_BYTE_SHIFT;
+				unsigned numCol = (lastX >> Mode::PIXELS_PER_BYTE_SHIFT) - col + 1;
+				if (canWriteLine(vram, getLineBlocks<Mode>(col, numCol, DY))) {
+					// no observers, so the exact time doesn't matter
+					EmuTime time = calculator.getTime();
+					bool readPending;
+					unsigned num = countSlots(calculator, ANX - 1,
+					                          DELTA_24, DELTA_72, readPending);
+					// TImp with color 0 doesn't write anything
+					if (std::is_same_v<LogOp, ImpOp> || CL) {
+						unsigned first = (TX > 0) ? ADX : ADX - (num - 1);
+						fillPixels<Mode>(time, vram, first, num, DY, CL);
+					}
+					ADX += num * TX;
+					ANX -= num;
+					addr = Mode::addressOf(ADX, DY, false);
+					if (!readPending) goto loop;
+					tmpDst = vram.cmdWriteWindow.readNP(addr);
+					phase = 1;
+					break;
+				}
+			}
+		}
 		if (likely(doPset)) {
 			tmpDst = vram.cmdWriteWindow.readNP(addr);
 		}
@@ -1351,6 +1541,18 @@ void VDPCmdEngine::executeHmmv(EmuTime::param limit)
 	auto calculator = getSlotCalculator(limit);
 
 	while (!calculator.limitReached()) {
+		if ((ANX > 1) && likely(!dstExt)) {
+			// The last byte of the line always takes the regular
+			// path below, that handles the end-of-line.
+			auto dst = getLineBlocks<Mode>(ADX, ANX - 1, TX, DY);
+			if (canWriteLine(vram, dst)) {
+				unsigned num = countSlots(calculator, ANX - 1, DELTA_48);
+				fillLine(vram, getLineBlocks<Mode>(ADX, num, TX, DY), COL);
+				ADX += num * TX;
+				ANX -= num;
+				continue;
+			}
+		}
 		if (likely(doPset)) {
 			vram.cmdWrite(Mode::addressOf(ADX, DY, dstExt),
 			              COL, calculator.getTime());
@@ -1461,6 +1663,26 @@ void VDPCmdEngine::executeHmmm(EmuTime::param limit)
 	switch (phase) {
 	case 0:
 loop:		if (unlikely(calculator.limitReached())) { phase = 0; break; }
+		if ((ANX > 1) && likely(!srcExt && !dstExt)) {
+			// The last byte of the line always takes the regular
+			// path below, that handles the end-of-line.
+			auto src = getLineBlocks<Mode>(ASX, ANX - 1, TX, SY);
+			auto dst = getLineBlocks<Mode>(ADX, ANX - 1, TX, DY);
+			if (canCopyLine(vram, src, dst)) {
+				bool readPending;
+				unsigned num = countSlots(calculator, ANX - 1,
+				                          DELTA_24, DELTA_64, readPending);
+				copyLine(vram, getLineBlocks<Mode>(ASX, num, TX, SY),
+				               getLineBlocks<Mode>(ADX, num, TX, DY));
+				ASX += num * TX; ADX += num * TX;
+				ANX -= num;
+				if (!readPending) goto loop;
+				tmpSrc = vram.cmdReadWindow.readNP(
+					Mode::addressOf(ASX, SY, false));
+				phase = 1;
+				break;
+			}
+		}
 		tmpSrc = likely(doPoint)
 			? vram.cmdReadWindow.readNP(
 			       Mode::addressOf(ASX, SY, srcExt))
@@ -1595,6 +1817,26 @@ void VDPCmdEngine::executeYmmm(EmuTime::param limit)
 	switch (phase) {
 	case 0:
 loop:		if (unlikely(calculator.limitReached())) { phase = 0; break; }
+		if ((ANX > 1) && likely(!dstExt)) {
+			// The last byte of the line always takes the regular
+			// path below, that handles the end-of-line.
+			auto src = getLineBlocks<Mode>(ADX, ANX - 1, TX, SY);
+			auto dst = getLineBlocks<Mode>(ADX, ANX - 1, TX, DY);
+			if (canCopyLine(vram, src, dst)) {
+				bool readPending;
+				unsigned num = countSlots(calculator, ANX - 1,
+				                          DELTA_24, DELTA_40, readPending);
+				copyLine(vram, getLineBlocks<Mode>(ADX, num, TX, SY),
+				               getLineBlocks<Mode>(ADX, num, TX, DY));
+				ADX += num * TX;
+				ANX -= num;
+				if (!readPending) goto loop;
+				tmpSrc = vram.cmdReadWindow.readNP(
+					Mode::addressOf(ADX, SY, false));
+				phase = 1;
+				break;
+			}
+		}
 		if (likely(doPset)) {
 			tmpSrc = vram.cmdReadWindow.readNP(
 			       Mode::addressOf(ADX, SY, dstExt));
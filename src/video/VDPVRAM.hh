@@ -10,6 +10,7 @@
 #include "openmsx.hh"
 #include "likely.hh"
 #include <cassert>
+#include <cstring>
 
 namespace openmsx {
 
@@ -298,6 +299,26 @@ public:
 		return (address & combiMask) == unsigned(baseAddr);
 	}
 
+	/** Might a change in the address range [address, address + size) have
+	  * to be notified to the observer of this window? This is a
+	  * conservative check: it can return true for a range that is not
+	  * actually inside this window, but when it returns false none of the
+	  * addresses is inside, or the observer isn't interested in the
+	  * range (see VRAMObserver::isObserving()), or there is no observer.
+	  * @param address The first address of the range.
+	  * @param size The size of the range, must be at least 1.
+	  */
+	[[nodiscard]] inline bool mayNotify(unsigned address, unsigned size) const {
+		assert(size != 0);
+		if (!hasObserver()) return false;
+		unsigned areaBits = Math::floodRight(address ^ (address + size - 1));
+		if (((address & combiMask) & ~areaBits) !=
+		    (unsigned(baseAddr) & ~areaBits)) {
+			return false;
+		}
+		return observer->isObserving(address, size);
+	}
+
 	/** Notifies the observer of this window of a VRAM change,
 	  * if the changes address is inside this window.
 	  * @param address The address to test.
@@ -430,6 +451,63 @@ public:
 		writeCommon(address, value, time);
 	}
 
+	/** Can the command engine access the range [address, address + size)
+	  * as a single block? This requires that the range is not split by
+	  * VRAM mirroring and that it's entirely present in VRAM.
+	  */
+	[[nodiscard]] inline bool cmdCanReadBlock(unsigned address, unsigned size) const {
+		assert(size != 0);
+		unsigned end = address + size - 1;
+		if ((address ^ end) & ~sizeMask) return false;
+		return ((address & sizeMask) + size) <= actualSize;
+	}
+
+	/** Like cmdCanReadBlock(), but additionally none of the observed VRAM
+	  * windows may overlap with the range. This means none of the
+	  * observers needs to be notified of the writes, so it doesn't matter
+	  * at what exact moment in time they happen.
+	  */
+	[[nodiscard]] inline bool cmdCanWriteBlock(unsigned address, unsigned size) const {
+		if (!cmdCanReadBlock(address, size)) return false;
+		address &= sizeMask;
+		return !bitmapVisibleWindow.mayNotify(address, size) &&
+		       !spriteAttribTable  .mayNotify(address, size) &&
+		       !spritePatternTable .mayNotify(address, size);
+	}
+
+	/** Do the given blocks (see cmdCanReadBlock()) overlap in VRAM?
+	  */
+	[[nodiscard]] inline bool cmdBlocksOverlap(
+			unsigned address1, unsigned size1,
+			unsigned address2, unsigned size2) const {
+		address1 &= sizeMask;
+		address2 &= sizeMask;
+		return (address1 < (address2 + size2)) &&
+		       (address2 < (address1 + size1));
+	}
+
+	/** Fill a block of VRAM from the command engine. Equivalent to, but a
+	  * lot faster than, a sequence of cmdWrite() calls. Only allowed when
+	  * cmdCanWriteBlock() is true for this block.
+	  */
+	inline void cmdFillBlock(unsigned address, unsigned size, byte value) {
+		assert(cmdCanWriteBlock(address, size));
+		memset(&data[address & sizeMask], value, size);
+	}
+
+	/** Copy a block of VRAM from the command engine. Equivalent to a
+	  * sequence of cmdReadWindow.readNP() and cmdWrite() calls. The
+	  * destination must be a valid block for cmdCanWriteBlock(), the
+	  * source for cmdCanReadBlock(), and they may not overlap.
+	  */
+	inline void cmdCopyBlock(unsigned srcAddress, unsigned dstAddress, unsigned size) {
+		assert(cmdCanReadBlock (srcAddress, size));
+		assert(cmdCanWriteBlock(dstAddress, size));
+		assert(!cmdBlocksOverlap(srcAddress, size, dstAddress, size));
+		memcpy(&data[dstAddress & sizeMask],
+		       &data[srcAddress & sizeMask], size);
+	}
+
 	/** Write a byte to VRAM through the CPU interface.
 	  * @param address The address to write.
 	  * @param value The value to write.
@@ -35,6 +35,21 @@ public:
 	  */
 	virtual void updateWindow(bool enabled, EmuTime::param time) = 0;
 
+	/** Does this observer want to be informed about changes in the
+	  * given range (with updateVRAM())? This allows to skip the
+	  * notifications for a whole block of writes (see
+	  * VDPVRAM::cmdCanWriteBlock()). The answer may only depend on the
+	  * current state of the observer, not on the moment in time of the
+	  * change, and it must remain valid until the observer is notified
+	  * of some other change (VDP register, window move, ...).
+	  * The default implementation conservatively returns true.
+	  * @param address The VRAM address of the first byte of the range.
+	  * @param size The number of bytes in the range, at least 1.
+	  */
+	[[nodiscard]] virtual bool isObserving(unsigned /*address*/, unsigned /*size*/) const {
+		return true;
+	}
+
 protected:
 	~VRAMObserver() = default;
 };
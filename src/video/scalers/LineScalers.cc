@@ -0,0 +1,237 @@
+#include "LineScalers.hh"
+#include "ScalerAVX2.hh"
+#include "avx2.hh"
+#include "build-info.hh"
+#include "unreachable.hh"
+#include <array>
+#include <cstddef>
+#ifdef AVX2_TARGET
+#include <immintrin.h>
+#endif
+
+namespace openmsx {
+
+bool ScalerAVX2::enabled = ScalerAVX2::isSupported();
+
+bool ScalerAVX2::isSupported()
+{
+	return hasAVX2();
+}
+
+#ifdef AVX2_TARGET
+
+AVX2_TARGET [[nodiscard]] static inline __m256i load(const char* p)
+{
+	return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+}
+AVX2_TARGET static inline void store(char* p, __m256i x)
+{
+	_mm256_storeu_si256(reinterpret_cast<__m256i*>(p), x);
+}
+
+template<typename Pixel>
+AVX2_TARGET static inline __m256i unpacklo(__m256i x, __m256i y)
+{
+	if (sizeof(Pixel) == 4) {
+		return _mm256_unpacklo_epi32(x, y);
+	} else {
+		return _mm256_unpacklo_epi16(x, y);
+	}
+}
+template<typename Pixel>
+AVX2_TARGET static inline __m256i unpackhi(__m256i x, __m256i y)
+{
+	if (sizeof(Pixel) == 4) {
+		return _mm256_unpackhi_epi32(x, y);
+	} else {
+		return _mm256_unpackhi_epi16(x, y);
+	}
+}
+
+template<typename Pixel>
+AVX2_TARGET static size_t scale_1on2_impl(const Pixel* in_, Pixel* out_, size_t dstWidth)
+{
+	size_t srcBytes = ((dstWidth / 2) * sizeof(Pixel)) & ~63;
+	if (srcBytes == 0) return 0;
+
+	const auto* in  = reinterpret_cast<const char*>(in_)  +     srcBytes;
+	      auto* out = reinterpret_cast<      char*>(out_) + 2 * srcBytes;
+
+	auto x = -ptrdiff_t(srcBytes);
+	do {
+		__m256i a0 = load(in + x +  0);
+		__m256i a1 = load(in + x + 32);
+		// The unpack instructions work within the 128-bit lanes, so
+		// afterwards the lanes need to be recombined.
+		__m256i l0 = unpacklo<Pixel>(a0, a0);
+		__m256i h0 = unpackhi<Pixel>(a0, a0);
+		__m256i l1 = unpacklo<Pixel>(a1, a1);
+		__m256i h1 = unpackhi<Pixel>(a1, a1);
+		store(out + 2 * x +  0, _mm256_permute2x128_si256(l0, h0, 0x20));
+		store(out + 2 * x + 32, _mm256_permute2x128_si256(l0, h0, 0x31));
+		store(out + 2 * x + 64, _mm256_permute2x128_si256(l1, h1, 0x20));
+		store(out + 2 * x + 96, _mm256_permute2x128_si256(l1, h1, 0x31));
+		x += 64;
+	} while (x < 0);
+	return 2 * srcBytes / sizeof(Pixel);
+}
+
+template<unsigned N>
+AVX2_TARGET static size_t scale_1onN_impl(const uint32_t* in, uint32_t* out, size_t dstWidth)
+{
+	// Output vector 'k' (of a group of N vectors) contains the output
+	// pixels [8k .. 8k+8), those are copies of input pixel (8k + i) / N.
+	static constexpr auto indices = [] {
+		std::array<int32_t, 8 * N> result = {};
+		for (unsigned i = 0; i < 8 * N; ++i) result[i] = i / N;
+		return result;
+	}();
+	__m256i idx[N];
+	for (unsigned k = 0; k < N; ++k) {
+		idx[k] = _mm256_loadu_si256(
+			reinterpret_cast<const __m256i*>(&indices[8 * k]));
+	}
+
+	size_t num = dstWidth / (8 * N);
+	for (size_t i = 0; i < num; ++i) {
+		__m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + 8 * i));
+		for (unsigned k = 0; k < N; ++k) {
+			_mm256_storeu_si256(
+				reinterpret_cast<__m256i*>(out + 8 * (N * i + k)),
+				_mm256_permutevar8x32_epi32(a, idx[k]));
+		}
+	}
+	return num * 8 * N;
+}
+
+// Same as the SSE2 version: average (rounded up) of each pair of pixels.
+AVX2_TARGET static inline __m256i blend2on1(__m256i x, __m256i y)
+{
+	// Even and odd pixels. Shuffle_ps works within the 128-bit lanes, so
+	// the result is in the order 0 1 4 5 2 3 6 7.
+	__m256 fx = _mm256_castsi256_ps(x);
+	__m256 fy = _mm256_castsi256_ps(y);
+	__m256i p = _mm256_castps_si256(_mm256_shuffle_ps(fx, fy, 0x88));
+	__m256i q = _mm256_castps_si256(_mm256_shuffle_ps(fx, fy, 0xDD));
+	return _mm256_permute4x64_epi64(_mm256_avg_epu8(p, q), 0xD8);
+}
+
+AVX2_TARGET static size_t scale_2on1_impl(const uint32_t* in_, uint32_t* out_, size_t dstWidth)
+{
+	size_t dstBytes = (dstWidth * sizeof(uint32_t)) & ~63;
+	if (dstBytes == 0) return 0;
+
+	const auto* in  = reinterpret_cast<const char*>(in_)  + 2 * dstBytes;
+	      auto* out = reinterpret_cast<      char*>(out_) +     dstBytes;
+
+	auto x = -ptrdiff_t(dstBytes);
+	do {
+		__m256i a0 = load(in + 2 * x +  0);
+		__m256i a1 = load(in + 2 * x + 32);
+		__m256i a2 = load(in + 2 * x + 64);
+		__m256i a3 = load(in + 2 * x + 96);
+		store(out + x +  0, blend2on1(a0, a1));
+		store(out + x + 32, blend2on1(a2, a3));
+		x += 64;
+	} while (x < 0);
+	return dstBytes / sizeof(uint32_t);
+}
+
+template<typename Pixel>
+AVX2_TARGET static size_t blendLines_impl(
+	const Pixel* in1_, const Pixel* in2_, Pixel* out_, size_t width, Pixel mask)
+{
+	size_t bytes = (width * sizeof(Pixel)) & ~31;
+	if (bytes == 0) return 0;
+
+	const auto* in1 = reinterpret_cast<const char*>(in1_) + bytes;
+	const auto* in2 = reinterpret_cast<const char*>(in2_) + bytes;
+	      auto* out = reinterpret_cast<      char*>(out_) + bytes;
+
+	// Same as PixelOperations::avgDown():  (a & b) + ((a ^ b) & mask) / 2
+	// The mask clears the lowest bit of each component, so a 16-bit shift
+	// gives the same result for 16bpp and for 32bpp.
+	__m256i m = (sizeof(Pixel) == 4) ? _mm256_set1_epi32(mask)
+	                                 : _mm256_set1_epi16(mask);
+	auto x = -ptrdiff_t(bytes);
+	do {
+		__m256i a = load(in1 + x);
+		__m256i b = load(in2 + x);
+		__m256i c = _mm256_add_epi16(
+			_mm256_and_si256(a, b),
+			_mm256_srli_epi16(_mm256_and_si256(m, _mm256_xor_si256(a, b)), 1));
+		store(out + x, c);
+		x += 32;
+	} while (x < 0);
+	return bytes / sizeof(Pixel);
+}
+
+// The functions with a target attribute can't be declared in the header
+// (there a declaration without the attribute would be a different function),
+// these forward to them.
+template<typename Pixel>
+size_t scale_1on2_AVX2(const Pixel* in, Pixel* out, size_t dstWidth)
+{
+	return scale_1on2_impl(in, out, dstWidth);
+}
+
+template<unsigned N>
+size_t scale_1onN_AVX2(const uint32_t* in, uint32_t* out, size_t dstWidth)
+{
+	return scale_1onN_impl<N>(in, out, dstWidth);
+}
+
+size_t scale_2on1_AVX2(const uint32_t* in, uint32_t* out, size_t dstWidth)
+{
+	return scale_2on1_impl(in, out, dstWidth);
+}
+
+template<typename Pixel>
+size_t blendLines_AVX2(
+	const Pixel* in1, const Pixel* in2, Pixel* out, size_t width, Pixel mask)
+{
+	return blendLines_impl(in1, in2, out, width, mask);
+}
+
+#else
+
+// Not compiled in, ScalerAVX2::isEnabled() is always false.
+template<typename Pixel>
+size_t scale_1on2_AVX2(const Pixel*, Pixel*, size_t)
+{
+	UNREACHABLE; return 0;
+}
+
+template<unsigned N>
+size_t scale_1onN_AVX2(const uint32_t*, uint32_t*, size_t)
+{
+	UNREACHABLE; return 0;
+}
+
+size_t scale_2on1_AVX2(const uint32_t*, uint32_t*, size_t)
+{
+	UNREACHABLE; return 0;
+}
+
+template<typename Pixel>
+size_t blendLines_AVX2(const Pixel*, const Pixel*, Pixel*, size_t, Pixel)
+{
+	UNREACHABLE; return 0;
+}
+
+#endif // AVX2_TARGET
+
+// Force template instantiation.
+template size_t scale_1onN_AVX2<3>(const uint32_t*, uint32_t*, size_t);
+template size_t scale_1onN_AVX2<4>(const uint32_t*, uint32_t*, size_t);
+template size_t scale_1onN_AVX2<6>(const uint32_t*, uint32_t*, size_t);
+#if HAVE_16BPP
+template size_t scale_1on2_AVX2<uint16_t>(const uint16_t*, uint16_t*, size_t);
+template size_t blendLines_AVX2<uint16_t>(const uint16_t*, const uint16_t*, uint16_t*, size_t, uint16_t);
+#endif
+#if HAVE_32BPP
+template size_t scale_1on2_AVX2<uint32_t>(const uint32_t*, uint32_t*, size_t);
+template size_t blendLines_AVX2<uint32_t>(const uint32_t*, const uint32_t*, uint32_t*, size_t, uint32_t);
+#endif
+
+} // namespace openmsx
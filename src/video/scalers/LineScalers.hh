@@ -2,10 +2,12 @@
 #define LINESCALERS_HH
 
 #include "PixelOperations.hh"
+#include "ScalerAVX2.hh"
 #include "likely.hh"
 #include "xrange.hh"
 #include <type_traits>
 #include <cstddef>
+#include <cstdint>
 #include <cstring>
 #include <cassert>
 #ifdef __SSE2__
@@ -358,12 +360,33 @@ private:
 
 // implementation
 
+// AVX2 versions of some of the routines below, see LineScalers.cc. They
+// process the largest part of the line that they can handle, and return the
+// number of output pixels that were produced. The remaining pixels must be
+// handled by the SSE2 or C++ code. Only call them when ScalerAVX2::isEnabled().
+template<typename Pixel> [[nodiscard]] size_t scale_1on2_AVX2(
+	const Pixel* in, Pixel* out, size_t dstWidth);
+template<unsigned N> [[nodiscard]] size_t scale_1onN_AVX2(
+	const uint32_t* in, uint32_t* out, size_t dstWidth);
+[[nodiscard]] size_t scale_2on1_AVX2(
+	const uint32_t* in, uint32_t* out, size_t dstWidth);
+template<typename Pixel> [[nodiscard]] size_t blendLines_AVX2(
+	const Pixel* in1, const Pixel* in2, Pixel* out, size_t width, Pixel mask);
+
 template<typename Pixel, unsigned N>
 static inline void scale_1onN(
 	const Pixel* __restrict in, Pixel* __restrict out, size_t width)
 {
+	if constexpr (sizeof(Pixel) == 4) {
+		if (ScalerAVX2::isEnabled()) {
+			size_t done = scale_1onN_AVX2<N>(in, out, width);
+			in    += done / N;
+			out   += done;
+			width -= done;
+		}
+	}
 	size_t i = 0, j = 0;
-	for (/* */; i < (width - (N - 1)); i += N, j += 1) {
+	for (/* */; (i + N) <= width; i += N, j += 1) {
 		Pixel pix = in[j];
 		for (auto k : xrange(N)) {
 			out[i + k] = pix;
@@ -467,12 +490,20 @@ void Scale_1on2<Pixel>::operator()(
 	//   approx 40% slower than the intrinsics version.
 	// Hopefully in some years the compilers have improved further so that
 	// the intrinsic version is no longer needed.
+	if (ScalerAVX2::isEnabled()) {
+		size_t done = scale_1on2_AVX2(in, out, dstWidth);
+		in       += done / 2;
+		out      += done;
+		dstWidth -= done;
+	}
 	size_t srcWidth = dstWidth / 2;
 
 #ifdef __SSE2__
 	size_t chunk = 4 * sizeof(__m128i) / sizeof(Pixel);
 	size_t srcWidth2 = srcWidth & ~(chunk - 1);
-	scale_1on2_SSE(in, out, srcWidth2);
+	if (srcWidth2 != 0) { // always zero after the AVX2 version
+		scale_1on2_SSE(in, out, srcWidth2);
+	}
 	in  +=      srcWidth2;
 	out +=  2 * srcWidth2;
 	srcWidth -= srcWidth2;
@@ -638,10 +669,20 @@ template<typename Pixel>
 void Scale_2on1<Pixel>::operator()(
 	const Pixel* __restrict in, Pixel* __restrict out, size_t dstWidth)
 {
+	if constexpr (sizeof(Pixel) == 4) {
+		if (ScalerAVX2::isEnabled()) {
+			size_t done = scale_2on1_AVX2(in, out, dstWidth);
+			in       += 2 * done;
+			out      += done;
+			dstWidth -= done;
+		}
+	}
 #ifdef __SSE2__
 	size_t n64 = (dstWidth * sizeof(Pixel)) & ~63;
 	Pixel mask = pixelOps.getBlendMask();
-	scale_2on1_SSE(in, out, n64, mask); // process 64 byte chunks
+	if (n64 != 0) { // always zero after the AVX2 version
+		scale_2on1_SSE(in, out, n64, mask); // process 64 byte chunks
+	}
 	dstWidth &= ((64 / sizeof(Pixel)) - 1); // remaning pixels (if any)
 	if (likely(dstWidth == 0)) return;
 	in  += (2 * n64) / sizeof(Pixel);
@@ -1053,6 +1094,16 @@ void BlendLines<Pixel, w1, w2>::operator()(
 	const Pixel* in1, const Pixel* in2, Pixel* out, size_t width)
 {
 	// It _IS_ allowed that the output is the same as one of the inputs.
+	if constexpr ((w1 == w2) && (w1 != 0)) {
+		if (ScalerAVX2::isEnabled()) {
+			size_t done = blendLines_AVX2(
+				in1, in2, out, width, pixelOps.getBlendMask());
+			in1   += done;
+			in2   += done;
+			out   += done;
+			width -= done;
+		}
+	}
 	// TODO SSE optimizations
 	// pure C++ version
 	for (auto i : xrange(width)) {
@@ -25,6 +25,10 @@ public:
 		unsigned srcStartY, unsigned srcEndY, unsigned srcWidth,
 		ScalerOutput<Pixel>& dst, unsigned dstStartY, unsigned dstEndY) override;
 
+	// Edges are followed over an arbitrary number of lines within the
+	// scaled area.
+	[[nodiscard]] bool canScaleInBands() const override { return false; }
+
 private:
 	const PixelOperations<Pixel> pixelOps;
 	const unsigned dstWidth;
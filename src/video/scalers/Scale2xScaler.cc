@@ -12,7 +12,9 @@ Visit the Scale2x site for info:
 
 #include "Scale2xScaler.hh"
 #include "FrameSource.hh"
+#include "ScalerAVX2.hh"
 #include "ScalerOutput.hh"
+#include "avx2.hh"
 #include "unreachable.hh"
 #include "vla.hh"
 #include "xrange.hh"
@@ -25,6 +27,9 @@ Visit the Scale2x site for info:
 #include "tmmintrin.h" // SSSE3  (supplemental SSE3)
 #endif
 #endif
+#ifdef AVX2_TARGET
+#include "immintrin.h" // AVX2
+#endif
 
 namespace openmsx {
 
@@ -203,6 +208,166 @@ static inline void scaleSSE(
 
 #endif
 
+#ifdef AVX2_TARGET
+
+// AVX2 version of the routines above. A unit is now 16x16bpp or 8x32bpp
+// pixels. Most AVX2 instructions work within the two 128-bit lanes, so
+// neighbouring pixels that cross the lane boundary are first moved into
+// place with a lane permute.
+
+template<typename Pixel> AVX2_TARGET [[nodiscard]] static inline __m256i isEqualAVX2(__m256i x, __m256i y)
+{
+	if (sizeof(Pixel) == 4) {
+		return _mm256_cmpeq_epi32(x, y);
+	} else if (sizeof(Pixel) == 2) {
+		return _mm256_cmpeq_epi16(x, y);
+	} else {
+		UNREACHABLE;
+	}
+}
+template<typename Pixel> AVX2_TARGET [[nodiscard]] static inline __m256i unpackloAVX2(__m256i x, __m256i y)
+{
+	if (sizeof(Pixel) == 4) {
+		return _mm256_unpacklo_epi32(x, y);
+	} else if (sizeof(Pixel) == 2) {
+		return _mm256_unpacklo_epi16(x, y);
+	} else {
+		UNREACHABLE;
+	}
+}
+template<typename Pixel> AVX2_TARGET [[nodiscard]] static inline __m256i unpackhiAVX2(__m256i x, __m256i y)
+{
+	if (sizeof(Pixel) == 4) {
+		return _mm256_unpackhi_epi32(x, y);
+	} else if (sizeof(Pixel) == 2) {
+		return _mm256_unpackhi_epi16(x, y);
+	} else {
+		UNREACHABLE;
+	}
+}
+template<typename Pixel> AVX2_TARGET [[nodiscard]] static inline __m256i broadcastAVX2(Pixel p)
+{
+	if (sizeof(Pixel) == 4) {
+		return _mm256_set1_epi32(p);
+	} else if (sizeof(Pixel) == 2) {
+		return _mm256_set1_epi16(p);
+	} else {
+		UNREACHABLE;
+	}
+}
+AVX2_TARGET [[nodiscard]] static inline __m256i loadu(const char* p)
+{
+	return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+}
+AVX2_TARGET [[nodiscard]] static inline __m256i selectAVX2(__m256i a0, __m256i a1, __m256i mask)
+{
+	// see select() above
+	return _mm256_xor_si256(_mm256_and_si256(_mm256_xor_si256(a0, a1), mask), a0);
+}
+
+template<typename Pixel, bool DOUBLE_X> AVX2_TARGET static inline void scale1AVX2(
+	__m256i top,	__m256i bottom,
+	__m256i prev,	__m256i mid,	__m256i next,
+	char* out0,	char* out1)
+{
+	__m256i left = _mm256_alignr_epi8(
+		mid, _mm256_permute2x128_si256(prev, mid, 0x21),
+		sizeof(__m128i) - sizeof(Pixel));
+	__m256i right = _mm256_alignr_epi8(
+		_mm256_permute2x128_si256(mid, next, 0x21), mid,
+		sizeof(Pixel));
+
+	__m256i teqb = isEqualAVX2<Pixel>(top, bottom);
+	__m256i leqt = isEqualAVX2<Pixel>(left, top);
+	__m256i reqt = isEqualAVX2<Pixel>(right, top);
+	__m256i leqb = isEqualAVX2<Pixel>(left, bottom);
+	__m256i reqb = isEqualAVX2<Pixel>(right, bottom);
+
+	__m256i cndA = _mm256_andnot_si256(_mm256_or_si256(teqb, reqt), leqt);
+	__m256i cndB = _mm256_andnot_si256(_mm256_or_si256(teqb, leqt), reqt);
+	__m256i cndC = _mm256_andnot_si256(_mm256_or_si256(teqb, reqb), leqb);
+	__m256i cndD = _mm256_andnot_si256(_mm256_or_si256(teqb, leqb), reqb);
+
+	__m256i a = selectAVX2(mid, top,    cndA);
+	__m256i b = selectAVX2(mid, top,    cndB);
+	__m256i c = selectAVX2(mid, bottom, cndC);
+	__m256i d = selectAVX2(mid, bottom, cndD);
+
+	auto* o0 = reinterpret_cast<__m256i*>(out0);
+	auto* o1 = reinterpret_cast<__m256i*>(out1);
+	if (DOUBLE_X) {
+		__m256i ab0 = unpackloAVX2<Pixel>(a, b);
+		__m256i ab1 = unpackhiAVX2<Pixel>(a, b);
+		__m256i cd0 = unpackloAVX2<Pixel>(c, d);
+		__m256i cd1 = unpackhiAVX2<Pixel>(c, d);
+		_mm256_storeu_si256(o0 + 0, _mm256_permute2x128_si256(ab0, ab1, 0x20));
+		_mm256_storeu_si256(o0 + 1, _mm256_permute2x128_si256(ab0, ab1, 0x31));
+		_mm256_storeu_si256(o1 + 0, _mm256_permute2x128_si256(cd0, cd1, 0x20));
+		_mm256_storeu_si256(o1 + 1, _mm256_permute2x128_si256(cd0, cd1, 0x31));
+	} else {
+		_mm256_storeu_si256(o0, a);
+		_mm256_storeu_si256(o1, c);
+	}
+}
+
+// Same as scaleSSE(), but the width (in bytes) must be a multiple of 32.
+template<bool DOUBLE_X, typename Pixel>
+AVX2_TARGET static void scaleAVX2(
+	      Pixel* __restrict out0_,  // top output line
+	      Pixel* __restrict out1_,  // bottom output line
+	const Pixel* __restrict in0_,   // top input line
+	const Pixel* __restrict in1_,   // middle output line
+	const Pixel* __restrict in2_,   // bottom output line
+	size_t width)
+{
+	Pixel first = in1_[0];
+	Pixel last  = in1_[width - 1];
+
+	width *= sizeof(Pixel); // width in bytes
+	assert((width % sizeof(__m256i)) == 0);
+	assert(width > 1);
+	width -= sizeof(__m256i); // handle last unit special
+
+	constexpr size_t SCALE = DOUBLE_X ? 2 : 1;
+
+	const auto* in0  = reinterpret_cast<const char*>(in0_ ) +         width;
+	const auto* in1  = reinterpret_cast<const char*>(in1_ ) +         width;
+	const auto* in2  = reinterpret_cast<const char*>(in2_ ) +         width;
+	      auto* out0 = reinterpret_cast<      char*>(out0_) + SCALE * width;
+	      auto* out1 = reinterpret_cast<      char*>(out1_) + SCALE * width;
+	ptrdiff_t x = -ptrdiff_t(width);
+
+	// Setup for first unit, only the last pixel of 'mid' is used.
+	__m256i next = loadu(in1 + x);
+	__m256i mid = broadcastAVX2(first);
+
+	// Central units
+	while (x < 0) {
+		__m256i prev = mid;
+		mid = next;
+		next = loadu(in1 + x + sizeof(__m256i));
+		scale1AVX2<Pixel, DOUBLE_X>(loadu(in0 + x), loadu(in2 + x),
+		                            prev, mid, next,
+		                            out0 + SCALE * x, out1 + SCALE * x);
+		x += sizeof(__m256i);
+	}
+	assert(x == 0);
+
+	// Last unit, only the first pixel of 'next' is used.
+	__m256i prev = mid;
+	mid = next;
+	next = broadcastAVX2(last);
+	scale1AVX2<Pixel, DOUBLE_X>(loadu(in0), loadu(in2),
+	                            prev, mid, next, out0, out1);
+}
+
+[[nodiscard]] static inline bool useAVX2(size_t widthInBytes)
+{
+	return ScalerAVX2::isEnabled() && ((widthInBytes % 32) == 0);
+}
+
+#endif
+
 
 template<typename Pixel>
 Scale2xScaler<Pixel>::Scale2xScaler(const PixelOperations<Pixel>& pixelOps_)
@@ -221,6 +386,12 @@ inline void Scale2xScaler<Pixel>::scaleLine_1on2(
 	// though a single loop only has to fetch the inputs once and can
 	// eliminate some common sub-expressions). For the asm version the
 	// situation is reversed.
+#ifdef AVX2_TARGET
+	if (useAVX2(srcWidth * sizeof(Pixel))) {
+		scaleAVX2<true>(dst0, dst1, src0, src1, src2, srcWidth);
+		return;
+	}
+#endif
 #ifdef __SSE2__
 	scaleSSE<true>(dst0, dst1, src0, src1, src2, srcWidth);
 #else
@@ -273,6 +444,12 @@ inline void Scale2xScaler<Pixel>::scaleLine_1on1(
 	const Pixel* __restrict src0, const Pixel* __restrict src1,
 	const Pixel* __restrict src2, size_t srcWidth) __restrict
 {
+#ifdef AVX2_TARGET
+	if (useAVX2(srcWidth * sizeof(Pixel))) {
+		scaleAVX2<false>(dst0, dst1, src0, src1, src2, srcWidth);
+		return;
+	}
+#endif
 #ifdef __SSE2__
 	scaleSSE<false>(dst0, dst1, src0, src1, src2, srcWidth);
 #else
@@ -30,6 +30,14 @@ public:
 	virtual void scaleImage(FrameSource& src, const RawFrame* superImpose,
 		unsigned srcStartY, unsigned srcEndY, unsigned srcWidth,
 		ScalerOutput<Pixel>& dst, unsigned dstStartY, unsigned dstEndY) = 0;
+
+	/** Does splitting an area in several parts (and scaling those parts
+	  * separately) give the same result as scaling the whole area at once?
+	  * This is true for scalers that only look at a fixed number (at most
+	  * 2) of neighbouring lines: those are read from the FrameSource, also
+	  * when they lie outside the given area.
+	  */
+	[[nodiscard]] virtual bool canScaleInBands() const { return true; }
 };
 
 } // namespace openmsx
@@ -0,0 +1,28 @@
+#ifndef SCALERAVX2_HH
+#define SCALERAVX2_HH
+
+namespace openmsx {
+
+/** Selects between the AVX2 and the SSE2 (or generic C++) versions of the
+  * scaler kernels, see avx2.hh. By default the AVX2 versions are used when
+  * they are supported. The unittests and benchmarks can disable them, to
+  * compare both versions.
+  */
+class ScalerAVX2
+{
+public:
+	/** Are the AVX2 versions compiled in and supported by the host CPU? */
+	[[nodiscard]] static bool isSupported();
+
+	[[nodiscard]] static bool isEnabled() { return enabled; }
+
+	/** Enabling only has effect when the AVX2 versions are supported. */
+	static void setEnabled(bool enabled_) { enabled = enabled_ && isSupported(); }
+
+private:
+	static bool enabled;
+};
+
+} // namespace openmsx
+
+#endif
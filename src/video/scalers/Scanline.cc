@@ -1,5 +1,7 @@
 #include "Scanline.hh"
 #include "PixelOperations.hh"
+#include "ScalerAVX2.hh"
+#include "avx2.hh"
 #include "enumerate.hh"
 #include "unreachable.hh"
 #include "xrange.hh"
@@ -9,6 +11,9 @@
 #ifdef __SSE2__
 #include <emmintrin.h>
 #endif
+#ifdef AVX2_TARGET
+#include <immintrin.h>
+#endif
 
 namespace openmsx {
 
@@ -127,6 +132,47 @@ static inline void drawSSE2(
 	} while (x < 0);
 }
 
+#ifdef AVX2_TARGET
+// Same as above, but 32 bytes at a time. The unpack and pack instructions
+// both work within the 128-bit lanes, so the pixel order is preserved.
+AVX2_TARGET static inline void drawAVX2_1(
+	const char* __restrict in1, const char* __restrict in2,
+	      char* __restrict out, __m256i f)
+{
+	__m256i zero = _mm256_setzero_si256();
+	__m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in1));
+	__m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in2));
+	__m256i c = _mm256_avg_epu8(a, b);
+	__m256i l = _mm256_unpacklo_epi8(c, zero);
+	__m256i h = _mm256_unpackhi_epi8(c, zero);
+	__m256i m = _mm256_mulhi_epu16(l, f);
+	__m256i n = _mm256_mulhi_epu16(h, f);
+	__m256i r = _mm256_packus_epi16(m, n);
+	_mm256_storeu_si256(reinterpret_cast<__m256i*>(out), r);
+}
+AVX2_TARGET static void drawAVX2(
+	const uint32_t* __restrict in1_,
+	const uint32_t* __restrict in2_,
+	      uint32_t* __restrict out_,
+	unsigned factor,
+	size_t width)
+{
+	width *= sizeof(uint32_t); // in bytes
+	assert(width >= 64);
+	const auto* in1 = reinterpret_cast<const char*>(in1_) + width;
+	const auto* in2 = reinterpret_cast<const char*>(in2_) + width;
+	      auto* out = reinterpret_cast<      char*>(out_) + width;
+
+	__m256i f = _mm256_set1_epi16(factor << 8);
+	ptrdiff_t x = -ptrdiff_t(width);
+	do {
+		drawAVX2_1(in1 + x +  0, in2 + x +  0, out + x +  0, f);
+		drawAVX2_1(in1 + x + 32, in2 + x + 32, out + x + 32, f);
+		x += 64;
+	} while (x < 0);
+}
+#endif
+
 // 16bpp
 static inline void drawSSE2(
 	const uint16_t* __restrict in1_,
@@ -202,6 +248,14 @@ void Scanline<Pixel>::draw(
 	const Pixel* __restrict src1, const Pixel* __restrict src2,
 	Pixel* __restrict dst, unsigned factor, size_t width)
 {
+#ifdef AVX2_TARGET
+	if constexpr (sizeof(Pixel) == 4) {
+		if (ScalerAVX2::isEnabled()) {
+			drawAVX2(src1, src2, dst, factor, width);
+			return;
+		}
+	}
+#endif
 #ifdef __SSE2__
 	drawSSE2(src1, src2, dst, factor, width, pixelOps, darkener);
 #else
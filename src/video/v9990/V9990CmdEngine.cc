@@ -12,8 +12,16 @@
 #include "likely.hh"
 #include "unreachable.hh"
 #include "xrange.hh"
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
+#include <utility>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 namespace openmsx {
 
@@ -267,6 +275,401 @@ static constexpr void fillTable8(unsigned op, byte* table)
 }
 
 
+// Bulk execution of the block commands -----------------------------------
+//
+// In the Bx modes a run of whole bytes on one line is a range of consecutive
+// addresses in the (not yet transformed) Bx address space, in the 16bpp mode
+// it's a range of consecutive addresses in both VRAM banks. Several commands
+// process such runs at once instead of pixel by pixel. The logical operations
+// below give the same result as the logOpLUT tables (including the
+// transparency rules), but work on 16 bytes in parallel (when SSE2 is
+// available). BMXL and BMLX also transfer runs of whole bytes between a line
+// and the linear address space. P1 and P2 use a different address mapping,
+// so in those modes the line based commands keep using the per-pixel code.
+
+constexpr unsigned MAX_BULK = 256; // max number of bytes per run
+
+// Result of logical operation 'op' on all bits of 'src' and 'dst'.
+[[nodiscard]] static inline byte logOpBits(byte op, byte src, byte dst)
+{
+	byte res = 0;
+	if (op & 1) res |= ~src & ~dst;
+	if (op & 2) res |= ~src &  dst;
+	if (op & 4) res |=  src & ~dst;
+	if (op & 8) res |=  src &  dst;
+	return res;
+}
+
+// All bits of the (BITS wide) pixels in 's' that are not zero.
+template<unsigned BITS> [[nodiscard]] static inline byte opaqueBits(byte s)
+{
+	if constexpr (BITS == 2) {
+		unsigned t = (s | (s >> 1)) & 0x55;
+		return t * 0x03;
+	} else if constexpr (BITS == 4) {
+		unsigned t = s | (s >> 1);
+		t = (t | (t >> 2)) & 0x11;
+		return t * 0x0F;
+	} else {
+		static_assert(BITS == 8);
+		return s ? 0xFF : 0x00;
+	}
+}
+
+// The (BITS wide) pixels in 's' in reverse order.
+template<unsigned BITS> [[nodiscard]] static inline byte reversePixels(byte s)
+{
+	if constexpr (BITS == 8) return s;
+	s = byte((s << 4) | (s >> 4));
+	if constexpr (BITS == 2) s = byte(((s & 0x33) << 2) | ((s >> 2) & 0x33));
+	return s;
+}
+
+#ifdef __SSE2__
+template<unsigned BITS> [[nodiscard]] static inline __m128i opaqueBits(__m128i s)
+{
+	auto zero = _mm_setzero_si128();
+	if constexpr (BITS == 8) {
+		return _mm_andnot_si128(_mm_cmpeq_epi8(s, zero), _mm_set1_epi8(-1));
+	} else {
+		auto result = zero;
+		for (unsigned f = (1 << BITS) - 1; f < 256; f <<= BITS) {
+			auto field = _mm_set1_epi8(char(f));
+			auto isZero = _mm_cmpeq_epi8(_mm_and_si128(s, field), zero);
+			result = _mm_or_si128(result, _mm_andnot_si128(isZero, field));
+		}
+		return result;
+	}
+}
+#endif
+
+// dst[i] = logical operation 'op' of src[i] and dst[i], but only for the bits
+// in 'wm'. When BITS is not zero, pixels that are zero in (src[i] | key[i])
+// are transparent. For the 16bpp mode 'key' is the other half of the source
+// word, for the other modes it's equal to 'src'.
+template<unsigned BITS>
+static void logOpBlock(byte* dst, const byte* src, const byte* key,
+                       size_t num, byte op, byte wm)
+{
+	size_t i = 0;
+#ifdef __SSE2__
+	auto c0 = _mm_set1_epi8((op & 1) ? -1 : 0);
+	auto c1 = _mm_set1_epi8((op & 2) ? -1 : 0);
+	auto c2 = _mm_set1_epi8((op & 4) ? -1 : 0);
+	auto c3 = _mm_set1_epi8((op & 8) ? -1 : 0);
+	auto mask = _mm_set1_epi8(char(wm));
+	for (; (i + 16) <= num; i += 16) {
+		auto s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+		auto d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+		auto n = _mm_or_si128(
+			_mm_or_si128(_mm_andnot_si128(_mm_or_si128(s, d), c0),
+			             _mm_and_si128(c1, _mm_andnot_si128(s, d))),
+			_mm_or_si128(_mm_and_si128(c2, _mm_andnot_si128(d, s)),
+			             _mm_and_si128(c3, _mm_and_si128(s, d))));
+		auto m = mask;
+		if constexpr (BITS != 0) {
+			auto k = _mm_loadu_si128(reinterpret_cast<const __m128i*>(key + i));
+			m = _mm_and_si128(m, opaqueBits<BITS>(_mm_or_si128(s, k)));
+		}
+		auto r = _mm_xor_si128(d, _mm_and_si128(_mm_xor_si128(d, n), m));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), r);
+	}
+#endif
+	for (; i < num; ++i) {
+		byte m = wm;
+		if constexpr (BITS != 0) m &= opaqueBits<BITS>(src[i] | key[i]);
+		byte n = logOpBits(op, src[i], dst[i]);
+		dst[i] ^= (dst[i] ^ n) & m;
+	}
+}
+
+// dst[i] = logical operation 'op' of 'src' and dst[i], but only for the bits
+// in 'mask' (for a fixed source the transparency is already in the mask).
+static void logOpFill(byte* dst, size_t num, byte src, byte op, byte mask)
+{
+	// the result for the bits that are set resp. reset in the destination
+	byte set   = logOpBits(op, src, 0xFF);
+	byte reset = logOpBits(op, src, 0x00);
+	size_t i = 0;
+#ifdef __SSE2__
+	auto s = _mm_set1_epi8(char(set));
+	auto r = _mm_set1_epi8(char(reset));
+	auto m = _mm_set1_epi8(char(mask));
+	for (; (i + 16) <= num; i += 16) {
+		auto d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+		auto n = _mm_or_si128(_mm_and_si128(d, s), _mm_andnot_si128(d, r));
+		auto x = _mm_xor_si128(d, _mm_and_si128(_mm_xor_si128(d, n), m));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), x);
+	}
+#endif
+	for (; i < num; ++i) {
+		byte n = (dst[i] & set) | (~dst[i] & reset);
+		dst[i] ^= (dst[i] ^ n) & mask;
+	}
+}
+
+// The even and the odd addresses in a run of 'num' Bx addresses (starting at
+// 'addr') each form a contiguous range in one of the two VRAM banks. For both
+// banks this is the position of the first of those addresses in the run and
+// the number of them.
+struct BxBanks {
+	BxBanks(unsigned addr, unsigned num)
+		: first{addr & 1, (addr & 1) ^ 1}
+	{
+		count[0] = (num + 1 - first[0]) / 2;
+		count[1] = num - count[0];
+	}
+	unsigned first[2];
+	unsigned count[2];
+};
+
+// Copy 'num' bytes between two runs of Bx addresses that don't overlap.
+static void copyBx(byte* vram, unsigned dst, unsigned src, unsigned num)
+{
+	assert((dst + num) <= 0x80000);
+	assert((src + num) <= 0x80000);
+	auto [first, count] = BxBanks(dst, num);
+	for (auto bank : xrange(2)) {
+		if (!count[bank]) continue;
+		memcpy(vram + V9990VRAM::transformBx(dst + first[bank]),
+		       vram + V9990VRAM::transformBx(src + first[bank]),
+		       count[bank]);
+	}
+}
+
+// Logical operation on 'num' consecutive Bx addresses (in the linear address
+// space), reading from 'src' and writing to 'dst'. Neither range may wrap
+// around the end of VRAM. All source bytes are read before anything is
+// written (the caller makes sure that gives the same result as processing
+// them one by one).
+template<unsigned BITS>
+static void logOpBx(byte* vram, unsigned dst, unsigned src, unsigned num,
+                    byte op, word wm)
+{
+	assert(num <= MAX_BULK);
+	assert((dst + num) <= 0x80000);
+	assert((src + num) <= 0x80000);
+	// The matching source addresses are also contiguous in one bank.
+	auto [first, count] = BxBanks(dst, num);
+
+	std::array<byte, MAX_BULK> buf;
+	byte* srcBuf[2] = {buf.data(), buf.data() + count[0]};
+	for (auto bank : xrange(2)) {
+		if (!count[bank]) continue;
+		memcpy(srcBuf[bank], vram + V9990VRAM::transformBx(src + first[bank]),
+		       count[bank]);
+	}
+	for (auto bank : xrange(2)) {
+		if (!count[bank]) continue;
+		byte mask = bank ? (wm >> 8) : (wm & 0xFF);
+		logOpBlock<BITS>(vram + V9990VRAM::transformBx(dst + first[bank]),
+		                 srcBuf[bank], srcBuf[bank], count[bank], op, mask);
+	}
+}
+
+// Same as logOpBx(), but the source bytes come from 'src' (in the order of
+// the destination addresses) instead of from VRAM.
+template<unsigned BITS>
+static void logOpBxFrom(byte* vram, unsigned dst, const byte* src, unsigned num,
+                        byte op, word wm)
+{
+	assert(num <= MAX_BULK);
+	assert((dst + num) <= 0x80000);
+	auto [first, count] = BxBanks(dst, num);
+
+	std::array<byte, MAX_BULK> buf;
+	byte* srcBuf[2] = {buf.data(), buf.data() + count[0]};
+	for (auto bank : xrange(2)) {
+		for (auto i : xrange(count[bank])) {
+			srcBuf[bank][i] = src[first[bank] + 2 * i];
+		}
+	}
+	for (auto bank : xrange(2)) {
+		if (!count[bank]) continue;
+		byte mask = bank ? (wm >> 8) : (wm & 0xFF);
+		logOpBlock<BITS>(vram + V9990VRAM::transformBx(dst + first[bank]),
+		                 srcBuf[bank], srcBuf[bank], count[bank], op, mask);
+	}
+}
+
+// Same as logOpBxFrom(), but for the 16bpp mode: 'dst' is an offset in both
+// VRAM banks, 'lo' and 'hi' are the low and high bytes of the source pixels.
+template<unsigned BITS>
+static void logOp16From(byte* vram, unsigned dst, const byte* lo, const byte* hi,
+                        unsigned num, byte op, word wm)
+{
+	assert((dst + num) <= 0x40000);
+	logOpBlock<BITS>(vram + dst + 0x00000, lo, hi, num, op, wm & 0xFF);
+	logOpBlock<BITS>(vram + dst + 0x40000, hi, lo, num, op, wm >> 8);
+}
+
+// Same as logOpBx(), but for the 16bpp mode: 'dst' and 'src' are offsets in
+// both VRAM banks.
+template<unsigned BITS>
+static void logOp16(byte* vram, unsigned dst, unsigned src, unsigned num,
+                    byte op, word wm)
+{
+	assert(num <= MAX_BULK);
+	assert((src + num) <= 0x40000);
+	std::array<byte, 2 * MAX_BULK> buf;
+	byte* lo = buf.data();
+	byte* hi = buf.data() + num;
+	memcpy(lo, vram + src + 0x00000, num);
+	memcpy(hi, vram + src + 0x40000, num);
+	logOp16From<BITS>(vram, dst, lo, hi, num, op, wm);
+}
+
+// Logical operation of a fixed color on a run of bytes.
+template<typename Mode>
+static void fillBulk(byte* vram, unsigned dst, unsigned num,
+                     word color, word wm, byte op)
+{
+	bool transp = (op & 0x10) != 0;
+	if constexpr (Mode::BITS_PER_PIXEL == 16) {
+		assert((dst + num) <= 0x40000);
+		if (transp && (color == 0)) return;
+		logOpFill(vram + dst + 0x00000, num, color & 0xFF, op, wm & 0xFF);
+		logOpFill(vram + dst + 0x40000, num, color >> 8,   op, wm >> 8);
+	} else {
+		assert((dst + num) <= 0x80000);
+		auto [first, count] = BxBanks(dst, num);
+		for (auto bank : xrange(2)) {
+			if (!count[bank]) continue;
+			byte src  = bank ? (color >> 8) : (color & 0xFF);
+			byte mask = bank ? (wm    >> 8) : (wm    & 0xFF);
+			if (transp) mask &= opaqueBits<Mode::BITS_PER_PIXEL>(src);
+			logOpFill(vram + V9990VRAM::transformBx(dst + first[bank]),
+			          count[bank], src, op, mask);
+		}
+	}
+}
+
+// Logical operation of a run of source bytes on a run of destination bytes.
+template<typename Mode>
+static void copyBulk(byte* vram, unsigned dst, unsigned src, unsigned num,
+                     word wm, byte op)
+{
+	bool transp = (op & 0x10) != 0;
+	if constexpr (Mode::BITS_PER_PIXEL == 16) {
+		if (transp) {
+			logOp16<8>(vram, dst, src, num, op, wm);
+		} else {
+			logOp16<0>(vram, dst, src, num, op, wm);
+		}
+	} else {
+		if (transp) {
+			logOpBx<Mode::BITS_PER_PIXEL>(vram, dst, src, num, op, wm);
+		} else {
+			logOpBx<0>(vram, dst, src, num, op, wm);
+		}
+	}
+}
+
+// Same as copyBulk(), but the source bytes come from 'src' instead of from
+// VRAM: src[i] is combined with the destination byte at address 'dst + i'.
+// For the 16bpp mode 'src' holds 'num' low bytes followed by 'num' high bytes.
+template<typename Mode>
+static void copyBulkFrom(byte* vram, unsigned dst, const byte* src, unsigned num,
+                         word wm, byte op)
+{
+	bool transp = (op & 0x10) != 0;
+	if constexpr (Mode::BITS_PER_PIXEL == 16) {
+		if (transp) {
+			logOp16From<8>(vram, dst, src, src + num, num, op, wm);
+		} else {
+			logOp16From<0>(vram, dst, src, src + num, num, op, wm);
+		}
+	} else {
+		if (transp) {
+			logOpBxFrom<Mode::BITS_PER_PIXEL>(vram, dst, src, num, op, wm);
+		} else {
+			logOpBxFrom<0>(vram, dst, src, num, op, wm);
+		}
+	}
+}
+
+// For the 16bpp mode this is the number of pixels per byte in each bank.
+template<typename Mode>
+[[nodiscard]] static constexpr unsigned bulkPixelsPerByte()
+{
+	return (Mode::BITS_PER_PIXEL == 16) ? 1 : Mode::PIXELS_PER_BYTE;
+}
+
+// The number of whole bytes (at most 'maxPixels' pixels) that can be
+// processed at once, starting at pixel 'x' in direction 'dir'.
+template<typename Mode>
+[[nodiscard]] static unsigned bulkBytes(unsigned x, int dir, unsigned maxPixels)
+{
+	constexpr unsigned PPB = bulkPixelsPerByte<Mode>();
+	if ((x % PPB) != ((dir > 0) ? 0 : PPB - 1)) return 0;
+	return std::min(maxPixels / PPB, MAX_BULK);
+}
+
+// A run of bytes on one line, in the linear address space.
+struct BulkRun {
+	unsigned first; // address of the first processed byte
+	unsigned low;   // lowest address in the run
+	unsigned num;   // number of bytes
+};
+
+// The run of (at most 'num') bytes starting at pixel (x, y) in direction
+// 'dir', that doesn't wrap around the end of the line or of VRAM.
+template<typename Mode>
+[[nodiscard]] static BulkRun getBulkRun(
+	unsigned x, unsigned y, int dir, unsigned pitch, unsigned num)
+{
+	constexpr unsigned PPB = bulkPixelsPerByte<Mode>();
+	constexpr unsigned SIZE = (Mode::BITS_PER_PIXEL == 16) ? 0x40000 : 0x80000;
+	unsigned col = (x / PPB) & (pitch - 1);
+	unsigned addr = (col + y * pitch) & (SIZE - 1);
+	if (dir > 0) {
+		num = std::min({num, pitch - col, SIZE - addr});
+		return {addr, addr, num};
+	} else {
+		num = std::min({num, col + 1, addr + 1});
+		return {addr, addr + 1 - num, num};
+	}
+}
+
+// Same as getBulkRun(), for a source and destination run of the same size.
+// The runs are shortened so that no byte is read after the same run has
+// written to it. Only then reading all source bytes first gives the same
+// result as processing the pixels one by one.
+template<typename Mode>
+[[nodiscard]] static std::pair<BulkRun, BulkRun> getBulkRuns(
+	unsigned sx, unsigned sy, unsigned dx, unsigned dy,
+	int dir, unsigned pitch, unsigned num)
+{
+	num = getBulkRun<Mode>(sx, sy, dir, pitch, num).num;
+	num = getBulkRun<Mode>(dx, dy, dir, pitch, num).num;
+	auto src = getBulkRun<Mode>(sx, sy, dir, pitch, num);
+	auto dst = getBulkRun<Mode>(dx, dy, dir, pitch, num);
+	int dist = (int(dst.first) - int(src.first)) * dir;
+	if ((dist > 0) && (unsigned(dist) < num)) {
+		src = getBulkRun<Mode>(sx, sy, dir, pitch, dist);
+		dst = getBulkRun<Mode>(dx, dy, dir, pitch, dist);
+	}
+	return {src, dst};
+}
+
+// Whether the address ranges [a, a + numA) and [b, b + numB) overlap.
+[[nodiscard]] static constexpr bool overlap(
+	unsigned a, unsigned numA, unsigned b, unsigned numB)
+{
+	return (a < (b + numB)) && (b < (a + numA));
+}
+
+// The number of pixels (or bytes) a command can still process before
+// 'limit', given that each one takes 'delta'.
+[[nodiscard]] static unsigned stepsUntil(
+	EmuTime::param time, EmuTime::param limit, EmuDuration::param delta)
+{
+	if (time >= limit) return 0;
+	if (delta == EmuDuration::zero()) return unsigned(-1);
+	uint64_t steps = ((limit - time).length() + delta.length() - 1) / delta.length();
+	return unsigned(std::min<uint64_t>(steps, unsigned(-1)));
+}
+
 constexpr byte DIY = 0x08;
 constexpr byte DIX = 0x04;
 constexpr byte NEQ = 0x02;
@@ -1028,14 +1431,28 @@ void V9990CmdEngine::startLMMV(EmuTime::param time)
 template<typename Mode>
 void V9990CmdEngine::executeLMMV(EmuTime::param limit)
 {
-	// TODO can be optimized a lot
-
 	auto delta = getTiming(*this, LMMV_TIMING);
 	unsigned pitch = Mode::getPitch(vdp.getImageWidth());
 	int dx = (ARG & DIX) ? -1 : 1;
 	int dy = (ARG & DIY) ? -1 : 1;
 	const byte* lut = Mode::getLogOpLUT(LOG);
 	while (engineTime < limit) {
+		if constexpr (Mode::BULK) {
+			// Process whole bytes of the current line at once. The
+			// last pixel of the line always takes the path below.
+			unsigned maxPixels = !bulkEnabled ? 0 : std::min(
+				unsigned(ANX - 1), stepsUntil(engineTime, limit, delta));
+			if (unsigned num = bulkBytes<Mode>(DX, dx, maxPixels)) {
+				auto run = getBulkRun<Mode>(DX, DY, dx, pitch, num);
+				fillBulk<Mode>(vram.getWriteBackdoor(), run.low, run.num,
+				               fgCol, WM, LOG);
+				unsigned pixels = run.num * bulkPixelsPerByte<Mode>();
+				engineTime += delta * pixels;
+				DX += pixels * dx;
+				ANX -= pixels;
+				continue;
+			}
+		}
 		engineTime += delta;
 		Mode::psetColor(vram, DX, DY, pitch, fgCol, WM, lut, LOG);
 
@@ -1120,14 +1537,33 @@ void V9990CmdEngine::startLMMM(EmuTime::param time)
 template<typename Mode>
 void V9990CmdEngine::executeLMMM(EmuTime::param limit)
 {
-	// TODO can be optimized a lot
-
 	auto delta = getTiming(*this, LMMM_TIMING);
 	unsigned pitch = Mode::getPitch(vdp.getImageWidth());
 	int dx = (ARG & DIX) ? -1 : 1;
 	int dy = (ARG & DIY) ? -1 : 1;
 	const byte* lut = Mode::getLogOpLUT(LOG);
 	while (engineTime < limit) {
+		if constexpr (Mode::BULK) {
+			// Same as in LMMV, but only when the source and destination
+			// pixels are at the same position within a byte.
+			constexpr unsigned PPB = bulkPixelsPerByte<Mode>();
+			unsigned maxPixels = !bulkEnabled ? 0 : std::min(
+				unsigned(ANX - 1), stepsUntil(engineTime, limit, delta));
+			unsigned num = (((SX ^ DX) % PPB) == 0)
+			             ? bulkBytes<Mode>(DX, dx, maxPixels) : 0;
+			if (num) {
+				auto [src, dst] = getBulkRuns<Mode>(
+					SX, SY, DX, DY, dx, pitch, num);
+				copyBulk<Mode>(vram.getWriteBackdoor(), dst.low, src.low,
+				               dst.num, WM, LOG);
+				unsigned pixels = dst.num * PPB;
+				engineTime += delta * pixels;
+				DX += pixels * dx;
+				SX += pixels * dx;
+				ANX -= pixels;
+				continue;
+			}
+		}
 		engineTime += delta;
 		auto src = Mode::point(vram, SX, SY, pitch);
 		src = Mode::shift(src, SX, DX);
@@ -1270,6 +1706,40 @@ void V9990CmdEngine::executeBMXL<V9990CmdEngine::V9990Bpp16>(EmuTime::param limi
 	const byte* lut = V9990Bpp16::getLogOpLUT(LOG);
 
 	while (engineTime < limit) {
+		// Process a run of pixels of the current line at once, the last
+		// pixel of the line always takes the path below. Runs where the
+		// source overlaps with the destination also take that path, for
+		// the others reading all source bytes first gives the same
+		// result.
+		unsigned maxPixels = !bulkEnabled ? 0 : std::min(
+			unsigned(ANX - 1), stepsUntil(engineTime, limit, delta));
+		if (unsigned num = bulkBytes<V9990Bpp16>(DX, dx, maxPixels)) {
+			unsigned src = srcAddress & 0x7FFFF;
+			auto dst = getBulkRun<V9990Bpp16>(
+				DX, DY, dx, pitch, std::min(num, (0x80000 - src) / 2));
+			num = dst.num;
+			if (num && !overlap(src, 2 * num, 2 * dst.low, 2 * num)) {
+				if ((dx > 0) && !(src & 1)) {
+					// the source has the same layout as 16bpp pixels
+					copyBulk<V9990Bpp16>(vram.getWriteBackdoor(), dst.low,
+					                     src / 2, num, WM, LOG);
+				} else {
+					std::array<byte, 2 * MAX_BULK> buf;
+					for (auto i : xrange(num)) {
+						unsigned j = (dx > 0) ? i : (num - 1 - i);
+						buf[j]       = vram.readVRAMBx(src + 2 * i + 0);
+						buf[num + j] = vram.readVRAMBx(src + 2 * i + 1);
+					}
+					copyBulkFrom<V9990Bpp16>(vram.getWriteBackdoor(), dst.low,
+					                         buf.data(), num, WM, LOG);
+				}
+				engineTime += delta * num;
+				srcAddress += 2 * num;
+				DX += num * dx;
+				ANX -= num;
+				continue;
+			}
+		}
 		engineTime += delta;
 		word src = vram.readVRAMBx(srcAddress + 0) +
 		           vram.readVRAMBx(srcAddress + 1) * 256;
@@ -1299,6 +1769,38 @@ void V9990CmdEngine::executeBMXL(EmuTime::param limit)
 	const byte* lut = Mode::getLogOpLUT(LOG);
 
 	while (engineTime < limit) {
+		if constexpr (Mode::BULK) {
+			// Same as for 16bpp: each source byte gives one whole
+			// destination byte (for both directions the pixels within a
+			// byte keep their order).
+			constexpr unsigned PPB = Mode::PIXELS_PER_BYTE;
+			unsigned maxPixels = !bulkEnabled ? 0 : unsigned(std::min<uint64_t>(
+				ANX - 1, uint64_t(stepsUntil(engineTime, limit, delta)) * PPB));
+			if (unsigned num = bulkBytes<Mode>(DX, dx, maxPixels)) {
+				unsigned src = srcAddress & 0x7FFFF;
+				auto dst = getBulkRun<Mode>(
+					DX, DY, dx, pitch, std::min(num, 0x80000 - src));
+				num = dst.num;
+				if (!overlap(src, num, dst.low, num)) {
+					if (dx > 0) {
+						copyBulk<Mode>(vram.getWriteBackdoor(), dst.low,
+						               src, num, WM, LOG);
+					} else {
+						std::array<byte, MAX_BULK> buf;
+						for (auto i : xrange(num)) {
+							buf[num - 1 - i] = vram.readVRAMBx(src + i);
+						}
+						copyBulkFrom<Mode>(vram.getWriteBackdoor(), dst.low,
+						                   buf.data(), num, WM, LOG);
+					}
+					engineTime += delta * num;
+					srcAddress += num;
+					DX += num * PPB * dx;
+					ANX -= num * PPB;
+					continue;
+				}
+			}
+		}
 		engineTime += delta;
 		byte d = vram.readVRAMBx(srcAddress++);
 		for (int i = 0; (ANY > 0) && (i < Mode::PIXELS_PER_BYTE); ++i) {
@@ -1337,6 +1839,36 @@ void V9990CmdEngine::executeBMLX<V9990CmdEngine::V9990Bpp16>(EmuTime::param limi
 	int dy = (ARG & DIY) ? -1 : 1;
 
 	while (engineTime < limit) {
+		// The reverse of BMXL: process a run of source pixels of the
+		// current line at once, when it doesn't overlap with the
+		// destination.
+		unsigned maxPixels = !bulkEnabled ? 0 : std::min(
+			unsigned(ANX - 1), stepsUntil(engineTime, limit, delta));
+		if (unsigned num = bulkBytes<V9990Bpp16>(SX, dx, maxPixels)) {
+			unsigned dst = dstAddress & 0x7FFFF;
+			auto src = getBulkRun<V9990Bpp16>(
+				SX, SY, dx, pitch, std::min(num, (0x80000 - dst) / 2));
+			num = src.num;
+			if (num && !overlap(2 * src.low, 2 * num, dst, 2 * num)) {
+				byte* v = vram.getWriteBackdoor();
+				if ((dx > 0) && !(dst & 1)) {
+					// the destination has the same layout as 16bpp pixels
+					memcpy(v + dst / 2 + 0x00000, v + src.low + 0x00000, num);
+					memcpy(v + dst / 2 + 0x40000, v + src.low + 0x40000, num);
+				} else {
+					for (auto i : xrange(num)) {
+						unsigned addr = (dx > 0) ? (src.first + i) : (src.first - i);
+						v[V9990VRAM::transformBx(dst + 2 * i + 0)] = v[addr + 0x00000];
+						v[V9990VRAM::transformBx(dst + 2 * i + 1)] = v[addr + 0x40000];
+					}
+				}
+				engineTime += delta * num;
+				dstAddress += 2 * num;
+				SX += num * dx;
+				ANX -= num;
+				continue;
+			}
+		}
 		engineTime += delta;
 		auto src = V9990Bpp16::point(vram, SX, SY, pitch);
 		vram.writeVRAMBx(dstAddress++, src & 0xFF);
@@ -1364,6 +1896,37 @@ void V9990CmdEngine::executeBMLX(EmuTime::param limit)
 	int dy = (ARG & DIY) ? -1 : 1;
 
 	while (engineTime < limit) {
+		if constexpr (Mode::BULK) {
+			// Same as for 16bpp: each whole source byte gives one
+			// destination byte (from right to left the pixels within a
+			// byte are reversed).
+			constexpr unsigned PPB = Mode::PIXELS_PER_BYTE;
+			unsigned maxPixels = !bulkEnabled ? 0 : unsigned(std::min<uint64_t>(
+				ANX - 1, uint64_t(stepsUntil(engineTime, limit, delta)) * PPB));
+			if (unsigned num = bulkBytes<Mode>(SX, dx, maxPixels)) {
+				unsigned dst = dstAddress & 0x7FFFF;
+				auto src = getBulkRun<Mode>(
+					SX, SY, dx, pitch, std::min(num, 0x80000 - dst));
+				num = src.num;
+				if (!overlap(src.low, num, dst, num)) {
+					byte* v = vram.getWriteBackdoor();
+					if (dx > 0) {
+						copyBx(v, dst, src.low, num);
+					} else {
+						for (auto i : xrange(num)) {
+							v[V9990VRAM::transformBx(dst + i)] =
+								reversePixels<Mode::BITS_PER_PIXEL>(
+									v[V9990VRAM::transformBx(src.first - i)]);
+						}
+					}
+					engineTime += delta * num;
+					dstAddress += num;
+					SX += num * PPB * dx;
+					ANX -= num * PPB;
+					continue;
+				}
+			}
+		}
 		engineTime += delta;
 		byte d = 0;
 		for (auto i : xrange(Mode::PIXELS_PER_BYTE)) {
@@ -1416,6 +1979,21 @@ void V9990CmdEngine::executeBMLL<V9990CmdEngine::V9990Bpp16>(EmuTime::param limi
 	const byte* lut = V9990Bpp16::getLogOpLUT(LOG);
 	bool transp = (LOG & 0x10) != 0;
 	while (engineTime < limit) {
+		// Process a run of words at once, the last word always takes the
+		// path below. The run may not read a word it has written itself.
+		unsigned num = !bulkEnabled ? 0 : std::min({
+			nbBytes - 1, stepsUntil(engineTime, limit, delta),
+			MAX_BULK, 0x40000 - srcAddress, 0x40000 - dstAddress});
+		if (dstAddress > srcAddress) num = std::min(num, dstAddress - srcAddress);
+		if (num) {
+			copyBulk<V9990Bpp16>(vram.getWriteBackdoor(), dstAddress, srcAddress,
+			                     num, WM, LOG);
+			engineTime += delta * num;
+			srcAddress = (srcAddress + num) & 0x3FFFF;
+			dstAddress = (dstAddress + num) & 0x3FFFF;
+			nbBytes -= num;
+			continue;
+		}
 		engineTime += delta;
 		// VRAM always mapped as in Bx modes
 		word srcColor = vram.readVRAMDirect(srcAddress + 0x00000) +
@@ -1442,6 +2020,20 @@ void V9990CmdEngine::executeBMLL(EmuTime::param limit)
 	auto delta = getTiming(*this, BMLL_TIMING);
 	const byte* lut = Mode::getLogOpLUT(LOG);
 	while (engineTime < limit) {
+		// Same as for 16bpp, but with Bx addresses.
+		unsigned num = !bulkEnabled ? 0 : std::min({
+			nbBytes - 1, stepsUntil(engineTime, limit, delta),
+			MAX_BULK, 0x80000 - srcAddress, 0x80000 - dstAddress});
+		if (dstAddress > srcAddress) num = std::min(num, dstAddress - srcAddress);
+		if (num) {
+			copyBulk<Mode>(vram.getWriteBackdoor(), dstAddress, srcAddress,
+			               num, WM, LOG);
+			engineTime += delta * num;
+			srcAddress = (srcAddress + num) & 0x7FFFF;
+			dstAddress = (dstAddress + num) & 0x7FFFF;
+			nbBytes -= num;
+			continue;
+		}
 		engineTime += delta;
 		// VRAM always mapped as in Bx modes
 		byte srcColor = vram.readVRAMBx(srcAddress);
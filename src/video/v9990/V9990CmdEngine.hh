@@ -91,6 +91,12 @@ public:
 	[[nodiscard]] const V9990& getVDP() const { return vdp; }
 	[[nodiscard]] bool getBrokenTiming() const { return brokenTiming; }
 
+	/** Where possible, LMMV, LMMM and BMLL process runs of whole bytes at
+	  * once instead of pixel by pixel. Only used by the unittest, to
+	  * compare both.
+	  */
+	static void setBulkEnabled(bool enabled) { bulkEnabled = enabled; }
+
 	template<typename Archive>
 	void serialize(Archive& ar, unsigned version);
 
@@ -100,6 +106,7 @@ private:
 		using Type = byte;
 		static constexpr word BITS_PER_PIXEL  = 4;
 		static constexpr word PIXELS_PER_BYTE = 2;
+		static constexpr bool BULK = false;
 		static inline unsigned getPitch(unsigned width);
 		static inline unsigned addressOf(unsigned x, unsigned y, unsigned pitch);
 		static inline byte point(V9990VRAM& vram,
@@ -121,6 +128,7 @@ private:
 		using Type = byte;
 		static constexpr word BITS_PER_PIXEL  = 4;
 		static constexpr word PIXELS_PER_BYTE = 2;
+		static constexpr bool BULK = false;
 		static inline unsigned getPitch(unsigned width);
 		static inline unsigned addressOf(unsigned x, unsigned y, unsigned pitch);
 		static inline byte point(V9990VRAM& vram,
@@ -142,6 +150,7 @@ private:
 		using Type = byte;
 		static constexpr word BITS_PER_PIXEL  = 2;
 		static constexpr word PIXELS_PER_BYTE = 4;
+		static constexpr bool BULK = true;
 		static inline unsigned getPitch(unsigned width);
 		static inline unsigned addressOf(unsigned x, unsigned y, unsigned pitch);
 		static inline byte point(V9990VRAM& vram,
@@ -163,6 +172,7 @@ private:
 		using Type = byte;
 		static constexpr word BITS_PER_PIXEL  = 4;
 		static constexpr word PIXELS_PER_BYTE = 2;
+		static constexpr bool BULK = true;
 		static inline unsigned getPitch(unsigned width);
 		static inline unsigned addressOf(unsigned x, unsigned y, unsigned pitch);
 		static inline byte point(V9990VRAM& vram,
@@ -184,6 +194,7 @@ private:
 		using Type = byte;
 		static constexpr word BITS_PER_PIXEL  = 8;
 		static constexpr word PIXELS_PER_BYTE = 1;
+		static constexpr bool BULK = true;
 		static inline unsigned getPitch(unsigned width);
 		static inline unsigned addressOf(unsigned x, unsigned y, unsigned pitch);
 		static inline byte point(V9990VRAM& vram,
@@ -205,6 +216,7 @@ private:
 		using Type = word;
 		static constexpr word BITS_PER_PIXEL  = 16;
 		static constexpr word PIXELS_PER_BYTE = 0;
+		static constexpr bool BULK = true;
 		static inline unsigned getPitch(unsigned width);
 		static inline unsigned addressOf(unsigned x, unsigned y, unsigned pitch);
 		static inline word point(V9990VRAM& vram,
@@ -317,6 +329,10 @@ private:
 	 */
 	bool brokenTiming;
 
+	/** See setBulkEnabled().
+	 */
+	static inline bool bulkEnabled = true;
+
 	/** The running command is complete. Perform necessary clean-up actions.
 	  */
 	void cmdReady(EmuTime::param time);
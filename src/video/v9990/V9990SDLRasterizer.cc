@@ -98,6 +98,8 @@ void V9990SDLRasterizer<Pixel>::frameStart()
 template<typename Pixel>
 void V9990SDLRasterizer<Pixel>::frameEnd(EmuTime::param time)
 {
+	// Allows the post processor to skip unchanged lines.
+	workFrame->calcLineHashes();
 	workFrame = postProcessor->rotateFrames(std::move(workFrame), time);
 	workFrame->init(
 	    vdp.isInterlaced() ? (vdp.getEvenOdd() ? RawFrame::FIELD_EVEN
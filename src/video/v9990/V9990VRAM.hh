@@ -78,6 +78,13 @@ public:
 		data.write(address, value);
 	}
 
+	/** Direct access to the VRAM data, used by the command engine to
+	  * process a block of bytes at once. Marks the VRAM as modified.
+	  */
+	[[nodiscard]] inline byte* getWriteBackdoor() {
+		return data.getWriteBackdoor();
+	}
+
 	[[nodiscard]] byte readVRAMCPU(unsigned address, EmuTime::param time);
 	void writeVRAMCPU(unsigned address, byte val, EmuTime::param time);
 